@@ -0,0 +1,72 @@
+<?
+// Reads the columnar files written by Print with the "columnar" type (see
+// ColumnarFile.h). Every batch of the file becomes a chunk, the columns are
+// put in place as they are, without parsing any of the values.
+function ColumnarReader( array $t_args, array $output ) {
+
+    grokit_assert( \count($output) > 0,
+        'ColumnarReader needs the types of its outputs' );
+
+    $my_output = [];
+    $kinds = [];
+    foreach( $output as $name => $type ) {
+        $kind = \grokit\columnarKind($type);
+
+        grokit_assert( $kind !== null,
+            'ColumnarReader cannot read values of type ' . $type );
+
+        $my_output[$name] = $type;
+        $kinds[$name] = $kind;
+    }
+
+    $className = generate_name( 'ColumnarReader' );
+?>
+
+class <?=$className?> {
+    ColumnarFileReader reader;
+
+public:
+
+    <?=$className?> ( GIStreamProxy& _stream ) :
+        reader(_stream.get_file_name().c_str())
+    {
+        FATALIF( reader.GetNumColumns() != <?=\count($my_output)?>,
+            "Columnar file %s has %d columns, expected <?=\count($my_output)?>",
+            _stream.get_file_name().c_str(), reader.GetNumColumns() );
+    }
+
+    bool ProduceChunk( size_t& numTuples, <?=implode(', ', array_map(function($name) { return "Column& {$name}"; }, array_keys($my_output)))?> ) {
+        if( !reader.NextBatch() ) {
+            numTuples = 0;
+            return false;
+        }
+
+        numTuples = reader.GetNumTuples();
+<?  $i = 0;
+    foreach( $my_output as $name => $type ) {
+        if( $kinds[$name] == 'string' ) { ?>
+        reader.GetStringColumn(<?=$i?>, <?=$type?>::NULL_STR, <?=$name?>);
+<?      } else { ?>
+        reader.GetFixedColumn(<?=$i?>, sizeof(<?=$type?>), <?=$name?>);
+<?      }
+        $i += 1;
+    } ?>
+
+        return true;
+    }
+};
+
+<?
+    return [
+        'name' => $className,
+        'kind' => 'GI',
+        'output' => $my_output,
+        'produce_chunk' => true,
+        'user_headers' => [
+            'GIStreamInfo.h',
+            'ColumnarFile.h',
+        ]
+    ];
+}
+
+?>
@@ -24,6 +24,7 @@ class <?=$name?> {
 public:
     <?=$name?>() : count(0) {}
     void AddItem( <?=const_typed_ref_args($input)?> ) { count++; }
+    void AddRun( <?=const_typed_ref_args($input)?><?=\count($input) > 0 ? ', ' : ''?>uint64_t _count ) { count += _count; }
     void AddState( <?=$name?> & o ) { count += o.count; }
     void GetResult(<?=$oType?> & _count ) const {
 <?  if( $asJson) { ?>
@@ -42,6 +43,8 @@ public:
         'input'       => $input,
         'output'      => $output,
         'result_type' => 'single',
+        'add_run'     => true,
+        'system_headers' => [ 'cstdint' ],
         ];
 }
 ?>
@@ -286,6 +286,15 @@ function GroupBy( array $t_args, array $inputs, array $outputs, array $states )
 
     $iterable = $innerGLA->iterable();
 
+    // A single STRING group can be taken by the chunk code of its dictionary
+    // encoded column: the tuples of a chunk are grouped in an array indexed by
+    // code, and only the groups of the chunk go through the hash map, at the
+    // chunk boundary.
+    $codeInput = null;
+    if( $numGByAtts == 1 && $gbyAtts[$gbyAttNames[0]]->name() == 'base::STRING' ) {
+        $codeInput = array_search($gbyAttNames[0], array_keys($inputs));
+    }
+
     // need to keep track of system includes needed
     $extraHeaders = array();
 
@@ -405,6 +414,13 @@ private:
 
     std::vector<MapType::iterator> theIterators;  // the iterators, only 2 elements if multi, many if fragment
     Iterator multiIterator;
+<?  if( $codeInput !== null ) { ?>
+
+    // the groups of the current chunk by chunk code of their key (AddItemCode),
+    // NULL for the codes not seen yet
+    std::vector<Key> codeKeys;
+    std::vector<InnerGLA*> codeGLAs;
+<?  } // if the group can be taken by code ?>
 
 public:
 
@@ -419,6 +435,24 @@ public:
         , multiIterator()
     { }
 
+<?  if( $codeInput !== null ) { ?>
+    ~<?=$className?>() {
+        for( size_t code = 0; code < codeGLAs.size(); code++ ) {
+            delete codeGLAs[code];
+        }
+    }
+
+    void Reset(void) {
+        count = 0;
+        groupByMap.clear();
+        theIterators.clear();
+        for( size_t code = 0; code < codeGLAs.size(); code++ ) {
+            delete codeGLAs[code];
+        }
+        codeKeys.clear();
+        codeGLAs.clear();
+    }
+<?  } else { ?>
     ~<?=$className?>() {}
 
     void Reset(void) {
@@ -426,6 +460,7 @@ public:
         groupByMap.clear();
         theIterators.clear();
     }
+<?  } // if the group can be taken by code ?>
 
     void AddItem(<?=array_template('const {val} & {key}', ', ', $inputs)?>) {
         count++;
@@ -448,6 +483,47 @@ public:
         }
         it->second.AddItem(<?=array_template('{key}', ', ', $glaInputAtts)?>);
     }
+<?  if( $codeInput !== null ) { ?>
+
+    // code is the chunk code of the group; the string is only hashed, and
+    // looked up in the map, once per group of the chunk, in ChunkBoundary
+    void AddItemCode(uint32_t code, <?=array_template('const {val} & {key}', ', ', $inputs)?>) {
+        count++;
+        if( code >= codeGLAs.size() ) {
+            codeKeys.resize(code + 1);
+            codeGLAs.resize(code + 1, NULL);
+        }
+
+        InnerGLA *& codeGLA = codeGLAs[code];
+        if( codeGLA == NULL ) {
+            codeKeys[code] = Key(<?=array_template('{key}', ', ', $gbyAtts)?>);
+<?      if( $innerGLA->has_state() ) { ?>
+            const InnerState & innerState = constState.getConstState(codeKeys[code]);
+<?      } // if gla has state ?>
+            codeGLA = new InnerGLA<?=$constructorString?>;
+        }
+        codeGLA->AddItem(<?=array_template('{key}', ', ', $glaInputAtts)?>);
+    }
+
+    // the codes start over with the next chunk, the groups of this one go
+    // to the map
+    void ChunkBoundary(void) {
+        for( size_t code = 0; code < codeGLAs.size(); code++ ) {
+            if( codeGLAs[code] == NULL )
+                continue;
+
+            MapType::iterator it = groupByMap.find(codeKeys[code]);
+            if( it != groupByMap.end() ) {
+                it->second.AddState(*codeGLAs[code]);
+            } else {
+                groupByMap.insert(MapType::value_type(codeKeys[code], *codeGLAs[code]));
+            }
+            delete codeGLAs[code];
+        }
+        codeKeys.clear();
+        codeGLAs.clear();
+    }
+<?  } // if the group can be taken by code ?>
 
     void AddState(<?=$className?>& other) {
         count += other.count;
@@ -608,6 +684,8 @@ typedef <?=$className?>::Iterator <?=$className?>_Iterator;
         'generated_state'  => $constState,
         'required_states'  => $reqStates,
         'iterable'         => $iterable,
+        'chunk_boundary'   => $codeInput !== null,
+        'code_input'       => $codeInput,
         'properties'       => [ 'resettable', 'finite container' ],
         'libraries'        => $libraries,
         'extra'            => [ 'inner_gla' => $innerGLA],
@@ -47,6 +47,13 @@ public:
 
         count++;
     }
+
+    // the same item _count times in a row
+    void AddRun( <?=const_typed_ref_args($input)?>, uintmax_t _count ) {
+        AddItem( <?=implode(', ', $inputNames)?> );
+        count += _count - 1;
+    }
+
     void AddState( <?=$name?> & o ) {
         if (count > 0 && o.count > 0) {
 <?  for($index = 0; $index < $nValues; $index++) { ?>
@@ -75,6 +82,7 @@ public:
         'input'       => $input,
         'output'      => $output,
         'result_type' => 'single',
+        'add_run'     => true,
         'system_headers' => [ 'algorithm', 'cstdint' ],
         ];
 }
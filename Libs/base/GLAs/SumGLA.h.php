@@ -7,6 +7,9 @@ function Sum( array $t_args, array $inputs, array $outputs ) {
 
     $storage = [];
     $inits = [];
+    // A run of equal values can be added as value * count if all the sums are
+    // arithmetic
+    $addRun = true;
     if( \count($inputs) == 0 ) {
         $inputs = [ "x" => lookupType("base::DOUBLE") ];
         $storage = [ "x" => 'long double' ];
@@ -25,6 +28,7 @@ function Sum( array $t_args, array $inputs, array $outputs ) {
                 $storage[$name] = 'long int';
             }else {
                 $storage[$name] = $value->value();
+                $addRun = false;
             }
             $oKey = key($outputs);
 
@@ -55,6 +59,12 @@ public:
     void AddItem(<?=array_template('const {val}& _{key}', ', ', $inputs)?>) {
         <?=array_template('{key} += _{key};' . PHP_EOL, '        ', $inputs)?>
     }
+<?  if( $addRun ) { ?>
+
+    void AddRun(<?=array_template('const {val}& _{key}', ', ', $inputs)?>, uint64_t _count) {
+        <?=array_template('{key} += ({val}) _{key} * _count;' . PHP_EOL, '        ', $storage)?>
+    }
+<?  } // if addRun ?>
 
     void AddState( <?=$className?> & other ) {
         <?=array_template('{key} += other.{key};' . PHP_EOL, '        ', $inputs)?>
@@ -83,6 +93,8 @@ public:
       'input'       => $inputs,
       'output'      => $outputs,
       'result_type' => 'single',
+      'add_run'     => $addRun,
+      'system_headers' => [ 'cstdint' ],
   );
 
 }
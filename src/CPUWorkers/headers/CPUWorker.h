@@ -32,9 +32,10 @@
 class CPUWorker : public EventProcessor {
 public:
 
-	// constructor (creates the implementation object)
-	CPUWorker (void) {
-		CPUWorkerImp *temp = new CPUWorkerImp;
+	// constructor (creates the implementation object); node is the NUMA node whose
+	// list in the CPUWorkerPool the worker goes back to when it is done with some work
+	CPUWorker (int node = 0) {
+		CPUWorkerImp *temp = new CPUWorkerImp (node);
 		evProc = temp;
 		temp->GetCopyOf (*this);
 	}
@@ -44,6 +44,9 @@ private:
 
 	EventProcessor me;
 
+	// the NUMA node this worker belongs to in the CPUWorkerPool
+	int myNode;
+
 	/* Performance counters to watch what the functions being executed are doing */
 	/* For now the info is just logged but it could be sent the the reciever in a
 	   special package for self-diagnosis */
@@ -62,7 +65,7 @@ protected:
 public:
 
 	// constructor and destructor
-	CPUWorkerImp ();
+	CPUWorkerImp (int node);
 	~CPUWorkerImp ();
 
 	// this handles a request to actually do some work
@@ -21,6 +21,7 @@
 #include "CPUWorkerImp.h"
 #include "ID.h"
 #include "History.h"
+#include "Numa.h"
 #include "Tokens.h"
 #include "WorkDescription.h"
 #include "WorkFuncs.h"
@@ -32,11 +33,14 @@ private:
 	static const constexpr size_t DEFAULT_STACK_SIZE = 64L * 1024L * 1024L; // 64 MiB
 
 
-	CPUWorkerList myWorkers;
+	// the idle workers, one list per NUMA node; on a machine with more than one node, the workers
+	// are dealt out to the nodes round robin and pinned there
+	int numNodes;
+	CPUWorkerList *myWorkers;
 
 public:
 
-	// set up all of the worker threads and puts them into the list myWorkers
+	// set up all of the worker threads and puts them into the lists in myWorkers
 	CPUWorkerPool (int numWorkers, size_t stack_size = DEFAULT_STACK_SIZE);
 
 	// die
@@ -55,14 +59,16 @@ public:
 	// the result of the work will be put into the param "result" by the function WorkFunc.
 	// Then, DoSomeWork will take the resulting ExecEngineData object, and send it back to
 	// the execution engine along with the lineage, the token, and the destination(s).
+	// If "node" is given, a worker pinned to that NUMA node does the work if one is idle.
 	void DoSomeWork (WayPointID &requestor, HistoryList &lineage, QueryExitContainer &dest,
-		GenericWorkToken &myToken, WorkDescription &workDescription, WorkFunc &myFunc);
+		GenericWorkToken &myToken, WorkDescription &workDescription, WorkFunc &myFunc,
+		int node = NUMA_ALL_NODES);
 
-	// add a worker back into the pool
-	void AddWorker (CPUWorker &addMe);
+	// add a worker back into the pool; node is the one the worker was given when it was created
+	void AddWorker (CPUWorker &addMe, int node);
 
 	// returns the number of available threads
-	int NumAvailable(void){ return myWorkers.Length(); }
+	int NumAvailable(void);
 };
 
 // myWorkers actually lives in CPUWorkerPool.cc
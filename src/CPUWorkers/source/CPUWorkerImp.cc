@@ -24,6 +24,7 @@
 #include "Profiling.h"
 #include "Logging.h"
 #include "Diagnose.h"
+#include "MMappedStorage.h"
 #include "WorkerMessages.h"
 
 /** How oftern the system should have context swithes? Need this to determine if we have
@@ -60,7 +61,8 @@ void CPUWorkerImp :: GetCopyOf (EventProcessor &myParent){
     me.copy (myParent);
 }
 
-CPUWorkerImp :: CPUWorkerImp ()
+CPUWorkerImp :: CPUWorkerImp (int node):
+    myNode(node)
 {
 
     // register the DoSomeWork method
@@ -92,9 +94,16 @@ MESSAGE_HANDLER_DEFINITION_BEGIN(CPUWorkerImp, DoSomeWork, WorkRequestMsg) {
     int64_t cpuStart = (cpuStartSpec.tv_sec * 1000LL) + (cpuStartSpec.tv_nsec / 1000000LL);
 #endif // PER_CPU_PROFILE
 
+    // the columns count the bridge copies they make in this thread
+    uint64_t bridgeCopiesStart = MMappedStorage::GetBridgeCopies ();
+
     // now, call the work function to actually produce the output data
     int returnVal = msg.myFunc (msg.workDescription, computationResult);
 
+    uint64_t bridgeCopies = MMappedStorage::GetBridgeCopies () - bridgeCopiesStart;
+    if (bridgeCopies > 0)
+        PROFILING2_INSTANT("bridge copies", bridgeCopies, msg.currentPos.getName());
+
 #ifdef PER_CPU_PROFILE
     PROFILING2_END;
     timespec cpuEndSpec;
@@ -124,9 +133,9 @@ MESSAGE_HANDLER_DEFINITION_BEGIN(CPUWorkerImp, DoSomeWork, WorkRequestMsg) {
     CPUWorker me;
     me.copy(evProc.me);
     if (CHECK_DATA_TYPE(msg.token, CPUWorkToken)) {
-        myCPUWorkers.AddWorker (me);
+        myCPUWorkers.AddWorker (me, evProc.myNode);
     } else if (CHECK_DATA_TYPE(msg.token, DiskWorkToken)) {
-        myDiskWorkers.AddWorker (me);
+        myDiskWorkers.AddWorker (me, evProc.myNode);
     } else
         FATAL ("Strange work token type!\n");
 
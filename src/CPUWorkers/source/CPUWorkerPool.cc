@@ -17,43 +17,65 @@
 #include "CPUWorkerPool.h"
 #include "WorkerMessages.h"
 
-void CPUWorkerPool :: AddWorker (CPUWorker &addMe) {
-    myWorkers.Add (addMe);
+void CPUWorkerPool :: AddWorker (CPUWorker &addMe, int node) {
+    myWorkers[node].Add (addMe);
+}
+
+int CPUWorkerPool :: NumAvailable (void) {
+    int numAvailable = 0;
+    for (int i = 0; i < numNodes; i++) {
+        numAvailable += myWorkers[i].Length ();
+    }
+    return numAvailable;
 }
 
 CPUWorkerPool :: CPUWorkerPool (int numWorkers, size_t stack_size) {
 
+    numNodes = numaNodeCount ();
+    myWorkers = new CPUWorkerList[numNodes];
+
     for (int i = 0; i < numWorkers; i++) {
 
         // create the CPU worker
-        CPUWorker temp;
+        int node = i % numNodes;
+        CPUWorker temp (node);
 
-        // start him going
-        temp.ForkAndSpin (NUMA_ALL_NODES, stack_size);
+        // start him going; with a single node, there is no point in pinning him
+        temp.ForkAndSpin (numNodes > 1 ? node : NUMA_ALL_NODES, stack_size);
 
         // and add him to the pool for later use
-        myWorkers.Add (temp);
+        myWorkers[node].Add (temp);
     }
 }
 
 CPUWorkerPool :: ~CPUWorkerPool () {
 
-    while (myWorkers.Length () > 0) {
-        CPUWorker temp;
-        myWorkers.AtomicRemove (temp);
-        KillEvProc (temp);
+    for (int i = 0; i < numNodes; i++) {
+        while (myWorkers[i].Length () > 0) {
+            CPUWorker temp;
+            myWorkers[i].AtomicRemove (temp);
+            KillEvProc (temp);
+        }
     }
+
+    delete [] myWorkers;
 }
 
 void CPUWorkerPool :: DoSomeWork (WayPointID &requestor, HistoryList &lineage, QueryExitContainer &dest,
-        GenericWorkToken &myToken, WorkDescription &workDescription, WorkFunc &myFunc) {
+        GenericWorkToken &myToken, WorkDescription &workDescription, WorkFunc &myFunc, int node) {
 
     // check if the token is forged
     FATALIF(myToken.Type() != CPUWorkToken::type, "I got a fake CPU token");
 
-    // first, go to the queue and take a worker out
+    // first, go to the queue and take a worker out; the requested node is tried first, then
+    // the others, starting with the node we are running on
+    int firstNode = (node == NUMA_ALL_NODES ? numaCurrentNode () : node) % numNodes;
     CPUWorker worker;
-    if (!myWorkers.AtomicRemove (worker)) {
+    bool found = false;
+    for (int i = 0; i < numNodes && !found; i++) {
+        found = myWorkers[(firstNode + i) % numNodes].AtomicRemove (worker);
+    }
+    if (!found) {
         FATAL ("Got into a situation where I have tried to remove a CPU worker, but none exits");
     }
 
@@ -62,4 +84,3 @@ void CPUWorkerPool :: DoSomeWork (WayPointID &requestor, HistoryList &lineage, Q
 
     // done!
 }
-
@@ -57,6 +57,9 @@ class Chunk {
         // make the chunk readonly
         void MakeReadonly();
 
+        // decompress now all the columns that were read compressed from disk
+        void Decompress();
+
         // This copies the chunk.  The copy is generally a fast, shallow
         // one (Column.copy is called for each of the columns in the chunk,
         // and since columns are read-only, Column.copy is shallow and fast).
@@ -157,4 +157,13 @@ void Chunk :: MakeReadonly(){
             cols[i] -> MakeReadonly();
           } 
     }
-}
\ No newline at end of file
+}
+
+void Chunk :: Decompress(){
+    // scans all the columns and decompresses the ones read compressed
+    for (int i = numCols - 1; i >= 0; i--) {
+        if (cols[i] != 0) {
+            cols[i] -> Decompress();
+        }
+    }
+}
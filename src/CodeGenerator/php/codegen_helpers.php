@@ -259,6 +259,22 @@ namespace grokit {
         }
     }
 
+    // How the values of type are written to columnar files (see ColumnarFile.h):
+    // 'string' for the strings, 'fixed' for the types whose values are copied
+    // as they are kept in the columns, null if the type cannot be written.
+    function columnarKind( $type ) {
+        if( $type->is('string') ) {
+            return 'string';
+        }
+
+        if( $type->isFixedSize() && !$type->reqDictionary()
+            && $type->iterator() == 'ColumnIterator<' . $type->value() . '>' ) {
+            return 'fixed';
+        }
+
+        return null;
+    }
+
     function fromStringNullable( $name, $type, $str, $dict = true, $nullStr = 'NULL', $case = true ) {
         $nullChars = \strlen($nullStr) > 0 ? str_split($nullStr) : [];
         $nullChars[] = "\\0";
@@ -271,6 +271,8 @@ EOT
         $waypoints = [];
         $res = new GenerationInfo;
 
+        $joinFilters = findJoinFilters( $wps, $edges );
+
         foreach( $wps as $wpast ) {
             // Get the waypoint's name from the node
             $wpname = ast_get( $wpast, NodeKey::NAME );
@@ -288,7 +290,8 @@ EOT
                 $waypoints[$wpname] = "gi";
                 break;
             case NodeType::SEL_WP:
-                $gRes = parseSelectionWP( $wpast, $wpname, $header);
+                $joinFilter = isset($joinFilters[$wpname]) ? $joinFilters[$wpname] : null;
+                $gRes = parseSelectionWP( $wpast, $wpname, $header, $joinFilter);
                 $waypoints[$wpname] = "selection";
                 break;
             case NodeType::JOIN_WP:
@@ -334,6 +337,51 @@ EOT
         return ["waypoints" => $waypoints, "edges" => $edges, "generated" => $res ];
     }
 
+    // Finds the selections whose only output is the LHS of a join. Those selections
+    // can probe the Bloom filter the join builds over its RHS keys and drop tuples
+    // that have no match, as nothing else downstream of them needs the tuples.
+    // Returns a map from selection name to the join name, LHS keys and the
+    // not exists target of the join.
+    function findJoinFilters( $wps, $edges ) {
+        $types = [];
+        $joins = [];
+        foreach( $wps as $wpast ) {
+            $wpname = ast_get( $wpast, NodeKey::NAME );
+            $types[$wpname] = ast_get( $wpast, NodeKey::TYPE );
+            if( $types[$wpname] == NodeType::JOIN_WP )
+                $joins[$wpname] = $wpast;
+        }
+
+        $outEdges = [];
+        foreach( $edges as $edge ) {
+            $outEdges[ast_get($edge, 'source')][] = $edge;
+        }
+
+        $filters = [];
+        foreach( $outEdges as $source => $outs ) {
+            if( !isset($types[$source]) || $types[$source] != NodeType::SEL_WP || \count($outs) != 1 )
+                continue;
+
+            // The RHS edge terminates at the join, the LHS one flows through it
+            $edge = $outs[0];
+            $dest = ast_get($edge, 'dest');
+            if( !isset($joins[$dest]) || ast_get($edge, 'terminating') )
+                continue;
+
+            $keys = ast_get($joins[$dest], 'LHS_keys');
+            if( \count($keys) == 0 )
+                continue;
+
+            $filters[$source] = [
+                'join' => $dest,
+                'keys' => $keys,
+                'not_exists' => ast_get($joins[$dest], 'not_exists_target')
+            ];
+        }
+
+        return $filters;
+    }
+
     function parseScanWP( $ast, $wpname, $header ) {
         // Nothing to do for scanner
         return new GenerationInfo;
@@ -567,6 +615,9 @@ EOT
 
         $jDesc->hash_RHS_attr = ast_get($ast, "hash_RHS_attr");
         $jDesc->query_classes_hash = ast_get($ast, "query_classes_hash");
+        $jDesc->probe_batch = ast_has($ast, "probe_batch") ? intval(ast_get($ast, "probe_batch")) : 0;
+        $jDesc->concurrent_build = ast_has($ast, "concurrent_build") ? ast_get($ast, "concurrent_build") : false;
+        $jDesc->radix = ast_has($ast, "radix") ? ast_get($ast, "radix") : false;
 
         $jobs = ast_get($ast, NodeKey::QUERIES);
         foreach( $jobs as $job ) {
@@ -660,7 +711,7 @@ EOT
         return $res;
     }
 
-    function parseSelectionWP( $ast, $name, $header ) {
+    function parseSelectionWP( $ast, $name, $header, $joinFilter = null ) {
         // Push LibraryManager so we can undo this waypoint's definitions.
         ob_start();
         LibraryManager::Push();
@@ -733,6 +784,10 @@ EOT
             $res->absorbInfoList($cargs);
             $res->absorbStateList($sargs);
             if( $gf !== null ) $res->absorbInfo($gf);
+
+            // A key computed here does not exist yet in the input chunk
+            if( $joinFilter !== null && \count(array_intersect($joinFilter['keys'], array_keys($synths))) > 0 )
+                $joinFilter = null;
         }
 
         /*************** END PROCESS AST ***************/
@@ -744,7 +799,7 @@ EOT
         $filename = $name . '.cc';
         $res->addFile($filename, $name);
         _startFile( $filename );
-        SelectionGenerate( $name, $queries, $attMap );
+        SelectionGenerate( $name, $queries, $attMap, $joinFilter );
         _endFile( $filename, $myHeaders );
 
         // Pop LibraryManager again to get rid of this waypoint's declarations
@@ -21,6 +21,11 @@ namespace grokit {
         // Whether or not this expression is constant
         private $is_const = false;
 
+        // Whether or not this expression always has the same value for the same
+        // tuple. Work functions use this to evaluate an expression once for a
+        // run of equal tuples.
+        private $is_deterministic = true;
+
         // Any constants that need to be defined before any tuples are processed by
         // this expression.
         private $constants = [];
@@ -48,6 +53,7 @@ namespace grokit {
         public function type() { return $this->type; }
         public function value() { return $this->value; }
         public function is_const() { return $this->is_const; }
+        public function is_deterministic() { return $this->is_deterministic; }
         public function constants() { return $this->constants; }
         public function preprocess() { return $this->preprocess; }
         public function source() { return $this->source; }
@@ -67,11 +73,16 @@ namespace grokit {
             $this->constants = array_merge($this->constants, $info->constants);
             $this->preprocess = array_merge($this->preprocess, $info->preprocess);
             $this->is_const = $this->is_const && $info->is_const;
+            $this->is_deterministic = $this->is_deterministic && $info->is_deterministic;
             $this->libraries = array_unique(array_merge($this->libraries, $info->libraries()));
         }
 
         // Functions to add metadata
 
+        public function makeNondeterministic() {
+            $this->is_deterministic = false;
+        }
+
         public function addConstant( $const ) {
             $this->constants[] = $const;
         }
@@ -85,6 +85,8 @@ namespace grokit {
                 $info->absorbMeta( $expr );
             }
 
+            // Operators are the C++ operators of the types, so the expression stays
+            // deterministic even if the operator is not marked as such
             return $info;
         }
     }
@@ -156,6 +158,10 @@ namespace grokit {
                 $info->absorbMeta( $expr );
             }
 
+            if( ! $this->deterministic ) {
+                $info->makeNondeterministic();
+            }
+
             return $info;
         }
     }
@@ -240,6 +246,10 @@ namespace grokit {
                 $info->absorbMeta($expr);
             }
 
+            if( ! $this->deterministic ) {
+                $info->makeNondeterministic();
+            }
+
             return $info;
         }
 
@@ -691,6 +691,9 @@ namespace grokit {
     class GI_Info extends GeneralizedObject {
 
         private $output = [];
+        // the GI has ProduceChunk(numTuples, columns...), that fills whole
+        // columns at a time instead of a tuple at a time
+        private $produce_chunk = false;
 
         public function __construct( $hash, $name, $value, array $args, $oArgs ) {
             parent::__construct(InfoKind::T_GI, $hash, $name, $value, $args, $oArgs[0]);
@@ -699,12 +702,17 @@ namespace grokit {
                 'No outputs declared for ' . $this );
 
             $this->output = $args['output'];
+
+            if( array_key_exists( 'produce_chunk', $args ) ) {
+                $this->produce_chunk = $args['produce_chunk'];
+            }
         }
 
         public function summary() {
             $ret = parent::summary();
 
             $ret['output'] = squash($this->output);
+            $ret['produce_chunk'] = $this->produce_chunk;
 
             return $ret;
         }
@@ -714,6 +722,8 @@ namespace grokit {
             return $this->output;
         }
 
+        public function produce_chunk() { return $this->produce_chunk; }
+
         /*
          * $outputs should be an array of TypeInfo objects giving the types of
          * the given outputs.
@@ -745,6 +755,12 @@ namespace grokit {
         private $post_finalize = false;
         private $chunk_boundary = false;
         private $intermediates = false;
+        // the GLA has AddRun(inputs..., count), that adds the same item count times
+        private $add_run = false;
+        // position of a STRING input the GLA can take by code: it has
+        // AddItemCode(code, inputs...), where code is the same for equal values of
+        // that input until the next ChunkBoundary(); null if it has not
+        private $code_input = null;
 
         public function __construct( $hash, $name, $value, array $args, array $oArgs ) {
             $args['req_states'] = $oArgs[3];
@@ -792,6 +808,16 @@ namespace grokit {
             if( array_key_exists( 'post_finalize', $args ) ) {
                 $this->post_finalize = $args['post_finalize'];
             }
+
+            if( array_key_exists( 'add_run', $args ) ) {
+                $this->add_run = $args['add_run'];
+            }
+
+            if( array_key_exists( 'code_input', $args ) ) {
+                $this->code_input = $args['code_input'];
+                grokit_assert( $this->code_input === null || $this->chunk_boundary,
+                    'GLA ' . $this . ' takes an input by code but not the chunk boundaries');
+            }
         }
 
         public function summary() {
@@ -805,6 +831,8 @@ namespace grokit {
             $ret['post_finalize'] = $this->post_finalize;
             $ret['chunk_boundary'] = $this->chunk_boundary;
             $ret['intermediates'] = $this->intermediates;
+            $ret['add_run'] = $this->add_run;
+            $ret['code_input'] = $this->code_input;
 
             return $ret;
         }
@@ -818,6 +846,8 @@ namespace grokit {
         public function post_finalize() { return $this->post_finalize; }
         public function chunk_boundary() { return $this->chunk_boundary; }
         public function intermediates() { return $this->intermediates; }
+        public function add_run() { return $this->add_run; }
+        public function code_input() { return $this->code_input; }
 
         /*
          * $outputs should be an array of TypeInfo objects giving the types of
@@ -0,0 +1,119 @@
+//
+//  Copyright 2012 Alin Dobra and Christopher Jermaine
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+// Microbenchmarks of the two ways of reading a column of fixed size values:
+// GetCurrent ()/Advance () for every tuple, and GetBatch ()/AdvanceBy () with a
+// tight loop over every batch, the way the generated code does it. Each
+// benchmark checks that both ways see the same values and prints the time of
+// each.
+
+#include <gtest/gtest.h>
+#include <cstdio>
+#include "../headers/Column.h"
+#include "../headers/ColumnIterator.h"
+#include "../headers/ColumnIterator.cc"
+#include "../headers/MMappedStorage.h"
+#include "Timer.h"
+
+using namespace std;
+
+class ColumnIteratorBenchmark : public ::testing::Test {
+protected:
+    static constexpr uint64_t kNumTuples = 1 << 24;
+    static constexpr int kRepeats = 5;
+
+    // writes a column with kNumTuples values
+    template <class DataType>
+    void MakeColumn(Column& col) {
+        MMappedStorage store;
+        Column temp(store);
+        ColumnIterator<DataType> iter(temp);
+        for (uint64_t i = 0; i < kNumTuples; i++) {
+            iter.Insert((DataType) (i % 100));
+            iter.Advance();
+        }
+        iter.Done(temp);
+        col.swap(temp);
+    }
+
+    // sum of the values and number of values under the limit, a tuple at a time
+    template <class DataType>
+    void Scalar(Column& col, DataType limit, DataType& sum, uint64_t& count) {
+        ColumnIterator<DataType> iter(col);
+        sum = 0;
+        count = 0;
+        for (uint64_t i = 0; i < kNumTuples; i++) {
+            const DataType& val = iter.GetCurrent();
+            sum += val;
+            count += val < limit;
+            iter.Advance();
+        }
+        iter.Done(col);
+    }
+
+    // same, a batch at a time
+    template <class DataType>
+    void Batch(Column& col, DataType limit, DataType& sum, uint64_t& count) {
+        ColumnIterator<DataType> iter(col);
+        sum = 0;
+        count = 0;
+        uint64_t left = kNumTuples;
+        while (left > 0) {
+            uint64_t batchLength;
+            const DataType* batch = iter.GetBatch(COLUMN_BATCH_SIZE, batchLength);
+            ASSERT_GT(batchLength, 0UL);
+            for (uint64_t i = 0; i < batchLength; i++) {
+                sum += batch[i];
+                count += batch[i] < limit;
+            }
+            iter.AdvanceBy(batchLength);
+            left -= batchLength;
+        }
+        iter.Done(col);
+    }
+
+    template <class DataType>
+    void Compare(const char* name) {
+        Column col;
+        MakeColumn<DataType>(col);
+
+        DataType sumScalar, sumBatch;
+        uint64_t countScalar, countBatch;
+        double timeScalar = 0.0, timeBatch = 0.0;
+        for (int i = 0; i < kRepeats; i++) {
+            Timer clock;
+            Scalar<DataType>(col, 50, sumScalar, countScalar);
+            timeScalar += clock.GetTime();
+
+            clock.Restart();
+            Batch<DataType>(col, 50, sumBatch, countBatch);
+            timeBatch += clock.GetTime();
+        }
+
+        EXPECT_EQ(sumScalar, sumBatch);
+        EXPECT_EQ(countScalar, countBatch);
+        printf("%s: %lu tuples, scalar %.3f ms, batch %.3f ms\n", name, kNumTuples,
+                1000 * timeScalar / kRepeats, 1000 * timeBatch / kRepeats);
+    }
+};
+
+TEST_F(ColumnIteratorBenchmark, Int) {
+    Compare<int>("INT");
+}
+
+TEST_F(ColumnIteratorBenchmark, Double) {
+    Compare<double>("DOUBLE");
+}
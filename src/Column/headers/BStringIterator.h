@@ -139,6 +139,13 @@ public:
     // advance to the next object in the column...
     void Advance ();
 
+    // number of objects, the current one included, that are the same as the current
+    // one; the pattern does not change until the iterator is advanced past them
+    uint64_t RunLength ();
+
+    // advance over n objects of the current run, n is at most RunLength ()
+    void Skip (uint64_t n);
+
     // advance from within the insert function
     void AdvanceForInsert ();
 
@@ -363,6 +370,28 @@ void BStringIterator :: Advance () {
     }
 }
 
+inline
+uint64_t BStringIterator :: RunLength () {
+    uint64_t len = endCount - startCount + 1;
+    if (len > numTuples - tupleCount)
+        len = numTuples - tupleCount;
+    return len;
+}
+
+inline
+void BStringIterator :: Skip (uint64_t n) {
+
+    if (it.IsInvalid () || n == 0)
+        return;
+
+    assert(!it.IsWriteOnly() && n <= RunLength ());
+
+    // stop just before the end of the run and let Advance () move to the next one
+    tupleCount += n - 1;
+    startCount += n - 1;
+    Advance ();
+}
+
 // Set the count extracting from the data stream
 // Set the last seen pattern from the data stream
 inline
@@ -20,6 +20,7 @@
 #include <pthread.h>
 #include "RawStorageDesc.h"
 #include "FileMetadata.h"
+#include "ColumnCodec.h"
 #include "DistributedCounter.h"
 #include <functional>
 
@@ -62,7 +63,9 @@ public:
     // compression happens in a single go (no incremental compression)
     // the storage state cannot be changed after this
     // if deleteDecompress is true, the decompressed version should be eliminated
-    void Compress(bool deleteDecompressed);
+    // codec is the codec and level the column is compressed with (see ColumnCodec.h),
+    // e.g. LZ4 for hot columns and Zstd for cold ones
+    void Compress(bool deleteDecompressed, ColumnCodec codec = ColumnCodec());
 
     // give access to the compressed data to hte caller and put a
     // description of where the data is in "where". Returns the size in
@@ -73,6 +76,11 @@ public:
     off_t GetCompressedSizeBytes();
     off_t GetCompressedSizePages();
     bool GetIsCompressed();
+    // read only access to the GetCompressedSizeBytes() compressed bytes, used to
+    // work on the encoded data directly (see EncodedRunIterator.h)
+    const char* GetCompressedBytes();
+    // the codec the compressed data is compressed with
+    int GetCodec();
 
 
     // access to uncompressed data. Should return the size of
@@ -96,6 +104,12 @@ public:
 
     // Get the mode (readonly or writeonly)
     bool IsWriteMode ();
+    // keep the objects written from now on within the pieces of the storage, so
+    // that they never have to be copied together (see MMappedStorage::AlignObjects)
+    void AlignObjects ();
+    // decompress the whole column now, if it was read compressed from disk
+    // (see MMappedStorage::Decompress)
+    void Decompress ();
     // make the column readonly. It should have been write only up to this point
     void MakeReadonly();
     
@@ -0,0 +1,249 @@
+//
+//  Copyright 2012 Alin Dobra and Christopher Jermaine
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+#ifndef COLUMN_CODEC_H
+#define COLUMN_CODEC_H
+
+#include <cstdint>
+#include <cstring>
+#include <strings.h>
+
+#include "Errors.h"
+#include "IntegerEncodings.h"
+#include "StringDictEncoding.h"
+
+#ifdef USE_LZ4
+#include <lz4.h>
+#endif
+
+#ifdef USE_ZSTD
+#include <zstd.h>
+#endif
+
+/** Codecs a column can be compressed with.
+
+    The codec ID is stored in the metadata of every column of every chunk, so
+    the values below must never change. Columns written before codecs existed
+    have no ID stored and were compressed with QuickLZ, hence CODEC_QUICKLZ is 0.
+
+    CODEC_QUICKLZ: the bundled QuickLZ in streaming mode. The level is fixed at
+        compile time by QLZ_COMPRESSION_LEVEL, the level of the codec is ignored.
+    CODEC_LZ4: fast LZ, meant for hot columns that are scanned all the time.
+        The level is the LZ4 acceleration (1 is the default, larger is faster).
+        Needs -DUSE_LZ4.
+    CODEC_ZSTD: high ratio, meant for cold columns that are seldom read.
+        The level is the Zstd compression level (1-22). Needs -DUSE_ZSTD.
+    CODEC_FOR, CODEC_DELTA, CODEC_RLE: the lightweight encodings for columns of
+        fixed width integers in IntegerEncodings.h. The level is the width of
+        the values in bytes (4 or 8).
+    CODEC_DICT: dictionary encoding for columns of strings, in
+        StringDictEncoding.h. The level is ignored.
+
+    The lightweight encodings are picked per chunk, when they pay off. The
+    general purpose codecs (QuickLZ, LZ4, Zstd) are set per column of a
+    relation, with the level, when it is created (see ColumnCodecByName and
+    FileMetadata::setColumnCodec); the columns without one are only kept
+    uncompressed.
+
+    Every codec compresses the column in COMPRESSION_UNIT pieces so that the
+    column iterators can decompress it a piece at a time (CODEC_DICT cuts them
+    shorter, between strings). QuickLZ pieces carry
+    their own header; the pieces of the other codecs are preceded by a
+    ColumnCodecBlockHeader.
+ */
+enum ColumnCodecID {
+    CODEC_QUICKLZ = 0,
+    CODEC_LZ4 = 1,
+    CODEC_ZSTD = 2,
+    CODEC_FOR = 3,
+    CODEC_DELTA = 4,
+    CODEC_RLE = 5,
+    CODEC_DICT = 6
+};
+
+// the IntEncodingKind a codec uses, INT_ENC_RAW if it is not an integer encoding
+inline int ColumnCodecIntEncoding(int codec) {
+    switch (codec) {
+        case CODEC_FOR:
+            return INT_ENC_FOR;
+        case CODEC_DELTA:
+            return INT_ENC_DELTA;
+        case CODEC_RLE:
+            return INT_ENC_RLE;
+        default:
+            return INT_ENC_RAW;
+    }
+}
+
+// the codec and level picked for a column when it gets compressed
+struct ColumnCodec {
+    int id;
+    int level;
+
+    ColumnCodec(int _id = CODEC_QUICKLZ, int _level = 0):
+        id(_id),
+        level(_level)
+    {}
+};
+
+// header in front of every compressed piece of the codecs other than QuickLZ
+struct ColumnCodecBlockHeader {
+    uint32_t compressedSize; // size of the compressed payload that follows
+    uint32_t decompressedSize;
+};
+
+// returns true if this build can compress and decompress with the codec
+inline bool ColumnCodecSupported(int codec) {
+    switch (codec) {
+        case CODEC_QUICKLZ:
+        case CODEC_FOR:
+        case CODEC_DELTA:
+        case CODEC_RLE:
+        case CODEC_DICT:
+            return true;
+#ifdef USE_LZ4
+        case CODEC_LZ4:
+            return true;
+#endif
+#ifdef USE_ZSTD
+        case CODEC_ZSTD:
+            return true;
+#endif
+        default:
+            return false;
+    }
+}
+
+// the general purpose codec called name (quicklz, lz4 or zstd, in any case), -1 if there is none
+inline int ColumnCodecByName(const char* name) {
+    if (strcasecmp(name, "quicklz") == 0)
+        return CODEC_QUICKLZ;
+    if (strcasecmp(name, "lz4") == 0)
+        return CODEC_LZ4;
+    if (strcasecmp(name, "zstd") == 0)
+        return CODEC_ZSTD;
+    return -1;
+}
+
+// largest compressed size, header included, of a piece of size bytes; not used for QuickLZ
+inline uint64_t ColumnCodecBlockBound(int codec, uint64_t size) {
+    uint64_t bound = 0;
+    switch (codec) {
+        case CODEC_FOR:
+        case CODEC_DELTA:
+        case CODEC_RLE:
+            bound = IntEncBound(size);
+            break;
+        case CODEC_DICT:
+            bound = DictEncBound(size);
+            break;
+#ifdef USE_LZ4
+        case CODEC_LZ4:
+            bound = LZ4_compressBound(size);
+            break;
+#endif
+#ifdef USE_ZSTD
+        case CODEC_ZSTD:
+            bound = ZSTD_compressBound(size);
+            break;
+#endif
+        default:
+            FATAL("Column codec %d is not supported by this build", codec);
+    }
+    return sizeof(ColumnCodecBlockHeader) + bound;
+}
+
+// compresses a piece of size bytes into dest, that must have room for
+// ColumnCodecBlockBound bytes; returns the bytes written, header included
+inline uint64_t ColumnCodecCompressBlock(int codec, int level, const char* src, uint64_t size, char* dest) {
+    char* payload = dest + sizeof(ColumnCodecBlockHeader);
+    uint64_t cSize = 0;
+    switch (codec) {
+        case CODEC_FOR:
+        case CODEC_DELTA:
+        case CODEC_RLE:
+            cSize = IntEncEncode(ColumnCodecIntEncoding(codec), level, src, size, payload);
+            break;
+        case CODEC_DICT:
+            cSize = DictEncEncode(src, size, payload);
+            break;
+#ifdef USE_LZ4
+        case CODEC_LZ4:
+            cSize = LZ4_compress_fast(src, payload, size, LZ4_compressBound(size),
+                    level > 0 ? level : 1);
+            FATALIF(cSize == 0, "LZ4 failed to compress a column piece of %lu bytes", size);
+            break;
+#endif
+#ifdef USE_ZSTD
+        case CODEC_ZSTD: {
+            size_t rez = ZSTD_compress(payload, ZSTD_compressBound(size), src, size,
+                    level > 0 ? level : ZSTD_CLEVEL_DEFAULT);
+            FATALIF(ZSTD_isError(rez), "Zstd failed to compress a column piece: %s", ZSTD_getErrorName(rez));
+            cSize = rez;
+            break;
+        }
+#endif
+        default:
+            FATAL("Column codec %d is not supported by this build", codec);
+    }
+
+    ColumnCodecBlockHeader header;
+    header.compressedSize = cSize;
+    header.decompressedSize = size;
+    memcpy(dest, &header, sizeof(header));
+
+    return sizeof(header) + cSize;
+}
+
+// decompresses the piece at src into dest; returns the decompressed size and puts
+// in compressedSize the bytes the piece takes, header included
+inline uint64_t ColumnCodecDecompressBlock(int codec, const char* src, char* dest, uint64_t& compressedSize) {
+    ColumnCodecBlockHeader header;
+    memcpy(&header, src, sizeof(header));
+    const char* payload = src + sizeof(header);
+
+    switch (codec) {
+        case CODEC_FOR:
+        case CODEC_DELTA:
+        case CODEC_RLE:
+            IntEncDecode(payload, header.compressedSize, dest, header.decompressedSize);
+            break;
+        case CODEC_DICT:
+            DictEncDecode(payload, header.compressedSize, dest, header.decompressedSize);
+            break;
+#ifdef USE_LZ4
+        case CODEC_LZ4: {
+            int rez = LZ4_decompress_safe(payload, dest, header.compressedSize, header.decompressedSize);
+            FATALIF(rez != (int) header.decompressedSize, "Corrupted LZ4 column piece");
+            break;
+        }
+#endif
+#ifdef USE_ZSTD
+        case CODEC_ZSTD: {
+            size_t rez = ZSTD_decompress(dest, header.decompressedSize, payload, header.compressedSize);
+            FATALIF(ZSTD_isError(rez) || rez != header.decompressedSize, "Corrupted Zstd column piece");
+            break;
+        }
+#endif
+        default:
+            FATAL("Column codec %d is not supported by this build", codec);
+    }
+
+    compressedSize = sizeof(header) + header.compressedSize;
+    return header.decompressedSize;
+}
+
+#endif // COLUMN_CODEC_H
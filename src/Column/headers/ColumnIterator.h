@@ -62,6 +62,18 @@ class ColumnIterator {
         // advance to the next object in the column...
         void Advance ();
 
+        // returns the objects from the current position on that are in memory one
+        // after the other, so that tight loops can go over them without the
+        // iterator; count gets their number, at most maxCount, and is 0 at the end
+        // of the column. A batch ends where the bytes the column gave us in one
+        // piece end; if the column had to copy pieces of its storage together to
+        // give us a step, the batch is in that copy. Only for flat types stored
+        // as their raw bytes (headerSize = 0, dtSize = sizeof(DataType))
+        const DataType* GetBatch (uint64_t maxCount, uint64_t &count);
+
+        // advance over n objects, usually the count of the last GetBatch ()
+        void AdvanceBy (uint64_t n);
+
         // add a new data object into the column at the current position, overwriting the
         // bytes that are already there.  Note that if the size of addMe differs from the
         // size of the object that is already there, addMe will over-run part of the next
@@ -135,6 +147,22 @@ inline void ColumnIterator <DataType, headerSize, dtSize > :: Advance () {
 }
 
 
+template <class DataType, uint64_t headerSize, uint64_t dtSize >
+inline const DataType* ColumnIterator <DataType, headerSize, dtSize > :: GetBatch (uint64_t maxCount, uint64_t &count) {
+    static_assert(headerSize == 0 && dtSize == sizeof(DataType), "Batches need objects stored as raw bytes");
+
+    count = it.ContiguousBytes () / sizeof(DataType);
+    if (count > maxCount)
+        count = maxCount;
+    return (const DataType*) it.GetData();
+}
+
+template <class DataType, uint64_t headerSize, uint64_t dtSize >
+inline void ColumnIterator <DataType, headerSize, dtSize > :: AdvanceBy (uint64_t n) {
+    it.Skip (n * dtSize);
+}
+
+
 template <class DataType, uint64_t headerSize, uint64_t dtSize >
 inline void ColumnIterator <DataType, headerSize, dtSize > :: Restart () {
     it.Restart();
@@ -18,6 +18,7 @@
 #define COL_STOR_H
 
 #include "RawStorageDesc.h"
+#include "ColumnCodec.h"
 #include "DistributedCounter.h"
 
 #include <utility>
@@ -102,7 +103,10 @@ public:
 
 	// API to compress and get access to the raw data. This is used by the IO subsystem
 	// see Column.h for the explanation of how they behave
-	virtual void Compress(bool deleteDecompressed)=0;
+	virtual void Compress(bool deleteDecompressed, ColumnCodec codec)=0;
+
+	// Get the codec the storage is compressed with
+	virtual int GetCodec() = 0;
 
 	// Get the handle of the compressed storage
 	virtual void GetCompressed(RawStorageList& where)=0;
@@ -110,6 +114,9 @@ public:
 	// Get the compressed size in bytes
 	virtual off_t GetCompressedSizeBytes() = 0;
 
+	// Get read access to the compressed bytes, without decompressing them
+	virtual const char* GetCompressedBytes() = 0;
+
 	// Get the compressed size in pages
 	virtual off_t GetCompressedSizePages() = 0;
 
@@ -78,6 +78,10 @@ ColumnVarIterator<DataType, headerSize, dtSize> :: ColumnVarIterator( Column &it
     if( it.IsInvalid() )
         return;
 
+    // the objects can be large, keep them out of the bridge of the storage
+    if( it.IsWriteOnly() )
+        it.AlignObjects();
+
     if( !it.IsWriteOnly() && !it.AtUnwrittenByte() ) {
         it.EnsureHeaderSpace();
         size_t serializedSize = SizeFromBuffer<DataType>(it.GetData());
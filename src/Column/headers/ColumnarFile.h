@@ -0,0 +1,270 @@
+//
+//  Copyright 2012 Alin Dobra and Christopher Jermaine
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+#ifndef COLUMNAR_FILE_H
+#define COLUMNAR_FILE_H
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "Errors.h"
+#include "MmapAllocator.h"
+#include "Column.h"
+#include "MMappedStorage.h"
+
+/** Columnar files: the results written by Print with the "columnar" type, laid
+    out like Arrow IPC so that other tools can mmap them and use the buffers in
+    place, and read back into columns by the ColumnarReader GI.
+
+    The file is:
+
+        ColumnarFileHeader
+        the names of the columns, each followed by a '\0'
+        the batches, one per chunk printed, in no particular order
+        a ColumnarBatchHeader with no tuples and a length of 0, the end
+
+    A batch is a ColumnarBatchHeader, a ColumnarColumnDesc for every column,
+    then the buffers of the columns. Every batch and every buffer starts at a
+    multiple of COLUMNAR_ALIGNMENT bytes from the start of the file. The gaps
+    are filled with 0s.
+
+    Every column has three buffers, any of them might be empty:
+
+    validity: a bit per tuple, least significant bit first, set if the value is
+        not null. Empty if no value is null.
+    offsets: for COLUMNAR_STRING, numTuples + 1 int64_t; value i is
+        values[offsets[i], offsets[i+1]). Empty for COLUMNAR_FIXED.
+    values: for COLUMNAR_FIXED, numTuples values of width bytes, exactly as
+        the column keeps them; for COLUMNAR_STRING, the bytes of all the
+        strings, without terminators.
+
+    The types keep their nulls in band (e.g. -1 for INT), so the values of the
+    nulls are written as they are. The validity buffer is only filled for the
+    types with an IsNull () method (STRING, ...).
+
+    Everything is in the byte order of the machine that wrote the file.
+ */
+
+#define COLUMNAR_MAGIC "GRKCOL01"
+#define COLUMNAR_VERSION 1
+#define COLUMNAR_ALIGNMENT 64
+
+enum ColumnarKind {
+    COLUMNAR_FIXED = 0,
+    COLUMNAR_STRING = 1
+};
+
+struct ColumnarFileHeader {
+    char magic[8]; // COLUMNAR_MAGIC, no terminator
+    uint32_t version;
+    uint32_t numColumns;
+    uint64_t namesLength; // bytes of names that follow, the batches start at the next multiple of COLUMNAR_ALIGNMENT
+};
+
+struct ColumnarBatchHeader {
+    uint64_t numTuples;
+    uint64_t length; // bytes of the whole batch, header and padding included
+};
+
+// a buffer of a column of a batch, offset is from the start of the batch
+struct ColumnarBuffer {
+    uint64_t offset;
+    uint64_t length;
+};
+
+struct ColumnarColumnDesc {
+    uint32_t kind; // ColumnarKind
+    uint32_t width; // bytes of a value for COLUMNAR_FIXED, 0 otherwise
+    ColumnarBuffer validity;
+    ColumnarBuffer offsets;
+    ColumnarBuffer values;
+};
+
+inline uint64_t ColumnarAlign(uint64_t pos) {
+    return (pos + COLUMNAR_ALIGNMENT - 1) / COLUMNAR_ALIGNMENT * COLUMNAR_ALIGNMENT;
+}
+
+// true if x is the null of its type; only the types with an IsNull () method
+// are asked, the others are never null
+template <class T>
+inline auto ColumnarIsNullImp(const T& x, int) -> decltype((bool) x.IsNull()) {
+    return x.IsNull();
+}
+
+template <class T>
+inline bool ColumnarIsNullImp(const T& x, long) {
+    return false;
+}
+
+template <class T>
+inline bool ColumnarIsNull(const T& x) {
+    return ColumnarIsNullImp(x, 0);
+}
+
+// writes the start of a columnar file, names are the names of the columns
+void ColumnarWriteFileHeader(FILE* file, const std::vector<std::string>& names);
+
+// writes the end of a columnar file
+void ColumnarWriteEnd(FILE* file);
+
+/** The values of a chunk, gathered a tuple at a time, to be written as a
+    batch. The types of the columns are set by the first value added to them.
+ */
+class ColumnarBatch {
+
+    struct ColumnData {
+        uint32_t kind;
+        uint32_t width;
+        bool anyNull;
+        std::vector<char> values;
+        std::vector<int64_t> offsets;
+        std::vector<uint8_t> validity;
+
+        ColumnData():
+            kind(COLUMNAR_FIXED),
+            width(0),
+            anyNull(false),
+            offsets(1, 0)
+        {}
+    };
+
+    std::vector<ColumnData> columns;
+    uint64_t numTuples;
+
+    void SetValid(ColumnData& col, bool isNull);
+
+public:
+
+    ColumnarBatch(int numColumns);
+
+    // the value of column col of the current tuple, for the fixed size types
+    template <class T>
+    void AddFixed(int col, const T& value, bool isNull);
+
+    // same, for strings
+    void AddString(int col, const char* str, uint64_t length, bool isNull);
+
+    // all the columns of the current tuple were added
+    void EndTuple();
+
+    uint64_t GetNumTuples() { return numTuples; }
+
+    // appends the batch to the file, as a single write as far as other threads
+    // writing the same file are concerned, and empties the batch
+    void Write(FILE* file);
+};
+
+/** Reader of columnar files. The file is mmapped and the columns of a batch are
+    copied straight into Column storage, one memcpy per buffer for the fixed
+    size types. */
+class ColumnarFileReader {
+
+    int fd;
+    char* data;
+    uint64_t size;
+
+    std::vector<std::string> names;
+
+    // offset of the current batch in the file and its header
+    uint64_t batch;
+    uint64_t nextBatch;
+    ColumnarBatchHeader header;
+
+    const ColumnarColumnDesc& Desc(int col);
+
+    // the buffer of the current batch, checked to be within the file
+    const char* Buffer(const ColumnarBuffer& buffer);
+
+    // true if value i of the column is null, validity might be NULL
+    static bool IsNull(const char* validity, uint64_t i);
+
+public:
+
+    // FATALs if the file cannot be opened or is not a columnar file
+    ColumnarFileReader(const char* fileName);
+    ~ColumnarFileReader();
+
+    int GetNumColumns() { return names.size(); }
+    const std::string& GetName(int col) { return names[col]; }
+
+    // moves to the next batch, false if there is none
+    bool NextBatch();
+
+    uint64_t GetNumTuples() { return header.numTuples; }
+
+    // puts column col of the current batch in where, as a read only column of
+    // values of width bytes
+    void GetFixedColumn(int col, uint32_t width, Column& where);
+
+    // same for a column of strings, kept by the column as null terminated
+    // strings; the nulls are replaced by nullStr (with its terminator)
+    void GetStringColumn(int col, const char* nullStr, Column& where);
+};
+
+/*** Here goes the inline definitions **/
+
+inline
+void ColumnarBatch :: SetValid(ColumnData& col, bool isNull) {
+    uint64_t i = numTuples;
+    if (i % 8 == 0)
+        col.validity.push_back(0);
+    if (isNull)
+        col.anyNull = true;
+    else
+        col.validity.back() |= 1 << (i % 8);
+}
+
+template <class T>
+inline
+void ColumnarBatch :: AddFixed(int col, const T& value, bool isNull) {
+    ColumnData& column = columns[col];
+    column.kind = COLUMNAR_FIXED;
+    column.width = sizeof(T);
+    const char* bytes = (const char*) &value;
+    column.values.insert(column.values.end(), bytes, bytes + sizeof(T));
+    SetValid(column, isNull);
+}
+
+inline
+void ColumnarBatch :: AddString(int col, const char* str, uint64_t length, bool isNull) {
+    ColumnData& column = columns[col];
+    column.kind = COLUMNAR_STRING;
+    column.width = 0;
+    if (!isNull)
+        column.values.insert(column.values.end(), str, str + length);
+    column.offsets.push_back(column.values.size());
+    SetValid(column, isNull);
+}
+
+inline
+void ColumnarBatch :: EndTuple() {
+    numTuples++;
+}
+
+inline
+bool ColumnarFileReader :: IsNull(const char* validity, uint64_t i) {
+    return validity != NULL && (validity[i / 8] & (1 << (i % 8))) == 0;
+}
+
+#endif // COLUMNAR_FILE_H
@@ -26,6 +26,7 @@
 #include "Errors.h"
 #include "Constants.h"
 #include "StorageUnit.h"
+#include "ColumnCodec.h"
 
 // Compression algorithm
 #define QLZ_COMPRESSION_LEVEL 3
@@ -36,7 +37,7 @@
 //#define COMPRESS_ALL_AT_ONCE 1
 
 // this structure is used by the mmapped storage to store all of its chunks of memory in compressed form
-// which is received from user
+// which is received from user. The data is compressed with the codec of the column (see ColumnCodec.h)
 struct CompressedStorageUnit {
 
     private:
@@ -53,6 +54,9 @@ struct CompressedStorageUnit {
         // total compressed size
         uint64_t compressedSize;
 
+        // bytes allocated for compressedBytes
+        uint64_t compressedSpace;
+
         // how much we decompressed in last call
         uint64_t lastDecompressedLength;
 
@@ -65,6 +69,14 @@ struct CompressedStorageUnit {
         // numa node
         uint64_t numa;
 
+        // codec the data is compressed with and the level used to compress it
+        int codec;
+        int level;
+
+        // decompress the piece starting at compressedBytes+nextCompress into dest
+        // returns the decompressed size, csize is set to the size of the compressed piece
+        uint64_t DecompressPiece(char* dest, uint64_t& csize);
+
     public:
 
         /// -------------------- Functions ------------------//
@@ -72,11 +84,18 @@ struct CompressedStorageUnit {
         // numa not needed here since this is supposed to be used only for swapping
         CompressedStorageUnit ();
 
-        // decompressed data constructor
-        CompressedStorageUnit(uint64_t _dataSize, uint64_t _numa = 0);
+        // decompressed data constructor, the data will be compressed with _codec
+        // _compressedSpace is the room to allocate for the compressed data, 0 means
+        // MaxCompressedSize(_codec, _dataSize)
+        CompressedStorageUnit(uint64_t _dataSize, uint64_t _numa = 0, ColumnCodec _codec = ColumnCodec(),
+                uint64_t _compressedSpace = 0);
         // compressed data constructor, where is the sister storage unit
-        // that accesses teh decompressed data
-        CompressedStorageUnit(char* _data, uint64_t _dataSize, uint64_t _compressedSize, StorageUnit& where, uint64_t _numa = 0);
+        // that accesses teh decompressed data. _codec is the one the data was compressed with
+        CompressedStorageUnit(char* _data, uint64_t _dataSize, uint64_t _compressedSize, StorageUnit& where,
+                uint64_t _numa = 0, int _codec = CODEC_QUICKLZ);
+
+        // space needed to compress a storage unit of dataSize bytes with the codec
+        static uint64_t MaxCompressedSize(int codec, uint64_t dataSize);
 
         // states are local to object and are created and destroyed with object.
         // in case of deep and shallow copies, they are created new and not copied
@@ -104,6 +123,10 @@ struct CompressedStorageUnit {
         // beggining of the buffer, not continuously
         uint64_t DecompressInPlace(uint64_t posToStartFrom, uint64_t decompress_position);
 
+        // decompress all the data, from the beggining, into the decompressed
+        // buffer. Whatever was decompressed before is dropped
+        uint64_t DecompressAll();
+
         // does a simple copy
         void copy (CompressedStorageUnit &fromMe);
 
@@ -122,6 +145,12 @@ struct CompressedStorageUnit {
         uint64_t GetCompressedSize();
 
         bool GetIsCompressed(){ return compressedSize>0; }
+
+        // Get the codec the data is compressed with
+        int GetCodec(){ return codec; }
+
+        // Get the compressed pieces, GetCompressedSize() bytes of them
+        const char* GetCompressedBytes(){ return compressedBytes; }
 };
 
 //////////////////// inline Definitions ///////////////////////////////
@@ -141,27 +170,64 @@ inline 	void CompressedStorageUnit::AddCompressedRawStorage(RawStorageList& out)
 inline
 CompressedStorageUnit::CompressedStorageUnit() : decompressedBytes(NULL), nextDecompress(0),
     compressedBytes(NULL), nextCompress(0), decompressedSize(0), compressedSize(0),
-    state_compress(NULL), state_decompress(NULL){}
+    compressedSpace(0), state_compress(NULL), state_decompress(NULL), codec(CODEC_QUICKLZ), level(0){}
+
+inline
+uint64_t CompressedStorageUnit::MaxCompressedSize(int codec, uint64_t dataSize) {
+    if (codec == CODEC_QUICKLZ)
+        return dataSize + QLZ_EXTRA_SPACE;
+
+    // every piece gets its own header and worst case expansion
+#ifndef COMPRESS_ALL_AT_ONCE
+    if (codec == CODEC_DICT) {
+        // the pieces are cut between strings, at least half a unit long
+        uint64_t pieces = 2 * (dataSize / COMPRESSION_UNIT) + 2;
+        return pieces * ColumnCodecBlockBound(codec, 0) + dataSize;
+    }
+
+    uint64_t fullPieces = dataSize / COMPRESSION_UNIT;
+    uint64_t lastPiece = dataSize % COMPRESSION_UNIT;
+    uint64_t rez = fullPieces * ColumnCodecBlockBound(codec, COMPRESSION_UNIT);
+    if (lastPiece > 0)
+        rez += ColumnCodecBlockBound(codec, lastPiece);
+    return rez;
+#else
+    return ColumnCodecBlockBound(codec, dataSize);
+#endif
+}
 
     inline /* data is decompressed, we'll compress */
-    CompressedStorageUnit::CompressedStorageUnit(uint64_t _decompressedSize, uint64_t _numa):
+    CompressedStorageUnit::CompressedStorageUnit(uint64_t _decompressedSize, uint64_t _numa, ColumnCodec _codec,
+            uint64_t _compressedSpace):
         decompressedBytes(NULL),
         nextDecompress(0),
-        compressedBytes((char*) mmap_alloc(_decompressedSize + QLZ_EXTRA_SPACE, _numa)),
+        compressedBytes(NULL),
         nextCompress(0),
         decompressedSize(_decompressedSize),
         compressedSize(0),
-        state_compress((qlz_state_compress *)malloc(sizeof(qlz_state_compress))),
+        compressedSpace(_compressedSpace),
+        state_compress(NULL),
         state_decompress(NULL),
-        numa(_numa)
+        numa(_numa),
+        codec(_codec.id),
+        level(_codec.level)
 {
-    // zero out the state_compress
-    memset(state_compress, 0, sizeof(qlz_state_compress));
+    FATALIF(!ColumnCodecSupported(codec), "Column codec %d is not supported by this build", codec);
+
+    if (compressedSpace == 0)
+        compressedSpace = MaxCompressedSize(codec, _decompressedSize);
+    compressedBytes = (char*) mmap_alloc(compressedSpace, _numa);
+
+    if (codec == CODEC_QUICKLZ) {
+        // zero out the state_compress
+        state_compress = (qlz_state_compress *)malloc(sizeof(qlz_state_compress));
+        memset(state_compress, 0, sizeof(qlz_state_compress));
+    }
 }
 
 inline /** data is compressed */
 CompressedStorageUnit::CompressedStorageUnit(char* _data, uint64_t _decompressedSize,
-        uint64_t _compressedSize, StorageUnit& where, uint64_t _numa):
+        uint64_t _compressedSize, StorageUnit& where, uint64_t _numa, int _codec):
     decompressedBytes((char*) mmap_alloc(_decompressedSize, _numa)),
     nextDecompress(0),
     compressedBytes(_data),
@@ -169,18 +235,29 @@ CompressedStorageUnit::CompressedStorageUnit(char* _data, uint64_t _decompressed
     decompressedSize(_decompressedSize),
     //decompressedSize(qlz_size_decompressed(_data)),
     compressedSize(_compressedSize),
+    compressedSpace(_compressedSize),
     state_compress(NULL),
-    state_decompress((qlz_state_decompress *)malloc(sizeof(qlz_state_decompress))),
-    numa(_numa)
+    state_decompress(NULL),
+    numa(_numa),
+    codec(_codec),
+    level(0)
 {
+    FATALIF(!ColumnCodecSupported(codec), "Column compressed with codec %d, which is not supported by this build", codec);
+
     // create sister storage unit
     where.bytes=decompressedBytes;
     where.start=0;
     where.end=decompressedSize - 1;
-    // zero out the state_compress
-    memset(state_decompress, 0, sizeof(qlz_state_decompress));
 
-    assert(decompressedSize == qlz_size_decompressed(_data));
+    if (codec == CODEC_QUICKLZ) {
+        // zero out the state_decompress
+        state_decompress = (qlz_state_decompress *)malloc(sizeof(qlz_state_decompress));
+        memset(state_decompress, 0, sizeof(qlz_state_decompress));
+
+        // every COMPRESSION_UNIT piece has its own header, the first one only
+        // knows about itself
+        assert(qlz_size_decompressed(_data) <= decompressedSize);
+    }
 }
 
 inline
@@ -239,11 +316,21 @@ void CompressedStorageUnit::CreateDeepCopy(CompressedStorageUnit &withMe) {
 
     // create a deep copy of compressed bytes
     if (compressedBytes) {
-        withMe.compressedBytes = (char*) mmap_alloc (decompressedSize+QLZ_EXTRA_SPACE, withMe.numa);
+        withMe.compressedBytes = (char*) mmap_alloc (compressedSpace, withMe.numa);
         memmove(withMe.compressedBytes, compressedBytes, nextCompress);
     }
 }
 
+inline
+uint64_t CompressedStorageUnit::DecompressPiece(char* dest, uint64_t& csize) {
+    if (codec == CODEC_QUICKLZ) {
+        csize = qlz_size_compressed(compressedBytes+nextCompress);
+        return qlz_decompress(compressedBytes+nextCompress, dest, state_decompress);
+    } else {
+        return ColumnCodecDecompressBlock(codec, compressedBytes+nextCompress, dest, csize);
+    }
+}
+
 // This works in streaming mode internally, see quicklz.h flags
 inline
 uint64_t CompressedStorageUnit::DecompressUpTo(uint64_t decompress_position) {
@@ -253,11 +340,9 @@ uint64_t CompressedStorageUnit::DecompressUpTo(uint64_t decompress_position) {
 
     // we go in a loop until we stream-decompressed enough
     while (decompress_position > nextDecompress){
-        uint64_t csize = qlz_size_compressed(compressedBytes+nextCompress);
+        uint64_t csize;
 
-        nextDecompress += qlz_decompress(compressedBytes+nextCompress,
-                decompressedBytes+nextDecompress,
-                state_decompress);
+        nextDecompress += DecompressPiece(decompressedBytes+nextDecompress, csize);
         nextCompress+=csize;
     }
 
@@ -320,12 +405,9 @@ uint64_t CompressedStorageUnit::DecompressInPlace(uint64_t posToStartFrom, uint6
 while (decompress_position > nextDecompress){
     // printf("\ndnexxxxxxxxxxxxxttttttttttttttttttttttttttttttttttt of decompressed buffer = %d %lx\n", dNext, decompressedBytes);
 
-    uint64_t csize = qlz_size_compressed(compressedBytes+nextCompress);
+    uint64_t csize;
 
-
-    uint64_t dsize = qlz_decompress(compressedBytes+nextCompress,
-            decompressedBytes+dNext,
-            state_decompress);
+    uint64_t dsize = DecompressPiece(decompressedBytes+dNext, csize);
     nextCompress+=csize;
     nextDecompress +=dsize;
     dNext +=dsize;
@@ -336,6 +418,18 @@ lastDecompressedLength = dNext;
 return nextDecompress;
 }
 
+inline
+uint64_t CompressedStorageUnit::DecompressAll() {
+    // restart the stream, the in place decompression might have used the buffer
+    nextDecompress = 0;
+    nextCompress = 0;
+    lastDecompressedLength = 0;
+    if (state_decompress)
+        memset(state_decompress, 0, sizeof(qlz_state_decompress));
+
+    return DecompressUpTo(decompressedSize);
+}
+
 // does a simple copy
 inline
 void CompressedStorageUnit::copy (CompressedStorageUnit &fromMe) {
@@ -378,14 +472,26 @@ void CompressedStorageUnit::CompressThisStorageUnit(StorageUnit& unit){
 #else
     uint64_t sizeToCompress = unit.Size();
 #endif
+    // the last storage unit is usually not full; compress only the bytes of the column
+    // since the decompressed buffer is allocated for decompressedSize bytes
     uint64_t size = unit.Size();
+    if (unit.start + size > decompressedSize)
+        size = unit.start < decompressedSize ? decompressedSize - unit.start : 0;
     while (num < size) {
         if (num + sizeToCompress > size)
             sizeToCompress = size - num;
-        uint64_t cSize = qlz_compress((const char*)unit.bytes + num, compressedBytes+nextCompress,
-                sizeToCompress, state_compress);
+        uint64_t pieceSize = sizeToCompress;
+        if (codec == CODEC_DICT)
+            pieceSize = DictEncCut((const char*)unit.bytes + num, sizeToCompress);
+        uint64_t cSize;
+        if (codec == CODEC_QUICKLZ)
+            cSize = qlz_compress((const char*)unit.bytes + num, compressedBytes+nextCompress,
+                    sizeToCompress, state_compress);
+        else
+            cSize = ColumnCodecCompressBlock(codec, level, (const char*)unit.bytes + num,
+                    pieceSize, compressedBytes+nextCompress);
         nextCompress += cSize;
-        num += sizeToCompress;
+        num += pieceSize;
     }
     // set the compressedSize to what we compressed so far
     compressedSize = nextCompress;
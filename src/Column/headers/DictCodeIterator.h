@@ -0,0 +1,310 @@
+//
+//  Copyright 2012 Alin Dobra and Christopher Jermaine
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+#ifndef DICT_CODE_ITERATOR_H
+#define DICT_CODE_ITERATOR_H
+
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#include "Column.h"
+#include "ColumnCodec.h"
+#include "HashFunctions.h"
+#include "StringDictEncoding.h"
+
+// chunk code of the piece codes not translated yet
+const uint32_t DICT_NO_CHUNK_CODE = UINT32_MAX;
+
+/** Read only iterator over a column of strings compressed with CODEC_DICT. It
+    works on the encoded pieces directly, nothing is decompressed, and gives for
+    every string its code in the dictionary of its piece and the entry of the
+    code, a null terminated string inside the column.
+
+    The codes are local to the pieces: NewPiece() tells when a new dictionary
+    starts. The iterator also keeps a dictionary of the whole chunk, that the
+    strings of the pieces are merged into as they are read, and translates the
+    code of every string to its code in the chunk (as the local dictionaries of
+    FACTOR are merged into the global one, see DictionaryManager). The chunk
+    codes are given out in the order GetChunkCode() first returns them, 0, 1,
+    2...; a code equal to the number of codes seen so far is new.
+
+    The generated code uses the chunk codes to evaluate predicates once per
+    distinct string of the chunk, and to hash the strings of join keys and
+    group by keys once, looking the hash or the group up by code for the other
+    tuples.
+
+    If the column is not encoded that way, or a piece is raw or splits a
+    string, the iterator is not valid and the caller should go through the
+    column with its usual iterator instead.
+
+    The iterator does not own the column; the column must stay alive, and
+    unchanged, while the iterator is used. All functions are inlined.
+*/
+class DictCodeIterator {
+
+private:
+
+    // the compressed pieces of the column
+    const char* data;
+    uint64_t dataSize;
+
+    // offset in data of the piece after the current one
+    uint64_t nextPiece;
+
+    bool valid;
+
+    // the current piece
+    DictEncHeader header;
+    const char* offsets;
+    const char* entries;
+    const char* codes;
+
+    // the current string in the piece
+    uint64_t index;
+    bool newPiece;
+
+    // the dictionary of the chunk: the distinct strings by chunk code, and an
+    // open addressing table of chunk code + 1, 0 for empty
+    std::vector<const char*> chunkEntries;
+    std::vector<uint32_t> chunkLengths;
+    std::vector<uint32_t> chunkTable;
+
+    // the chunk code of every code of the current piece, DICT_NO_CHUNK_CODE if
+    // the code was not translated yet
+    std::vector<uint32_t> translation;
+
+    // moves to the next piece with strings; returns false if there is none
+    bool StartPiece ();
+
+    // finds the string of code of the current piece in the dictionary of the
+    // chunk, adds it if new
+    uint32_t Translate (uint32_t code);
+
+public:
+
+    DictCodeIterator (Column& iterateMe);
+
+    // true if the column is dictionary encoded and the codes can be used
+    bool IsValid ();
+
+    // true past the last string
+    bool AtEnd ();
+
+    // true if the current string is the first of a piece, the codes and the
+    // entries start over
+    bool NewPiece ();
+
+    // number of entries in the dictionary of the current piece
+    uint32_t GetNumEntries ();
+
+    // code of the current string
+    uint32_t GetCode ();
+
+    // the string of code in the current piece
+    const char* GetEntry (uint32_t code);
+
+    // code of the current string in the dictionary of the chunk
+    uint32_t GetChunkCode ();
+
+    // number of chunk codes given out so far
+    uint32_t GetNumChunkEntries ();
+
+    // the string of a chunk code
+    const char* GetChunkEntry (uint32_t chunkCode);
+
+    // moves to the next string
+    void Advance ();
+};
+
+/*** Here goes the inline definitions **/
+
+inline
+DictCodeIterator :: DictCodeIterator (Column& iterateMe):
+    data(NULL),
+    dataSize(0),
+    nextPiece(0),
+    valid(false),
+    offsets(NULL),
+    entries(NULL),
+    codes(NULL),
+    index(0),
+    newPiece(false)
+{
+    memset(&header, 0, sizeof(header));
+
+    if (!iterateMe.IsValid() || !iterateMe.GetIsCompressed() ||
+            iterateMe.GetCodec() != CODEC_DICT)
+        return;
+
+    data = iterateMe.GetCompressedBytes();
+    dataSize = iterateMe.GetCompressedSizeBytes();
+
+    // check that every piece is encoded and has whole strings, before we
+    // commit to the codes; this only reads the headers
+    uint64_t pos = 0;
+    while (pos < dataSize) {
+        ColumnCodecBlockHeader block;
+        DictEncHeader piece;
+        if (pos + sizeof(block) + sizeof(piece) > dataSize)
+            return;
+        memcpy(&block, data + pos, sizeof(block));
+        memcpy(&piece, data + pos + sizeof(block), sizeof(piece));
+        if (piece.codeWidth == 0 || !piece.terminated)
+            return;
+        pos += sizeof(block) + block.compressedSize;
+    }
+    if (pos != dataSize)
+        return;
+
+    valid = true;
+    StartPiece();
+}
+
+inline
+bool DictCodeIterator :: IsValid () {
+    return valid;
+}
+
+inline
+bool DictCodeIterator :: StartPiece () {
+    do {
+        if (nextPiece >= dataSize) {
+            header.numCodes = 0;
+            index = 0;
+            return false;
+        }
+
+        ColumnCodecBlockHeader block;
+        memcpy(&block, data + nextPiece, sizeof(block));
+        memcpy(&header, data + nextPiece + sizeof(block), sizeof(header));
+
+        offsets = data + nextPiece + sizeof(block) + sizeof(header);
+        entries = offsets + (header.numEntries + 1) * sizeof(uint32_t);
+        codes = entries + header.entriesSize;
+        index = 0;
+        newPiece = true;
+        translation.assign(header.numEntries, DICT_NO_CHUNK_CODE);
+
+        nextPiece += sizeof(block) + block.compressedSize;
+    } while (header.numCodes == 0);
+
+    return true;
+}
+
+inline
+bool DictCodeIterator :: AtEnd () {
+    return index >= header.numCodes;
+}
+
+inline
+bool DictCodeIterator :: NewPiece () {
+    return newPiece;
+}
+
+inline
+uint32_t DictCodeIterator :: GetNumEntries () {
+    return header.numEntries;
+}
+
+inline
+uint32_t DictCodeIterator :: GetCode () {
+    return DictEncGetCode(codes, index, header.codeWidth);
+}
+
+inline
+const char* DictCodeIterator :: GetEntry (uint32_t code) {
+    return entries + DictEncGetOffset(offsets, code);
+}
+
+inline
+uint32_t DictCodeIterator :: Translate (uint32_t code) {
+    const char* entry = GetEntry(code);
+    uint32_t length = DictEncGetOffset(offsets, code + 1) - DictEncGetOffset(offsets, code);
+
+    // keep the table at most half full
+    if (2 * (chunkEntries.size() + 1) > chunkTable.size()) {
+        uint64_t tableSize = chunkTable.empty() ? 16 : 2 * chunkTable.size();
+        std::vector<uint32_t> bigger(tableSize, 0);
+        for (uint32_t e = 0; e < chunkEntries.size(); e++) {
+            uint64_t s = DictEncHash(chunkEntries[e], chunkLengths[e]) & (tableSize - 1);
+            while (bigger[s] != 0)
+                s = (s + 1) & (tableSize - 1);
+            bigger[s] = e + 1;
+        }
+        chunkTable.swap(bigger);
+    }
+
+    uint64_t mask = chunkTable.size() - 1;
+    uint64_t slot = DictEncHash(entry, length) & mask;
+    while (true) {
+        uint32_t e = chunkTable[slot];
+        if (e == 0) {
+            chunkTable[slot] = chunkEntries.size() + 1;
+            chunkEntries.push_back(entry);
+            chunkLengths.push_back(length);
+            return chunkEntries.size() - 1;
+        }
+        e--;
+        if (chunkLengths[e] == length && memcmp(chunkEntries[e], entry, length) == 0)
+            return e;
+        slot = (slot + 1) & mask;
+    }
+}
+
+inline
+uint32_t DictCodeIterator :: GetChunkCode () {
+    uint32_t code = GetCode();
+    uint32_t& chunkCode = translation[code];
+    if (chunkCode == DICT_NO_CHUNK_CODE)
+        chunkCode = Translate(code);
+    return chunkCode;
+}
+
+inline
+uint32_t DictCodeIterator :: GetNumChunkEntries () {
+    return chunkEntries.size();
+}
+
+inline
+const char* DictCodeIterator :: GetChunkEntry (uint32_t chunkCode) {
+    return chunkEntries[chunkCode];
+}
+
+inline
+void DictCodeIterator :: Advance () {
+    newPiece = false;
+    index++;
+    if (index >= header.numCodes)
+        StartPiece();
+}
+
+// the hash of value, the current string of codes. The hash is computed the
+// first time a chunk code is seen and kept in hashes, by chunk code, for the
+// other tuples; hashes must only be filled through here. If the codes cannot be
+// used, value is hashed every time.
+template <class T>
+inline uint64_t DictCodeHash (DictCodeIterator& codes, std::vector<uint64_t>& hashes,
+        const T& value) {
+    if (!codes.IsValid())
+        return Hash(value);
+
+    uint32_t code = codes.GetChunkCode();
+    if (code == hashes.size())
+        hashes.push_back(Hash(value));
+    return hashes[code];
+}
+
+#endif // DICT_CODE_ITERATOR_H
@@ -0,0 +1,260 @@
+//
+//  Copyright 2012 Alin Dobra and Christopher Jermaine
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+#ifndef ENCODED_RUN_ITERATOR_H
+#define ENCODED_RUN_ITERATOR_H
+
+#include <cstdint>
+#include <cstring>
+
+#include "Column.h"
+#include "ColumnCodec.h"
+#include "IntegerEncodings.h"
+
+/** Read only iterator over a column of fixed width integers compressed with one
+    of the integer codecs (CODEC_FOR, CODEC_DELTA, CODEC_RLE). It works on the
+    encoded pieces directly, nothing is decompressed, and gives the column as
+    runs of equal values:
+
+    INT_ENC_RLE: the runs of the piece.
+    INT_ENC_FOR: a single run if all the values of the piece are the same
+        (0 bits per value), otherwise the bit-packed values one at a time.
+    INT_ENC_DELTA: a single run if all the deltas are 0, otherwise the values
+        one at a time.
+    INT_ENC_RAW: the values one at a time.
+
+    The generated code uses it, together with BStringIterator::RunLength(), to
+    evaluate predicates and add items to aggregates once per run instead of
+    once per tuple (e.g. a sum over a run is value * count).
+
+    If the column is not encoded that way (or not with values of the given
+    width), the iterator is not valid and the caller should go through the
+    column with a ColumnIterator instead. An invalid iterator behaves as a
+    single endless run, so that it can be skipped along with the valid ones.
+
+    The iterator does not own the column; the column must stay alive, and
+    unchanged, while the iterator is used. All functions are inlined.
+*/
+class EncodedRunIterator {
+
+private:
+
+    // the compressed pieces of the column
+    const char* data;
+    uint64_t dataSize;
+
+    // offset in data of the piece after the current one
+    uint64_t nextPiece;
+
+    // width of the values in bytes
+    int width;
+
+    bool valid;
+
+    // the current piece
+    IntEncHeader header;
+    const char* payload;
+    uint64_t numValues;
+    uint64_t mask; // low header.bits bits set
+
+    // position of the current run in the piece: index of the value, or of the
+    // run for INT_ENC_RLE
+    uint64_t index;
+
+    // the current run
+    uint64_t value;
+    uint64_t runLeft;
+
+    // number of values or runs in the current piece
+    uint64_t NumElements ();
+
+    // moves to the next piece; returns false if there is none
+    bool StartPiece ();
+
+    // sets value and runLeft for the element at index, moving to the next
+    // piece as needed
+    void SetRun ();
+
+public:
+
+    // width is the size in bytes of the values of the column (4 or 8)
+    EncodedRunIterator (Column& iterateMe, int width);
+
+    // true if the column is encoded and the runs can be used
+    bool IsValid ();
+
+    // the value of the current run, as the low width bytes of the result
+    uint64_t GetValue ();
+
+    // number of values left in the current run, the current one included; 0 at
+    // the end of the column
+    uint64_t RunLength ();
+
+    // advance over n values of the current run, n is at most RunLength ()
+    void Skip (uint64_t n);
+};
+
+/*** Here goes the inline definitions **/
+
+inline
+EncodedRunIterator :: EncodedRunIterator (Column& iterateMe, int _width):
+    data(NULL),
+    dataSize(0),
+    nextPiece(0),
+    width(_width),
+    valid(false),
+    payload(NULL),
+    numValues(0),
+    mask(0),
+    index(0),
+    value(0),
+    runLeft(0)
+{
+    memset(&header, 0, sizeof(header));
+
+    if (!iterateMe.IsValid() || !iterateMe.GetIsCompressed() ||
+            ColumnCodecIntEncoding(iterateMe.GetCodec()) == INT_ENC_RAW)
+        return;
+
+    data = iterateMe.GetCompressedBytes();
+    dataSize = iterateMe.GetCompressedSizeBytes();
+
+    // check that every piece holds whole values of our width, before we commit
+    // to the runs; this only reads the headers
+    uint64_t pos = 0;
+    while (pos < dataSize) {
+        ColumnCodecBlockHeader block;
+        IntEncHeader piece;
+        if (pos + sizeof(block) + sizeof(piece) > dataSize)
+            return;
+        memcpy(&block, data + pos, sizeof(block));
+        memcpy(&piece, data + pos + sizeof(block), sizeof(piece));
+        if (piece.width != width || block.decompressedSize % width != 0)
+            return;
+        pos += sizeof(block) + block.compressedSize;
+    }
+    if (pos != dataSize)
+        return;
+
+    valid = true;
+    SetRun();
+}
+
+inline
+bool EncodedRunIterator :: IsValid () {
+    return valid;
+}
+
+inline
+uint64_t EncodedRunIterator :: NumElements () {
+    return header.kind == INT_ENC_RLE ? header.count : numValues;
+}
+
+inline
+bool EncodedRunIterator :: StartPiece () {
+    if (nextPiece >= dataSize)
+        return false;
+
+    ColumnCodecBlockHeader block;
+    memcpy(&block, data + nextPiece, sizeof(block));
+    memcpy(&header, data + nextPiece + sizeof(block), sizeof(header));
+
+    payload = data + nextPiece + sizeof(block) + sizeof(header);
+    numValues = block.decompressedSize / width;
+    mask = IntEncMask(header.bits);
+    index = 0;
+
+    nextPiece += sizeof(block) + block.compressedSize;
+    return true;
+}
+
+inline
+void EncodedRunIterator :: SetRun () {
+    while (index >= NumElements()) {
+        if (!StartPiece()) {
+            runLeft = 0;
+            return;
+        }
+    }
+
+    switch (header.kind) {
+        case INT_ENC_RAW:
+            value = IntEncGet(payload + index * width, width);
+            runLeft = 1;
+            break;
+
+        case INT_ENC_FOR:
+            if (header.bits == 0) {
+                value = header.reference;
+                runLeft = numValues - index;
+            } else {
+                value = header.reference + IntEncUnpackOne(payload, index, header.bits, mask);
+                runLeft = 1;
+            }
+            break;
+
+        case INT_ENC_DELTA:
+            if (index == 0)
+                value = header.first;
+            else if (header.bits == 0)
+                value += header.reference;
+            else
+                value += header.reference + IntEncUnpackOne(payload, index - 1, header.bits, mask);
+            runLeft = (header.bits == 0 && header.reference == 0) ? numValues - index : 1;
+            break;
+
+        case INT_ENC_RLE: {
+            uint16_t len;
+            memcpy(&len, payload + header.count * width + index * sizeof(len), sizeof(len));
+            value = IntEncGet(payload + index * width, width);
+            runLeft = (uint64_t) len + 1;
+            break;
+        }
+
+        default:
+            FATAL("Unknown integer encoding %d", header.kind);
+    }
+}
+
+inline
+uint64_t EncodedRunIterator :: GetValue () {
+    return value;
+}
+
+inline
+uint64_t EncodedRunIterator :: RunLength () {
+    return valid ? runLeft : UINT64_MAX;
+}
+
+inline
+void EncodedRunIterator :: Skip (uint64_t n) {
+    if (!valid || n == 0)
+        return;
+
+    FATALIF(n > runLeft, "Skipping %lu values in a run of %lu", n, runLeft);
+
+    runLeft -= n;
+    // the runs of RLE are one element each, the others count values
+    if (header.kind != INT_ENC_RLE)
+        index += n;
+    else if (runLeft == 0)
+        index++;
+
+    if (runLeft == 0)
+        SetRun();
+}
+
+#endif // ENCODED_RUN_ITERATOR_H
@@ -0,0 +1,369 @@
+//
+//  Copyright 2012 Alin Dobra and Christopher Jermaine
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+#ifndef INTEGER_ENCODINGS_H
+#define INTEGER_ENCODINGS_H
+
+#include <cstdint>
+#include <cstring>
+
+#include "Errors.h"
+
+/** Lightweight encodings for columns of fixed width integers (INT, BIGINT,
+    DATE, FACTOR, ...). They work on one compressed piece (COMPRESSION_UNIT
+    bytes) at a time, so a whole column iterator step is decoded in one go.
+
+    INT_ENC_FOR: frame of reference; the values minus the smallest one are
+        bit-packed with as many bits as the largest difference needs.
+    INT_ENC_DELTA: the first value, then the differences between consecutive
+        values, frame of reference bit-packed. Good for sorted keys and dates.
+    INT_ENC_RLE: runs of equal values, as values followed by run lengths. Good
+        for low cardinality and mostly constant columns.
+    INT_ENC_RAW: the piece as it is, used for the pieces that do not shrink
+        with the encoding picked for the column.
+
+    Values are 4 or 8 bytes wide. All arithmetic is done modulo 2^64 so any bit
+    pattern goes through unchanged; bytes past the last full value are copied
+    at the end of the piece.
+ */
+enum IntEncodingKind {
+    INT_ENC_RAW = 0,
+    INT_ENC_FOR = 1,
+    INT_ENC_DELTA = 2,
+    INT_ENC_RLE = 3
+};
+
+// header of every encoded piece
+struct IntEncHeader {
+    uint8_t kind;
+    uint8_t width; // width of the values in bytes
+    uint8_t bits; // bits per packed value for INT_ENC_FOR and INT_ENC_DELTA
+    uint8_t unused;
+    uint32_t count; // number of values, or number of runs for INT_ENC_RLE
+    uint64_t first; // first value for INT_ENC_DELTA
+    uint64_t reference; // value subtracted before bit-packing
+};
+
+inline uint64_t IntEncGet(const char* where, int width) {
+    if (width == 4) {
+        int32_t v;
+        memcpy(&v, where, sizeof(v));
+        return (uint64_t) (int64_t) v;
+    } else {
+        uint64_t v;
+        memcpy(&v, where, sizeof(v));
+        return v;
+    }
+}
+
+inline void IntEncPut(char* where, int width, uint64_t v) {
+    if (width == 4) {
+        uint32_t low = (uint32_t) v;
+        memcpy(where, &low, sizeof(low));
+    } else {
+        memcpy(where, &v, sizeof(v));
+    }
+}
+
+// number of bits needed to represent range
+inline int IntEncBits(uint64_t range) {
+    return range == 0 ? 0 : 64 - __builtin_clzll(range);
+}
+
+// bytes taken by count values packed with bits bits each
+inline uint64_t IntEncPackedSize(uint64_t count, int bits) {
+    return ((count * bits + 63) / 64) * sizeof(uint64_t);
+}
+
+// largest encoded piece for size bytes of input
+inline uint64_t IntEncBound(uint64_t size) {
+    return sizeof(IntEncHeader) + size;
+}
+
+// Packs value into the bit stream at dest (that must be zeroed) as the index-th value
+inline void IntEncPack(char* dest, uint64_t index, int bits, uint64_t value) {
+    uint64_t bitPos = index * bits;
+    char* wordPtr = dest + (bitPos >> 6) * sizeof(uint64_t);
+    int offset = bitPos & 63;
+
+    uint64_t word;
+    memcpy(&word, wordPtr, sizeof(word));
+    word |= value << offset;
+    memcpy(wordPtr, &word, sizeof(word));
+
+    if (offset + bits > 64) {
+        memcpy(&word, wordPtr + sizeof(uint64_t), sizeof(word));
+        word |= value >> (64 - offset);
+        memcpy(wordPtr + sizeof(uint64_t), &word, sizeof(word));
+    }
+}
+
+// Unpacks the index-th value of the bit stream at src; mask has the low bits bits set
+inline uint64_t IntEncUnpackOne(const char* src, uint64_t index, int bits, uint64_t mask) {
+    uint64_t bitPos = index * bits;
+    const char* wordPtr = src + (bitPos >> 6) * sizeof(uint64_t);
+    int offset = bitPos & 63;
+
+    uint64_t word;
+    memcpy(&word, wordPtr, sizeof(word));
+    uint64_t value = word >> offset;
+    if (offset + bits > 64) {
+        memcpy(&word, wordPtr + sizeof(uint64_t), sizeof(word));
+        value |= word << (64 - offset);
+    }
+    return value & mask;
+}
+
+inline uint64_t IntEncMask(int bits) {
+    return bits == 64 ? ~0ULL : ((1ULL << bits) - 1);
+}
+
+// Unpacks count values packed with bits bits each, adds reference to each, and
+// calls emit(i, value) in order. The loop has no data dependencies between the
+// values so that the compiler can vectorize it.
+template <class Emit>
+inline void IntEncUnpack(const char* src, uint64_t count, int bits, uint64_t reference, Emit emit) {
+    if (bits == 0) {
+        for (uint64_t i = 0; i < count; i++)
+            emit(i, reference);
+        return;
+    }
+
+    uint64_t mask = IntEncMask(bits);
+    for (uint64_t i = 0; i < count; i++)
+        emit(i, reference + IntEncUnpackOne(src, i, bits, mask));
+}
+
+// end of the run of equal values that starts at value i; runs are cut at 2^16 values
+// so that their lengths fit in 16 bits
+inline uint64_t IntEncRunEnd(const char* src, uint64_t i, uint64_t count, int width) {
+    uint64_t v = IntEncGet(src + i * width, width);
+    uint64_t j = i + 1;
+    while (j < count && j - i < (1ULL << 16) && IntEncGet(src + j * width, width) == v)
+        j++;
+    return j;
+}
+
+// sizes of the piece of size bytes encoded with each of the encodings, indexed
+// by IntEncodingKind. Runs longer than 2^16 are not split, so RLE may come out a
+// bit smaller than it really is.
+inline void IntEncEstimate(const char* src, uint64_t size, int width, uint64_t sizes[4]) {
+    uint64_t count = size / width;
+    uint64_t tail = size - count * width;
+
+    sizes[INT_ENC_RAW] = size;
+    if (count == 0) {
+        sizes[INT_ENC_FOR] = sizes[INT_ENC_DELTA] = sizes[INT_ENC_RLE] = sizeof(IntEncHeader) + tail;
+        return;
+    }
+
+    int64_t minV = IntEncGet(src, width);
+    int64_t maxV = minV;
+    int64_t minD = 0, maxD = 0;
+    uint64_t runs = 1;
+    uint64_t prev = minV;
+    for (uint64_t i = 1; i < count; i++) {
+        uint64_t v = IntEncGet(src + i * width, width);
+        int64_t sv = v;
+        if (sv < minV) minV = sv;
+        if (sv > maxV) maxV = sv;
+
+        int64_t d = v - prev;
+        if (i == 1 || d < minD) minD = d;
+        if (i == 1 || d > maxD) maxD = d;
+
+        runs += (v != prev);
+        prev = v;
+    }
+
+    sizes[INT_ENC_FOR] = sizeof(IntEncHeader) + tail +
+        IntEncPackedSize(count, IntEncBits((uint64_t) maxV - (uint64_t) minV));
+    sizes[INT_ENC_DELTA] = sizeof(IntEncHeader) + tail +
+        IntEncPackedSize(count - 1, IntEncBits((uint64_t) maxD - (uint64_t) minD));
+    sizes[INT_ENC_RLE] = sizeof(IntEncHeader) + tail + runs * (width + sizeof(uint16_t));
+}
+
+// encodes the piece at src of size bytes with kind into dest, that must have room
+// for IntEncBound(size) bytes. Falls back to INT_ENC_RAW if the piece would not
+// shrink. Returns the size of the encoded piece.
+inline uint64_t IntEncEncode(int kind, int width, const char* src, uint64_t size, char* dest) {
+    FATALIF(width != 4 && width != 8, "Integer encodings work on 4 or 8 byte values, not %d", width);
+
+    uint64_t sizes[4];
+    IntEncEstimate(src, size, width, sizes);
+    if (sizes[kind] >= sizeof(IntEncHeader) + size)
+        kind = INT_ENC_RAW;
+
+    IntEncHeader header;
+    memset(&header, 0, sizeof(header));
+    header.kind = kind;
+    header.width = width;
+
+    uint64_t count = size / width;
+    uint64_t tail = size - count * width;
+    char* data = dest + sizeof(header);
+    uint64_t dataSize = 0;
+
+    switch (kind) {
+        case INT_ENC_RAW:
+            header.count = 0;
+            memcpy(data, src, size);
+            memcpy(dest, &header, sizeof(header));
+            return sizeof(header) + size;
+
+        case INT_ENC_FOR: {
+            int64_t minV = IntEncGet(src, width), maxV = minV;
+            for (uint64_t i = 1; i < count; i++) {
+                int64_t v = IntEncGet(src + i * width, width);
+                if (v < minV) minV = v;
+                if (v > maxV) maxV = v;
+            }
+            header.count = count;
+            header.reference = minV;
+            header.bits = IntEncBits((uint64_t) maxV - (uint64_t) minV);
+            dataSize = IntEncPackedSize(count, header.bits);
+            memset(data, 0, dataSize);
+            if (header.bits > 0)
+                for (uint64_t i = 0; i < count; i++)
+                    IntEncPack(data, i, header.bits, IntEncGet(src + i * width, width) - header.reference);
+            break;
+        }
+
+        case INT_ENC_DELTA: {
+            header.count = count;
+            header.first = IntEncGet(src, width);
+            int64_t minD = 0, maxD = 0;
+            for (uint64_t i = 1; i < count; i++) {
+                int64_t d = IntEncGet(src + i * width, width) - IntEncGet(src + (i - 1) * width, width);
+                if (i == 1 || d < minD) minD = d;
+                if (i == 1 || d > maxD) maxD = d;
+            }
+            header.reference = minD;
+            header.bits = IntEncBits((uint64_t) maxD - (uint64_t) minD);
+            dataSize = IntEncPackedSize(count - 1, header.bits);
+            memset(data, 0, dataSize);
+            if (header.bits > 0)
+                for (uint64_t i = 1; i < count; i++) {
+                    uint64_t d = IntEncGet(src + i * width, width) - IntEncGet(src + (i - 1) * width, width);
+                    IntEncPack(data, i - 1, header.bits, d - header.reference);
+                }
+            break;
+        }
+
+        case INT_ENC_RLE: {
+            // first pass writes the values, second the lengths after them
+            uint64_t runs = 0;
+            for (uint64_t i = 0; i < count; i = IntEncRunEnd(src, i, count, width))
+                IntEncPut(data + (runs++) * width, width, IntEncGet(src + i * width, width));
+
+            char* lengths = data + runs * width;
+            runs = 0;
+            for (uint64_t i = 0, j; i < count; i = j) {
+                j = IntEncRunEnd(src, i, count, width);
+                uint16_t len = j - i - 1; // runs are at least 1 long
+                memcpy(lengths + (runs++) * sizeof(len), &len, sizeof(len));
+            }
+            header.count = runs;
+            dataSize = runs * (width + sizeof(uint16_t));
+            break;
+        }
+
+        default:
+            FATAL("Unknown integer encoding %d", kind);
+    }
+
+    memcpy(data + dataSize, src + count * width, tail);
+    memcpy(dest, &header, sizeof(header));
+    return sizeof(header) + dataSize + tail;
+}
+
+// decodes the piece at src, that decodes to size bytes, into dest
+inline void IntEncDecode(const char* src, uint64_t encodedSize, char* dest, uint64_t size) {
+    IntEncHeader header;
+    memcpy(&header, src, sizeof(header));
+    const char* data = src + sizeof(header);
+
+    int width = header.width;
+    uint64_t count = size / width;
+    uint64_t tail = size - count * width;
+    uint64_t dataSize = 0;
+
+    switch (header.kind) {
+        case INT_ENC_RAW:
+            memcpy(dest, data, size);
+            return;
+
+        case INT_ENC_FOR:
+            dataSize = IntEncPackedSize(count, header.bits);
+            if (width == 4)
+                IntEncUnpack(data, count, header.bits, header.reference,
+                        [dest](uint64_t i, uint64_t v) { uint32_t low = v; memcpy(dest + i * 4, &low, 4); });
+            else
+                IntEncUnpack(data, count, header.bits, header.reference,
+                        [dest](uint64_t i, uint64_t v) { memcpy(dest + i * 8, &v, 8); });
+            break;
+
+        case INT_ENC_DELTA:
+            dataSize = IntEncPackedSize(count - 1, header.bits);
+            // unpack the deltas in place, then add them up
+            IntEncPut(dest, width, header.first);
+            if (width == 4) {
+                IntEncUnpack(data, count - 1, header.bits, header.reference,
+                        [dest](uint64_t i, uint64_t v) { uint32_t low = v; memcpy(dest + (i + 1) * 4, &low, 4); });
+                uint32_t acc = header.first;
+                for (uint64_t i = 1; i < count; i++) {
+                    uint32_t d;
+                    memcpy(&d, dest + i * 4, 4);
+                    acc += d;
+                    memcpy(dest + i * 4, &acc, 4);
+                }
+            } else {
+                IntEncUnpack(data, count - 1, header.bits, header.reference,
+                        [dest](uint64_t i, uint64_t v) { memcpy(dest + (i + 1) * 8, &v, 8); });
+                uint64_t acc = header.first;
+                for (uint64_t i = 1; i < count; i++) {
+                    uint64_t d;
+                    memcpy(&d, dest + i * 8, 8);
+                    acc += d;
+                    memcpy(dest + i * 8, &acc, 8);
+                }
+            }
+            break;
+
+        case INT_ENC_RLE: {
+            const char* lengths = data + header.count * width;
+            uint64_t pos = 0;
+            for (uint64_t r = 0; r < header.count; r++) {
+                uint16_t len;
+                memcpy(&len, lengths + r * sizeof(len), sizeof(len));
+                const char* value = data + r * width;
+                for (uint64_t k = 0; k <= len; k++, pos++)
+                    memcpy(dest + pos * width, value, width);
+            }
+            FATALIF(pos != count, "Corrupted run length encoded column piece");
+            dataSize = header.count * (width + sizeof(uint16_t));
+            break;
+        }
+
+        default:
+            FATAL("Unknown integer encoding %d", header.kind);
+    }
+
+    FATALIF(sizeof(header) + dataSize + tail != encodedSize, "Corrupted integer encoded column piece");
+    memcpy(dest + count * width, data + dataSize, tail);
+}
+
+#endif // INTEGER_ENCODINGS_H
@@ -53,6 +53,15 @@ class Iterator {
         // advance to the next object in the column...
         void Advance ();
 
+        // advance over len bytes (whole objects) and load the object there, the
+        // same way Advance () does for one object
+        void Skip (uint64_t len);
+
+        // number of bytes from the current position on that are in memory one
+        // after the other and can be read through GetData (); it stops at the end
+        // of the column and is 0 if we are past it
+        uint64_t ContiguousBytes ();
+
         // start from the beggining
         // usefull to read what we wrote
         void Restart();
@@ -116,6 +125,9 @@ class Iterator {
         // Do we have invalid column OR column at all?
         bool IsInvalid ();
 
+        // Keep the objects within the storage units of the column
+        void AlignObjects ();
+
         // Mark fragment
         void MarkFragment ();
 
@@ -170,6 +182,16 @@ uint64_t Iterator :: AtUnwrittenByte () {
     return (curPosInColumn >= colLength || colLength == 0 );
 }
 
+inline
+uint64_t Iterator :: ContiguousBytes () {
+
+    if (isInValid || curPosInColumn >= colLength)
+        return 0;
+
+    uint64_t end = firstInvalidByte < colLength ? firstInvalidByte : colLength;
+    return end > curPosInColumn ? end - curPosInColumn : 0;
+}
+
 inline
 void Iterator :: Advance () {
 
@@ -190,6 +212,24 @@ void Iterator :: Advance () {
     EnsureSpace (objLen, objLen);
 }
 
+inline
+void Iterator :: Skip (uint64_t len) {
+
+    if (isInValid)
+        return;
+
+    AdvanceBy (len);
+
+    if (curPosInColumn >= colLength) {
+        return;
+    }
+
+    // unlike Advance (), ask for a full step even if only the object is missing,
+    // so that the next ContiguousBytes () is not just one object
+    EnsureSpace (myMinByteToGetLength, bytesToRequest);
+    EnsureSpace (objLen, bytesToRequest);
+}
+
 inline
 void Iterator :: AdvanceBy (uint64_t len) {
 
@@ -231,6 +271,13 @@ bool Iterator :: IsInvalid () {
     return isInValid;
 }
 
+inline
+void Iterator :: AlignObjects () {
+
+    if (!isInValid)
+        myColumn.AlignObjects ();
+}
+
 inline
 void Iterator :: MarkFragment () {
 
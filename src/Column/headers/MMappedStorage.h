@@ -62,6 +62,20 @@ private:
 	   will cover multiple pages thus it will result in a copy via the bridtge */
 	int allocMultiplier;
 
+	/* If true, no object straddles two storage units, so objects are never
+	   read or written through the bridge. When a write needs more than is
+	   left in the last unit, the unit is cut at the write position and a new
+	   one starts there (see AlignObjects ()) */
+	bool alignObjects;
+
+	// number of times this thread filled the bridge
+	static thread_local uint64_t bridgeCopies;
+
+	// puts the storage units back together into a single one; the units of
+	// aligned storage do not end at page boundaries, but the disk writes whole
+	// pages of each unit
+	void Consolidate ();
+
 	// compressed data from the disk
 	CompressedStorageUnit cstorage;
 
@@ -86,6 +100,23 @@ public:
 
 	// function to mark the storage as readonly (to make sure it does not get changed)
 	void MakeReadonly();
+
+	// asks for objects to be kept within storage units from now on, which is
+	// worth it for columns of large variable length objects (STRING, JSON,
+	// ...) since every one crossing a unit would be copied through the bridge.
+	// Every request the writer makes must start at an object (the iterators
+	// ask for data at the current position). Ignored unless no object can
+	// straddle units yet, that is the storage has at most one unit
+	void AlignObjects ();
+
+	// number of times the bridge was filled by the calling thread, so far
+	static uint64_t GetBridgeCopies ();
+
+	// decompresses all the data read from disk now, instead of as the
+	// iterators go through it, so that the readers get it as a single
+	// uncompressed unit. The compressed data is kept. Does nothing if there is
+	// nothing to decompress
+	void Decompress ();
 	
 	//void Detach ();
 	MMappedStorage *CreatePartialDeepCopy (uint64_t position);
@@ -96,8 +127,11 @@ public:
 	static DistributedCounter* storeCount; // REMOVE
 	static DistributedCounter* createCount; // REMOVE
 
-	// Compress the storage
-	void Compress(bool);
+	// Compress the storage with the given codec
+	void Compress(bool, ColumnCodec codec = ColumnCodec());
+
+	// Get the codec the storage is compressed with
+	int GetCodec();
 
 	// Get the handle of the compressed storage
 	void GetCompressed(RawStorageList&);
@@ -105,6 +139,9 @@ public:
 	// Get the compressed size in bytes
 	off_t GetCompressedSizeBytes();
 
+	// Get read access to the compressed bytes
+	const char* GetCompressedBytes();
+
 	// Get the compressed size in pages
 	off_t GetCompressedSizePages();
 
@@ -125,8 +162,9 @@ public:
 
 	// This receives storage from outside, either compressed or uncompressed
 	// Hence it is read only storage. Passing allocated space considering it blank
-	// will not work
-	MMappedStorage (void *myData, uint64_t numBytes, uint64_t numCompressedBytes, uint64_t numaNode = 0);
+	// will not work. codec is the one the compressed data was compressed with
+	MMappedStorage (void *myData, uint64_t numBytes, uint64_t numCompressedBytes, uint64_t numaNode = 0,
+            int codec = CODEC_QUICKLZ);
 
 	// Special constructor to read a partial chunk
 	// Arguments:
@@ -155,6 +193,9 @@ public:
         swap(numCompressedBytes, withMe.numCompressedBytes);
         swap(bridge, withMe.bridge);
         swap(bridgeEmpty, withMe.bridgeEmpty);
+        swap(bridgeSize, withMe.bridgeSize);
+        swap(allocMultiplier, withMe.allocMultiplier);
+        swap(alignObjects, withMe.alignObjects);
         swap(cstorage, withMe.cstorage);
         swap(decompress, withMe.decompress);
         swap(isWriteMode, withMe.isWriteMode);
@@ -168,6 +209,9 @@ public:
 inline
 bool MMappedStorage :: IsWriteMode () {return isWriteMode;}
 
+inline
+uint64_t MMappedStorage :: GetBridgeCopies () {return bridgeCopies;}
+
 inline
 void swap(MMappedStorage& a, MMappedStorage& b) {
     a.swap(b);
@@ -0,0 +1,260 @@
+//
+//  Copyright 2012 Alin Dobra and Christopher Jermaine
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+#ifndef STRING_DICT_ENCODING_H
+#define STRING_DICT_ENCODING_H
+
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#include "Errors.h"
+
+/** Dictionary encoding for columns of null terminated strings (STRING). Like
+    the integer encodings, it works on one compressed piece at a time; every
+    piece has its own (local) dictionary, so the pieces decode independently.
+
+    An encoded piece is a DictEncHeader followed by:
+
+        uint32_t offsets[numEntries + 1]: entry i is entries[offsets[i], offsets[i+1])
+        char entries[entriesSize]: the distinct strings, with their '\0'
+        codes[numCodes]: the index of the entry of every string, codeWidth bytes each
+
+    so the entries can be used in place as C strings and a string is turned
+    into its code once per piece, not once per use.
+
+    The encoding is exact for any bytes: the piece is split after every '\0'
+    and the last string may have no terminator (the piece was cut in the
+    middle of a string). The compressor cuts the pieces after a '\0' whenever
+    it can (see DictEncCut), so that every string is whole in its piece.
+
+    A piece that would not shrink is kept raw (codeWidth 0), as the bytes
+    after the header.
+
+    Everything is accessed with memcpy since pieces start at any byte.
+ */
+
+// header of every encoded piece
+struct DictEncHeader {
+    uint32_t numEntries; // distinct strings in the piece
+    uint32_t numCodes; // strings in the piece
+    uint32_t entriesSize; // bytes of the entries
+    uint8_t codeWidth; // bytes of a code (1, 2 or 4), 0 for a raw piece
+    uint8_t terminated; // 1 if the last string of the piece has its '\0'
+    uint16_t unused;
+};
+
+// largest encoded piece for size bytes of input
+inline uint64_t DictEncBound(uint64_t size) {
+    return sizeof(DictEncHeader) + size;
+}
+
+// the size of the piece that starts at src, at most size bytes: the piece is cut
+// after the last '\0' if that leaves at least half of it, so that the strings
+// are not split across pieces
+inline uint64_t DictEncCut(const char* src, uint64_t size) {
+    const char* last = (const char*) memrchr(src, '\0', size);
+    if (last != NULL && (uint64_t) (last + 1 - src) >= size / 2)
+        return last + 1 - src;
+    else
+        return size;
+}
+
+// hash of the length bytes of a string, to find it in a dictionary
+inline uint64_t DictEncHash(const char* str, uint64_t length) {
+    uint64_t h = 0xcbf29ce484222325ULL;
+    for (uint64_t i = 0; i < length; i++)
+        h = (h ^ (unsigned char) str[i]) * 0x100000001b3ULL;
+    return h;
+}
+
+/** The strings of a piece and its dictionary, as they are found. */
+class DictEncPiece {
+
+    const char* src;
+
+    // the distinct strings, as offset and length in src
+    std::vector<uint32_t> entryStart;
+    std::vector<uint32_t> entryLength;
+    uint64_t entriesSize;
+
+    // the entry of every string
+    std::vector<uint32_t> codes;
+    bool terminated;
+
+    // open addressing table of entry index + 1, 0 for empty
+    std::vector<uint32_t> table;
+
+public:
+
+    // finds the strings of the piece at src of size bytes
+    DictEncPiece(const char* _src, uint64_t size):
+        src(_src),
+        entriesSize(0),
+        terminated(true)
+    {
+        uint64_t tableSize = 16;
+        while (tableSize < size / 4)
+            tableSize *= 2;
+        table.resize(tableSize, 0);
+
+        for (uint64_t pos = 0; pos < size; ) {
+            const char* end = (const char*) memchr(src + pos, '\0', size - pos);
+            uint64_t length = end != NULL ? end + 1 - (src + pos) : size - pos;
+            terminated = end != NULL;
+
+            // look the string up, add it if new
+            uint64_t slot = DictEncHash(src + pos, length) & (tableSize - 1);
+            while (true) {
+                uint32_t e = table[slot];
+                if (e == 0) {
+                    table[slot] = entryStart.size() + 1;
+                    entryStart.push_back(pos);
+                    entryLength.push_back(length);
+                    entriesSize += length;
+                    codes.push_back(entryStart.size() - 1);
+                    break;
+                }
+                e--;
+                if (entryLength[e] == length && memcmp(src + entryStart[e], src + pos, length) == 0) {
+                    codes.push_back(e);
+                    break;
+                }
+                slot = (slot + 1) & (tableSize - 1);
+            }
+
+            // keep the table at most half full
+            if (2 * entryStart.size() > tableSize) {
+                tableSize *= 2;
+                std::vector<uint32_t> bigger(tableSize, 0);
+                for (uint32_t e = 0; e < entryStart.size(); e++) {
+                    uint64_t s = DictEncHash(src + entryStart[e], entryLength[e]) & (tableSize - 1);
+                    while (bigger[s] != 0)
+                        s = (s + 1) & (tableSize - 1);
+                    bigger[s] = e + 1;
+                }
+                table.swap(bigger);
+            }
+
+            pos += length;
+        }
+    }
+
+    int CodeWidth() {
+        return entryStart.size() <= (1 << 8) ? 1 : entryStart.size() <= (1 << 16) ? 2 : 4;
+    }
+
+    // size of the piece encoded, header included
+    uint64_t EncodedSize() {
+        return sizeof(DictEncHeader) + (entryStart.size() + 1) * sizeof(uint32_t) +
+            entriesSize + codes.size() * CodeWidth();
+    }
+
+    // writes the encoded piece to dest, EncodedSize() bytes
+    void Write(char* dest) {
+        DictEncHeader header;
+        memset(&header, 0, sizeof(header));
+        header.numEntries = entryStart.size();
+        header.numCodes = codes.size();
+        header.entriesSize = entriesSize;
+        header.codeWidth = CodeWidth();
+        header.terminated = terminated ? 1 : 0;
+        memcpy(dest, &header, sizeof(header));
+
+        char* offsets = dest + sizeof(header);
+        char* entries = offsets + (header.numEntries + 1) * sizeof(uint32_t);
+        uint32_t offset = 0;
+        for (uint32_t e = 0; e < header.numEntries; e++) {
+            memcpy(offsets + e * sizeof(uint32_t), &offset, sizeof(uint32_t));
+            memcpy(entries + offset, src + entryStart[e], entryLength[e]);
+            offset += entryLength[e];
+        }
+        memcpy(offsets + header.numEntries * sizeof(uint32_t), &offset, sizeof(uint32_t));
+
+        char* codesOut = entries + entriesSize;
+        for (uint64_t i = 0; i < codes.size(); i++)
+            memcpy(codesOut + i * header.codeWidth, &codes[i], header.codeWidth);
+    }
+};
+
+// size of the piece at src of size bytes once encoded
+inline uint64_t DictEncEstimate(const char* src, uint64_t size) {
+    DictEncPiece piece(src, size);
+    uint64_t encoded = piece.EncodedSize();
+    return encoded < DictEncBound(size) ? encoded : DictEncBound(size);
+}
+
+// encodes the piece at src of size bytes into dest, that must have room for
+// DictEncBound(size) bytes. Keeps the piece raw if it would not shrink.
+// Returns the size of the encoded piece.
+inline uint64_t DictEncEncode(const char* src, uint64_t size, char* dest) {
+    DictEncPiece piece(src, size);
+    if (piece.EncodedSize() < DictEncBound(size)) {
+        piece.Write(dest);
+        return piece.EncodedSize();
+    }
+
+    DictEncHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(dest, &header, sizeof(header));
+    memcpy(dest + sizeof(header), src, size);
+    return DictEncBound(size);
+}
+
+// reads code i of the codes at where
+inline uint32_t DictEncGetCode(const char* where, uint64_t i, int width) {
+    uint32_t code = 0;
+    memcpy(&code, where + i * width, width);
+    return code;
+}
+
+// reads offset i of the offsets at where
+inline uint32_t DictEncGetOffset(const char* where, uint64_t i) {
+    uint32_t offset;
+    memcpy(&offset, where + i * sizeof(uint32_t), sizeof(uint32_t));
+    return offset;
+}
+
+// decodes the piece at src, that decodes to size bytes, into dest
+inline void DictEncDecode(const char* src, uint64_t encodedSize, char* dest, uint64_t size) {
+    DictEncHeader header;
+    memcpy(&header, src, sizeof(header));
+
+    if (header.codeWidth == 0) {
+        FATALIF(encodedSize != DictEncBound(size), "Corrupted dictionary encoded column piece");
+        memcpy(dest, src + sizeof(header), size);
+        return;
+    }
+
+    const char* offsets = src + sizeof(header);
+    const char* entries = offsets + (header.numEntries + 1) * sizeof(uint32_t);
+    const char* codes = entries + header.entriesSize;
+    FATALIF(codes + header.numCodes * header.codeWidth != src + encodedSize,
+            "Corrupted dictionary encoded column piece");
+
+    uint64_t pos = 0;
+    for (uint64_t i = 0; i < header.numCodes; i++) {
+        uint32_t code = DictEncGetCode(codes, i, header.codeWidth);
+        FATALIF(code >= header.numEntries, "Corrupted dictionary encoded column piece");
+        uint32_t start = DictEncGetOffset(offsets, code);
+        uint32_t length = DictEncGetOffset(offsets, code + 1) - start;
+        FATALIF(pos + length > size, "Corrupted dictionary encoded column piece");
+        memcpy(dest + pos, entries + start, length);
+        pos += length;
+    }
+    FATALIF(pos != size, "Corrupted dictionary encoded column piece");
+}
+
+#endif // STRING_DICT_ENCODING_H
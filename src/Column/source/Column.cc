@@ -48,6 +48,15 @@ bool Column :: IsWriteMode () {
     return myData->IsWriteMode ();
 }
 
+void Column :: AlignObjects () {
+    myData->AlignObjects ();
+}
+
+void Column :: Decompress () {
+    if (myData != NULL)
+        myData->Decompress ();
+}
+
 char *Column :: GetNewData (uint64_t posToStartFrom, uint64_t &numBytesRequested) {
     FATALIF( myData == NULL, "Why is this NULL?");
 
@@ -55,14 +64,22 @@ char *Column :: GetNewData (uint64_t posToStartFrom, uint64_t &numBytesRequested
     return myData->GetData (posToStartFrom, numBytesRequested);
 }
 
-void Column :: Compress (bool deleteDecompressed) {
-    myData->Compress (deleteDecompressed);
+void Column :: Compress (bool deleteDecompressed, ColumnCodec codec) {
+    myData->Compress (deleteDecompressed, codec);
+}
+
+int Column :: GetCodec() {
+    return myData->GetCodec();
 }
 
 void Column :: GetCompressed(RawStorageList& where) {
     return myData->GetCompressed (where);
 }
 
+const char* Column :: GetCompressedBytes() {
+    return myData->GetCompressedBytes();
+}
+
 off_t Column :: GetCompressedSizeBytes() {
     return myData->GetCompressedSizeBytes();
 }
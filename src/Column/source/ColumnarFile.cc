@@ -0,0 +1,240 @@
+//
+//  Copyright 2012 Alin Dobra and Christopher Jermaine
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+#include "ColumnarFile.h"
+
+#include <cerrno>
+
+using namespace std;
+
+// writes the 0s that get the file from pos to the next aligned position
+static void WritePadding(FILE* file, uint64_t pos) {
+    static const char zeros[COLUMNAR_ALIGNMENT] = { 0 };
+    uint64_t padding = ColumnarAlign(pos) - pos;
+    if (padding > 0)
+        fwrite(zeros, 1, padding, file);
+}
+
+void ColumnarWriteFileHeader(FILE* file, const vector<string>& names) {
+    ColumnarFileHeader header;
+    memcpy(header.magic, COLUMNAR_MAGIC, sizeof(header.magic));
+    header.version = COLUMNAR_VERSION;
+    header.numColumns = names.size();
+    header.namesLength = 0;
+    for (const string& name : names)
+        header.namesLength += name.size() + 1;
+
+    flockfile(file);
+    fwrite(&header, sizeof(header), 1, file);
+    for (const string& name : names)
+        fwrite(name.c_str(), 1, name.size() + 1, file);
+    WritePadding(file, sizeof(header) + header.namesLength);
+    funlockfile(file);
+}
+
+void ColumnarWriteEnd(FILE* file) {
+    ColumnarBatchHeader end;
+    end.numTuples = 0;
+    end.length = 0;
+    fwrite(&end, sizeof(end), 1, file);
+}
+
+ColumnarBatch :: ColumnarBatch(int numColumns):
+    columns(numColumns),
+    numTuples(0)
+{}
+
+void ColumnarBatch :: Write(FILE* file) {
+    if (numTuples == 0)
+        return;
+
+    // lay the buffers out
+    vector<ColumnarColumnDesc> descs(columns.size());
+    uint64_t pos = ColumnarAlign(sizeof(ColumnarBatchHeader) + descs.size() * sizeof(ColumnarColumnDesc));
+    for (size_t i = 0; i < columns.size(); i++) {
+        ColumnData& col = columns[i];
+        ColumnarColumnDesc& desc = descs[i];
+        desc.kind = col.kind;
+        desc.width = col.width;
+
+        desc.validity.offset = pos;
+        desc.validity.length = col.anyNull ? col.validity.size() : 0;
+        pos = ColumnarAlign(pos + desc.validity.length);
+
+        desc.offsets.offset = pos;
+        desc.offsets.length = col.kind == COLUMNAR_STRING ? col.offsets.size() * sizeof(int64_t) : 0;
+        pos = ColumnarAlign(pos + desc.offsets.length);
+
+        desc.values.offset = pos;
+        desc.values.length = col.values.size();
+        pos = ColumnarAlign(pos + desc.values.length);
+    }
+
+    ColumnarBatchHeader header;
+    header.numTuples = numTuples;
+    header.length = pos;
+
+    // the other threads printing the same query write their batches whole,
+    // before or after ours
+    flockfile(file);
+    fwrite(&header, sizeof(header), 1, file);
+    fwrite(descs.data(), sizeof(ColumnarColumnDesc), descs.size(), file);
+    WritePadding(file, sizeof(header) + descs.size() * sizeof(ColumnarColumnDesc));
+    for (size_t i = 0; i < columns.size(); i++) {
+        ColumnData& col = columns[i];
+        ColumnarColumnDesc& desc = descs[i];
+
+        fwrite(col.validity.data(), 1, desc.validity.length, file);
+        WritePadding(file, desc.validity.offset + desc.validity.length);
+        fwrite(col.offsets.data(), 1, desc.offsets.length, file);
+        WritePadding(file, desc.offsets.offset + desc.offsets.length);
+        fwrite(col.values.data(), 1, desc.values.length, file);
+        WritePadding(file, desc.values.offset + desc.values.length);
+    }
+    funlockfile(file);
+
+    vector<ColumnData> empty(columns.size());
+    columns.swap(empty);
+    numTuples = 0;
+}
+
+ColumnarFileReader :: ColumnarFileReader(const char* fileName):
+    fd(-1),
+    data(NULL),
+    size(0),
+    batch(0),
+    nextBatch(0)
+{
+    header.numTuples = 0;
+    header.length = 0;
+
+    fd = open(fileName, O_RDONLY);
+    FATALIF(fd == -1, "Could not open columnar file %s: %s", fileName, strerror(errno));
+
+    struct stat st;
+    FATALIF(fstat(fd, &st) != 0, "Could not stat columnar file %s: %s", fileName, strerror(errno));
+    size = st.st_size;
+    FATALIF(size < sizeof(ColumnarFileHeader), "File %s is not a columnar file", fileName);
+
+    data = (char*) mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    FATALIF(data == MAP_FAILED, "Could not map columnar file %s: %s", fileName, strerror(errno));
+
+    ColumnarFileHeader fHeader;
+    memcpy(&fHeader, data, sizeof(fHeader));
+    FATALIF(memcmp(fHeader.magic, COLUMNAR_MAGIC, sizeof(fHeader.magic)) != 0,
+            "File %s is not a columnar file", fileName);
+    FATALIF(fHeader.version != COLUMNAR_VERSION, "Columnar file %s has version %u, only %d is known",
+            fileName, fHeader.version, COLUMNAR_VERSION);
+    FATALIF(sizeof(fHeader) + fHeader.namesLength > size, "Columnar file %s is truncated", fileName);
+
+    const char* name = data + sizeof(fHeader);
+    const char* namesEnd = name + fHeader.namesLength;
+    for (uint32_t i = 0; i < fHeader.numColumns; i++) {
+        FATALIF(name >= namesEnd, "Columnar file %s has fewer names than columns", fileName);
+        names.push_back(name);
+        name += names.back().size() + 1;
+    }
+
+    nextBatch = ColumnarAlign(sizeof(fHeader) + fHeader.namesLength);
+}
+
+ColumnarFileReader :: ~ColumnarFileReader() {
+    if (data != NULL && data != MAP_FAILED)
+        munmap(data, size);
+    if (fd != -1)
+        close(fd);
+}
+
+bool ColumnarFileReader :: NextBatch() {
+    FATALIF(nextBatch + sizeof(ColumnarBatchHeader) > size,
+            "Columnar file is truncated, no end of the batches");
+
+    batch = nextBatch;
+    memcpy(&header, data + batch, sizeof(header));
+    if (header.length == 0)
+        return false;
+
+    FATALIF(header.length % COLUMNAR_ALIGNMENT != 0 || batch + header.length > size ||
+            sizeof(header) + names.size() * sizeof(ColumnarColumnDesc) > header.length,
+            "Corrupted batch at offset %lu of columnar file", batch);
+
+    nextBatch = batch + header.length;
+    return true;
+}
+
+const ColumnarColumnDesc& ColumnarFileReader :: Desc(int col) {
+    FATALIF(col < 0 || col >= (int) names.size(), "Columnar file has no column %d", col);
+    return ((const ColumnarColumnDesc*) (data + batch + sizeof(header)))[col];
+}
+
+const char* ColumnarFileReader :: Buffer(const ColumnarBuffer& buffer) {
+    FATALIF(buffer.offset + buffer.length > header.length,
+            "Buffer out of its batch at offset %lu of columnar file", batch);
+    return data + batch + buffer.offset;
+}
+
+void ColumnarFileReader :: GetFixedColumn(int col, uint32_t width, Column& where) {
+    const ColumnarColumnDesc& desc = Desc(col);
+    uint64_t bytes = header.numTuples * width;
+    FATALIF(desc.kind != COLUMNAR_FIXED || desc.width != width || desc.values.length != bytes,
+            "Column %s of the columnar file does not have values of %u bytes", names[col].c_str(), width);
+
+    void* mem = mmap_alloc(PAGES_TO_BYTES(BYTES_TO_PAGES(bytes)), 1);
+    memcpy(mem, Buffer(desc.values), bytes);
+
+    MMappedStorage store(mem, bytes, 0);
+    Column temp(store);
+    where.swap(temp);
+}
+
+void ColumnarFileReader :: GetStringColumn(int col, const char* nullStr, Column& where) {
+    const ColumnarColumnDesc& desc = Desc(col);
+    FATALIF(desc.kind != COLUMNAR_STRING ||
+            desc.offsets.length != (header.numTuples + 1) * sizeof(int64_t) ||
+            (desc.validity.length != 0 && desc.validity.length < (header.numTuples + 7) / 8),
+            "Column %s of the columnar file is not a column of strings", names[col].c_str());
+
+    const int64_t* offsets = (const int64_t*) Buffer(desc.offsets);
+    const char* values = Buffer(desc.values);
+    const char* validity = desc.validity.length > 0 ? Buffer(desc.validity) : NULL;
+    uint64_t nullLength = strlen(nullStr) + 1;
+
+    // the strings and their terminators
+    uint64_t bytes = 0;
+    for (uint64_t i = 0; i < header.numTuples; i++) {
+        FATALIF(offsets[i] > offsets[i + 1] || (uint64_t) offsets[i + 1] > desc.values.length,
+                "Corrupted offsets in column %s of the columnar file", names[col].c_str());
+        bytes += IsNull(validity, i) ? nullLength : offsets[i + 1] - offsets[i] + 1;
+    }
+
+    char* mem = (char*) mmap_alloc(PAGES_TO_BYTES(BYTES_TO_PAGES(bytes)), 1);
+    char* pos = mem;
+    for (uint64_t i = 0; i < header.numTuples; i++) {
+        if (IsNull(validity, i)) {
+            memcpy(pos, nullStr, nullLength);
+            pos += nullLength;
+        } else {
+            uint64_t length = offsets[i + 1] - offsets[i];
+            memcpy(pos, values + offsets[i], length);
+            pos[length] = '\0';
+            pos += length + 1;
+        }
+    }
+
+    MMappedStorage store(mem, bytes, 0);
+    Column temp(store);
+    where.swap(temp);
+}
@@ -27,6 +27,8 @@ using namespace std;
 
 // forward decls of the allocation functions
 
+thread_local uint64_t MMappedStorage :: bridgeCopies = 0;
+
 MMappedStorage *MMappedStorage :: CreateShallowCopy () {
 
 	// create the guy we are gonna return
@@ -48,6 +50,7 @@ MMappedStorage *MMappedStorage :: CreateShallowCopy () {
 	returnVal->decompress = decompress;
 	returnVal->isWriteMode = isWriteMode;
 	returnVal->numa = numa;
+	returnVal->alignObjects = alignObjects;
 
 	return returnVal;
 };
@@ -62,6 +65,7 @@ MMappedStorage :: MMappedStorage (uint64_t numaNode) :
     bridgeEmpty(true),
     bridgeSize(0),
     allocMultiplier(1),
+    alignObjects(false),
     cstorage(),
     decompress(false),
 	// this can be treated as write only storage, because we dont have anything to read
@@ -234,6 +238,43 @@ char *MMappedStorage :: GetData (uint64_t posToStartFrom, uint64_t &numBytesRequ
 //#endif
 
 
+			// the objects are kept within units, so the one at posToStartFrom
+			// ends in this unit; give the rest of it, or, if we are writing at the
+			// end, cut the unit here and start a new one that covers the request
+			} else if (alignObjects) {
+				StorageUnit& unit = storage.Current ();
+				storage.Advance ();
+				if (!isWriteMode || storage.RightLength ()) {
+					numBytesRequested = unit.end - posToStartFrom + 1;
+					return unit.bytes + (posToStartFrom - unit.start);
+				}
+
+				uint64_t numPages = BYTES_TO_PAGES(numBytesRequested);
+				if (numPages < (uint64_t) allocMultiplier)
+					numPages = allocMultiplier;
+
+				StorageUnit temp;
+				temp.start = posToStartFrom;
+				temp.end = posToStartFrom + PAGES_TO_BYTES(numPages) - 1;
+				temp.bytes = (char *) mmap_alloc (PAGES_TO_BYTES(numPages), numa);
+
+				// whatever is already there moves along (a writer has nothing past
+				// its position, but a reader in write mode might)
+				temp.CopyOverlappingContent (unit);
+
+				numBytesRequested = temp.end - posToStartFrom + 1;
+				char *returnVal = temp.bytes;
+
+				if (unit.start < posToStartFrom) {
+					unit.end = posToStartFrom - 1;
+					storage.Insert (temp);
+				} else {
+					// the unit is smaller than the request, replace it
+					unit.swap (temp);
+				}
+
+				return returnVal;
+
 			// the page does not totally cover the request, so create a bridge
 			// that is a contiguous block of storage covering the entire request
 			} else {
@@ -253,6 +294,7 @@ char *MMappedStorage :: GetData (uint64_t posToStartFrom, uint64_t &numBytesRequ
 			  bridge.start = posToStartFrom;
 			  bridge.end = posToStartFrom + numBytesRequested - 1;
 			  bridgeEmpty = false;
+			  bridgeCopies++;
 
 				uint64_t upperEnd;
 				while (storage.RightLength ()) {
@@ -308,6 +350,39 @@ char *MMappedStorage :: GetData (uint64_t posToStartFrom, uint64_t &numBytesRequ
 
 
 
+void MMappedStorage :: AlignObjects () {
+	// with more than one unit, objects might already straddle them
+	if (storage.Length () <= 1 && !decompress)
+		alignObjects = true;
+}
+
+void MMappedStorage :: Decompress () {
+	if (!decompress || isWriteMode)
+		return;
+
+	// the sister unit of cstorage covers all the decompressed data
+	cstorage.DecompressAll ();
+	decompress = false;
+}
+
+void MMappedStorage :: Consolidate () {
+	StorageUnit whole;
+	whole.start = 0;
+	whole.end = PAGES_TO_BYTES(BYTES_TO_PAGES(numBytes)) - 1;
+	whole.bytes = (char *) mmap_alloc (whole.end + 1, numa);
+
+	storage.MoveToStart ();
+	while (storage.RightLength ()) {
+		StorageUnit temp;
+		storage.Remove (temp);
+		whole.CopyOverlappingContent (temp);
+	}
+
+	if (!isWriteMode)
+		whole.MakeReadonly ();
+	storage.Insert (whole);
+}
+
 void MMappedStorage :: MakeReadonly(){
 	storage.MoveToStart ();
 	while (storage.RightLength ()) {
@@ -394,6 +469,7 @@ MMappedStorage *MMappedStorage :: CreatePartialDeepCopy (uint64_t position) {
 	returnVal->cstorage.CreateDeepCopy (newcs);
 	returnVal->cstorage.swap(newcs);
 	returnVal->decompress = decompress;
+	returnVal->alignObjects = alignObjects;
 
 	// as soon as we deep copy, our mode changes to writeonly
 	// because that is when we will want deep copy
@@ -406,10 +482,21 @@ uint64_t MMappedStorage :: GetNumBytes () {
 	return numBytes;
 }
 
-void MMappedStorage :: Compress(bool deleteDecompressed) {
+void MMappedStorage :: Compress(bool deleteDecompressed, ColumnCodec codec) {
+	// every storage unit is compressed in pieces of its own, so the room needed
+	// for the compressed data depends on how the column is split into units
+	uint64_t compressedSpace = 0;
+	if (codec.id != CODEC_QUICKLZ) {
+		storage.MoveToStart ();
+		while (storage.RightLength ()) {
+			compressedSpace += CompressedStorageUnit::MaxCompressedSize(codec.id, storage.Current().Size());
+			storage.Advance();
+		}
+	}
+
 	// create a compressed storage unit and store it into cStorage
 	// compress into same numa until enhanced not to
-	CompressedStorageUnit cUnit(GetNumBytes(), numa);
+	CompressedStorageUnit cUnit(GetNumBytes(), numa, codec, compressedSpace);
 
 	// it is crucial to check that the storage units are in order
 	int prevPos = -1;
@@ -445,11 +532,19 @@ bool MMappedStorage :: GetIsCompressed() {
 	return cstorage.GetIsCompressed();
 }
 
+int MMappedStorage :: GetCodec() {
+	return cstorage.GetCodec();
+}
+
 off_t MMappedStorage :: GetCompressedSizeBytes () {
 	// return the actual compressed bytes stored at the time of compression
 	return cstorage.GetCompressedSize();
 }
 
+const char* MMappedStorage :: GetCompressedBytes () {
+	return cstorage.GetCompressedBytes();
+}
+
 off_t MMappedStorage :: GetCompressedSizePages () {
 	// return the actual compressed bytes stored at the time of compression
 	return BYTES_TO_PAGES(GetCompressedSizeBytes());
@@ -474,6 +569,17 @@ void MMappedStorage :: GetUncompressed(RawStorageList& rawUncompressedList) {
 	RawStorageList empty;
 	rawUncompressedList.swap(empty); // clean up the content of the output
 
+	// every unit but the last one is written as whole pages
+	bool pageAligned = true;
+	storage.MoveToStart ();
+	while (storage.RightLength () > 1) {
+		if (storage.Current ().Size () % MMAP_PAGE_SIZE != 0)
+			pageAligned = false;
+		storage.Advance ();
+	}
+	if (!pageAligned && numBytes > 0)
+		Consolidate ();
+
 	storage.MoveToStart ();
 	while (storage.RightLength ()) {
 		StorageUnit& temp = storage.Current();
@@ -490,7 +596,8 @@ void MMappedStorage :: GetUncompressed(RawStorageList& rawUncompressedList) {
 	}
 }
 
-MMappedStorage :: MMappedStorage (void *myData, uint64_t sizeDecompressed, uint64_t sizeCompressed, uint64_t numaNode) :
+MMappedStorage :: MMappedStorage (void *myData, uint64_t sizeDecompressed, uint64_t sizeCompressed, uint64_t numaNode,
+        int codec) :
     ColumnStorage(),
     storage(),
     numBytes(sizeDecompressed),
@@ -499,6 +606,7 @@ MMappedStorage :: MMappedStorage (void *myData, uint64_t sizeDecompressed, uint6
     bridgeEmpty(true),
     bridgeSize(0),
     allocMultiplier(1),
+    alignObjects(false),
     cstorage(),
     decompress(false),
     isWriteMode(false),
@@ -518,7 +626,7 @@ MMappedStorage :: MMappedStorage (void *myData, uint64_t sizeDecompressed, uint6
 	} else {
 		// create a compressed storage unit
 		StorageUnit temp;
-		CompressedStorageUnit cUnit((char*)myData, sizeDecompressed, sizeCompressed, temp, numa); // compressed or not we get a single storage unit
+		CompressedStorageUnit cUnit((char*)myData, sizeDecompressed, sizeCompressed, temp, numa, codec); // compressed or not we get a single storage unit
 		cstorage.swap(cUnit);
 		decompress = true;
 		// and remember it
@@ -539,6 +647,7 @@ MMappedStorage :: MMappedStorage (void *myData, uint64_t preEmptyPages, uint64_t
     bridgeEmpty(true),
     bridgeSize(0),
     allocMultiplier(1),
+    alignObjects(false),
     cstorage(),
     decompress(false),
     isWriteMode(false),
@@ -0,0 +1,150 @@
+//
+//  Copyright 2012 Alin Dobra and Christopher Jermaine
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+// Tests of the replacement of the chunk cache and of the version of the
+// columns the ChunkReaderWriters read through it.
+
+#include <gtest/gtest.h>
+#include <cstring>
+#include <vector>
+#include "../headers/ChunkCache.h"
+#include "MmapAllocator.h"
+
+using namespace std;
+
+class ChunkCacheTest : public ::testing::Test {
+protected:
+    static constexpr off_t kCapacity = 8; // pages
+
+    ChunkCache cache;
+    vector<char> page;
+    vector<char> out;
+
+    ChunkCacheTest() :
+        cache(kCapacity),
+        page(PAGES_TO_BYTES(1)),
+        out(PAGES_TO_BYTES(1))
+    {}
+
+    ChunkCache::Key MakeKey(off_t chunkID, bool compressed = false) {
+        ChunkCache::Key key = { 1, chunkID, 0, compressed };
+        return key;
+    }
+
+    void Put(off_t chunkID, char value, bool compressed = false) {
+        memset(page.data(), value, page.size());
+        cache.Put(MakeKey(chunkID, compressed), page.data(), 1);
+    }
+
+    bool Get(off_t chunkID, bool compressed = false) {
+        return cache.Get(MakeKey(chunkID, compressed), out.data(), 1);
+    }
+};
+
+constexpr off_t ChunkCacheTest::kCapacity;
+
+TEST_F(ChunkCacheTest, GetCopiesThePages) {
+    Put(0, 'a');
+    ASSERT_TRUE(Get(0));
+    EXPECT_EQ('a', out[0]);
+    EXPECT_EQ('a', out[out.size() - 1]);
+    EXPECT_FALSE(Get(1));
+    EXPECT_EQ(1u, cache.GetHits());
+    EXPECT_EQ(1u, cache.GetMisses());
+}
+
+// the chunks used again stay while a scan goes through many others
+TEST_F(ChunkCacheTest, ScanDoesNotEvictHotChunks) {
+    for (off_t chunk = 0; chunk < 4; chunk++) {
+        Put(chunk, 'h');
+        ASSERT_TRUE(Get(chunk));
+    }
+
+    for (off_t chunk = 100; chunk < 200; chunk++)
+        Put(chunk, 's');
+
+    for (off_t chunk = 0; chunk < 4; chunk++)
+        EXPECT_TRUE(Get(chunk)) << "hot chunk " << chunk;
+    EXPECT_LE(cache.GetUsed(), kCapacity);
+}
+
+// a chunk in Am that is put again (read by two queries at once) stays there
+TEST_F(ChunkCacheTest, PutAgainKeepsHotChunk) {
+    Put(0, 'a');
+    ASSERT_TRUE(Get(0)); // to Am
+    Put(0, 'b');
+
+    for (off_t chunk = 100; chunk < 200; chunk++)
+        Put(chunk, 's');
+
+    ASSERT_TRUE(Get(0));
+    EXPECT_EQ('b', out[0]);
+}
+
+TEST_F(ChunkCacheTest, ForgetDropsTheChunks) {
+    Put(0, 'a');
+    Put(1, 'b');
+    cache.Forget(1, 0);
+    EXPECT_FALSE(Get(0));
+    EXPECT_TRUE(Get(1));
+
+    cache.Forget(1);
+    EXPECT_FALSE(Get(1));
+    EXPECT_EQ(0, cache.GetUsed());
+}
+
+// with no decompression threads the reader asks for the uncompressed
+// columns and must get them even if the compressed ones are cached
+TEST_F(ChunkCacheTest, NoVersionSwitchWithoutDecompression) {
+    Put(0, 'c', true);
+
+    ChunkCache::Key key = MakeKey(0, false);
+    cache.PickVersion(key, true, false);
+    EXPECT_FALSE(key.compressed);
+    EXPECT_FALSE(cache.Get(key, out.data(), 1));
+
+    // the cache fills up, still no compressed columns
+    for (off_t chunk = 1; chunk < kCapacity; chunk++)
+        Put(chunk, 'u');
+    ASSERT_TRUE(cache.UnderPressure());
+    key = MakeKey(kCapacity + 1, false);
+    cache.PickVersion(key, true, false);
+    EXPECT_FALSE(key.compressed);
+}
+
+TEST_F(ChunkCacheTest, VersionSwitchWithDecompression) {
+    Put(0, 'c', true);
+
+    // the cached version is taken
+    ChunkCache::Key key = MakeKey(0, false);
+    cache.PickVersion(key, true, true);
+    ASSERT_TRUE(key.compressed);
+    ASSERT_TRUE(cache.Get(key, out.data(), 1));
+    EXPECT_EQ('c', out[0]);
+
+    // not if there is no compressed version
+    key = MakeKey(0, false);
+    cache.PickVersion(key, false, true);
+    EXPECT_FALSE(key.compressed);
+
+    // the compressed one under pressure
+    for (off_t chunk = 1; chunk < kCapacity; chunk++)
+        Put(chunk, 'u');
+    ASSERT_TRUE(cache.UnderPressure());
+    key = MakeKey(kCapacity + 1, false);
+    cache.PickVersion(key, true, true);
+    EXPECT_TRUE(key.compressed);
+}
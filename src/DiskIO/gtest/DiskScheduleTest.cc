@@ -0,0 +1,87 @@
+//
+//  Copyright 2012 Alin Dobra and Christopher Jermaine
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+// Tests of the order in which the DiskArray sends the jobs of a stripe.
+
+#include <gtest/gtest.h>
+#include <list>
+#include <vector>
+#include "../headers/DiskSchedule.h"
+
+using namespace std;
+
+struct TestJob {
+    int id;
+    int operation;
+    int priority;
+    off_t firstPage;
+    double arrival;
+};
+
+class DiskScheduleTest : public ::testing::Test {
+protected:
+    static constexpr double kDeadlineMs = 500;
+
+    list<TestJob> jobs;
+
+    void Add(int id, int operation, int priority, off_t firstPage, double arrival = 0) {
+        TestJob job = { id, operation, priority, firstPage, arrival };
+        jobs.push_back(job);
+    }
+
+    // the ids in the order the jobs are sent, the head moving as they go
+    vector<int> Order(off_t headPage, double now = 0) {
+        vector<int> order;
+        while (!jobs.empty()) {
+            list<TestJob>::iterator it = PickStripeJob(jobs, headPage, now, kDeadlineMs);
+            order.push_back(it->id);
+            headPage = it->firstPage + 1;
+            jobs.erase(it);
+        }
+        return order;
+    }
+};
+
+constexpr double DiskScheduleTest::kDeadlineMs;
+
+// the read of the scan is sent after the one of the tile join, even though
+// it came first and is next to the head
+TEST_F(DiskScheduleTest, HigherPriorityReadFirst) {
+    Add(1, READ, 2, 10);
+    Add(2, READ, 1, 500);
+    EXPECT_EQ(vector<int>({ 2, 1 }), Order(10));
+}
+
+TEST_F(DiskScheduleTest, ReadsBeforeWrites) {
+    Add(1, WRITE, 1, 10);
+    Add(2, READ, 3, 20);
+    EXPECT_EQ(vector<int>({ 2, 1 }), Order(0));
+}
+
+TEST_F(DiskScheduleTest, ElevatorWithinPriority) {
+    Add(1, READ, 2, 5);
+    Add(2, READ, 2, 40);
+    Add(3, READ, 2, 25);
+    Add(4, READ, 2, 30);
+    EXPECT_EQ(vector<int>({ 3, 4, 2, 1 }), Order(20));
+}
+
+// a low priority job that waited past the deadline is not starved
+TEST_F(DiskScheduleTest, LateJobGoesFirst) {
+    Add(1, READ, 3, 10, 0.0);
+    Add(2, READ, 1, 20, 0.9);
+    EXPECT_EQ(vector<int>({ 1, 2 }), Order(0, 1.0));
+}
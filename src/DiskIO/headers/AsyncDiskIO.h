@@ -0,0 +1,126 @@
+//
+//  Copyright 2012 Alin Dobra and Christopher Jermaine
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+#ifndef _ASYNC_DISK_IO_H_
+#define _ASYNC_DISK_IO_H_
+
+#include <cstdint>
+#include <vector>
+
+#include <sys/types.h>
+#include <sys/uio.h>
+#include <linux/aio_abi.h>
+
+struct io_uring_sqe;
+struct io_uring_cqe;
+
+/** Asynchronous reads and writes on the file of a stripe, so that the
+  HDThread can keep many requests in flight on the disk instead of one.
+
+  Two backends are tried, in this order, when the object is created:
+
+  io_uring: a submission and a completion ring shared with the kernel
+      (Linux 5.1 and up).
+  Linux AIO: io_setup/io_submit/io_getevents, in the kernel for much
+      longer. It is only asynchronous on files opened with O_DIRECT.
+
+  Both are used through the system calls directly, no library is needed.
+  If neither can be set up (old kernel, system calls filtered out), the
+  object is not valid and the caller should do its requests synchronously.
+
+  Usage: Prepare() up to GetDepth() requests, Submit() them, and get them
+  back, in any order, with WaitCompletion(). The iovecs and the memory they
+  point to must stay untouched until the request is back. The object is
+  used by a single thread.
+*/
+class AsyncDiskIO {
+
+    public:
+        enum Backend {
+            ASYNC_NONE = 0,
+            ASYNC_IO_URING = 1,
+            ASYNC_LINUX_AIO = 2
+        };
+
+    private:
+        int fd; // the file the requests go to
+        unsigned depth; // most requests in flight
+        Backend backend;
+
+        unsigned inFlight; // prepared or submitted, not back yet
+        unsigned prepared; // prepared, not submitted
+
+        // io_uring
+        int ringFd;
+        void* sqRing;
+        size_t sqRingSize;
+        void* cqRing;
+        size_t cqRingSize;
+        struct io_uring_sqe* sqes;
+        size_t sqesSize;
+
+        unsigned* sqHead;
+        unsigned* sqTail;
+        unsigned* sqMask;
+        unsigned* sqArray;
+        unsigned* cqHead;
+        unsigned* cqTail;
+        unsigned* cqMask;
+        struct io_uring_cqe* cqes;
+
+        // Linux AIO
+        aio_context_t aioContext;
+        std::vector<struct iocb> iocbs; // one per slot
+        std::vector<struct iocb*> freeIocbs;
+        std::vector<struct iocb*> toSubmit;
+
+        bool SetUpIoUring();
+        bool SetUpLinuxAio();
+
+        void TearDown();
+
+    public:
+        // sets up a backend for file descriptor _fd that can have _depth
+        // requests in flight
+        AsyncDiskIO(int _fd, unsigned _depth);
+        ~AsyncDiskIO();
+
+        // false if no backend could be set up
+        bool IsValid() { return backend != ASYNC_NONE; }
+
+        Backend GetBackend() { return backend; }
+
+        unsigned GetDepth() { return depth; }
+
+        // number of requests prepared or submitted that did not come back
+        unsigned GetInFlight() { return inFlight; }
+
+        // prepares the reading (or writing) of the iovcnt buffers of iov from
+        // (to) position offset of the file. The tag comes back with the
+        // completion. At most GetDepth() requests can be in flight.
+        void Prepare(bool isWrite, const struct iovec* iov, int iovcnt, off_t offset, uint64_t tag);
+
+        // hands all the prepared requests to the kernel
+        void Submit();
+
+        // waits for a request to be done and returns its tag and its result,
+        // the number of bytes transferred or -errno
+        void WaitCompletion(uint64_t& tag, int64_t& result);
+
+        // name of the backend, for messages
+        const char* GetBackendName();
+};
+
+#endif // _ASYNC_DISK_IO_H_
@@ -0,0 +1,174 @@
+//
+//  Copyright 2012 Alin Dobra and Christopher Jermaine
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+#ifndef _CHUNK_CACHE_H_
+#define _CHUNK_CACHE_H_
+
+#include <cstdint>
+#include <list>
+#include <map>
+#include <memory>
+#include <pthread.h>
+#include <sys/types.h>
+
+/** Cache of the columns read from the disk, shared by the ChunkReaderWriters
+  of all the relations, so that the chunks read again by other queries (the
+  dimension tables, the dashboards) do not go to the disks.
+
+  What is cached is the pages of a column of a chunk as they are on disk,
+  compressed or not. A ChunkReaderWriter that finds the pages of a column
+  copies them in the memory of the column instead of reading them; the
+  chunk is then made as if it came from the disk, so nothing in the chunks
+  is shared between the queries.
+
+  The replacement is 2Q, so that a scan of a large relation does not push out
+  the columns that are used again and again:
+
+  A1in: the pages seen once, in FIFO order, a quarter of the cache once it
+      is full.
+  A1out: the keys (no pages) of the ones that left A1in, as much as half of
+      the cache would hold.
+  Am: the pages used again, while in A1in or A1out, in LRU order.
+
+  A scan reads every chunk once, so its columns go through A1in only.
+
+  Past CHUNK_CACHE_PRESSURE percent full, the cache is under pressure and the
+  ChunkReaderWriters read and cache the compressed version of the columns,
+  when they have one, so that more of them fit. They only do so, or take the
+  version that is cached instead of the one asked for, when the chunk goes
+  through the decompressor (see PickVersion).
+
+  The cache is used by all the ChunkReaderWriter threads at once, so every
+  method takes its mutex. The pages are copied out of the cache after the
+  mutex is let go.
+  */
+class ChunkCache {
+
+    public:
+        // the pages of a column of a chunk, in one of the versions
+        struct Key {
+            uint64_t relID;
+            off_t chunkID;
+            uint64_t column;
+            bool compressed;
+
+            bool operator < (const Key& other) const;
+        };
+
+    private:
+        // the cached pages; freed when the last user lets go of them
+        struct Pages {
+            void* data;
+            off_t sizePages;
+
+            Pages(const void* _data, off_t _sizePages);
+            ~Pages();
+        };
+        typedef std::shared_ptr<Pages> PagesPtr;
+
+        enum Queue { A1IN, AM };
+
+        struct Entry {
+            Key key;
+            PagesPtr pages;
+            Queue queue;
+        };
+        typedef std::list<Entry> EntryList;
+
+        struct Ghost {
+            Key key;
+            off_t sizePages;
+        };
+        typedef std::list<Ghost> GhostList;
+
+        pthread_mutex_t mutex;
+
+        off_t capacity; // most pages cached, 0 if the cache is off
+        off_t used; // pages in A1in and Am
+        off_t a1inUsed; // pages in A1in
+        off_t a1outUsed; // pages the keys of A1out stand for
+
+        // the newest are at the front
+        EntryList a1in;
+        EntryList am;
+        GhostList a1out;
+
+        std::map<Key, EntryList::iterator> entries;
+        std::map<Key, GhostList::iterator> ghosts;
+
+        // in pages
+        uint64_t hits;
+        uint64_t misses;
+
+        ChunkCache(ChunkCache&); // block the copy constructor
+
+        // makes room for sizePages more pages
+        void Evict(off_t sizePages);
+
+        // removes the entry (and its pages) from the cache
+        void Remove(std::map<Key, EntryList::iterator>::iterator it);
+
+    public:
+        // cache of capacityPages pages
+        ChunkCache(off_t capacityPages);
+        ~ChunkCache();
+
+        // the cache of the system, of CHUNK_CACHE_SIZE MB
+        static ChunkCache& GetChunkCache();
+
+        bool IsEnabled(void){ return capacity > 0; }
+
+        // true if the pages of key are cached, does not count as a use
+        bool IsCached(const Key& key);
+
+        // copies the sizePages cached pages of key to where; false (a miss) if
+        // they are not cached
+        bool Get(const Key& key, void* where, off_t sizePages);
+
+        // caches a copy of the sizePages pages at data for key
+        void Put(const Key& key, const void* data, off_t sizePages);
+
+        // forgets the columns of a chunk (deleted) or of a relation (emptied)
+        void Forget(uint64_t relID, off_t chunkID);
+        void Forget(uint64_t relID);
+
+        // true if the compressed versions should be preferred
+        bool UnderPressure(void);
+
+        // picks the version of the column to read, starting from the one the
+        // reader would read (key.compressed): the other one if it is cached
+        // and this one is not, the compressed one if the cache is under
+        // pressure. Nothing is changed if the column has no compressed version
+        // or if maySwitch is not set (the chunk is not decompressed before it
+        // is used, so the reader's choice has to stay)
+        void PickVersion(Key& key, bool hasCompressed, bool maySwitch);
+
+        // statistics, in pages
+        off_t GetUsed(void);
+        uint64_t GetHits(void);
+        uint64_t GetMisses(void);
+};
+
+inline bool ChunkCache::Key::operator < (const Key& other) const {
+    if (relID != other.relID)
+        return relID < other.relID;
+    if (chunkID != other.chunkID)
+        return chunkID < other.chunkID;
+    if (column != other.column)
+        return column < other.column;
+    return compressed < other.compressed;
+}
+
+#endif // _CHUNK_CACHE_H_
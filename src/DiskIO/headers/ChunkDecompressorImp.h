@@ -0,0 +1,55 @@
+//
+//  Copyright 2013 Tera Insights LLC
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+#ifndef _CHUNK_DECOMPRESSOR_IMP_H_
+#define _CHUNK_DECOMPRESSOR_IMP_H_
+
+#include "DiskIOMessages.h"
+#include "EventProcessorImp.h"
+#include "EventProcessor.h"
+
+/** Pool of threads that decompress the chunks read from disk.
+
+  Compressed columns are otherwise decompressed a piece at a time by
+  the CPU worker that goes through them, so every work function on a
+  fresh chunk stalls on the decompression. The ChunkReaderWriters send
+  the chunks with compressed columns here instead of to the execution
+  engine; every column is decompressed in full (the compressed data is
+  kept, see MMappedStorage::Decompress) and the chunk goes on to the
+  execution engine as if it came straight from the disk.
+
+  The chunks are independent so the threads need no locking; a chunk
+  is handled by a single thread.
+
+  There is one decompressor, shared by all the ChunkReaderWriters,
+  started by the DiskPool with NUM_DECOMPRESSION_THREADS threads.
+  */
+
+class ChunkDecompressorImp : public EventProcessorImp {
+
+    public:
+        // numThreads is the most threads that can be started with ForkAndSpin
+        ChunkDecompressorImp(int numThreads);
+        virtual ~ChunkDecompressorImp();
+
+        //////////////////////////
+        // MESSAGE HANDLERS
+
+        // a chunk with compressed columns is off the disk
+        MESSAGE_HANDLER_DECLARATION(DecompressChunkFunc);
+};
+
+
+#endif // _CHUNK_DECOMPRESSOR_IMP_H_
@@ -18,6 +18,7 @@
 
 #include <vector>
 #include <map>
+#include <set>
 #include <utility>
 #include <cstddef>
 #include <pthread.h>
@@ -51,6 +52,14 @@
   On Reading, the class creates chunks so it does all the heavy
   lifting in terms of memory allocation and initialization. This is
   why this class should be asynchronous and allow multi-threading.
+
+  Chunks can be deleted (DeleteChunk); once too much of the disk array
+  is lost between the allocations (DISK_COMPACTION_THRESHOLD), the
+  space is filled by moving the chunks after it lower in the disk array
+  (CompactChunks), one chunk at a time, with reads and writes of low
+  priority. The pages no longer used are freed only once the metadata
+  is flushed and the reads that might go to them are back, so the
+  metadata on disk and the reads out never see pages reused by others.
   */
 
 class ChunkReaderWriterImp : public EventProcessorImp {
@@ -60,9 +69,14 @@ class ChunkReaderWriterImp : public EventProcessorImp {
     public:
         typedef std::pair<int64_t, int64_t> ClusterRange;
         typedef std::vector<ClusterRange> ClusterRangeList;
+        // zone maps indexed by chunk, then by column
+        typedef std::vector< std::vector<ColumnZoneMaps> > ZoneMapList;
 
         // the file scanner will get the messages when the job is done
-        ChunkReaderWriterImp(const char* _scannerName, uint64_t _numCols, EventProcessor& _execEngine);
+        // the chunks read with compressed columns go through _decompressor
+        // first, if it is valid (see ChunkDecompressorImp.h)
+        ChunkReaderWriterImp(const char* _scannerName, uint64_t _numCols, EventProcessor& _execEngine,
+                EventProcessor& _decompressor);
         virtual ~ChunkReaderWriterImp();
 
         // method to get the number of chunks
@@ -81,6 +95,21 @@ class ChunkReaderWriterImp : public EventProcessorImp {
           return ret;
         }
 
+        // zone maps of all the columns of all the chunks, same rules as above
+        ZoneMapList GetZoneMaps(void) {
+          off_t nChunks = metadataMgr.getNumChunks();
+          unsigned long nCols = metadataMgr.getNumCols();
+          ZoneMapList ret(nChunks);
+
+          for( off_t i = 0; i < nChunks; i++ ) {
+            for( unsigned long j = 0; j < nCols; j++ ) {
+              ret[i].push_back(metadataMgr.getZoneMaps(i, j));
+            }
+          }
+
+          return ret;
+        }
+
         //////////////////////////
         // MESSAGE HANDLERS
 
@@ -99,6 +128,12 @@ class ChunkReaderWriterImp : public EventProcessorImp {
         MESSAGE_HANDLER_DECLARATION(DeleteContentFunc);
 
         MESSAGE_HANDLER_DECLARATION(ClusterUpdateFunc);
+
+        MESSAGE_HANDLER_DECLARATION(DeleteChunkFunc);
+
+        MESSAGE_HANDLER_DECLARATION(CompactChunksFunc);
+
+        MESSAGE_HANDLER_DECLARATION(SetColumnCodecFunc);
 };
 
 
@@ -75,6 +75,18 @@ class DiskArray : public EventProcessor {
         // method to delete all content of a relation
         void DeleteRelationSpace(uint64_t relID);
 
+        // method to free _noPages pages at startPage, allocated to relID
+        void FreePages(off_t startPage, off_t _noPages, uint64_t relID);
+
+        // method to move pages lower in the array, see DiskArrayImp
+        off_t RelocatePages(off_t startPage, off_t _noPages, uint64_t relID);
+
+        // pages lost between the allocations
+        off_t FragmentedSpace(void){ return array->FragmentedSpace(); }
+
+        // is it time to compact the relations, see DiskArrayImp
+        bool NeedsCompaction(void){ return array->NeedsCompaction(); }
+
         // function to force the array to writte metadata on disk
         // should be done at the end of each bulk load (pointless before sice we want the whole bulkload to succeed)
         void Flush(void){ array->Flush();}
@@ -88,6 +100,10 @@ class DiskArray : public EventProcessor {
         // ask about the amount of IO
         off_t NumPagesProcessed(void);
         off_t NumPagesDelta(void); // since last call
+
+        // how many chunks, out of maxChunks, the table scanners should have
+        // requested ahead; fewer while one of the disks is slow
+        static int ReadAheadChunks(int maxChunks);
 };
 
 // INLINE methods
@@ -107,6 +123,21 @@ inline off_t DiskArray::AllocatePages(off_t _noPages, uint64_t relID){
     return array->AllocatePages(_noPages,relID);
 }
 
+inline void DiskArray::FreePages(off_t startPage, off_t _noPages, uint64_t relID){
+    array->FreePages(startPage,_noPages,relID);
+}
+
+inline off_t DiskArray::RelocatePages(off_t startPage, off_t _noPages, uint64_t relID){
+    return array->RelocatePages(startPage,_noPages,relID);
+}
+
+inline int DiskArray::ReadAheadChunks(int maxChunks){
+    if (array == NULL)
+        return maxChunks;
+    int chunks = maxChunks * array->ReadAheadPercent() / 100;
+    return chunks > 0 ? chunks : 1;
+}
+
 inline DiskArray& DiskArray::GetDiskArray(){
     return oneInstance;
 }
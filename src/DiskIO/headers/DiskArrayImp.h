@@ -22,7 +22,11 @@
 #include "DiskMemoryAllocator.h"
 
 
+#include "Timer.h"
+
 #include <vector>
+#include <list>
+#include <atomic>
 #include <sqlite3.h>
 
 /** Disk array driver. Ideally, there is only one in the system and
@@ -38,7 +42,10 @@
   defines the struct DisksMetadata that contains all the info it
   needs. Once created, this metadata will not change.q
 
-  For now, there is no deletion.
+  The space is managed per relation by the DiskMemoryAllocator. Whole
+  relations or single ranges of pages (deleted or moved chunks) can be
+  freed; the free space is reused by later allocations and reported to the
+  profiler as "space fragmented".
 
     Tasks:
 
@@ -47,6 +54,19 @@
 
     C. Implement the striping strategy (for now, just the simple random striping)
 
+    B. Schedule the jobs of each stripe. At most DISK_SCHED_JOBS_PER_STRIPE
+    jobs are out on a stripe, the others wait in the array. When the stripe
+    is done with a job (StripeJobDone), the next one is picked by:
+      1. the oldest job that waited more than DISK_SCHED_DEADLINE_MS
+      2. reads before writes (writes wait while reads are backlogged)
+      3. higher priority first (1 is the highest, as in ExecEngine)
+      4. elevator order: the first job at or after the last page sent to
+      the stripe, wrapping around to the lowest page
+
+    E. Keep per disk statistics (seconds per page) and tell the table
+    scanners to read ahead fewer chunks while a disk is slow (see
+    ReadAheadPercent()).
+
     D. Manage the space in the repository. A very simple approach is
     used now that consists in maintaining a threshold beyound which
     all pages are empty.
@@ -63,7 +83,6 @@
     1. Allow redundancy in the HDThreads to mask disk problems
     a. add messages from HDThreads to the DiskArray indicating disk problems
 
-    2. Use statistics in a creative way
 
     Future Improvements:
     0. allow deletions and manage space better. Bitmap mask for available pages? Vector of free ranges?
@@ -138,6 +157,40 @@ class DiskArrayImp : public EventProcessorImp {
         off_t totalPages; // total number of pages read by the system
         off_t pagesAtLastCall;
 
+        // how much of the maximum read-ahead the table scanners should use,
+        // in percent; lowered while a disk is slow
+        std::atomic<int> readAheadPercent;
+        int slowDisk; // the disk found slow, -1 if none
+
+        // recomputes the read-ahead from the statistics of the disks
+        void UpdateReadAhead(void);
+
+        //////////// scheduling
+        // a job for a stripe, waiting for the stripe to have room for it
+        struct StripeJob {
+            off_t requestId;
+            int operation;
+            int priority;
+            DistributedCounter* counter;
+            EventProcessor requestor;
+            DiskRequestDataContainer requests;
+            off_t firstPage; // first and last+1 pages of the job on the stripe
+            off_t endPage;
+            double arrival; // when the job got to the array, on clock
+        };
+        typedef std::list<StripeJob> StripeJobList;
+
+        std::vector<StripeJobList> pending; // per stripe, in arrival order
+        std::vector<int> jobsOut; // per stripe, jobs sent and not done
+        std::vector<off_t> headPage; // per stripe, the end of the last job sent
+        Timer clock;
+
+        // the job of the stripe to send next, see B. above and DiskSchedule.h
+        StripeJobList::iterator PickJob(uint64_t stripe);
+
+        // sends jobs to the stripe while it has room for them
+        void Dispatch(uint64_t stripe);
+
         // allign the page to the larger disk page using pageMultiplier
         off_t PageAllign(off_t page);
 
@@ -174,6 +227,25 @@ class DiskArrayImp : public EventProcessorImp {
         // method to delete all content of a relation
         void DeleteRelationSpace(uint64_t relID);
 
+        // method to free _noPages pages at startPage, allocated to relID
+        void FreePages(off_t startPage, off_t _noPages, uint64_t relID);
+
+        // method to find free space lower in the array for the _noPages
+        // pages at startPage of relID. Returns the new start page, allocated
+        // to relID, or -1 if the pages should stay where they are.
+        off_t RelocatePages(off_t startPage, off_t _noPages, uint64_t relID);
+
+        // space in use and space lost between the allocations, in pages
+        off_t AllocatedSpace(void){ return diskSpaceMng.AllocatedSpace(); }
+        off_t FragmentedSpace(void){ return diskSpaceMng.FragmentedSpace(); }
+
+        // true if the fragmented space is over DISK_COMPACTION_THRESHOLD
+        // percent of the allocated space
+        bool NeedsCompaction(void);
+
+        // sends the space counters to the profiler
+        void ReportSpace(void);
+
         // statistics
         void PrintStatistics(void);
 
@@ -190,11 +262,17 @@ class DiskArrayImp : public EventProcessorImp {
         off_t NumPagesProcessed(void);
         off_t NumPagesDelta(void); // since last call
 
+        // percent of the maximum read-ahead the table scanners should use
+        int ReadAheadPercent(void){ return readAheadPercent; }
+
         // this message is received when the top wants an operation performed
         MESSAGE_HANDLER_DECLARATION(DoDiskOperation);
 
         // this mesage is sent by the HDThreads with statistics on throughput
         MESSAGE_HANDLER_DECLARATION(ProcessDiskStatistics);
+
+        // this message is sent by the HDThreads when they are done with a job
+        MESSAGE_HANDLER_DECLARATION(ProcessStripeJobDone);
 };
 
 //////////////////
@@ -215,6 +293,7 @@ inline void DiskArrayImp::Flush(sqlite3* db){ diskSpaceMng.Flush(db); }
 
 inline void DiskArrayImp::DeleteRelationSpace(uint64_t relID){
     diskSpaceMng.DiskFree(relID);
+    ReportSpace();
 }
 
 inline off_t DiskArrayImp::PageAllign (off_t _noPages){
@@ -229,5 +308,15 @@ inline off_t DiskArrayImp::AllocatePages(off_t _noPages, uint64_t relID){
     return diskSpaceMng.DiskAlloc(_noPages, relID);
 }
 
+inline void DiskArrayImp::FreePages(off_t startPage, off_t _noPages, uint64_t relID){
+    // the pages were alligned when allocated
+    diskSpaceMng.DiskFreePages(startPage, PageAllign(_noPages), relID);
+    ReportSpace();
+}
+
+inline off_t DiskArrayImp::RelocatePages(off_t startPage, off_t _noPages, uint64_t relID){
+    return diskSpaceMng.DiskRelocate(startPage, PageAllign(_noPages), relID);
+}
+
 
 #endif // _DISKARRAY_IMP_H_
@@ -21,7 +21,6 @@
 
 #include <map>
 #include <vector>
-#include <list>
 #include <pthread.h>
 #include <sys/mman.h>
 
@@ -42,7 +41,7 @@ class DiskMemoryAllocator {
     // Keep the record of chunk
     struct ChunkInfo{
         off_t startPage;    // Keep start page number
-        off_t size;         // keep the chunk size, for now this is always a block size
+        off_t size;         // keep the chunk size, a block or the piece of a free extent or of a split chunk
         off_t nextFreePage; // Next free page
     };
 
@@ -55,12 +54,31 @@ class DiskMemoryAllocator {
     // last chunk will fill free page request
     std::map<uint64_t, ChunkList*> mRelationIDToChunkList;
 
-    // Keep freed chunks for future use
-    std::list<ChunkInfo*> mFreeChunks;
+    // A range of free pages below mLastPage
+    struct FreeExtent {
+        off_t startPage;
+        off_t size;
+    };
+
+    // Freed space for future use, sorted on startPage and coalesced: no two
+    // extents touch, and none touches mLastPage (that space goes back to it)
+    std::vector<FreeExtent> mFreeExtents;
 
     DiskMemoryAllocator(DiskMemoryAllocator&); // block the copy constructor
 
-    void CreateNewChunk(ChunkList* l);
+    // puts the pages [startPage, startPage+size) in the free extents,
+    // merging with the neighbours
+    void AddFreeExtent(off_t startPage, off_t size);
+
+    // the smallest free extent of at least size pages, -1 if none
+    int BestFreeExtent(off_t size);
+
+    // takes size pages from the start of free extent index
+    off_t TakeFreeExtent(int index, off_t size);
+
+    // adds to l a new block with room for at least minSize pages, the new
+    // last chunk of l
+    void CreateNewChunk(ChunkList* l, off_t minSize);
 
     public:
     // default constructor; initializes the allocator
@@ -75,6 +93,16 @@ class DiskMemoryAllocator {
     // function to deallocate complete relation
     void DiskFree(uint64_t relID);
 
+    // function to deallocate pSize pages starting at startPage, allocated
+    // before to relID with DiskAlloc (a deleted or rewritten chunk)
+    void DiskFreePages(off_t startPage, off_t pSize, uint64_t relID);
+
+    // finds pSize free pages below startPage, in the first free extent with
+    // room, and allocates them to relID. Used by compaction to move the pages
+    // at startPage lower; the old pages are freed with DiskFreePages once
+    // moved. Returns the new start page or -1 if there is no room below.
+    off_t DiskRelocate(off_t startPage, off_t pSize, uint64_t relID);
+
     // method to switch the space from one relation to another relation
     // used to "glue" relations together
     void StealSpace(uint64_t oldRelID, uint64_t newRelID);
@@ -86,7 +114,8 @@ class DiskMemoryAllocator {
     // How much space we are using
     off_t AllocatedSpace();
 
-    // How much space is wasted
+    // How much space is wasted: the free extents and the unused ends of the
+    // blocks, other than the last of each relation, below the last page
     off_t FragmentedSpace();
 
     // Destructor (frees the mmaps)
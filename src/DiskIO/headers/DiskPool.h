@@ -21,6 +21,8 @@
 #include "History.h"
 #include "Tokens.h"
 #include "Chunk.h"
+#include "ZoneMap.h"
+#include "EventProcessor.h"
 
 #include <map>
 #include <string>
@@ -46,6 +48,8 @@ class DiskPool {
     public:
         typedef std::pair<int64_t, int64_t> ClusterRange;
         typedef std::vector<ClusterRange> ClusterRangeList;
+        // zone maps of a column, indexed by chunk
+        typedef std::vector<ColumnZoneMaps> ZoneMapList;
     
     private:
         typedef EfficientMap< TableScanID, EventProcessor > EVProcMap;
@@ -59,12 +63,23 @@ class DiskPool {
         typedef std::map< TableScanID, ClusterRangeList > ClusterRangeMap;
         ClusterRangeMap clusterRanges;
 
+        // zone maps of all the columns, indexed by chunk then by column
+        typedef std::map< TableScanID, std::vector< std::vector<ColumnZoneMaps> > > ZoneMapMap;
+        ZoneMapMap zoneMaps;
+
+        // decompresses the chunks read with compressed columns for all the
+        // files; started with the first file, not valid if
+        // NUM_DECOMPRESSION_THREADS is 0
+        EventProcessor decompressor;
+
     public:
         // start the disk pool
         DiskPool():
           files(),
           sizes(),
-          clusterRanges()
+          clusterRanges(),
+          zoneMaps(),
+          decompressor()
         {}
 
         // destructor
@@ -88,11 +103,20 @@ class DiskPool {
 
            colsToProcess is a set of pairs that specify the logical--physcal columns.
 
+           For reads, the fragment range of id, if it has one, says that only the
+           tuples of those fragments can match the queries.
+
+           The priority of a read is the one of ExecEngine (1 is the highest),
+           the one the disk token was asked for with (DISK_SCAN_PRIORITY,
+           DISK_TILE_JOIN_PRIORITY); the disk array serves the reads with
+           higher priorities first.
+
 */
 
         void ReadRequest(ChunkID& id, WayPointID &requestor, bool useUncompressed,
                 HistoryList &lineage, QueryExitContainer &dest,
-                GenericWorkToken& token, SlotPairContainer& colsToProcess);
+                GenericWorkToken& token, SlotPairContainer& colsToProcess,
+                int priority);
 
         void WriteRequest(ChunkID& id, WayPointID &requestor, Chunk& chunk,
                 HistoryList &lineage, QueryExitContainer &dest,
@@ -103,6 +127,22 @@ class DiskPool {
 
         void Flush (TableScanID id);
 
+        /* Deletes a chunk of a file (see DeleteChunk in DiskIOMessages). The
+           chunk keeps its ID and is read as a chunk with no tuples; its space
+           is reused and the chunks after it are moved lower to fill it. A
+           chunk is rewritten by deleting it and writing the new version. */
+        void DeleteChunk(ChunkID& id);
+
+        /* Moves the chunks of a file to the free space lower in the disk
+           array, while the file is used, if too much space is lost (see
+           CompactChunks in DiskIOMessages). */
+        void Compact(TableScanID id);
+
+        /* Compacts all the files started if too much of the disk array is
+           lost between the allocations. Called after the deletions and
+           every time the execution engine is configured. */
+        void CompactFragmented(void);
+
         /* If the file scanner associated with the name is not started, it
            will be started by this function. If already running, nothing happens.
 
@@ -124,8 +164,22 @@ class DiskPool {
 
         ClusterRangeList ClusterRanges(TableScanID);
 
+        // zone maps of a column of the file, for the chunks it had when it was
+        // started (like the cluster ranges)
+        ZoneMapList ZoneMaps(TableScanID, int column);
+
         void DeleteContent(std::string);
 
+        // sets the codec of a column of a relation (see SetColumnCodec in
+        // DiskIOMessages), starting its file if needed (numCols as in AddFile)
+        void SetColumnCodec(std::string name, uint64_t numCols, int column,
+                int codec, int level);
+
+        // deletes the chunks of a relation with DeleteChunk, starting its file
+        // if needed (numCols as in AddFile), then compacts the file
+        void DeleteChunks(std::string name, uint64_t numCols,
+                const std::vector<off_t>& chunks);
+
         void DeleteRelation(std::string name);
 
 };
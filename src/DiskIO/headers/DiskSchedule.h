@@ -0,0 +1,80 @@
+//
+//  Copyright 2012 Alin Dobra and Christopher Jermaine
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+#ifndef _DISK_SCHEDULE_H_
+#define _DISK_SCHEDULE_H_
+
+#include <sys/types.h>
+
+// the disk operations
+#define READ 1
+#define WRITE 2
+
+/** Picks the job a stripe does next, out of the jobs waiting for it (see
+  DiskArrayImp, B.):
+
+    1. the oldest job that waited more than deadlineMs
+    2. reads before writes (writes wait while reads are backlogged)
+    3. higher priority first (1 is the highest, as in ExecEngine)
+    4. elevator order: the first job at or after headPage, the end of the
+    last job sent to the stripe, wrapping around to the lowest page
+
+  JobList is a list of jobs in arrival order, with the fields operation
+  (READ or WRITE), priority, firstPage and arrival (in seconds, on the same
+  clock as now). jobs must not be empty.
+  */
+template <class JobList>
+typename JobList::iterator PickStripeJob(JobList& jobs, off_t headPage, double now,
+        double deadlineMs){
+    typedef typename JobList::iterator Iterator;
+
+    // 1. the jobs are in arrival order, the first late one is the oldest
+    for (Iterator it = jobs.begin(); it != jobs.end(); ++it) {
+        if ((now - it->arrival) * 1000.0 > deadlineMs)
+            return it;
+    }
+
+    // 2. writes wait while there are reads
+    int operation = WRITE;
+    for (Iterator it = jobs.begin(); it != jobs.end(); ++it) {
+        if (it->operation == READ) {
+            operation = READ;
+            break;
+        }
+    }
+
+    // 3. and 4. the highest priority, then the first job after the head,
+    // or the lowest one if they are all behind it
+    Iterator best = jobs.end();
+    for (Iterator it = jobs.begin(); it != jobs.end(); ++it) {
+        if (it->operation != operation)
+            continue;
+        if (best == jobs.end() || it->priority < best->priority) {
+            best = it;
+            continue;
+        }
+        if (it->priority > best->priority)
+            continue;
+
+        bool itAhead = it->firstPage >= headPage;
+        bool bestAhead = best->firstPage >= headPage;
+        if (itAhead != bestAhead ? itAhead : it->firstPage < best->firstPage)
+            best = it;
+    }
+
+    return best;
+}
+
+#endif // _DISK_SCHEDULE_H_
@@ -19,9 +19,12 @@
 #define _FILEMETADATA_H
 
 #include <vector>
+#include <map>
 #include <assert.h>
 #include "Errors.h"
 #include "Swap.h"
+#include "ColumnCodec.h"
+#include "ZoneMap.h"
 #include <cstdio>
 #include <cinttypes>
 #include <sqlite3.h>
@@ -39,6 +42,12 @@
     Columns -- info on columns/chunk (storage)
     colNo:uint64_t, relID:uint64_t, chunkID:uint64_t, startPage:uint64_t, sizeInPages:uint64_t, columnType:uint64_t,
     varStartPage:uint64_t
+    ColumnCodecs -- codec of the compressed columns not compressed with QuickLZ, and with
+    chunkID -1 the codec and level set for the column (see setColumnCodec)
+    relID:uint64_t, chunkID:int64_t, colNo:uint64_t, codec:uint64_t, level:int64_t
+    ZoneMaps -- zone maps of the columns (see ZoneMap.h), fragment is -1 for the whole column
+    relID:uint64_t, chunkID:uint64_t, colNo:uint64_t, fragment:int64_t, minValue:int64_t,
+    maxValue:int64_t, nullCount:uint64_t
 
     **/
 
@@ -176,7 +185,11 @@ private:
     uint64_t sizePagesCompr;
     uint64_t sizeBytes;
     uint64_t sizeBytesCompr;
+    // codec of the compressed data (see ColumnCodec.h)
+    uint64_t codec;
     Fragments fragments;
+    // zone maps of the column and of its fragments
+    ColumnZoneMaps zoneMaps;
 
 public:
 
@@ -185,13 +198,15 @@ public:
             uint64_t _startPageCompr = -1,
             uint64_t _sizePagesCompr = -1,
             uint64_t _sizeBytes = -1,
-            uint64_t _sizeBytesCompr = -1) :
+            uint64_t _sizeBytesCompr = -1,
+            uint64_t _codec = CODEC_QUICKLZ) :
         startPage(_startPage),
         sizePages(_sizePages),
         startPageCompr(_startPageCompr),
         sizePagesCompr(_sizePagesCompr),
         sizeBytes(_sizeBytes),
-        sizeBytesCompr(_sizeBytesCompr)
+        sizeBytesCompr(_sizeBytesCompr),
+        codec(_codec)
     {}
 
         ColumnMetaData (Fragments& _fragments, uint64_t _startPage = -1,
@@ -199,14 +214,18 @@ public:
                                         uint64_t _startPageCompr = -1,
                                         uint64_t _sizePagesCompr = -1,
                                         uint64_t _sizeBytes = -1,
-                                        uint64_t _sizeBytesCompr = -1) :
+                                        uint64_t _sizeBytesCompr = -1,
+                                        uint64_t _codec = CODEC_QUICKLZ,
+                                        const ColumnZoneMaps& _zoneMaps = ColumnZoneMaps()) :
                                         startPage(_startPage),
                                          sizePages(_sizePages),
                                         startPageCompr(_startPageCompr),
                                         sizePagesCompr(_sizePagesCompr),
                                         sizeBytes(_sizeBytes),
                                         sizeBytesCompr(_sizeBytesCompr),
-                                        fragments(_fragments) {}
+                                        codec(_codec),
+                                        fragments(_fragments),
+                                        zoneMaps(_zoneMaps) {}
 
         // Load from disk
         void Initialize(long int _startPage, long int _sizePages,
@@ -225,7 +244,13 @@ public:
         off_t getSizeBytes();
         off_t getSizeBytesCompr();
 
+        // Returns the codec the compressed data was compressed with.
+        int getCodec();
+
         Fragments& getFragments();
+
+        // Returns the zone maps, not valid if they were not collected.
+        ColumnZoneMaps& getZoneMaps();
 };
 
 class ChunkMetaD {
@@ -276,8 +301,12 @@ public:
         off_t getSizeBytes(unsigned long numCol);
         off_t getSizeBytesCompr(unsigned long numCol);
 
+        // Returns the codec of the compressed data for a given column.
+        int getCodec(unsigned long numCol);
+
         uint64_t getNumTuples ();
         Fragments& getFragments(unsigned long numCol);
+        ColumnZoneMaps& getZoneMaps(unsigned long numCol);
         FragmentsTuples& getFragmentsTuples() {return fragTuple;}
 
         // adds a column (must be done in order)
@@ -288,7 +317,9 @@ public:
                 off_t _startPageCompr,
                 off_t _sizeByesCompr,
                 off_t _sizePagesCompr,
-                Fragments& _fragments);
+                Fragments& _fragments,
+                int _codec = CODEC_QUICKLZ,
+                const ColumnZoneMaps& _zoneMaps = ColumnZoneMaps());
 
         bool isDirty() const;
 
@@ -330,6 +361,9 @@ class FileMetadata {
         // how many columns have been filled
         long colsFilled;
 
+        // the codecs set for the columns, by column
+        std::map<unsigned long, ColumnCodec> columnCodecs;
+
         static void DeleteContentSQL(uint64_t relID, sqlite3* db);
 
     public:
@@ -367,9 +401,17 @@ class FileMetadata {
         off_t getSizeBytes(off_t numChunk, unsigned long numCol);
         off_t getSizeBytesCompr(off_t numChunk, unsigned long numCol);
 
+        // Returns the codec the compressed data of a given chunk and column was
+        // compressed with. Old relations have no codecs recorded and get QuickLZ.
+        int getCodec(off_t numChunk, unsigned long numCol);
+
         Fragments& getFragments(off_t numChunk, unsigned long numCol);
         FragmentsTuples& getFragmentsTuples(off_t numChunk);
 
+        // Returns the zone maps of a given chunk and column. They are not valid
+        // for the columns written before zone maps existed or not fixed width.
+        ColumnZoneMaps& getZoneMaps(off_t numChunk, unsigned long numCol);
+
         ClusterRange getClusterRange(off_t numChunk) const;
         void updateClusterRange(off_t numChunk, const ClusterRange & r);
 
@@ -394,13 +436,27 @@ class FileMetadata {
         void setNumTuples(off_t _numTuples);
 
         // adds a column (must be done in order)
+        // _codec is the codec the compressed version was compressed with
+        // _zoneMaps are the zone maps of the column, if they were collected
         void addColumn(off_t _startPage,
                 off_t _sizeBytes,
                 off_t _sizePages,
                 off_t _startPageCompr,
                 off_t _sizeByesCompr,
                 off_t _sizePagesCompr,
-                Fragments& _fragments);
+                Fragments& _fragments,
+                int _codec = CODEC_QUICKLZ,
+                const ColumnZoneMaps& _zoneMaps = ColumnZoneMaps());
+
+        /** The codec and level the compressed version of a column is made
+            with, in the chunks written from now on. A column without one is
+            only compressed if a lightweight encoding pays off for the chunk.
+            The codecs are kept with the relation, not with the chunks, so
+            DeleteContent leaves them.
+         */
+        void setColumnCodec(unsigned long numCol, ColumnCodec codec);
+        // returns false if the column has no codec set
+        bool getColumnCodec(unsigned long numCol, ColumnCodec& codec);
 
         // reserve pages in the storage; the return is the index of the first page
         // in the sequence
@@ -409,6 +465,22 @@ class FileMetadata {
 
         bool DeleteContent(sqlite3 * db = nullptr);
 
+        /** Methods to delete and move chunks
+
+            A deleted chunk keeps its ID, so that the IDs of the chunks after it
+            do not change, but has no tuples and no pages left. It is the only
+            kind of chunk with no tuples. The pages are freed by the caller,
+            with the sizes from before the deletion.
+
+            A column is moved by writing its pages elsewhere and then giving
+            the metadata the new start page.
+         */
+        void deleteChunk(off_t numChunk);
+        bool isDeleted(off_t numChunk);
+
+        // _compressed says which version of the column moved
+        void moveColumn(off_t numChunk, unsigned long numCol, bool _compressed, off_t _newStartPage);
+
         // saving the content of the metadata file
         // if the file specified exists, it is erased
         void Flush(void);
@@ -577,10 +649,20 @@ off_t ColumnMetaData::getSizeBytesCompr() {
     return sizeBytesCompr;
 }
 
+inline
+int ColumnMetaData::getCodec() {
+    return codec;
+}
+
 inline
 Fragments& ColumnMetaData::getFragments(){
     return fragments;
 }
+
+inline
+ColumnZoneMaps& ColumnMetaData::getZoneMaps(){
+    return zoneMaps;
+}
 // ===========================INLINE methods for ChunkMetaData =================
 inline
 void ChunkMetaD :: Initialize (uint64_t _numCols, long int _numTuples,
@@ -634,6 +716,13 @@ inline off_t ChunkMetaD::getSizeBytesCompr(unsigned long numCol) {
     return colMetaData[numCol].getSizeBytesCompr();
 }
 
+inline int ChunkMetaD::getCodec(unsigned long numCol) {
+#ifdef DEBUG
+    assert(numCol < colMetaData.size());
+#endif
+    return colMetaData[numCol].getCodec();
+}
+
 inline Fragments& ChunkMetaD::getFragments(unsigned long numCol) {
 #ifdef DEBUG
     assert(numCol < colMetaData.size());
@@ -641,6 +730,13 @@ inline Fragments& ChunkMetaD::getFragments(unsigned long numCol) {
     return colMetaData[numCol].getFragments();
 }
 
+inline ColumnZoneMaps& ChunkMetaD::getZoneMaps(unsigned long numCol) {
+#ifdef DEBUG
+    assert(numCol < colMetaData.size());
+#endif
+    return colMetaData[numCol].getZoneMaps();
+}
+
 inline uint64_t ChunkMetaD::getNumTuples () {
     return numTuples;
 }
@@ -652,9 +748,11 @@ inline void ChunkMetaD::addColumn(
                 off_t _startPageCompr,
                 off_t _sizeBytesCompr,
                 off_t _sizePagesCompr,
-                Fragments& _fragments) {
+                Fragments& _fragments,
+                int _codec,
+                const ColumnZoneMaps& _zoneMaps) {
 
-    ColumnMetaData col (_fragments, _startPage, _sizePages, _startPageCompr, _sizePagesCompr, _sizeBytes, _sizeBytesCompr);
+    ColumnMetaData col (_fragments, _startPage, _sizePages, _startPageCompr, _sizePagesCompr, _sizeBytes, _sizeBytesCompr, _codec, _zoneMaps);
     colMetaData.push_back(col);
 }
 
@@ -692,6 +790,13 @@ inline off_t FileMetadata::getNumTuples(off_t numChunk) {
     return chunkMetaD[numChunk].getNumTuples();
 }
 
+inline bool FileMetadata::isDeleted(off_t numChunk) {
+#ifdef DEBUG
+    assert(numChunk < chunkMetaD.size());
+#endif
+    return chunkMetaD[numChunk].getNumTuples() == 0;
+}
+
 inline off_t FileMetadata::getStartPage(off_t numChunk, unsigned long numCol) {
 #ifdef DEBUG
     assert(numChunk < chunkMetaD.size());
@@ -734,6 +839,28 @@ inline off_t FileMetadata::getSizeBytesCompr(off_t numChunk, unsigned long numCo
     return chunkMetaD[numChunk].getSizeBytesCompr(numCol);
 }
 
+inline void FileMetadata::setColumnCodec(unsigned long numCol, ColumnCodec codec) {
+    FATALIF(numCol >= (unsigned long) numCols, "Setting the codec of column %lu that is not in relation %s",
+        numCol, relName);
+    columnCodecs[numCol] = codec;
+    modified = true;
+}
+
+inline bool FileMetadata::getColumnCodec(unsigned long numCol, ColumnCodec& codec) {
+    std::map<unsigned long, ColumnCodec>::iterator it = columnCodecs.find(numCol);
+    if (it == columnCodecs.end())
+        return false;
+    codec = it->second;
+    return true;
+}
+
+inline int FileMetadata::getCodec(off_t numChunk, unsigned long numCol) {
+#ifdef DEBUG
+    assert(numChunk < chunkMetaD.size());
+#endif
+    return chunkMetaD[numChunk].getCodec(numCol);
+}
+
 inline Fragments& FileMetadata::getFragments(off_t numChunk, unsigned long numCol) {
 #ifdef DEBUG
     assert(numChunk < chunkMetaD.size());
@@ -741,6 +868,13 @@ inline Fragments& FileMetadata::getFragments(off_t numChunk, unsigned long numCo
     return chunkMetaD[numChunk].getFragments(numCol);
 }
 
+inline ColumnZoneMaps& FileMetadata::getZoneMaps(off_t numChunk, unsigned long numCol) {
+#ifdef DEBUG
+    assert(numChunk < chunkMetaD.size());
+#endif
+    return chunkMetaD[numChunk].getZoneMaps(numCol);
+}
+
 inline FragmentsTuples& FileMetadata::getFragmentsTuples(off_t numChunk) {
 #ifdef DEBUG
     assert(numChunk < chunkMetaD.size());
@@ -807,12 +941,14 @@ inline void FileMetadata::addColumn(off_t _startPage,
         off_t _startPageCompr,
         off_t _sizeBytesCompr,
         off_t _sizePagesCompr,
-        Fragments& _fragments) {
+        Fragments& _fragments,
+        int _codec,
+        const ColumnZoneMaps& _zoneMaps) {
 
     assert (chkFilled == numChunks && colsFilled < numCols);
 
     // We add columns to last newly added chunk
-    chunkMetaD[chunkMetaD.size()-1].addColumn (_startPage, _sizeBytes, _sizePages, _startPageCompr, _sizeBytesCompr, _sizePagesCompr, _fragments);
+    chunkMetaD[chunkMetaD.size()-1].addColumn (_startPage, _sizeBytes, _sizePages, _startPageCompr, _sizeBytesCompr, _sizePagesCompr, _fragments, _codec, _zoneMaps);
 
     colsFilled++;
 }
@@ -19,16 +19,17 @@
 #include "DiskIOMessages.h"
 #include "EventProcessorImp.h"
 #include "EventProcessor.h"
+#include "ProfMSG-Data.h"
+#include "AsyncDiskIO.h"
+#include "DiskSchedule.h"
 
 #include <map>
+#include <vector>
 #include <pthread.h>
 #include <libgen.h>
 #include <cstdio>
 #include <cinttypes>
 
-#define READ 1
-#define WRITE 2
-
 // forward definition on DiskArray
 class DiskArray;
 
@@ -43,6 +44,17 @@ class DiskArray;
   to be implemented at higher level. The HDThreads are low leve disk
   drivers that just do what told.
 
+  The only liberty taken is to coalesce the requests of a job: runs of
+  requests that follow each other on the stripe (reads may skip over
+  small gaps, see IO_COALESCE_MAX_GAP_PAGES) are done with a single
+  preadv/pwritev that scatters the pages to their memory. The callers
+  should send the requests ordered by page to get the most out of it.
+
+  The runs of a job are handed to the disk all at once, with up to
+  HD_QUEUE_DEPTH of them in flight, through io_uring or Linux AIO (see
+  AsyncDiskIO). Without either (old kernel, or built with
+  -DNO_ASYNC_IO) the runs are done one at a time with preadv/pwritev.
+
   To allow signaling of job termination, the HDThreads use a
   distributed counter and send a signal when the count reaches 0.
 
@@ -97,8 +109,48 @@ class HDThreadImp : public EventProcessorImp {
 
         DiskArray& diskArray;
 
+        // pages in the gaps between coalesced reads land here,
+        // IO_COALESCE_MAX_GAP_PAGES long
+        void* gapBuffer;
+
+        // the asynchronous backend, NULL if the runs are done synchronously
+        AsyncDiskIO* asyncIO;
+
+        // a coalesced run of the requests of a job, done with one read/write
+        struct IORun {
+            off_t page; // first page of the run
+            off_t numPG; // pages of the run, gaps included
+            off_t gapPages; // pages of the gaps, read in gapBuffer
+            std::vector<struct iovec> iov;
+        };
+
+        // histograms of the sizes of the reads and writes issued, bucket i
+        // counts the ones of (2^(i-1), 2^i] pages
+        static constexpr int NUM_SIZE_BUCKETS = 16;
+        uint64_t readSizes[NUM_SIZE_BUCKETS];
+        uint64_t writeSizes[NUM_SIZE_BUCKETS];
+
         void UpdateStatistics(double time);
 
+        // cuts the requests of a job in runs, see IO_COALESCE_MAX_GAP_PAGES
+        void CoalesceRequests(DiskRequestDataContainer& requests, int operation,
+                std::vector<IORun>& runs);
+
+        // does the runs of a job one at a time
+        void DoRunsSync(std::vector<IORun>& runs, int operation, off_t requestId);
+
+        // does the runs of a job with asyncIO, as many at once as it takes
+        void DoRunsAsync(std::vector<IORun>& runs, int operation, off_t requestId);
+
+        // the run is done, counts it in the statistics
+        void RunDone(IORun& run, int operation, double time);
+
+        // adds a request of numPG pages to the histogram
+        static void AddToHistogram(uint64_t* histogram, off_t numPG);
+
+        // puts the histograms in counters, for the profiler, and clears them
+        void GetHistograms(PCounterList& counters);
+
     public:
         HDThreadImp(const char *_fileName, uint64_t arrayHash, EventProcessor &_diskArray, uint64_t _frequencyUpdate, bool isReadOnly = false);
         virtual ~HDThreadImp();
@@ -0,0 +1,125 @@
+//
+//  Copyright 2012 Alin Dobra and Christopher Jermaine
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+#ifndef _ZONE_MAP_H_
+#define _ZONE_MAP_H_
+
+#include <cstdint>
+#include <vector>
+
+/**
+    Zone map of a column of a chunk, or of a fragment of it: the smallest and
+    the largest value and the number of nulls.
+
+    The write path has no types, so zone maps are only kept for the columns
+    that take exactly 4 or 8 bytes per tuple (INT, BIGINT, DATE, ...), the same
+    columns that get the integer encodings. The values are read as signed
+    integers. The ones with all the bits set (-1, the null of INT, BIGINT and
+    DATE) are counted as nulls and are left out of [min, max].
+
+    Zone maps are checked against the ranges pushed down to the scanners, which
+    are in ClusterValue () terms. A 4 byte column might be unsigned (UINT,
+    DATETIME), so whoever builds the zone map of one with negative values adds
+    UINT32_MAX to it to cover both readings.
+ */
+class ZoneMap {
+
+    private:
+        int64_t min;
+        int64_t max;
+        uint64_t nullCount;
+
+        // false if nothing is known about the values
+        bool valid;
+
+    public:
+
+        ZoneMap() :
+            min(1),
+            max(0),
+            nullCount(0),
+            valid(false)
+        {}
+
+        // Load from disk
+        ZoneMap(int64_t _min, int64_t _max, uint64_t _nullCount) :
+            min(_min),
+            max(_max),
+            nullCount(_nullCount),
+            valid(true)
+        {}
+
+        // add a value (-1 is a null)
+        void Add(int64_t value);
+
+        bool IsValid() const { return valid; }
+
+        // min > max if all the values are null
+        int64_t GetMin() const { return min; }
+        int64_t GetMax() const { return max; }
+        uint64_t GetNullCount() const { return nullCount; }
+
+        // returns false only if no value can be in [rMin, rMax]
+        // an inverted range (rMin > rMax) is not a range of values, so it always
+        // gets true
+        bool MayContain(int64_t rMin, int64_t rMax) const;
+};
+
+/** Zone maps of a column of a chunk: one for the whole column and one for
+    each of its fragments, if it has any. */
+struct ColumnZoneMaps {
+    ZoneMap column;
+    std::vector<ZoneMap> fragments;
+};
+
+// ===========================INLINE methods for ZoneMap =================
+inline
+void ZoneMap :: Add(int64_t value) {
+    if (!valid) {
+        min = 1;
+        max = 0;
+        nullCount = 0;
+        valid = true;
+    }
+
+    if (value == -1) {
+        nullCount++;
+    } else if (min > max) {
+        min = max = value;
+    } else if (value < min) {
+        min = value;
+    } else if (value > max) {
+        max = value;
+    }
+}
+
+inline
+bool ZoneMap :: MayContain(int64_t rMin, int64_t rMax) const {
+    if (!valid || rMin > rMax)
+        return true;
+
+    // the values
+    if (min <= max && rMin <= max && min <= rMax)
+        return true;
+
+    // the nulls are -1 for the signed types and UINT32_MAX for the unsigned ones
+    if (nullCount > 0 && ((rMin <= -1 && -1 <= rMax) ||
+                (rMin <= (int64_t) UINT32_MAX && (int64_t) UINT32_MAX <= rMax)))
+        return true;
+
+    return false;
+}
+
+#endif // _ZONE_MAP_H_
@@ -38,8 +38,77 @@ DiskArray& diskArray;
 // the Event processor that gets notified if we finish a request
 EventProcessor execEngine;
 
+// decompresses the chunks read with compressed columns before they go to
+// execEngine; not valid if the CPU workers decompress them
+EventProcessor decompressor;
+
 // total page counter (bookkeeping)
 off_t totalPages;
 
+// the reads sent to the disk array and not back yet
+std::set<off_t> readsOut;
+
+// pages of deleted and moved chunks. They are freed once the metadata
+// without them is flushed (flushed is set) and the reads that might still go
+// to them, up to lastRequest, are back.
+struct UnusedPages {
+    off_t startPage;
+    off_t sizePages;
+    uint64_t lastRequest;
+    bool flushed;
+};
+std::vector<UnusedPages> unusedPages;
+
+// compaction (see CompactChunks): the pages of a column moved lower
+struct CompactMove {
+    unsigned long column;
+    bool compressed;
+    off_t oldStart;
+    off_t newStart;
+    off_t sizePages;
+    void* data;
+};
+off_t compactNext; // next chunk to look at, -1 if no compaction is going on
+bool compactAgain; // another compaction was asked for while this one runs
+off_t compactChunk; // the chunk being moved, -1 if none (or given up)
+off_t compactRequest; // the disk job of the chunk being moved
+bool compactWriting; // the job is the write to the new pages
+std::vector<CompactMove> compactMoves;
+
+// the columns of the reads out that go in the ChunkCache when they are back,
+// by request; dropped if the chunk is deleted meanwhile
+struct CacheFill {
+    off_t chunkID;
+    unsigned long column;
+    bool compressed;
+    void* data;
+    off_t sizePages;
+};
+std::map<off_t, std::vector<CacheFill> > cacheFills;
+
 //////////////// Helper functions
 uint64_t NewRequest(void);
+
+// puts the pages in unusedPages
+void ReleasePages(off_t startPage, off_t sizePages);
+
+// flushes the metadata and frees the unused pages that can be freed
+void FlushAndFree(void);
+
+// frees the unused pages that can be freed
+void FreeUnusedPages(void);
+
+// frees the pages of the deleted chunks and, if too much of the disk array
+// is lost between the allocations, starts going through the chunks from the
+// first
+void StartCompaction(void);
+
+// starts moving the next chunk that has room lower in the disk array, ends
+// the compaction if there is none
+void CompactNext(void);
+
+// the read or the write of the chunk being moved is done
+void CompactJobDone(void);
+
+// drops the cache fills of the chunk, or of all the chunks if -1
+void DropCacheFills(off_t chunkID);
@@ -0,0 +1,33 @@
+#ifndef _CHUNKDECOMPRESSOR_H_
+#define _CHUNKDECOMPRESSOR_H_
+
+#include "EventProcessor.h"
+
+<?php
+//
+//  Copyright 2013 Tera Insights LLC
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+?>
+<?php
+require_once('HierarchiesFunctions.php');
+
+grokit\interface_class( 'ChunkDecompressor', 'EventProcessor', 'evProc' );
+grokit\interface_constructor( [ 'numThreads' => 'int', ] );
+grokit\interface_default_constructor();
+grokit\interface_class_end();
+?>
+
+
+#endif // _CHUNKDECOMPRESSOR_H_
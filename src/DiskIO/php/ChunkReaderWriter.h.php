@@ -2,6 +2,7 @@
 #define _CHUNKREADERWRITER_H_
 
 #include "EventProcessor.h"
+#include "ZoneMap.h"
 
 #include <vector>
 #include <utility>
@@ -34,7 +35,7 @@ grokit\interface_class( 'ChunkReaderWriter', 'EventProcessor', 'evProc' );
 ?>
 
 	<?php
-grokit\interface_constructor( [ 'scannerName' => 'const char*', 'numChunks' => 'int', 'execEngine' => 'EventProcessor&', ] );
+grokit\interface_constructor( [ 'scannerName' => 'const char*', 'numChunks' => 'int', 'execEngine' => 'EventProcessor&', 'decompressor' => 'EventProcessor&', ] );
 ?>
 
   <?php
@@ -47,6 +48,14 @@ grokit\interface_function(
 	'std::vector< std::pair<int64_t, int64_t> >',
 	[]
 );
+?>
+
+<?php
+grokit\interface_function(
+	'GetZoneMaps',
+	'std::vector< std::vector<ColumnZoneMaps> >',
+	[]
+);
 ?>
 
 	<?php
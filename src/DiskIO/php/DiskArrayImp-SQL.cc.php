@@ -187,6 +187,17 @@ EOT
     totalPages = 0;
     hds = new EventProcessor[meta.HDNo];
 
+    // statistics and scheduling, per stripe
+    DiskStatisticsData noStats = { 0.0, 0.0 };
+    stats.resize(meta.HDNo, noStats);
+    expectation = 0.0;
+    readAheadPercent = 100;
+    slowDisk = -1;
+    pending.resize(meta.HDNo);
+    jobsOut.resize(meta.HDNo, 0);
+    headPage.resize(meta.HDNo, 0);
+    clock.Restart();
+
     // read the stripes from Stripes and start the HD threads
     <?php
 grokit\sql_statement_table( <<<'EOT'
@@ -223,9 +234,10 @@ grokit\sql_close_database();
 ?>
 ;
 
-    //priority for processing read chunks is higher than accepting new chunks
-    RegisterMessageProcessor(DiskStatistics::type, &ProcessDiskStatistics, 2);
-    RegisterMessageProcessor(DiskOperation::type, &DoDiskOperation, 1);
+    // the stripes get their next jobs before new jobs are queued
+    RegisterMessageProcessor(StripeJobDone::type, &ProcessStripeJobDone, 1);
+    RegisterMessageProcessor(DiskOperation::type, &DoDiskOperation, 2);
+    RegisterMessageProcessor(DiskStatistics::type, &ProcessDiskStatistics, 3);
 }
 
 void DiskArrayImp::Flush(void) {
@@ -100,11 +100,12 @@ typedef TwoWayList< DiskRequestData > DiskRequestDataContainer;
 		
 		Arguments:
 				chunkID: id of the chunk we are dealing with
+				decompress: true if some columns were read compressed
 				hMsg: the hopping message to send back to EE
 				token: the token to send back
 */
 <?php
-grokit\create_data_type( "CRWRequest", "Data", [ 'chunkID' => 'off_t', ], [ 'hMsg' => 'HoppingDataMsg', 'token' => 'GenericWorkToken', ] );
+grokit\create_data_type( "CRWRequest", "Data", [ 'chunkID' => 'off_t', 'decompress' => 'bool', ], [ 'hMsg' => 'HoppingDataMsg', 'token' => 'GenericWorkToken', ] );
 ?>
 
 
@@ -59,6 +59,19 @@ grokit\create_message_type( 'DiskStatistics', [ 'diskNo' => 'int', 'expectation'
 ?>
 
 
+///////////// STRIPE JOB DONE MESSAGE //////////
+
+/** Message sent by each individual disk to the DiskArray when it is done
+		with a MegaJob, so that the DiskArray can send it the next one.
+
+		Arguments:
+			diskNo: which disk
+*/
+<?php
+grokit\create_message_type( 'StripeJobDone', [ 'diskNo' => 'int', ], [ ] );
+?>
+
+
 
 ///////////// DISK OPERATION MESSAGE ////////////
 
@@ -70,11 +83,13 @@ grokit\create_message_type( 'DiskStatistics', [ 'diskNo' => 'int', 'expectation'
 		Arguments:
 			requestID: request identifier (so that the caller knows what is confirmed
 			operation: either the DISK_READ or DISK_WRITE macros
+			priority: as in ExecEngine, 1 is the highest; the DiskArray serves the
+				reads with a higher priority first
 			pages: the pages that need to be accessed
 */
 
 <?php
-grokit\create_message_type( 'DiskOperation', [ 'requestId' => 'off_t', 'operation' => 'int', ], [ 'requestor' => 'EventProcessor', 'requests' => 'DiskRequestDataContainer', ] );
+grokit\create_message_type( 'DiskOperation', [ 'requestId' => 'off_t', 'operation' => 'int', 'priority' => 'int', ], [ 'requestor' => 'EventProcessor', 'requests' => 'DiskRequestDataContainer', ] );
 ?>
 
 
@@ -116,13 +131,32 @@ grokit\create_message_type( 'MegaJobFinished', [ 'requestId' => 'off_t', 'operat
 	Arguments:
 	   chunkID: which chunk to read
 		 useUncompressed: if set to true, uncompressed data is used, otherwise compressed
+		 priority: of the disk requests, as in ExecEngine (1 is the highest)
+		 fragmentStart, fragmentEnd: if not -1, only the tuples of these fragments can match
+		   the queries; the others are read but tagged with no query
 		 lineage, request: used for routing the reply inside execEngine
 		 dest: destination queryExits
 		 colsToProcess: list of (logical,phisical) columns to process
 */
 
 <?php
-grokit\create_message_type( 'ChunkRead', [ 'requestor' => 'WayPointID', 'chunkID' => 'off_t', 'useUncompressed' => 'bool', ], [ 'lineage' => 'HistoryList', 'dest' => 'QueryExitContainer', 'token' => 'GenericWorkToken', 'colsToProcess' => 'SlotPairContainer', ] );
+grokit\create_message_type( 'ChunkRead', [ 'requestor' => 'WayPointID', 'chunkID' => 'off_t', 'useUncompressed' => 'bool', 'priority' => 'int', 'fragmentStart' => 'int', 'fragmentEnd' => 'int', ], [ 'lineage' => 'HistoryList', 'dest' => 'QueryExitContainer', 'token' => 'GenericWorkToken', 'colsToProcess' => 'SlotPairContainer', ] );
+?>
+
+
+//////////// DECOMPRESS CHUNK MESSAGE //////////////
+/** Message sent by a ChunkReaderWriter to the ChunkDecompressor when a chunk
+	read with compressed columns is off the disk. The columns are decompressed
+	and the chunk is sent on to the execution engine.
+
+	Arguments:
+		chunkID: the chunk
+		execEngine: who gets the chunk once decompressed
+		hMsg: the hopping message with the chunk
+		token: the token to send back with it
+*/
+<?php
+grokit\create_message_type( 'DecompressChunk', [ 'chunkID' => 'off_t', ], [ 'execEngine' => 'EventProcessor', 'hMsg' => 'HoppingDataMsg', 'token' => 'GenericWorkToken', ] );
 ?>
 
 
@@ -185,4 +219,42 @@ grokit\create_message_type(
 );
 ?>
 
+///////////// DELETE CHUNK ///////////////
+/*	Message sent to the ChunkReaderWriter to delete a chunk. The chunk keeps
+	its ID, so the IDs of the other chunks do not change, but it has no tuples
+	left and its pages are freed once the metadata is flushed (by Flush or
+	CompactChunks).
+
+	Arguments:
+		chunkID: the chunk to delete
+ */
+<?
+grokit\create_message_type( 'DeleteChunk', [ 'chunkID' => 'off_t', ], [ ] );
+?>
+
+///////////// COMPACT CHUNKS ///////////////
+/*	Message sent to the ChunkReaderWriter to move its chunks to the free space
+	lower in the disk array, so that the space freed by the deleted chunks is
+	filled and the end of the array is given back. The chunks are moved one at
+	a time, while the relation is used. The pages of the deleted chunks are
+	freed first; nothing is moved unless the space lost between the
+	allocations is over DISK_COMPACTION_THRESHOLD.
+ */
+<?
+grokit\create_message_type( 'CompactChunks', [ ], [ ] );
+?>
+
+///////////// SET COLUMN CODEC ///////////////
+/*	Message sent to the ChunkReaderWriter to set the codec the compressed
+	version of a column is made with, in the chunks written from now on (see
+	FileMetadata::setColumnCodec).
+
+	Arguments:
+		column: the physical column
+		codec, level: the ColumnCodec
+ */
+<?
+grokit\create_message_type( 'SetColumnCodec', [ 'column' => 'int', 'codec' => 'int', 'level' => 'int', ], [ ] );
+?>
+
 #endif // _DISKIO_MESSAGES_H_
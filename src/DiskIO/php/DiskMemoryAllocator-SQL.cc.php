@@ -40,25 +40,95 @@ DiskMemoryAllocator::DiskMemoryAllocator()
     mLastPage = 0;
 }
 
-// Helper function, to create new chunk or use already freed chunk
-void DiskMemoryAllocator::CreateNewChunk(ChunkList* l) {
-    ChunkInfo* chunk = NULL;
-    if (mFreeChunks.empty()) // If chunk is not in freelist
+void DiskMemoryAllocator::AddFreeExtent(off_t startPage, off_t size) {
+    if (size == 0)
+        return;
+
+    FATALIF(startPage + size > mLastPage, "Freeing disk pages past the last allocated page");
+
+    // first extent after the new one
+    vector<FreeExtent>::iterator it = mFreeExtents.begin();
+    for (; it != mFreeExtents.end() && it->startPage < startPage; ++it) ;
+
+    FATALIF(it != mFreeExtents.end() && startPage + size > it->startPage,
+        "Freeing disk pages %ld to %ld that are free already", (long) startPage, (long) (startPage + size));
+
+    if (it != mFreeExtents.begin()) {
+        vector<FreeExtent>::iterator prev = it - 1;
+        FATALIF(prev->startPage + prev->size > startPage,
+            "Freeing disk pages %ld to %ld that are free already", (long) startPage, (long) (startPage + size));
+        if (prev->startPage + prev->size == startPage) {
+            // grow the previous extent
+            prev->size += size;
+            if (it != mFreeExtents.end() && prev->startPage + prev->size == it->startPage) {
+                prev->size += it->size;
+                mFreeExtents.erase(it);
+            }
+            it = mFreeExtents.end(); // done
+            size = 0;
+        }
+    }
+
+    if (size != 0) {
+        if (it != mFreeExtents.end() && startPage + size == it->startPage) {
+            // grow the next extent down
+            it->startPage = startPage;
+            it->size += size;
+        } else {
+            FreeExtent extent = { startPage, size };
+            mFreeExtents.insert(it, extent);
+        }
+    }
+
+    // the space at the end goes back to the last page
+    if (!mFreeExtents.empty() &&
+            mFreeExtents.back().startPage + mFreeExtents.back().size == mLastPage) {
+        mLastPage = mFreeExtents.back().startPage;
+        mFreeExtents.pop_back();
+    }
+}
+
+int DiskMemoryAllocator::BestFreeExtent(off_t size) {
+    int best = -1;
+    for (int i = 0; i < (int) mFreeExtents.size(); i++) {
+        if (mFreeExtents[i].size >= size &&
+                (best == -1 || mFreeExtents[i].size < mFreeExtents[best].size))
+            best = i;
+    }
+    return best;
+}
+
+off_t DiskMemoryAllocator::TakeFreeExtent(int index, off_t size) {
+    FreeExtent& extent = mFreeExtents[index];
+    FATALIF(extent.size < size, "Taking more pages than the free extent has");
+
+    off_t result = extent.startPage;
+    extent.startPage += size;
+    extent.size -= size;
+    if (extent.size == 0)
+        mFreeExtents.erase(mFreeExtents.begin() + index);
+
+    return result;
+}
+
+// Helper function, to create new chunk from the free space or at the end
+void DiskMemoryAllocator::CreateNewChunk(ChunkList* l, off_t minSize) {
+    off_t size = minSize > DISK_ALLOC_BLOCK_SIZE ? minSize : DISK_ALLOC_BLOCK_SIZE;
+
+    ChunkInfo* chunk = new ChunkInfo;
+    int index = BestFreeExtent(size);
+    if (index != -1) // a freed extent has room for a block
     {
-        chunk = new ChunkInfo;
-        chunk->startPage = mLastPage;
-        chunk->size = DISK_ALLOC_BLOCK_SIZE; // set the fix size of chunk
-        chunk->nextFreePage = mLastPage;
-        (l->listOfChunks).push_back(chunk); // insert into list of chunks
-        mLastPage += DISK_ALLOC_BLOCK_SIZE; // update the global last free page
+        chunk->startPage = TakeFreeExtent(index, size);
     }
-    else	// If free chunk is found in freelist
+    else	// take it from the end
     {
-        chunk = mFreeChunks.front();
-        mFreeChunks.pop_front();
-        chunk->nextFreePage = chunk->startPage;
-        (l->listOfChunks).push_back(chunk);
+        chunk->startPage = mLastPage;
+        mLastPage += size; // update the global last free page
     }
+    chunk->size = size;
+    chunk->nextFreePage = chunk->startPage;
+    (l->listOfChunks).push_back(chunk); // insert into list of chunks
 }
 
 off_t DiskMemoryAllocator::DiskAlloc(off_t pSize, uint64_t relID){
@@ -70,31 +140,36 @@ off_t DiskMemoryAllocator::DiskAlloc(off_t pSize, uint64_t relID){
     pthread_mutex_lock(&mutex);
     off_t result = -1;
 
+    ChunkList* l = NULL;
     map<uint64_t, ChunkList*>::iterator it = mRelationIDToChunkList.find(relID);
     if (it == mRelationIDToChunkList.end()) {
-        /*If chunk list is not found w.r.t relation ID, we need to create first
-            chunk and add it to the list. Use free chunks if already present in the
-            free list.
-        */
-        ChunkList* l = new ChunkList;
-        CreateNewChunk(l);
+        l = new ChunkList;
         mRelationIDToChunkList[relID] = l;
-        ChunkInfo* c = (l->listOfChunks).back();
-        result = c->nextFreePage; // Set the result page number
-        c->nextFreePage += pSize;	// Update the next free page number
+    } else {
+        l = it->second;
+    }
 
+    /* The last chunk of the relation fills the requests while it has room.
+        Otherwise the smallest free extent that fits is used, a piece of it if
+        it is smaller than a block (the holes left by the deleted chunks), and
+        a new block if there is no such extent.
+    */
+    ChunkInfo* c = (l->listOfChunks).empty() ? NULL : (l->listOfChunks).back();
+    if (c != NULL && c->nextFreePage + pSize <= c->startPage + c->size) {
+        result = c->nextFreePage;   // Set the result page number
+        c->nextFreePage += pSize;   // Update the next free page number
     } else {
-        /*If chunk list is found w.r.t relation ID, we need to see if it fully
-            satisfies the request. If not, create a new chunk and add into the list.
-        */
-        ChunkList* l = it->second;
-        ChunkInfo* c = (l->listOfChunks).back();
-        if (c->nextFreePage - c->startPage + pSize < c->size) {
-            result = c->nextFreePage;   // Set the result page number
-            c->nextFreePage += pSize;   // Update the next free page number
-            FATALIF( c->nextFreePage > c->startPage + c->size, "Page alocator spilled over the disk page chunk");
+        int index = BestFreeExtent(pSize);
+        if (index != -1 && mFreeExtents[index].size < DISK_ALLOC_BLOCK_SIZE) {
+            // a hole, full as soon as taken; the last chunk stays last
+            ChunkInfo* hole = new ChunkInfo;
+            hole->startPage = TakeFreeExtent(index, pSize);
+            hole->size = pSize;
+            hole->nextFreePage = hole->startPage + pSize;
+            (l->listOfChunks).insert((l->listOfChunks).end() - (c != NULL ? 1 : 0), hole);
+            result = hole->startPage;
         } else {
-            CreateNewChunk(l);
+            CreateNewChunk(l, pSize);
             c = (l->listOfChunks).back();
             result = c->nextFreePage;   // Set the result page number
             c->nextFreePage += pSize;   // Update the next free page number
@@ -116,13 +191,117 @@ void DiskMemoryAllocator::DiskFree(uint64_t relID){
 
     ChunkList* l = it->second;
     for (uint64_t i = 0; i < (l->listOfChunks).size(); i++) {
-        mFreeChunks.push_back((l->listOfChunks)[i]);
+        AddFreeExtent((l->listOfChunks)[i]->startPage, (l->listOfChunks)[i]->size);
+        delete (l->listOfChunks)[i];
     }
     delete it->second;
     mRelationIDToChunkList.erase(relID);
     pthread_mutex_unlock(&mutex);
 }
 
+void DiskMemoryAllocator::DiskFreePages(off_t startPage, off_t pSize, uint64_t relID){
+
+    if (pSize == 0)
+        return;
+
+    pthread_mutex_lock(&mutex);
+
+    map<uint64_t, ChunkList*>::iterator it = mRelationIDToChunkList.find(relID);
+    FATALIF(it == mRelationIDToChunkList.end(), "Freeing disk pages of relation %lu that has none",
+        (unsigned long) relID);
+
+    // the chunk with the pages
+    vector<ChunkInfo*>& chunks = it->second->listOfChunks;
+    uint64_t i = 0;
+    for (; i < chunks.size(); i++) {
+        if (chunks[i]->startPage <= startPage && startPage + pSize <= chunks[i]->nextFreePage)
+            break;
+    }
+    FATALIF(i == chunks.size(), "Freeing disk pages %ld to %ld not allocated to relation %lu",
+        (long) startPage, (long) (startPage + pSize), (unsigned long) relID);
+
+    ChunkInfo* c = chunks[i];
+    bool isLast = (i == chunks.size() - 1);
+
+    /* The chunk is split around the freed pages: c keeps the pages before
+        them, after holds the pages after them and the unused end. If nothing
+        after is in use, the unused end is freed as well, unless the chunk
+        is the last one and still fills the requests.
+    */
+    ChunkInfo* after = new ChunkInfo;
+    after->startPage = startPage + pSize;
+    after->size = c->startPage + c->size - after->startPage;
+    after->nextFreePage = c->nextFreePage;
+
+    c->size = startPage - c->startPage;
+    c->nextFreePage = startPage;
+
+    off_t freeEnd = startPage + pSize;
+    if (after->nextFreePage == after->startPage) {
+        if (isLast) {
+            // give the pages back to the last chunk instead
+            after->startPage = startPage;
+            after->size += pSize;
+            after->nextFreePage = startPage;
+            freeEnd = startPage;
+        } else {
+            freeEnd += after->size;
+            after->size = 0;
+        }
+    }
+    AddFreeExtent(startPage, freeEnd - startPage);
+
+    // replace c by its non empty pieces, in the same place
+    chunks.erase(chunks.begin() + i);
+    if (after->size > 0)
+        chunks.insert(chunks.begin() + i, after);
+    else
+        delete after;
+    if (c->size > 0)
+        chunks.insert(chunks.begin() + i, c);
+    else
+        delete c;
+
+    if (chunks.empty()) {
+        delete it->second;
+        mRelationIDToChunkList.erase(it);
+    }
+
+    pthread_mutex_unlock(&mutex);
+}
+
+off_t DiskMemoryAllocator::DiskRelocate(off_t startPage, off_t pSize, uint64_t relID){
+
+    if (pSize == 0)
+        return -1;
+
+    pthread_mutex_lock(&mutex);
+    off_t result = -1;
+
+    map<uint64_t, ChunkList*>::iterator it = mRelationIDToChunkList.find(relID);
+    if (it != mRelationIDToChunkList.end()) {
+        // the extents are sorted, the first with room is the lowest
+        for (int i = 0; i < (int) mFreeExtents.size() && mFreeExtents[i].startPage < startPage; i++) {
+            if (mFreeExtents[i].size >= pSize && mFreeExtents[i].startPage + pSize <= startPage) {
+                ChunkInfo* moved = new ChunkInfo;
+                moved->startPage = TakeFreeExtent(i, pSize);
+                moved->size = pSize;
+                moved->nextFreePage = moved->startPage + pSize;
+
+                // the last chunk stays last
+                vector<ChunkInfo*>& chunks = it->second->listOfChunks;
+                chunks.insert(chunks.end() - 1, moved);
+                result = moved->startPage;
+                break;
+            }
+        }
+    }
+
+    pthread_mutex_unlock(&mutex);
+
+    return result;
+}
+
 DiskMemoryAllocator::~DiskMemoryAllocator(void){
     // dealocate the mutex
     pthread_mutex_destroy(&mutex);
@@ -130,6 +309,7 @@ DiskMemoryAllocator::~DiskMemoryAllocator(void){
 }
 
 off_t DiskMemoryAllocator::AllocatedSpace() {
+    pthread_mutex_lock(&mutex);
     off_t allocated = 0;
     for (map<uint64_t, ChunkList*>::iterator it = mRelationIDToChunkList.begin(); it != mRelationIDToChunkList.end(); ++it) {
         ChunkList* l = it->second;
@@ -137,20 +317,25 @@ off_t DiskMemoryAllocator::AllocatedSpace() {
             allocated += ((l->listOfChunks)[i]->nextFreePage - (l->listOfChunks)[i]->startPage);
         }
     }
+    pthread_mutex_unlock(&mutex);
     return allocated;
 }
 
-// This adds up all fragmented space including last chunk, later we can remove counting last chunk
-// because essentially last chunk isn't fragmented yet, since it has opportunity to fulfill more
-// requests.
+// The last chunk of a relation is not counted since it can still fulfill
+// more requests.
 off_t DiskMemoryAllocator::FragmentedSpace() {
+    pthread_mutex_lock(&mutex);
     off_t fragmented = 0;
+    for (uint64_t i = 0; i < mFreeExtents.size(); i++) {
+        fragmented += mFreeExtents[i].size;
+    }
     for (map<uint64_t, ChunkList*>::iterator it = mRelationIDToChunkList.begin(); it != mRelationIDToChunkList.end(); ++it) {
         ChunkList* l = it->second;
-        for (uint64_t i = 0; i < (l->listOfChunks).size(); i++) { // iterate one less if last chunk not to be counted
-            fragmented += (l->listOfChunks)[i]->startPage + ((l->listOfChunks)[i]->size - (l->listOfChunks)[i]->nextFreePage);
+        for (uint64_t i = 0; i + 1 < (l->listOfChunks).size(); i++) {
+            fragmented += (l->listOfChunks)[i]->startPage + (l->listOfChunks)[i]->size - (l->listOfChunks)[i]->nextFreePage;
         }
     }
+    pthread_mutex_unlock(&mutex);
     return fragmented;
 }
 
@@ -218,11 +403,12 @@ grokit\sql_instantiate_parameters( [ 'mDiskArrayID', 'rel', 'startPg', 'sz', 'n'
 ;
             }
     }
-        for (list<ChunkInfo*>::iterator iter = mFreeChunks.begin(); iter != mFreeChunks.end(); ++iter) {
+        // free extents have no relation
+        for (vector<FreeExtent>::iterator iter = mFreeExtents.begin(); iter != mFreeExtents.end(); ++iter) {
             uint64_t rel = -1;
-            uint64_t startPg = (*iter)->startPage;
-            uint64_t sz = (*iter)->size;
-            uint64_t n = (*iter)->nextFreePage;
+            uint64_t startPg = iter->startPage;
+            uint64_t sz = iter->size;
+            uint64_t n = iter->startPage;
             //printf("-1 startPg = %d, sz = %d, n = %d, rel = %d, diskArrayID = %d, lastPage = %d\n", startPg, sz, n, rel, mDiskArrayID, mLastPage);
 <?php
 grokit\sql_instantiate_parameters( [ 'mDiskArrayID', 'rel', 'startPg', 'sz', 'n', 'mLastPage', ] );
@@ -238,6 +424,7 @@ grokit\sql_parametric_end();
 
 void DiskMemoryAllocator::Load(sqlite3* db) {
     pthread_mutex_lock(&mutex);
+    vector<FreeExtent> freed; // added once mLastPage is known
 <?php
 grokit\sql_existing_database( 'db' );
 ?>
@@ -271,12 +458,12 @@ EOT
 , [ 'relID' => 'int', 'startPage' => 'int', 'size' => 'int', 'nextFreePage' => 'int', 'LastPage' => 'int', ], [ 'mDiskArrayID', ] );
 ?>
 {
-        ChunkInfo* c = new ChunkInfo;
-        c->startPage = startPage;
-        c->size = size;
-        c->nextFreePage = nextFreePage;
         mLastPage = LastPage;
         if (relID != -1) {
+            ChunkInfo* c = new ChunkInfo;
+            c->startPage = startPage;
+            c->size = size;
+            c->nextFreePage = nextFreePage;
             map<uint64_t, ChunkList*>::iterator it = mRelationIDToChunkList.find(relID);
             if (it == mRelationIDToChunkList.end()) {
                 ChunkList* l = new ChunkList;
@@ -287,13 +474,18 @@ EOT
                 (l->listOfChunks).push_back(c);
             }
         } else {
-            mFreeChunks.push_back(c);
+            FreeExtent extent = { startPage, size };
+            freed.push_back(extent);
         }
     }<?php
 grokit\sql_end_statement_table();
 ?>
 ;
 
+    for (uint64_t i = 0; i < freed.size(); i++) {
+        AddFreeExtent(freed[i].startPage, freed[i].size);
+    }
+
     // cout << "\nLOADDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDD" << mLastPage << endl;
 /*
     // Now place the biggest free chunk at the end for every relation
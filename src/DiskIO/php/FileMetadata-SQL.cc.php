@@ -11,6 +11,7 @@
 #include "Errors.h"
 #include "MetadataDB.h"
 #include "DiskArray.h"
+#include "ChunkCache.h"
 #include "Constants.h"
 #include <set>
 
@@ -109,6 +110,27 @@ grokit\sql_statements_norez( <<<'EOT'
             chunkID         INTEGER
     );
 
+    /* ColumnCodecs, columns without an entry are compressed with QuickLZ;
+       chunkID -1 for the codec set for the column */
+    CREATE TABLE IF NOT EXISTS ColumnCodecs(
+            relID           INTEGER NOT NULL,
+            chunkID         INTEGER NOT NULL,
+            colNo           INTEGER NOT NULL,
+      codec           INTEGER NOT NULL,
+      level           INTEGER NOT NULL DEFAULT 0
+    );
+
+    /* ZoneMaps, fragment is -1 for the whole column */
+    CREATE TABLE IF NOT EXISTS ZoneMaps(
+            relID           INTEGER NOT NULL,
+            chunkID         INTEGER NOT NULL,
+            colNo           INTEGER NOT NULL,
+            fragment        INTEGER NOT NULL,
+      minValue        INTEGER NOT NULL,
+      maxValue        INTEGER NOT NULL,
+      nullCount       INTEGER NOT NULL
+    );
+
 "
 EOT
 , [ ] );
@@ -212,6 +234,49 @@ EOT
         }<?php
 grokit\sql_end_statement_table();
 ?>
+;
+
+<?php
+grokit\sql_statement_table( <<<'EOT'
+"
+      SELECT chunkID, colNo, codec, level
+      FROM ColumnCodecs
+        WHERE relID=%d;
+    "
+EOT
+, [ '_chunkID4' => 'int', '_colNo3' => 'int', '_codec' => 'int', '_level' => 'int', ], [ 'relID', ] );
+?>
+{
+            if (_chunkID4 < 0)
+                columnCodecs[_colNo3] = ColumnCodec(_codec, _level);
+            else
+                chunkMetaD[_chunkID4].colMetaData[_colNo3].codec = _codec;
+        }<?php
+grokit\sql_end_statement_table();
+?>
+;
+
+<?php
+grokit\sql_statement_table( <<<'EOT'
+"
+      SELECT chunkID, colNo, fragment, minValue, maxValue, nullCount
+      FROM ZoneMaps
+        WHERE relID=%d
+      ORDER BY chunkID, colNo, fragment;
+    "
+EOT
+, [ '_chunkID5' => 'int', '_colNo4' => 'int', '_fragment' => 'int', '_minValue' => 'int', '_maxValue' => 'int', '_nullCount' => 'int', ], [ 'relID', ] );
+?>
+{
+            ColumnZoneMaps& zones = chunkMetaD[_chunkID5].colMetaData[_colNo4].zoneMaps;
+            ZoneMap zone(_minValue, _maxValue, _nullCount);
+            if (_fragment < 0)
+                zones.column = zone;
+            else
+                zones.fragments.push_back(zone);
+        }<?php
+grokit\sql_end_statement_table();
+?>
 ;
 
     } else { // new relation
@@ -299,6 +364,19 @@ grokit\sql_end_statement_table();
 ;
         DeleteContentSQL(relID, <?=grokit\sql_database_object()?>);
 
+        // the relID can be given to a new relation
+        ChunkCache::GetChunkCache().Forget(relID);
+
+<?
+grokit\sql_statements_norez( <<<'EOT'
+"
+    DELETE FROM ColumnCodecs
+    WHERE relID=%d;
+"
+EOT
+, [ 'relID' ])
+?>
+
 <?
 grokit\sql_statements_norez( <<<'EOT'
 "
@@ -422,6 +500,28 @@ EOT
 ?>
 ;
 
+<?php
+grokit\sql_statements_norez( <<<'EOT'
+"
+        DELETE FROM ColumnCodecs
+        WHERE relID=%d AND chunkID >= 0;
+"
+EOT
+, [ 'relID', ] );
+?>
+;
+
+<?php
+grokit\sql_statements_norez( <<<'EOT'
+"
+        DELETE FROM ZoneMaps
+        WHERE relID=%d;
+"
+EOT
+, [ 'relID', ] );
+?>
+;
+
 }
 
 void FileMetadata::Flush(void) {
@@ -521,6 +621,99 @@ grokit\sql_instantiate_parameters( [ 'colit', 'chunkit', 'relID', 'chunkMetaD[ch
 <?php
 grokit\sql_parametric_end();
 ?>
+;
+
+    // Now flush the codecs of the columns not compressed with QuickLZ
+<?php
+grokit\sql_statement_parametric_norez( <<<'EOT'
+"
+        INSERT INTO ColumnCodecs(relID, chunkID, colNo, codec) VALUES (?1, ?2, ?3, ?4);
+        "
+EOT
+, [ 'int', 'int', 'int', 'int', ], [ ]);
+?>
+;
+            for (uint64_t chunkit = 0; chunkit < chunkMetaD.size(); chunkit++) {
+                for (uint64_t colit = 0; colit < chunkMetaD[chunkit].colMetaData.size(); colit++) {
+                    if (chunkMetaD[chunkit].colMetaData[colit].codec == CODEC_QUICKLZ)
+                        continue;
+<?php
+grokit\sql_instantiate_parameters( [ 'relID', 'chunkit', 'colit', 'chunkMetaD[chunkit].colMetaData[colit].codec', ] );
+?>
+;
+                }
+            }
+<?php
+grokit\sql_parametric_end();
+?>
+;
+
+    // and the codecs set for the columns, that DeleteContentSQL leaves
+<?php
+grokit\sql_statements_norez( <<<'EOT'
+"
+        DELETE FROM ColumnCodecs
+        WHERE relID=%d AND chunkID < 0;
+"
+EOT
+, [ 'relID', ] );
+?>
+;
+
+<?php
+grokit\sql_statement_parametric_norez( <<<'EOT'
+"
+        INSERT INTO ColumnCodecs(relID, chunkID, colNo, codec, level) VALUES (?1, -1, ?2, ?3, ?4);
+        "
+EOT
+, [ 'int', 'int', 'int', 'int', ], [ ]);
+?>
+;
+            for (std::map<unsigned long, ColumnCodec>::iterator it = columnCodecs.begin();
+                    it != columnCodecs.end(); ++it) {
+<?php
+grokit\sql_instantiate_parameters( [ 'relID', 'it->first', 'it->second.id', 'it->second.level', ] );
+?>
+;
+            }
+<?php
+grokit\sql_parametric_end();
+?>
+;
+
+    // Now flush the zone maps of the columns that have them
+<?php
+grokit\sql_statement_parametric_norez( <<<'EOT'
+"
+        INSERT INTO ZoneMaps(relID, chunkID, colNo, fragment, minValue, maxValue, nullCount)
+        VALUES (?1, ?2, ?3, ?4, ?5, ?6, ?7);
+        "
+EOT
+, [ 'int', 'int', 'int', 'int', 'int', 'int', 'int', ], [ ]);
+?>
+;
+            for (uint64_t chunkit = 0; chunkit < chunkMetaD.size(); chunkit++) {
+                for (uint64_t colit = 0; colit < chunkMetaD[chunkit].colMetaData.size(); colit++) {
+                    ColumnZoneMaps& zones = chunkMetaD[chunkit].colMetaData[colit].zoneMaps;
+                    if (!zones.column.IsValid())
+                        continue;
+
+                    // the whole column first, then the fragments in order
+                    for (int64_t frag = -1; frag < (int64_t) zones.fragments.size(); frag++) {
+                        ZoneMap& zone = frag < 0 ? zones.column : zones.fragments[frag];
+                        int64_t zMin = zone.GetMin();
+                        int64_t zMax = zone.GetMax();
+                        int64_t zNulls = zone.GetNullCount();
+<?php
+grokit\sql_instantiate_parameters( [ 'relID', 'chunkit', 'colit', 'frag', 'zMin', 'zMax', 'zNulls', ] );
+?>
+;
+                    }
+                }
+            }
+<?php
+grokit\sql_parametric_end();
+?>
 ;
 
     // Now flush all fragment info for each column
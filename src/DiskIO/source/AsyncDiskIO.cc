@@ -0,0 +1,263 @@
+//
+//  Copyright 2012 Alin Dobra and Christopher Jermaine
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <linux/io_uring.h>
+
+#include "AsyncDiskIO.h"
+#include "Errors.h"
+
+using namespace std;
+
+// the ring indexes are shared with the kernel
+#define RING_LOAD(p) __atomic_load_n((p), __ATOMIC_ACQUIRE)
+#define RING_STORE(p, v) __atomic_store_n((p), (v), __ATOMIC_RELEASE)
+
+AsyncDiskIO::AsyncDiskIO(int _fd, unsigned _depth) :
+    fd(_fd),
+    depth(_depth),
+    backend(ASYNC_NONE),
+    inFlight(0),
+    prepared(0),
+    ringFd(-1),
+    sqRing(MAP_FAILED),
+    sqRingSize(0),
+    cqRing(MAP_FAILED),
+    cqRingSize(0),
+    sqes((struct io_uring_sqe*) MAP_FAILED),
+    sqesSize(0),
+    aioContext(0)
+{
+    FATALIF(depth == 0, "Asynchronous disk IO needs room for at least one request");
+
+    if (SetUpIoUring())
+        backend = ASYNC_IO_URING;
+    else if (SetUpLinuxAio())
+        backend = ASYNC_LINUX_AIO;
+}
+
+AsyncDiskIO::~AsyncDiskIO() {
+    TearDown();
+}
+
+bool AsyncDiskIO::SetUpIoUring() {
+#ifdef __NR_io_uring_setup
+    struct io_uring_params params;
+    memset(&params, 0, sizeof(params));
+
+    ringFd = syscall(__NR_io_uring_setup, depth, &params);
+    if (ringFd < 0) {
+        ringFd = -1;
+        return false;
+    }
+
+    sqRingSize = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    cqRingSize = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+
+    // newer kernels map both rings at once
+    if (params.features & IORING_FEAT_SINGLE_MMAP) {
+        if (cqRingSize > sqRingSize)
+            sqRingSize = cqRingSize;
+        cqRingSize = sqRingSize;
+    }
+
+    sqRing = mmap(NULL, sqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+            ringFd, IORING_OFF_SQ_RING);
+    if (sqRing == MAP_FAILED) {
+        TearDown();
+        return false;
+    }
+
+    if (params.features & IORING_FEAT_SINGLE_MMAP) {
+        cqRing = sqRing;
+    } else {
+        cqRing = mmap(NULL, cqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                ringFd, IORING_OFF_CQ_RING);
+        if (cqRing == MAP_FAILED) {
+            TearDown();
+            return false;
+        }
+    }
+
+    sqesSize = params.sq_entries * sizeof(struct io_uring_sqe);
+    sqes = (struct io_uring_sqe*) mmap(NULL, sqesSize, PROT_READ | PROT_WRITE,
+            MAP_SHARED | MAP_POPULATE, ringFd, IORING_OFF_SQES);
+    if (sqes == MAP_FAILED) {
+        TearDown();
+        return false;
+    }
+
+    char* sq = (char*) sqRing;
+    sqHead = (unsigned*) (sq + params.sq_off.head);
+    sqTail = (unsigned*) (sq + params.sq_off.tail);
+    sqMask = (unsigned*) (sq + params.sq_off.ring_mask);
+    sqArray = (unsigned*) (sq + params.sq_off.array);
+
+    char* cq = (char*) cqRing;
+    cqHead = (unsigned*) (cq + params.cq_off.head);
+    cqTail = (unsigned*) (cq + params.cq_off.tail);
+    cqMask = (unsigned*) (cq + params.cq_off.ring_mask);
+    cqes = (struct io_uring_cqe*) (cq + params.cq_off.cqes);
+
+    // the kernel rounds the number of entries up to a power of 2
+    if (params.sq_entries < depth)
+        depth = params.sq_entries;
+
+    return true;
+#else
+    return false;
+#endif // __NR_io_uring_setup
+}
+
+bool AsyncDiskIO::SetUpLinuxAio() {
+    aioContext = 0;
+    if (syscall(__NR_io_setup, depth, &aioContext) < 0) {
+        aioContext = 0;
+        return false;
+    }
+
+    iocbs.resize(depth);
+    for (unsigned i = 0; i < depth; i++)
+        freeIocbs.push_back(&iocbs[i]);
+
+    return true;
+}
+
+void AsyncDiskIO::TearDown() {
+    if (sqes != MAP_FAILED)
+        munmap(sqes, sqesSize);
+    if (cqRing != MAP_FAILED && cqRing != sqRing)
+        munmap(cqRing, cqRingSize);
+    if (sqRing != MAP_FAILED)
+        munmap(sqRing, sqRingSize);
+    if (ringFd != -1)
+        close(ringFd);
+
+    sqes = (struct io_uring_sqe*) MAP_FAILED;
+    cqRing = sqRing = MAP_FAILED;
+    ringFd = -1;
+
+    if (aioContext != 0)
+        syscall(__NR_io_destroy, aioContext);
+    aioContext = 0;
+}
+
+void AsyncDiskIO::Prepare(bool isWrite, const struct iovec* iov, int iovcnt, off_t offset, uint64_t tag) {
+    FATALIF(inFlight >= depth, "More than %u asynchronous disk requests in flight", depth);
+
+    if (backend == ASYNC_IO_URING) {
+        // our own copy of the tail, the kernel only moves the head
+        unsigned tail = *sqTail;
+        unsigned index = tail & *sqMask;
+
+        struct io_uring_sqe& sqe = sqes[index];
+        memset(&sqe, 0, sizeof(sqe));
+        sqe.opcode = isWrite ? IORING_OP_WRITEV : IORING_OP_READV;
+        sqe.fd = fd;
+        sqe.off = offset;
+        sqe.addr = (uint64_t) iov;
+        sqe.len = iovcnt;
+        sqe.user_data = tag;
+
+        sqArray[index] = index;
+        RING_STORE(sqTail, tail + 1);
+    } else if (backend == ASYNC_LINUX_AIO) {
+        struct iocb* cb = freeIocbs.back();
+        freeIocbs.pop_back();
+
+        memset(cb, 0, sizeof(*cb));
+        cb->aio_lio_opcode = isWrite ? IOCB_CMD_PWRITEV : IOCB_CMD_PREADV;
+        cb->aio_fildes = fd;
+        cb->aio_offset = offset;
+        cb->aio_buf = (uint64_t) iov;
+        cb->aio_nbytes = iovcnt;
+        cb->aio_data = tag;
+
+        toSubmit.push_back(cb);
+    } else {
+        FATAL("No asynchronous disk IO backend to prepare requests for");
+    }
+
+    inFlight++;
+    prepared++;
+}
+
+void AsyncDiskIO::Submit() {
+    while (prepared > 0) {
+        long ret;
+        if (backend == ASYNC_IO_URING) {
+            ret = syscall(__NR_io_uring_enter, ringFd, prepared, 0, 0, NULL, 0);
+        } else {
+            ret = syscall(__NR_io_submit, aioContext, (long) toSubmit.size(), toSubmit.data());
+            if (ret > 0)
+                toSubmit.erase(toSubmit.begin(), toSubmit.begin() + ret);
+        }
+
+        if (ret < 0 && (errno == EINTR || errno == EAGAIN))
+            continue;
+        FATALIF(ret <= 0, "Could not submit %u asynchronous disk requests: %s",
+                prepared, ret < 0 ? strerror(errno) : "none taken");
+
+        prepared -= ret;
+    }
+}
+
+void AsyncDiskIO::WaitCompletion(uint64_t& tag, int64_t& result) {
+    FATALIF(inFlight == 0 || prepared > 0, "Waiting for asynchronous disk requests that were not submitted");
+
+    if (backend == ASYNC_IO_URING) {
+        unsigned head = *cqHead;
+        while (head == RING_LOAD(cqTail)) {
+            long ret = syscall(__NR_io_uring_enter, ringFd, 0, 1, IORING_ENTER_GETEVENTS, NULL, 0);
+            FATALIF(ret < 0 && errno != EINTR && errno != EAGAIN,
+                    "Waiting for asynchronous disk requests failed: %s", strerror(errno));
+        }
+
+        struct io_uring_cqe& cqe = cqes[head & *cqMask];
+        tag = cqe.user_data;
+        result = cqe.res;
+        RING_STORE(cqHead, head + 1);
+    } else {
+        struct io_event event;
+        while (true) {
+            long ret = syscall(__NR_io_getevents, aioContext, 1, 1, &event, NULL);
+            if (ret == 1)
+                break;
+            FATALIF(ret < 0 && errno != EINTR,
+                    "Waiting for asynchronous disk requests failed: %s", strerror(errno));
+        }
+
+        tag = event.data;
+        result = event.res;
+        freeIocbs.push_back((struct iocb*) event.obj);
+    }
+
+    inFlight--;
+}
+
+const char* AsyncDiskIO::GetBackendName() {
+    switch (backend) {
+        case ASYNC_IO_URING:
+            return "io_uring";
+        case ASYNC_LINUX_AIO:
+            return "Linux AIO";
+        default:
+            return "none";
+    }
+}
@@ -0,0 +1,256 @@
+//
+//  Copyright 2012 Alin Dobra and Christopher Jermaine
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+#include <string.h>
+
+#include "ChunkCache.h"
+#include "Constants.h"
+#include "MmapAllocator.h"
+#include "Errors.h"
+
+using namespace std;
+
+ChunkCache::Pages::Pages(const void* _data, off_t _sizePages) :
+    data(mmap_alloc(PAGES_TO_BYTES(_sizePages), 1)),
+    sizePages(_sizePages)
+{
+    memcpy(data, _data, PAGES_TO_BYTES(sizePages));
+}
+
+ChunkCache::Pages::~Pages() {
+    mmap_free(data);
+}
+
+ChunkCache::ChunkCache(off_t capacityPages) :
+    capacity(capacityPages),
+    used(0),
+    a1inUsed(0),
+    a1outUsed(0),
+    hits(0),
+    misses(0)
+{
+    pthread_mutex_init(&mutex, NULL);
+}
+
+ChunkCache::~ChunkCache() {
+    pthread_mutex_destroy(&mutex);
+}
+
+ChunkCache& ChunkCache::GetChunkCache() {
+    static ChunkCache cache(BYTES_TO_PAGES(((uint64_t) CHUNK_CACHE_SIZE) << 20));
+    return cache;
+}
+
+void ChunkCache::Remove(map<Key, EntryList::iterator>::iterator it) {
+    EntryList::iterator entry = it->second;
+    used -= entry->pages->sizePages;
+    if (entry->queue == A1IN) {
+        a1inUsed -= entry->pages->sizePages;
+        a1in.erase(entry);
+    } else {
+        am.erase(entry);
+    }
+    entries.erase(it);
+}
+
+void ChunkCache::Evict(off_t sizePages) {
+    while (used + sizePages > capacity && (!a1in.empty() || !am.empty())) {
+        if (!a1in.empty() && (a1inUsed > capacity / 4 || am.empty())) {
+            // out of A1in, the key is remembered in A1out
+            Entry& entry = a1in.back();
+            Ghost ghost = { entry.key, entry.pages->sizePages };
+            a1out.push_front(ghost);
+            ghosts[ghost.key] = a1out.begin();
+            a1outUsed += ghost.sizePages;
+
+            Remove(entries.find(entry.key));
+
+            while (a1outUsed > capacity / 2) {
+                a1outUsed -= a1out.back().sizePages;
+                ghosts.erase(a1out.back().key);
+                a1out.pop_back();
+            }
+        } else {
+            // the least recently used of Am
+            Remove(entries.find(am.back().key));
+        }
+    }
+}
+
+bool ChunkCache::IsCached(const Key& key) {
+    pthread_mutex_lock(&mutex);
+    bool cached = entries.find(key) != entries.end();
+    pthread_mutex_unlock(&mutex);
+    return cached;
+}
+
+bool ChunkCache::Get(const Key& key, void* where, off_t sizePages) {
+    PagesPtr pages;
+
+    pthread_mutex_lock(&mutex);
+    map<Key, EntryList::iterator>::iterator it = entries.find(key);
+    if (it != entries.end() && it->second->pages->sizePages == sizePages) {
+        EntryList::iterator entry = it->second;
+        pages = entry->pages;
+        // used again, to the front of Am
+        if (entry->queue == A1IN) {
+            a1inUsed -= sizePages;
+            entry->queue = AM;
+            am.splice(am.begin(), a1in, entry);
+        } else {
+            am.splice(am.begin(), am, entry);
+        }
+        hits += sizePages;
+    } else {
+        misses += sizePages;
+    }
+    pthread_mutex_unlock(&mutex);
+
+    if (!pages)
+        return false;
+
+    memcpy(where, pages->data, PAGES_TO_BYTES(sizePages));
+    return true;
+}
+
+void ChunkCache::Put(const Key& key, const void* data, off_t sizePages) {
+    if (sizePages == 0 || sizePages > capacity)
+        return;
+
+    // copied before the mutex is taken
+    PagesPtr pages(new Pages(data, sizePages));
+
+    pthread_mutex_lock(&mutex);
+    map<Key, EntryList::iterator>::iterator it = entries.find(key);
+    if (it != entries.end()) {
+        // read again by somebody else meanwhile, that is a use: the pages are
+        // refreshed and the entry goes to the front of Am
+        EntryList::iterator entry = it->second;
+        used += sizePages - entry->pages->sizePages;
+        if (entry->queue == A1IN) {
+            a1inUsed -= entry->pages->sizePages;
+            entry->queue = AM;
+            am.splice(am.begin(), a1in, entry);
+        } else {
+            am.splice(am.begin(), am, entry);
+        }
+        entry->pages = pages;
+
+        Evict(0);
+        pthread_mutex_unlock(&mutex);
+        return;
+    }
+
+    Evict(sizePages);
+
+    Entry entry = { key, pages, A1IN };
+    map<Key, GhostList::iterator>::iterator ghost = ghosts.find(key);
+    if (ghost != ghosts.end()) {
+        // seen again after it left A1in, it is worth keeping
+        a1outUsed -= ghost->second->sizePages;
+        a1out.erase(ghost->second);
+        ghosts.erase(ghost);
+
+        entry.queue = AM;
+        am.push_front(entry);
+        entries[key] = am.begin();
+    } else {
+        a1in.push_front(entry);
+        entries[key] = a1in.begin();
+        a1inUsed += sizePages;
+    }
+    used += sizePages;
+
+    pthread_mutex_unlock(&mutex);
+}
+
+void ChunkCache::Forget(uint64_t relID, off_t chunkID) {
+    Key first = { relID, chunkID, 0, false };
+
+    pthread_mutex_lock(&mutex);
+    map<Key, EntryList::iterator>::iterator it = entries.lower_bound(first);
+    while (it != entries.end() && it->first.relID == relID && it->first.chunkID == chunkID)
+        Remove(it++);
+
+    map<Key, GhostList::iterator>::iterator git = ghosts.lower_bound(first);
+    while (git != ghosts.end() && git->first.relID == relID && git->first.chunkID == chunkID) {
+        a1outUsed -= git->second->sizePages;
+        a1out.erase(git->second);
+        ghosts.erase(git++);
+    }
+    pthread_mutex_unlock(&mutex);
+}
+
+void ChunkCache::Forget(uint64_t relID) {
+    Key first = { relID, 0, 0, false };
+
+    pthread_mutex_lock(&mutex);
+    map<Key, EntryList::iterator>::iterator it = entries.lower_bound(first);
+    while (it != entries.end() && it->first.relID == relID)
+        Remove(it++);
+
+    map<Key, GhostList::iterator>::iterator git = ghosts.lower_bound(first);
+    while (git != ghosts.end() && git->first.relID == relID) {
+        a1outUsed -= git->second->sizePages;
+        a1out.erase(git->second);
+        ghosts.erase(git++);
+    }
+    pthread_mutex_unlock(&mutex);
+}
+
+bool ChunkCache::UnderPressure(void) {
+    pthread_mutex_lock(&mutex);
+    bool pressure = used * 100 > capacity * CHUNK_CACHE_PRESSURE;
+    pthread_mutex_unlock(&mutex);
+    return pressure;
+}
+
+void ChunkCache::PickVersion(Key& key, bool hasCompressed, bool maySwitch) {
+    if (!IsEnabled() || !hasCompressed || !maySwitch)
+        return;
+
+    Key other = key;
+    other.compressed = !key.compressed;
+
+    pthread_mutex_lock(&mutex);
+    if (entries.find(key) == entries.end()) {
+        // the compressed version takes less of the cache when it is getting full
+        bool pressure = used * 100 > capacity * CHUNK_CACHE_PRESSURE;
+        if (entries.find(other) != entries.end() || (pressure && !key.compressed))
+            key.compressed = !key.compressed;
+    }
+    pthread_mutex_unlock(&mutex);
+}
+
+off_t ChunkCache::GetUsed(void) {
+    pthread_mutex_lock(&mutex);
+    off_t rez = used;
+    pthread_mutex_unlock(&mutex);
+    return rez;
+}
+
+uint64_t ChunkCache::GetHits(void) {
+    pthread_mutex_lock(&mutex);
+    uint64_t rez = hits;
+    pthread_mutex_unlock(&mutex);
+    return rez;
+}
+
+uint64_t ChunkCache::GetMisses(void) {
+    pthread_mutex_lock(&mutex);
+    uint64_t rez = misses;
+    pthread_mutex_unlock(&mutex);
+    return rez;
+}
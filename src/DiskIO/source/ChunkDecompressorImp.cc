@@ -0,0 +1,52 @@
+//
+//  Copyright 2013 Tera Insights LLC
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+#include "ChunkDecompressor.h"
+#include "ExecEngineData.h"
+#include "EEExternMessages.h"
+#include "Profiling.h"
+#include "Debug.h"
+
+
+ChunkDecompressorImp::ChunkDecompressorImp(int numThreads)
+#ifdef  DEBUG_EVPROC
+    : EventProcessorImp(true, "ChunkDecompressor")
+#endif
+{
+    SetMaxThreads(numThreads);
+
+    RegisterMessageProcessor(DecompressChunk::type, &DecompressChunkFunc, 1);
+}
+
+ChunkDecompressorImp::~ChunkDecompressorImp() {
+}
+
+MESSAGE_HANDLER_DEFINITION_BEGIN(ChunkDecompressorImp, DecompressChunkFunc, DecompressChunk){
+
+    PDEBUG("MESSAGE_HANDLER_DEFINITION_BEGIN(ChunkDecompressorImp, DecompressChunkFunc, DecompressChunk)");
+
+    PROFILING2_START;
+
+    ChunkContainer cCont;
+    cCont.swap(msg.hMsg.get_data());
+    cCont.get_myChunk().Decompress();
+    cCont.swap(msg.hMsg.get_data());
+
+    PROFILING2_END;
+    PROFILING2_SINGLE("decompressed chunks", 1, "disk");
+
+    HoppingDataMsgMessage_Factory (msg.execEngine, msg.chunkID, msg.token, msg.hMsg);
+
+}MESSAGE_HANDLER_DEFINITION_END
@@ -16,6 +16,9 @@
 #include <stdlib.h>
 #include <stdio.h>
 #include <assert.h>
+#include <string.h>
+#include <vector>
+#include <algorithm>
 
 #include "BStringIterator.h"
 #include "Errors.h"
@@ -27,6 +30,8 @@
 #include "DistributedCounter.h"
 #include "MmapAllocator.h"
 #include "ChunkReaderWriterImp.h"
+#include "ChunkCache.h"
+#include "Profiling.h"
 #include "Constants.h"
 #include "ExecEngineData.h"
 #include "EEExternMessages.h"
@@ -34,7 +39,7 @@
 
 
 ChunkReaderWriterImp::ChunkReaderWriterImp(const char* _scannerName, uint64_t _numCols,
-        EventProcessor& _execEngine):
+        EventProcessor& _execEngine, EventProcessor& _decompressor):
     metadataMgr(_scannerName, _numCols), diskArray(DiskArray::GetDiskArray())
 #ifdef  DEBUG_EVPROC
     ,EventProcessorImp(true, "ChunkReaderWriter")
@@ -44,11 +49,18 @@ ChunkReaderWriterImp::ChunkReaderWriterImp(const char* _scannerName, uint64_t _n
     fileScannerId.swap(__id);
 
     execEngine.copy(_execEngine);
+    decompressor.copy(_decompressor);
 
     nextRequest = 0; // counter to generate independent requests for all
     // disk jobs. Also counts how many requests we
     // processed since starting
 
+    compactNext = -1; // no compaction yet
+    compactAgain = false;
+    compactChunk = -1;
+    compactRequest = -1;
+    compactWriting = false;
+
     //priority for processing read chunks is higher than accepting new chunks
     RegisterMessageProcessor(MegaJobFinished::type, &ChunkRWJobDone, 3);
     RegisterMessageProcessor(ChunkRead::type, &ReadChunk, 2);
@@ -56,6 +68,11 @@ ChunkReaderWriterImp::ChunkReaderWriterImp(const char* _scannerName, uint64_t _n
     RegisterMessageProcessor(Flush::type, &FlushFunc, 4);
     RegisterMessageProcessor(DeleteContent::type, &DeleteContentFunc, 5);
     RegisterMessageProcessor(ChunkClusterUpdate::type, &ClusterUpdateFunc, 6);
+    // the compaction starts once the deletions before it are done
+    RegisterMessageProcessor(DeleteChunk::type, &DeleteChunkFunc, 7);
+    RegisterMessageProcessor(CompactChunks::type, &CompactChunksFunc, 8);
+    // with the writes, that come after it
+    RegisterMessageProcessor(SetColumnCodec::type, &SetColumnCodecFunc, 1);
 }
 
 uint64_t ChunkReaderWriterImp::NewRequest(){ return ++nextRequest; }
@@ -74,17 +91,49 @@ MESSAGE_HANDLER_DEFINITION_BEGIN(ChunkReaderWriterImp, ChunkRWJobDone, MegaJobFi
     // detele the distributed counter that got created in the DiskArrary
     delete msg.counter;
 
-    // whatever request finished, we have to do the same thing: get the
-    // hopping message from requests and send it to the execution engine
-    KOff_t key(requestIdInitial);
-    KOff_t dummy;
-    CRWRequest req;
-    evProc.requests.Remove(key, dummy, req);
+    if (requestIdInitial == evProc.compactRequest) {
+        // a chunk being moved, not wanted by anybody
+        evProc.CompactJobDone();
+    } else {
+        // whatever request finished, we have to do the same thing: get the
+        // hopping message from requests and send it to the execution engine
+        KOff_t key(requestIdInitial);
+        KOff_t dummy;
+        CRWRequest req;
+        evProc.requests.Remove(key, dummy, req);
+
+        // the columns read go in the cache before anybody (the decompressor)
+        // can change their pages
+        std::map<off_t, std::vector<CacheFill> >::iterator fills = evProc.cacheFills.find(requestIdInitial);
+        if (fills != evProc.cacheFills.end()) {
+            ChunkCache& cache = ChunkCache::GetChunkCache();
+            for (CacheFill& fill : fills->second) {
+                ChunkCache::Key cacheKey = { evProc.metadataMgr.getRelID(), fill.chunkID,
+                    fill.column, fill.compressed };
+                cache.Put(cacheKey, fill.data, fill.sizePages);
+            }
+            evProc.cacheFills.erase(fills);
+        }
+
+        // chunk will be make readonly in the Table waypoint
 
-    // chunk will be make readonly in the Table waypoint
+        // and send it, through the decompressor if some columns are compressed
+        if (req.get_decompress() && evProc.decompressor.IsValid()) {
+            EventProcessor copy;
+            copy.copy(evProc.execEngine);
+            DecompressChunk_Factory (evProc.decompressor, req.get_chunkID(), copy,
+                    req.get_hMsg(), req.get_token());
+        } else {
+            HoppingDataMsgMessage_Factory (evProc.execEngine, req.get_chunkID(), req.get_token(), req.get_hMsg());
+        }
 
-    // and send it
-    HoppingDataMsgMessage_Factory (evProc.execEngine, req.get_chunkID(), req.get_token(), req.get_hMsg());
+        // the pages of the deleted and moved chunks wait for the reads
+        if (msg.operation == READ) {
+            evProc.readsOut.erase(requestIdInitial);
+            if (!evProc.unusedPages.empty())
+                evProc.FreeUnusedPages();
+        }
+    }
 
 }MESSAGE_HANDLER_DEFINITION_END
 
@@ -103,19 +152,59 @@ MESSAGE_HANDLER_DEFINITION_BEGIN(ChunkReaderWriterImp, ReadChunk, ChunkRead){
     // create the chunk
     Chunk chunk;
 
+    // did we read any column compressed?
+    bool anyCompressed = false;
+
     //create bitmap
     QueryID queries = QueryExitsToQueries(msg.dest);
 
     MMappedStorage bitStore;
     Column outBitCol(bitStore);
-    assert(evProc.metadataMgr.getNumTuples(_chunkId));
-    BStringIterator outQueries (outBitCol, queries, evProc.metadataMgr.getNumTuples(_chunkId));
-    outQueries.SetFragmentsTuples(evProc.metadataMgr.getFragmentsTuples(_chunkId));
+    // the deleted chunks have no tuples and no pages, they are read as empty
+    // chunks (no disk request is made for them)
+    uint64_t numTuples = evProc.metadataMgr.getNumTuples(_chunkId);
+    FragmentsTuples& fragTuples = evProc.metadataMgr.getFragmentsTuples(_chunkId);
+    BStringIterator outQueries;
+    if (msg.fragmentStart >= 0 && msg.fragmentEnd < (int) fragTuples.tuplesCount.size() &&
+            fragTuples.GetOverallTupleCount() == numTuples) {
+        // the zone maps say only the tuples of [fragmentStart, fragmentEnd] can
+        // match, the others are tagged with no query
+        BStringIterator someQueries (outBitCol, queries);
+        QueryID noQueries;
+        for (int frag = 0; frag < (int) fragTuples.tuplesCount.size(); frag++) {
+            bool inRange = frag >= msg.fragmentStart && frag <= msg.fragmentEnd;
+            for (uint64_t i = 0; i < fragTuples.tuplesCount[frag]; i++)
+                someQueries.Insert(inRange ? queries : noQueries);
+        }
+        outQueries.swap(someQueries);
+    } else {
+        BStringIterator allQueries (outBitCol, queries, numTuples);
+        outQueries.swap(allQueries);
+    }
+    outQueries.SetFragmentsTuples(fragTuples);
     outQueries.Done();
     //outQueries.Done(outBitCol);
     //chunk.SwapBitmap(outBitCol);
     chunk.SwapBitmap(outQueries);
 
+    // the pages of the columns and where they go
+    struct ColumnRead {
+        off_t startPage;
+        off_t sizePages;
+        void* data;
+    };
+    std::vector<ColumnRead> reads;
+
+    // the columns found in the cache are copied from there, the others are
+    // read and go in the cache when they are back
+    ChunkCache& cache = ChunkCache::GetChunkCache();
+    bool useCache = cache.IsEnabled();
+    // the version read can only be changed to a compressed one if the chunk is
+    // decompressed before the execution engine gets it
+    bool maySwitch = !msg.useUncompressed && evProc.decompressor.IsValid();
+    std::vector<CacheFill> fills;
+    off_t hitPages = 0;
+
     // go through all the columns and produce the allocation and the
     // disk requests
     // pay attentention to the special QueryIDs columns
@@ -128,8 +217,22 @@ MESSAGE_HANDLER_DEFINITION_BEGIN(ChunkReaderWriterImp, ReadChunk, ChunkRead){
         off_t sizeCompressed;
         off_t sizeUncompressed;
 
-        if (msg.useUncompressed || evProc.metadataMgr.getSizeBytesCompr(_chunkId, index) == 0 ||
-                ( evProc.metadataMgr.getSizeBytesCompr(_chunkId, index) > .75 * evProc.metadataMgr.getSizeBytes(_chunkId, index)) ){
+        bool hasCompressed = evProc.metadataMgr.getSizeBytesCompr(_chunkId, index) != 0;
+        bool useCompressed = !(msg.useUncompressed || !hasCompressed ||
+                ( evProc.metadataMgr.getSizeBytesCompr(_chunkId, index) > COMPRESSED_READ_RATIO * evProc.metadataMgr.getSizeBytes(_chunkId, index)) );
+
+        ChunkCache::Key cacheKey;
+        cacheKey.relID = evProc.metadataMgr.getRelID();
+        cacheKey.chunkID = _chunkId;
+        cacheKey.column = index.GetValue();
+        cacheKey.compressed = useCompressed;
+
+        if (useCache) {
+            cache.PickVersion(cacheKey, hasCompressed, maySwitch);
+            useCompressed = cacheKey.compressed;
+        }
+
+        if (!useCompressed){
             // uncompressed columns
             startPage = evProc.metadataMgr.getStartPage(_chunkId, index);
             sizePages = evProc.metadataMgr.getSizePages(_chunkId, index);
@@ -140,32 +243,60 @@ MESSAGE_HANDLER_DEFINITION_BEGIN(ChunkReaderWriterImp, ReadChunk, ChunkRead){
             sizePages = evProc.metadataMgr.getSizePagesCompr(_chunkId, index);
             sizeCompressed = evProc.metadataMgr.getSizeBytesCompr(_chunkId, index);
             sizeUncompressed = evProc.metadataMgr.getSizeBytes(_chunkId, index);
+            anyCompressed = true;
         }
 
         // allocate memory
         void* data = mmap_alloc(PAGES_TO_BYTES(sizePages), 1/*, numaNode*/);
         //create the column and load it into the chunk
-        MMappedStorage colStorage(data, sizeUncompressed, sizeCompressed );
+        MMappedStorage colStorage(data, sizeUncompressed, sizeCompressed, 0 /*numaNode*/,
+                evProc.metadataMgr.getCodec(_chunkId, index));
         Column newColumn(colStorage);
         newColumn.SetFragments(evProc.metadataMgr.getFragments(_chunkId, index));
 
         chunk.SwapColumn(newColumn, chkSlot);
 
-        // now create the disk requests
+        if (useCache && sizePages > 0) {
+            if (cache.Get(cacheKey, data, sizePages)) {
+                // no need to go to the disk
+                hitPages += sizePages;
+                continue;
+            }
+            CacheFill fill = { _chunkId, cacheKey.column, useCompressed, data, sizePages };
+            fills.push_back(fill);
+        }
+
+        // now plan the disk requests
         counter = counter + sizePages;
-        DiskRequestData req (startPage, sizePages, data);
+        ColumnRead read = { startPage, sizePages, data };
+        reads.push_back(read);
+    }END_FOREACH
 
+    if (useCache) {
+        PROFILING2_INSTANT("cache hit", PAGES_TO_BYTES(hitPages), "disk");
+        PROFILING2_INSTANT("cache miss", PAGES_TO_BYTES(counter), "disk");
+    }
+
+    // the requests go out ordered by page so that the columns that are next
+    // to each other on a stripe are read together (see HDThreadImp)
+    std::sort(reads.begin(), reads.end(),
+            [] (const ColumnRead& a, const ColumnRead& b) { return a.startPage < b.startPage; });
+    for (ColumnRead& read : reads) {
+        DiskRequestData req (read.startPage, read.sizePages, read.data);
         dRequests.Append(req);
-    }END_FOREACH
+    }
 
     off_t requestID = evProc.NewRequest();
 
     // place chunk in HoppingMessage and message in RequestsMap
     ChunkContainer chkContainer(chunk);
     HoppingDataMsg result (msg.requestor, msg.dest, msg.lineage, chkContainer);
-    CRWRequest req(_chunkId, result, msg.token);
+    CRWRequest req(_chunkId, anyCompressed, result, msg.token);
     KOff_t key(requestID);
     evProc.requests.Insert(key, req);
+    evProc.readsOut.insert(requestID);
+    if (!fills.empty())
+        evProc.cacheFills[requestID].swap(fills);
 
     evProc.totalPages+=counter;
 
@@ -173,7 +304,7 @@ MESSAGE_HANDLER_DEFINITION_BEGIN(ChunkReaderWriterImp, ReadChunk, ChunkRead){
     copy.copy(evProc.myInterface);
 
     // send the job to the disk array
-    DiskOperation_Factory(evProc.diskArray, requestID, READ, copy, dRequests);
+    DiskOperation_Factory(evProc.diskArray, requestID, READ, msg.priority, copy, dRequests);
 
 }MESSAGE_HANDLER_DEFINITION_END
 
@@ -200,6 +331,190 @@ static off_t RawListToDiskRequest(off_t startPage,
     return curr;
 }
 
+/** helper function to find the width of the values of a column
+
+  Columns that take exactly 4 or 8 bytes per tuple hold fixed width values
+  (INT, BIGINT, DATE, FACTOR, ...).
+
+  returns the width in bytes, 0 if the column is not fixed width
+  */
+
+static int FixedWidth(Column& col, uint64_t numTuples){
+    uint64_t numBytes = col.GetUncompressedSizeBytes();
+    if (numBytes == 4 * numTuples)
+        return 4;
+    else if (numBytes == 8 * numTuples)
+        return 8;
+    else
+        return 0;
+}
+
+/** helper function to pick a lightweight integer encoding for a column
+
+  The encoding that takes the least space, estimated on the same
+  COMPRESSION_UNIT pieces the column is compressed in, is picked if the
+  column shrinks enough to be read compressed.
+
+  returns false if the column should be written only uncompressed
+  */
+
+static bool ChooseIntEncoding(Column& col, uint64_t numTuples, ColumnCodec& codec){
+    uint64_t numBytes = col.GetUncompressedSizeBytes();
+    int width = FixedWidth(col, numTuples);
+    if (width == 0)
+        return false;
+
+    uint64_t sizes[4] = { 0, 0, 0, 0 };
+    RawStorageList rawList;
+    col.GetUncompressed(rawList);
+    FOREACH_TWL(el, rawList){
+        for (uint64_t pos = 0; pos < el.sizeInBytes; pos += COMPRESSION_UNIT) {
+            uint64_t size = el.sizeInBytes - pos < COMPRESSION_UNIT ? el.sizeInBytes - pos : COMPRESSION_UNIT;
+            uint64_t pieceSizes[4];
+            IntEncEstimate((char*) el.data + pos, size, width, pieceSizes);
+            for (int kind = 0; kind < 4; kind++)
+                sizes[kind] += sizeof(ColumnCodecBlockHeader) + pieceSizes[kind];
+        }
+    }END_FOREACH
+
+    int best = INT_ENC_FOR;
+    if (sizes[INT_ENC_DELTA] < sizes[best])
+        best = INT_ENC_DELTA;
+    if (sizes[INT_ENC_RLE] < sizes[best])
+        best = INT_ENC_RLE;
+
+    if (sizes[best] > COMPRESSED_READ_RATIO * numBytes)
+        return false;
+
+    int ids[4] = { CODEC_QUICKLZ, CODEC_FOR, CODEC_DELTA, CODEC_RLE };
+    codec = ColumnCodec(ids[best], width);
+    return true;
+}
+
+/** helper function to decide if a column of strings should be dictionary encoded
+
+  The columns of null terminated strings (STRING) are recognized by having a
+  '\0' at the end of every tuple and nowhere else. The encoding is estimated
+  on the same pieces the column would be compressed in (see DictEncCut) and is
+  picked if the column shrinks enough to be read compressed; this leaves out
+  the high cardinality columns.
+
+  returns false if the column should not be dictionary encoded
+  */
+
+static bool ChooseDictEncoding(Column& col, uint64_t numTuples, ColumnCodec& codec){
+    uint64_t numBytes = col.GetUncompressedSizeBytes();
+    if (numBytes == 0)
+        return false;
+
+    RawStorageList rawList;
+    col.GetUncompressed(rawList);
+
+    // count the strings first, that is cheap
+    uint64_t numStrings = 0;
+    uint64_t seen = 0;
+    char last = 0;
+    FOREACH_TWL(el, rawList){
+        uint64_t size = el.sizeInBytes < numBytes - seen ? el.sizeInBytes : numBytes - seen;
+        const char* bytes = (const char*) el.data;
+        for (const char* p = bytes; (p = (const char*) memchr(p, '\0', bytes + size - p)) != NULL; p++)
+            numStrings++;
+        if (size > 0)
+            last = bytes[size - 1];
+        seen += size;
+    }END_FOREACH
+    if (numStrings != numTuples || last != '\0')
+        return false;
+
+    uint64_t size = 0;
+    seen = 0;
+    FOREACH_TWL(el, rawList){
+        uint64_t elSize = el.sizeInBytes < numBytes - seen ? el.sizeInBytes : numBytes - seen;
+        for (uint64_t pos = 0; pos < elSize; ) {
+            uint64_t piece = elSize - pos < COMPRESSION_UNIT ? elSize - pos : COMPRESSION_UNIT;
+            piece = DictEncCut((const char*) el.data + pos, piece);
+            size += sizeof(ColumnCodecBlockHeader) + DictEncEstimate((const char*) el.data + pos, piece);
+            pos += piece;
+        }
+        seen += elSize;
+    }END_FOREACH
+
+    if (size > COMPRESSED_READ_RATIO * numBytes)
+        return false;
+
+    codec = ColumnCodec(CODEC_DICT);
+    return true;
+}
+
+/** helper function to collect the zone maps of a fixed width column
+
+  The fragments of the column start at the byte positions in its Fragments;
+  the values in front of the first one, if any, count for the first one.
+
+  returns false if the column is not fixed width
+  */
+
+static bool ComputeZoneMaps(Column& col, uint64_t numTuples, ColumnZoneMaps& zones){
+    int width = FixedWidth(col, numTuples);
+    if (width == 0)
+        return false;
+
+    uint64_t numBytes = col.GetUncompressedSizeBytes();
+    std::vector<uint64_t>& fragStarts = col.GetFragments().startPositions;
+    zones.fragments.resize(fragStarts.size());
+
+    uint64_t colPos = 0; // position in the column of the current piece
+    uint64_t nextFrag = 1; // next fragment to start
+    ZoneMap* fragZone = zones.fragments.empty() ? NULL : &zones.fragments[0];
+
+    RawStorageList rawList;
+    col.GetUncompressed(rawList);
+    FOREACH_TWL(el, rawList){
+        uint64_t size = el.sizeInBytes;
+        if (colPos + size > numBytes)
+            size = numBytes - colPos;
+
+        const char* data = (const char*) el.data;
+        for (uint64_t pos = 0; pos < size; pos += width) {
+            while (nextFrag < fragStarts.size() && colPos + pos >= fragStarts[nextFrag]) {
+                fragZone = &zones.fragments[nextFrag];
+                nextFrag++;
+            }
+
+            int64_t value;
+            if (width == 4) {
+                int32_t v;
+                memcpy(&v, data + pos, sizeof(v));
+                value = v;
+            } else {
+                memcpy(&value, data + pos, sizeof(value));
+            }
+
+            zones.column.Add(value);
+            if (fragZone != NULL)
+                fragZone->Add(value);
+        }
+
+        colPos += size;
+    }END_FOREACH
+
+    // the values might be unsigned, see ZoneMap.h
+    if (width == 4) {
+        if (zones.column.GetMin() < 0)
+            zones.column.Add(UINT32_MAX);
+        for (uint64_t i = 0; i < zones.fragments.size(); i++)
+            if (zones.fragments[i].GetMin() < 0)
+                zones.fragments[i].Add(UINT32_MAX);
+    }
+
+    // a fragment with no values has nothing to say
+    for (uint64_t i = 0; i < zones.fragments.size(); i++)
+        if (!zones.fragments[i].IsValid())
+            zones.fragments[i] = ZoneMap(1, 0, 0);
+
+    return true;
+}
+
 MESSAGE_HANDLER_DEFINITION_BEGIN(ChunkReaderWriterImp, WriteChunk, ChunkWrite){
     off_t counter = 0;
 
@@ -267,6 +582,22 @@ MESSAGE_HANDLER_DEFINITION_BEGIN(ChunkReaderWriterImp, WriteChunk, ChunkWrite){
         off_t startPageCompr = 0;
         Fragments frag;
 
+        // zone maps of the fixed width columns, taken before any encoding
+        ColumnZoneMaps zones;
+        if (slot != BITSTRING_SLOT && col.IsValid() && !col.GetIsCompressed())
+            ComputeZoneMaps(col, numTuples, zones);
+
+        // encode integer columns that compress well, and dictionary encode string
+        // columns with few distinct values; the encoding is picked per chunk. The
+        // other columns are compressed with the codec set for them, if any
+        ColumnCodec codec;
+        if (slot != BITSTRING_SLOT && col.IsValid() && !col.GetIsCompressed() && (
+#ifndef NO_COLUMN_ENCODING
+                ChooseIntEncoding(col, numTuples, codec) || ChooseDictEncoding(col, numTuples, codec) ||
+#endif
+                evProc.metadataMgr.getColumnCodec(index.GetValue(), codec)))
+            col.Compress(false, codec);
+
         if (col.IsValid()) {
             // get the size needed in pages
             sizePages = col.GetUncompressedSizePages();
@@ -288,7 +619,9 @@ MESSAGE_HANDLER_DEFINITION_BEGIN(ChunkReaderWriterImp, WriteChunk, ChunkWrite){
                     startPageCompr,
                     col.GetCompressedSizeBytes(),
                     sizePagesCompr,
-                    frag );
+                    frag,
+                    col.GetCodec(),
+                    zones );
         } else {
             evProc.metadataMgr.addColumn(0,
                     0,
@@ -330,24 +663,35 @@ MESSAGE_HANDLER_DEFINITION_BEGIN(ChunkReaderWriterImp, WriteChunk, ChunkWrite){
     KOff_t key(requestID);
     ChunkContainer chkContainer(msg.chunk);
     HoppingDataMsg result (msg.requestor, msg.dest, msg.lineage, chkContainer);
-    CRWRequest req(_chunkId, result, msg.token);
+    CRWRequest req(_chunkId, false, result, msg.token);
     evProc.requests.Insert(key, req);
 
     EventProcessor copy;
     copy.copy(evProc.myInterface);
 
     // send the job to the disk array
-    DiskOperation_Factory(evProc.diskArray, requestID, WRITE, copy, dRequests);
+    DiskOperation_Factory(evProc.diskArray, requestID, WRITE, DISK_WRITE_PRIORITY, copy, dRequests);
 
 }MESSAGE_HANDLER_DEFINITION_END
 
 
 MESSAGE_HANDLER_DEFINITION_BEGIN(ChunkReaderWriterImp, FlushFunc, Flush){
-    evProc.metadataMgr.Flush();
+    evProc.FlushAndFree();
 }MESSAGE_HANDLER_DEFINITION_END
 
 MESSAGE_HANDLER_DEFINITION_BEGIN(ChunkReaderWriterImp, DeleteContentFunc, DeleteContent) {
-    evProc.metadataMgr.DeleteContent();
+    if (evProc.metadataMgr.DeleteContent()) {
+        // all the space of the relation is free now, including the pages
+        // waiting to be freed and the ones of the chunk being moved
+        evProc.unusedPages.clear();
+        evProc.compactNext = -1;
+        evProc.compactAgain = false;
+        evProc.compactChunk = -1;
+
+        // the chunk IDs are given again from 0, nothing cached is right
+        evProc.DropCacheFills(-1);
+        ChunkCache::GetChunkCache().Forget(evProc.metadataMgr.getRelID());
+    }
 }MESSAGE_HANDLER_DEFINITION_END
 
 MESSAGE_HANDLER_DEFINITION_BEGIN(ChunkReaderWriterImp, ClusterUpdateFunc, ChunkClusterUpdate) {
@@ -358,3 +702,203 @@ MESSAGE_HANDLER_DEFINITION_BEGIN(ChunkReaderWriterImp, ClusterUpdateFunc, ChunkC
 
     evProc.metadataMgr.updateClusterRange(chunkNum, range);
 }MESSAGE_HANDLER_DEFINITION_END
+
+MESSAGE_HANDLER_DEFINITION_BEGIN(ChunkReaderWriterImp, DeleteChunkFunc, DeleteChunk) {
+    off_t _chunkId = msg.chunkID;
+    FATALIF( _chunkId >= evProc.metadataMgr.getNumChunks(), "Deleting a chunk not in the relation");
+
+    if (!evProc.metadataMgr.isDeleted(_chunkId)) {
+        for (unsigned long col = 0; col < evProc.metadataMgr.getNumCols(); col++) {
+            evProc.ReleasePages(evProc.metadataMgr.getStartPage(_chunkId, col),
+                    evProc.metadataMgr.getSizePages(_chunkId, col));
+            evProc.ReleasePages(evProc.metadataMgr.getStartPageCompr(_chunkId, col),
+                    evProc.metadataMgr.getSizePagesCompr(_chunkId, col));
+        }
+        evProc.metadataMgr.deleteChunk(_chunkId);
+
+        evProc.DropCacheFills(_chunkId);
+        ChunkCache::GetChunkCache().Forget(evProc.metadataMgr.getRelID(), _chunkId);
+    }
+}MESSAGE_HANDLER_DEFINITION_END
+
+MESSAGE_HANDLER_DEFINITION_BEGIN(ChunkReaderWriterImp, CompactChunksFunc, CompactChunks) {
+    if (evProc.compactNext != -1 || evProc.compactRequest != -1) {
+        // go through the chunks again when done
+        evProc.compactAgain = true;
+    } else {
+        evProc.StartCompaction();
+    }
+}MESSAGE_HANDLER_DEFINITION_END
+
+MESSAGE_HANDLER_DEFINITION_BEGIN(ChunkReaderWriterImp, SetColumnCodecFunc, SetColumnCodec) {
+    FATALIF(!ColumnCodecSupported(msg.codec), "Column codec %d is not supported by this build", msg.codec);
+
+    evProc.metadataMgr.setColumnCodec(msg.column, ColumnCodec(msg.codec, msg.level));
+    evProc.metadataMgr.Flush();
+}MESSAGE_HANDLER_DEFINITION_END
+
+void ChunkReaderWriterImp::DropCacheFills(off_t chunkID){
+    std::map<off_t, std::vector<CacheFill> >::iterator it = cacheFills.begin();
+    while (it != cacheFills.end()) {
+        std::vector<CacheFill> keep;
+        for (CacheFill& fill : it->second)
+            if (chunkID != -1 && fill.chunkID != chunkID)
+                keep.push_back(fill);
+        it->second.swap(keep);
+
+        if (it->second.empty())
+            cacheFills.erase(it++);
+        else
+            ++it;
+    }
+}
+
+void ChunkReaderWriterImp::ReleasePages(off_t startPage, off_t sizePages){
+    if (sizePages == 0)
+        return;
+
+    UnusedPages pages = { startPage, sizePages, nextRequest, false };
+    unusedPages.push_back(pages);
+}
+
+void ChunkReaderWriterImp::FlushAndFree(void){
+    metadataMgr.Flush();
+
+    for (UnusedPages& pages : unusedPages)
+        pages.flushed = true;
+    FreeUnusedPages();
+}
+
+void ChunkReaderWriterImp::FreeUnusedPages(void){
+    // the requests are numbered in order, the oldest read out is the first
+    uint64_t firstRead = readsOut.empty() ? nextRequest + 1 : *readsOut.begin();
+
+    bool freed = false;
+    std::vector<UnusedPages> stillUsed;
+    for (UnusedPages& pages : unusedPages) {
+        if (pages.flushed && pages.lastRequest < firstRead) {
+            diskArray.FreePages(pages.startPage, pages.sizePages, metadataMgr.getRelID());
+            freed = true;
+        } else {
+            stillUsed.push_back(pages);
+        }
+    }
+    unusedPages.swap(stillUsed);
+
+    // the space manager state on disk has to forget them as well
+    if (freed)
+        diskArray.Flush();
+}
+
+void ChunkReaderWriterImp::StartCompaction(void){
+    compactAgain = false;
+
+    // the pages of the deleted chunks have to be free to be filled, and to
+    // be counted as lost space
+    FlushAndFree();
+    if (!diskArray.NeedsCompaction())
+        return;
+
+    PROFILING2_INSTANT("compaction", 1, "disk");
+    compactNext = 0;
+    CompactNext();
+}
+
+void ChunkReaderWriterImp::CompactNext(void){
+    uint64_t relID = metadataMgr.getRelID();
+
+    while (compactNext < metadataMgr.getNumChunks()) {
+        off_t _chunkId = compactNext++;
+        if (metadataMgr.isDeleted(_chunkId))
+            continue;
+
+        // every column, compressed and not, moves if there is room lower
+        compactMoves.clear();
+        for (unsigned long col = 0; col < metadataMgr.getNumCols(); col++) {
+            for (int compressed = 0; compressed < 2; compressed++) {
+                off_t startPage = compressed ? metadataMgr.getStartPageCompr(_chunkId, col) :
+                    metadataMgr.getStartPage(_chunkId, col);
+                off_t sizePages = compressed ? metadataMgr.getSizePagesCompr(_chunkId, col) :
+                    metadataMgr.getSizePages(_chunkId, col);
+                if (sizePages == 0)
+                    continue;
+
+                off_t newStart = diskArray.RelocatePages(startPage, sizePages, relID);
+                if (newStart == -1)
+                    continue;
+
+                void* data = mmap_alloc(PAGES_TO_BYTES(sizePages), 1);
+                CompactMove move = { col, compressed != 0, startPage, newStart, sizePages, data };
+                compactMoves.push_back(move);
+            }
+        }
+
+        if (compactMoves.empty())
+            continue;
+
+        // read the columns first
+        DiskRequestDataContainer dRequests;
+        for (CompactMove& move : compactMoves) {
+            DiskRequestData req (move.oldStart, move.sizePages, move.data);
+            dRequests.Append(req);
+        }
+
+        compactChunk = _chunkId;
+        compactRequest = NewRequest();
+        compactWriting = false;
+
+        EventProcessor copy;
+        copy.copy(myInterface);
+        DiskOperation_Factory(diskArray, compactRequest, READ, DISK_COMPACTION_PRIORITY, copy, dRequests);
+        return;
+    }
+
+    // all the chunks were looked at
+    compactNext = -1;
+    FlushAndFree();
+
+    if (compactAgain)
+        StartCompaction();
+}
+
+void ChunkReaderWriterImp::CompactJobDone(void){
+    compactRequest = -1;
+
+    // given up (the content was deleted) or the chunk was deleted meanwhile
+    bool keep = compactChunk != -1 && !metadataMgr.isDeleted(compactChunk);
+
+    if (keep && !compactWriting) {
+        // now write the columns to the new pages
+        DiskRequestDataContainer dRequests;
+        for (CompactMove& move : compactMoves) {
+            DiskRequestData req (move.newStart, move.sizePages, move.data);
+            dRequests.Append(req);
+        }
+
+        compactRequest = NewRequest();
+        compactWriting = true;
+
+        EventProcessor copy;
+        copy.copy(myInterface);
+        DiskOperation_Factory(diskArray, compactRequest, WRITE, DISK_COMPACTION_PRIORITY, copy, dRequests);
+    } else {
+        for (CompactMove& move : compactMoves) {
+            if (keep) {
+                // the columns are in the new place
+                metadataMgr.moveColumn(compactChunk, move.column, move.compressed, move.newStart);
+                ReleasePages(move.oldStart, move.sizePages);
+            } else if (compactChunk != -1) {
+                ReleasePages(move.newStart, move.sizePages);
+            }
+            mmap_free(move.data);
+        }
+        compactMoves.clear();
+
+        if (compactChunk != -1) {
+            compactChunk = -1;
+            CompactNext();
+        } else if (compactAgain) {
+            StartCompaction();
+        }
+    }
+}
@@ -21,9 +21,11 @@
 
 #include "Errors.h"
 #include "DiskArrayImp.h"
+#include "DiskSchedule.h"
 #include "Constants.h"
 #include "MmapAllocator.h"
 #include "Hash.h"
+#include "Profiling.h"
 
 using namespace std;
 
@@ -91,21 +93,108 @@ void DiskArrayImp::PrintStatistics(void){
     cerr << "TOTAL MEMORY WRITTEN: " << (PAGES_TO_BYTES(totalPages) >> 20)  << "MB" << endl;
 }
 
+void DiskArrayImp::UpdateReadAhead(void){
+    // a chunk is striped over all the disks, so it is read as fast as
+    // the slowest of them; compare it with the average of the others
+    int slowest = -1;
+    double sum = 0.0;
+    int known = 0;
+    for (uint64_t i = 0; i < meta.HDNo; i++) {
+        if (stats[i].exp <= 0.0)
+            continue; // nothing heard yet
+        sum += stats[i].exp;
+        known++;
+        if (slowest == -1 || stats[i].exp > stats[slowest].exp)
+            slowest = i;
+    }
+
+    if (known < 2) {
+        readAheadPercent = 100;
+        return;
+    }
+
+    expectation = sum / known;
+    double others = (sum - stats[slowest].exp) / (known - 1);
+    double ratio = stats[slowest].exp / others;
+
+    if (ratio > DISK_SLOW_FACTOR) {
+        WARNINGIF(slowDisk != slowest, "Disk %d is %.1f times slower than the others, reading ahead less",
+                slowest, ratio);
+        slowDisk = slowest;
+        readAheadPercent = (int) (100.0 / ratio);
+    } else {
+        slowDisk = -1;
+        readAheadPercent = 100;
+    }
+}
+
 MESSAGE_HANDLER_DEFINITION_BEGIN(DiskArrayImp, ProcessDiskStatistics, DiskStatistics){
     // we got disk statistics from a disk. Compare it with the other
     // disks statistics and see how much lazier this disk is. If it is
     // overly lazy print warnings.
+    FATALIF(msg.diskNo < 0 || (uint64_t) msg.diskNo >= evProc.meta.HDNo,
+            "Statistics from unknown disk %d", msg.diskNo);
+
+    evProc.stats[msg.diskNo].exp = msg.expectation;
+    evProc.stats[msg.diskNo].var = msg.variance;
+    evProc.UpdateReadAhead();
+
+    // the allocations since the last statistics
+    evProc.ReportSpace();
 }MESSAGE_HANDLER_DEFINITION_END
 
-/** This message processes requests first in first out (modulo HDs finishing
-  in the same order; small jobs might finish slightly out of order)
+void DiskArrayImp::ReportSpace(void){
+    PCounterList counters;
+    PCounter allocated("space allocated", PAGES_TO_BYTES(diskSpaceMng.AllocatedSpace()), "disk");
+    counters.Append(allocated);
+    PCounter fragmented("space fragmented", PAGES_TO_BYTES(diskSpaceMng.FragmentedSpace()), "disk");
+    counters.Append(fragmented);
+    PROFILING2_PROGRESS_SET(counters, "disk");
+}
+
+bool DiskArrayImp::NeedsCompaction(void){
+    off_t allocated = diskSpaceMng.AllocatedSpace();
+    off_t fragmented = diskSpaceMng.FragmentedSpace();
+    return fragmented > 0 && fragmented * 100 > allocated * DISK_COMPACTION_THRESHOLD;
+}
+
+DiskArrayImp::StripeJobList::iterator DiskArrayImp::PickJob(uint64_t stripe){
+    return PickStripeJob(pending[stripe], headPage[stripe], clock.GetTime(),
+            DISK_SCHED_DEADLINE_MS);
+}
+
+void DiskArrayImp::Dispatch(uint64_t stripe){
+    while (jobsOut[stripe] < DISK_SCHED_JOBS_PER_STRIPE && !pending[stripe].empty()) {
+        StripeJobList::iterator it = PickJob(stripe);
+        StripeJob& job = *it;
+
+        headPage[stripe] = job.endPage;
+        jobsOut[stripe]++;
+        MegaJob_Factory(hds[stripe], job.requestId, job.operation, job.counter, job.requestor, job.requests);
+
+        pending[stripe].erase(it);
+    }
+}
+
+MESSAGE_HANDLER_DEFINITION_BEGIN(DiskArrayImp, ProcessStripeJobDone, StripeJobDone){
+    FATALIF(msg.diskNo < 0 || (uint64_t) msg.diskNo >= evProc.meta.HDNo,
+            "Job done by unknown disk %d", msg.diskNo);
+    FATALIF(evProc.jobsOut[msg.diskNo] == 0, "Disk %d is done with a job it was not given", msg.diskNo);
+
+    evProc.jobsOut[msg.diskNo]--;
+    evProc.Dispatch(msg.diskNo);
+}MESSAGE_HANDLER_DEFINITION_END
+
+/** This message splits the requests over the stripes and queues a job for
+  each stripe that has something to do; the jobs go out to the HDThreads
+  in the order given by PickJob() (see B. in DiskArrayImp.h).
 
   Any controll on multiple requests has to be performed at the higher level.
   */
 MESSAGE_HANDLER_DEFINITION_BEGIN(DiskArrayImp, DoDiskOperation, DiskOperation){
-    // create a new distributed counter to detect when all HD threads have finished
-    // The receiver of the message has to destroy it
-    DistributedCounter* dCounter = new DistributedCounter(evProc.meta.HDNo);
+    FATALIF(!msg.requestor.IsValid(), "Requestor passed in DiskArray is not valid");
+    FATALIF(msg.operation != READ && msg.operation != WRITE,
+            "Invalid operation type(%d) specified\n", msg.operation);
 
     // we make a separate list for each harddrive
     DiskRequestDataContainer* hdRequests = new DiskRequestDataContainer[evProc.meta.HDNo];
@@ -157,16 +246,46 @@ MESSAGE_HANDLER_DEFINITION_BEGIN(DiskArrayImp, DoDiskOperation, DiskOperation){
         }
     }
 
-    FATALIF(!msg.requestor.IsValid(), "Requestor passed in DiskArray is not valid");
+    // create a new distributed counter to detect when all HD threads have finished
+    // The receiver of the message has to destroy it
+    uint64_t numStripes = 0;
+    for (uint64_t i=0; i<evProc.meta.HDNo; i++){
+        if (hdRequests[i].Length() > 0)
+            numStripes++;
+    }
+    DistributedCounter* dCounter = new DistributedCounter(numStripes);
 
-    // tell each disk to do its work
-    // some of the requests are empty but that should be fine
+    if (numStripes == 0) {
+        // nothing to do, the job is done already
+        MegaJobFinished_Factory(msg.requestor, msg.requestId, msg.operation, dCounter);
+    }
+
+    double now = evProc.clock.GetTime();
     for (uint64_t i=0; i<evProc.meta.HDNo; i++){
+        if (hdRequests[i].Length() == 0)
+            continue;
+
+        evProc.pending[i].emplace_back();
+        StripeJob& job = evProc.pending[i].back();
+        job.requestId = msg.requestId;
+        job.operation = msg.operation;
+        job.priority = msg.priority;
+        job.counter = dCounter;
         // have to copy the requestor otherwise swap will give us an empty one
-        EventProcessor copy;
-        copy.copy(msg.requestor);
+        job.requestor.copy(msg.requestor);
+        job.firstPage = -1;
+        job.endPage = 0;
+        for (hdRequests[i].MoveToStart(); !hdRequests[i].AtEnd(); hdRequests[i].Advance()) {
+            DiskRequestData& req = hdRequests[i].Current();
+            if (job.firstPage == -1 || req.get_startPage() < job.firstPage)
+                job.firstPage = req.get_startPage();
+            if (req.get_startPage() + req.get_sizePages() > job.endPage)
+                job.endPage = req.get_startPage() + req.get_sizePages();
+        }
+        job.requests.swap(hdRequests[i]);
+        job.arrival = now;
 
-        MegaJob_Factory(evProc.hds[i], msg.requestId, msg.operation, dCounter, copy, hdRequests[i]);
+        evProc.Dispatch(i);
     }
 
     delete [] hdRequests;
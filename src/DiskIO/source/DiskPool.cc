@@ -16,6 +16,9 @@
 #include "Debug.h"
 #include "DiskPool.h"
 #include "ChunkReaderWriter.h"
+#include "ChunkDecompressor.h"
+#include "DiskArray.h"
+#include "Constants.h"
 #include "DiskIOMessages.h"
 #include "FileMetadata.h"
 
@@ -39,10 +42,18 @@ TableScanID DiskPool::AddFile(string name, uint64_t numCols){
         return id;
     }
 
-    ChunkReaderWriter file(name.c_str(), numCols, executionEngine);
+    if (NUM_DECOMPRESSION_THREADS > 0 && !decompressor.IsValid()) {
+        ChunkDecompressor temp(NUM_DECOMPRESSION_THREADS);
+        for (int i = 0; i < NUM_DECOMPRESSION_THREADS; i++)
+            temp.ForkAndSpin();
+        decompressor.swap(temp);
+    }
+
+    ChunkReaderWriter file(name.c_str(), numCols, executionEngine, decompressor);
 
     off_t numChunks = file.GetNumChunks();
     ClusterRangeList cRanges = file.GetClusterRanges();
+    std::vector< std::vector<ColumnZoneMaps> > zMaps = file.GetZoneMaps();
 
     PDEBUG("Started %s stream with %d chunks and %d columns", name.c_str(), numChunks, numCols);
 
@@ -54,6 +65,7 @@ TableScanID DiskPool::AddFile(string name, uint64_t numCols){
     files.Insert(cID, file);
     sizes[id]=numChunks;
     clusterRanges[id] = cRanges;
+    zoneMaps[id].swap(zMaps);
 
     return id;
 }
@@ -78,9 +90,24 @@ auto DiskPool::ClusterRanges(TableScanID id) -> ClusterRangeList {
     return it->second;
 }
 
+auto DiskPool::ZoneMaps(TableScanID id, int column) -> ZoneMapList {
+    FATALIF( !files.IsThere(id), "Why are we asking about the zone maps of a file not started?");
+    auto it = zoneMaps.find(id);
+    FATALIF(it == zoneMaps.end(),
+        "No zone map information found");
+
+    ZoneMapList ret;
+    for( auto& chunk : it->second ) {
+        FATALIF(column < 0 || column >= (int) chunk.size(),
+            "Asking for the zone maps of column %d that does not exist", column);
+        ret.push_back(chunk[column]);
+    }
+    return ret;
+}
+
 void DiskPool::ReadRequest(ChunkID& id, WayPointID &requestor, bool useUncompressed,
         HistoryList &lineage, QueryExitContainer &dest,
-        GenericWorkToken& token, SlotPairContainer& colsToProcess){
+        GenericWorkToken& token, SlotPairContainer& colsToProcess, int priority){
 
     // check if the token is forged
     FATALIF(token.Type() != DiskWorkToken::type, "I got a fake disk token in read");
@@ -93,7 +120,8 @@ void DiskPool::ReadRequest(ChunkID& id, WayPointID &requestor, bool useUncompres
 
     EventProcessor& evProc = files.Find(tId);
 
-    ChunkRead_Factory(evProc, requestor, chunkID, useUncompressed, lineage,
+    ChunkRead_Factory(evProc, requestor, chunkID, useUncompressed, priority,
+            id.GetFragmentStart(), id.GetFragmentEnd(), lineage,
             dest, token, colsToProcess);
 
 }
@@ -138,6 +166,33 @@ void DiskPool::Flush (TableScanID id) {
     Flush_Factory(evProc);
 }
 
+void DiskPool::DeleteChunk(ChunkID& id) {
+    TableScanID tId = id.GetTableScanId();
+
+    FATALIF( !files.IsThere(tId), "Deleting a chunk of unknown file");
+
+    EventProcessor& evProc = files.Find(tId);
+
+    off_t chunkID = (uint64_t) id;
+    DeleteChunk_Factory(evProc, chunkID);
+}
+
+void DiskPool::Compact(TableScanID id) {
+    FATALIF( !files.IsThere(id), "Compacting unknown file");
+
+    EventProcessor& evProc = files.Find(id);
+    CompactChunks_Factory(evProc);
+}
+
+void DiskPool::CompactFragmented(void) {
+    if (!DiskArray::GetDiskArray().NeedsCompaction())
+        return;
+
+    for (SizeMap::iterator it = sizes.begin(); it != sizes.end(); ++it) {
+        Compact(it->first);
+    }
+}
+
 void DiskPool :: DeleteContent(std::string name) {
     TableScanID id(name);
     if( !files.IsThere(id) ) {
@@ -148,6 +203,29 @@ void DiskPool :: DeleteContent(std::string name) {
     }
 }
 
+void DiskPool :: SetColumnCodec(std::string name, uint64_t numCols, int column,
+        int codec, int level) {
+    TableScanID id = AddFile(name, numCols);
+
+    EventProcessor& evProc = files.Find(id);
+    SetColumnCodec_Factory(evProc, column, codec, level);
+}
+
+void DiskPool :: DeleteChunks(std::string name, uint64_t numCols,
+        const std::vector<off_t>& chunks) {
+    TableScanID id = AddFile(name, numCols);
+
+    for (off_t chunk : chunks) {
+        FATALIF(chunk < 0 || chunk >= NumChunks(id),
+            "Deleting chunk %ld that is not in relation %s", (long) chunk, name.c_str());
+        ChunkID chunkID(chunk, id);
+        DeleteChunk(chunkID);
+    }
+
+    // after the deletions, their pages are counted once freed
+    Compact(id);
+}
+
 void DiskPool :: DeleteRelation(std::string name) {
     // do we have the file started?
     TableScanID id(name);
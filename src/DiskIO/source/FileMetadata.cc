@@ -37,3 +37,31 @@ FileMetadata::~FileMetadata() {
     free(relName);
 }
 
+void FileMetadata::deleteChunk(off_t numChunk) {
+    FATALIF(numChunk < 0 || numChunk >= numChunks, "Deleting chunk %ld that is not in relation %s",
+        (long) numChunk, relName);
+
+    ChunkMetaD& chunk = chunkMetaD[numChunk];
+    chunk.numTuples = 0;
+    chunk.fragTuple = FragmentsTuples();
+    for (unsigned long col = 0; col < chunk.colMetaData.size(); col++) {
+        // same as the columns with no data
+        Fragments noFragments;
+        chunk.colMetaData[col] = ColumnMetaData(noFragments, 0, 0, 0, 0, 0, 0);
+    }
+
+    modified = true;
+}
+
+void FileMetadata::moveColumn(off_t numChunk, unsigned long numCol, bool _compressed, off_t _newStartPage) {
+    FATALIF(numChunk < 0 || numChunk >= numChunks, "Moving chunk %ld that is not in relation %s",
+        (long) numChunk, relName);
+
+    ColumnMetaData& column = chunkMetaD[numChunk].colMetaData[numCol];
+    if (_compressed)
+        column.startPageCompr = _newStartPage;
+    else
+        column.startPage = _newStartPage;
+
+    modified = true;
+}
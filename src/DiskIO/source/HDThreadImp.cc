@@ -23,7 +23,10 @@
 #include <assert.h>
 #include <sys/types.h>
 #include <sys/stat.h>
+#include <sys/uio.h>
 #include <fcntl.h>
+#include <limits.h>
+#include <errno.h>
 
 
 #include "Errors.h"
@@ -33,6 +36,7 @@
 #include "DiskArray.h"
 #include "MmapAllocator.h"
 #include "Profiling.h"
+#include "Constants.h"
 
 #ifndef O_DIRECT
 # define O_LARGEFILE 0100000
@@ -125,6 +129,22 @@ HDThreadImp::HDThreadImp(const char *_fileName, uint64_t arrayHash, EventProcess
         FATAL("Error in HDThreads(%s)\n", _fileName);
     }
 
+    asyncIO = NULL;
+#ifndef NO_ASYNC_IO
+    asyncIO = new AsyncDiskIO(fileDescriptor, HD_QUEUE_DEPTH);
+    if (!asyncIO->IsValid()) {
+        WARNING("No asynchronous IO for stripe %s, the disk gets one request at a time", fileName);
+        delete asyncIO;
+        asyncIO = NULL;
+    }
+#endif // NO_ASYNC_IO
+
+    gapBuffer = IO_COALESCE_MAX_GAP_PAGES > 0 ?
+        mmap_alloc(PAGES_TO_BYTES(IO_COALESCE_MAX_GAP_PAGES), 1) : NULL;
+
+    memset(readSizes, 0, sizeof(readSizes));
+    memset(writeSizes, 0, sizeof(writeSizes));
+
     RegisterMessageProcessor(MegaJob::type, &HDThreadImp::ExecuteJob, 1);
 }
 
@@ -137,8 +157,12 @@ HDThreadImp::~HDThreadImp() {
     // WARNING("You should not shut down the disk array");
 
     free(fileName);
+    if (asyncIO != NULL)
+        delete asyncIO;
     if( fileDescriptor != -1 )
         close(fileDescriptor);
+    if (gapBuffer != NULL)
+        mmap_free(gapBuffer);
 }
 
 void HDThreadImp::UpdateStatistics(double time){
@@ -153,59 +177,180 @@ void HDThreadImp::UpdateStatistics(double time){
     }
 }
 
-//thread for each HD
-//the parameter is a HDThreadParam struct
-MESSAGE_HANDLER_DEFINITION_BEGIN(HDThreadImp, ExecuteJob, MegaJob){
+void HDThreadImp::AddToHistogram(uint64_t* histogram, off_t numPG){
+    int bucket = 0;
+    while (bucket < NUM_SIZE_BUCKETS - 1 && ((off_t)1 << bucket) < numPG)
+        bucket++;
+    histogram[bucket]++;
+}
 
-    FATALIF(!msg.requestor.IsValid(), "Requestor passed in DiskArray is not valid");
+void HDThreadImp::GetHistograms(PCounterList& counters){
+    char group[32];
+    sprintf(group, "hd%d", header.stripeId);
+
+    for (int i = 0; i < NUM_SIZE_BUCKETS; i++) {
+        char name[64];
+        uint64_t kb = PAGES_TO_BYTES((off_t)1 << i) >> 10;
+        if (readSizes[i] != 0) {
+            sprintf(name, "reads <=%luKB", kb);
+            PCounter cnt(name, readSizes[i], group);
+            counters.Append(cnt);
+        }
+        if (writeSizes[i] != 0) {
+            sprintf(name, "writes <=%luKB", kb);
+            PCounter cnt(name, writeSizes[i], group);
+            counters.Append(cnt);
+        }
+    }
+
+    memset(readSizes, 0, sizeof(readSizes));
+    memset(writeSizes, 0, sizeof(writeSizes));
+}
+
+void HDThreadImp::CoalesceRequests(DiskRequestDataContainer& requests, int operation,
+        vector<IORun>& runs){
+    // reads can go over the gaps between the requests, the pages of
+    // the gaps are read in gapBuffer
+    const off_t maxGap = (operation == READ) ? IO_COALESCE_MAX_GAP_PAGES : 0;
+
+    requests.MoveToStart();
+    while (!requests.AtEnd()){
+        IORun run;
+        run.page = requests.Current().get_startPage();
+        run.gapPages = 0;
+        off_t endPage = run.page; // page after the last page of the run
+
+        // extend the run with the requests that follow it closely enough
+        for (; !requests.AtEnd(); requests.Advance()){
+            DiskRequestData& request = requests.Current();
+            off_t gap = request.get_startPage() - endPage;
+            off_t runPages = request.get_startPage() + request.get_sizePages() - run.page;
+
+            if (!run.iov.empty() && (gap < 0 || gap > maxGap ||
+                        runPages > IO_COALESCE_MAX_PAGES || run.iov.size() + 2 > IOV_MAX))
+                break;
+
+            if (gap > 0) {
+                struct iovec gapVec = { gapBuffer, PAGES_TO_BYTES(gap) };
+                run.iov.push_back(gapVec);
+                run.gapPages += gap;
+            }
+
+            struct iovec vec = { request.get_memLoc(), PAGES_TO_BYTES(request.get_sizePages()) };
+            run.iov.push_back(vec);
+            endPage = request.get_startPage() + request.get_sizePages();
+        }
+
+        run.numPG = endPage - run.page;
+        if (run.numPG > 0)
+            runs.push_back(run);
+    }
+}
+
+void HDThreadImp::RunDone(IORun& run, int operation, double time){
+    AddToHistogram(operation == WRITE ? writeSizes : readSizes, run.numPG);
+    UpdateStatistics(time/run.numPG);
+}
 
-    // main loop over the pages in the request
-    for(msg.requests.MoveToStart(); !msg.requests.AtEnd(); msg.requests.Advance()){
-        DiskRequestData& request = msg.requests.Current();
-        off_t page = request.get_startPage();
-        off_t numPG = request.get_sizePages();
-        void* where = request.get_memLoc();
+void HDThreadImp::DoRunsSync(vector<IORun>& runs, int operation, off_t requestId){
+    for (IORun& run : runs) {
+        off_t position = header.offset + PAGES_TO_BYTES(run.page);
 
         Timer clock;
         clock.Restart();
 
-        //first go to the correct location
-        if (lseek (evProc.fileDescriptor, evProc.header.offset+PAGES_TO_BYTES(page), SEEK_SET) == -1) {
+        ssize_t ret = (operation == WRITE) ?
+            pwritev(fileDescriptor, run.iov.data(), run.iov.size(), position) :
+            preadv(fileDescriptor, run.iov.data(), run.iov.size(), position);
+        if (ret == -1) {
             perror("HDThread:");
-            FATAL("Failed to seek in file %s to position %ld",
-                    evProc.fileName, evProc.header.offset+PAGES_TO_BYTES(page));
+            FATAL("%s of file %s at position %ld of size %ld for job %ld failed. Mem: %lx",
+                    operation == WRITE ? "Writting" : "Reading", fileName, run.page,
+                    PAGES_TO_BYTES(run.numPG), (int64_t)requestId, (uint64_t)run.iov[0].iov_base);
         }
 
-        // now perform the operation
-        if (msg.operation == WRITE) {
-
-            FATALIF(evProc.isReadOnly, "Attempting to write data to read-only disk")
-            PROFILING2_START;
-            if (write (evProc.fileDescriptor, where, PAGES_TO_BYTES(numPG) ) == -1){
-                perror("HDThread:");
-                FATAL("Writting of file %s at position %ld of size %ld for job %d failed. Mem: %lx",
-                        evProc.fileName, page, PAGES_TO_BYTES(numPG),  (uint64_t)msg.requestId, where);
-            }
+        RunDone(run, operation, clock.GetTime());
+    }
+}
 
-            PROFILING2_END;
-            PROFILING2_SINGLE("byw", PAGES_TO_BYTES(numPG), "disk");
-        }
-        else  if (msg.operation == READ) {
-            PROFILING2_START;
-            if (read (evProc.fileDescriptor, where, PAGES_TO_BYTES(numPG)) == -1) {
-                perror("HDThread:");
-                FATAL("Reading of file %s at position %ld of size %d for job %d failed. Mem: %lx",
-                        evProc.fileName, page, PAGES_TO_BYTES(numPG), (uint64_t)msg.requestId, where);
-            }
-            PROFILING2_END;
-            PROFILING2_SINGLE("byr", PAGES_TO_BYTES(numPG), "disk");
+void HDThreadImp::DoRunsAsync(vector<IORun>& runs, int operation, off_t requestId){
+    // when each of the runs in flight was handed to the disk
+    vector<double> started(runs.size());
+    Timer clock;
+    clock.Restart();
+
+    size_t next = 0; // next run to hand to the disk
+    size_t done = 0;
+    while (done < runs.size()) {
+        // keep the queue full
+        while (next < runs.size() && asyncIO->GetInFlight() < asyncIO->GetDepth()) {
+            IORun& run = runs[next];
+            off_t position = header.offset + PAGES_TO_BYTES(run.page);
+            asyncIO->Prepare(operation == WRITE, run.iov.data(), run.iov.size(), position, next);
+            started[next] = clock.GetTime();
+            next++;
         }
-        else {
-            FATAL("Invalid operation type(%d) specified\n",msg.operation);
+        asyncIO->Submit();
+
+        uint64_t tag;
+        int64_t result;
+        asyncIO->WaitCompletion(tag, result);
+        IORun& run = runs[tag];
+        if (result < 0) {
+            errno = -result;
+            perror("HDThread:");
+            FATAL("%s of file %s at position %ld of size %ld for job %ld failed. Mem: %lx",
+                    operation == WRITE ? "Writting" : "Reading", fileName, run.page,
+                    PAGES_TO_BYTES(run.numPG), (int64_t)requestId, (uint64_t)run.iov[0].iov_base);
         }
 
-        evProc.UpdateStatistics(clock.GetTime()/numPG);
+        RunDone(run, operation, clock.GetTime() - started[tag]);
+        done++;
     }
+}
+
+//thread for each HD
+//the parameter is a HDThreadParam struct
+MESSAGE_HANDLER_DEFINITION_BEGIN(HDThreadImp, ExecuteJob, MegaJob){
+
+    FATALIF(!msg.requestor.IsValid(), "Requestor passed in DiskArray is not valid");
+    FATALIF(msg.operation != READ && msg.operation != WRITE,
+            "Invalid operation type(%d) specified\n", msg.operation);
+    FATALIF(msg.operation == WRITE && evProc.isReadOnly, "Attempting to write data to read-only disk");
+
+    PROFILING2_START;
+
+    vector<IORun> runs;
+    evProc.CoalesceRequests(msg.requests, msg.operation, runs);
+
+    if (evProc.asyncIO != NULL)
+        evProc.DoRunsAsync(runs, msg.operation, msg.requestId);
+    else
+        evProc.DoRunsSync(runs, msg.operation, msg.requestId);
+
+    PROFILING2_END;
+
+    off_t numPG = 0;
+    off_t gapPages = 0;
+    for (IORun& run : runs) {
+        numPG += run.numPG;
+        gapPages += run.gapPages;
+    }
+    if (msg.operation == WRITE) {
+        PROFILING2_SINGLE("byw", PAGES_TO_BYTES(numPG), "disk");
+    } else {
+        PROFILING2_SINGLE("byr", PAGES_TO_BYTES(numPG - gapPages), "disk");
+        if (gapPages > 0)
+            PROFILING2_SINGLE("byr gaps", PAGES_TO_BYTES(gapPages), "disk");
+    }
+
+    PCounterList histograms;
+    evProc.GetHistograms(histograms);
+    if (histograms.Length() > 0)
+        PROFILING2_SET(histograms, "disk");
+
+    // the disk array can send us the next job
+    StripeJobDone_Factory(evProc.diskArray, evProc.header.stripeId);
 
     //signal the calling thread if these are the last pages to read/write
     if (msg.counter->Decrement(1) == 0) { // decrease the number of threads that finished
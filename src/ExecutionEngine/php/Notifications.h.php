@@ -81,8 +81,10 @@ grokit\create_data_type( "WayPointDeadMsg", "Notification", [ ], [ ] );
 grokit\create_data_type( "CentralHashMessage", "Notification", [ ], [ 'centralHash' => 'HashTable', ] );
 ?>
 
+// sent from a join to the cleaner to ask for the hash; rhsEntries is the number of hash table
+// entries the join expects its RHS to take (0 if it does not know), used to size the segments
 <?
-grokit\create_data_type( "GetHashTable", "Notification", [ ], [ ] );
+grokit\create_data_type( "GetHashTable", "Notification", [ 'rhsEntries' => 'int64_t', ], [ ] );
 ?>
 
 #endif
@@ -133,9 +133,10 @@ grokit\create_data_type( "JoinMergeWorkDescription", "WorkDescription", [ 'wayPo
 ?>
 
 
-// work description for the hash table cleaner
+// work description for the hash table cleaner; numRanges is zero when the whole segment is
+// rebuilt by one worker, otherwise the worker cleans range whichRange of numRanges
 <?php
-grokit\create_data_type( "HashCleanerWorkDescription", "WorkDescription", [ 'whichSegment' => 'int', ], [ 'centralHashTable' => 'HashTable', 'diskTokenQueue' => 'DiskWorkTokenQueue', 'dyingWayPointsToSend' => 'JoinWayPointIDList', 'dyingWayPointsToHold' => 'JoinWayPointIDList', 'theseQueriesAreDone' => 'QueryExitContainer', 'equivalences' => 'JoinWayPointIDEquivalences', ] );
+grokit\create_data_type( "HashCleanerWorkDescription", "WorkDescription", [ 'whichSegment' => 'int', 'whichRange' => 'int', 'numRanges' => 'int', ], [ 'centralHashTable' => 'HashTable', 'diskTokenQueue' => 'DiskWorkTokenQueue', 'dyingWayPointsToSend' => 'JoinWayPointIDList', 'dyingWayPointsToHold' => 'JoinWayPointIDList', 'theseQueriesAreDone' => 'QueryExitContainer', 'equivalences' => 'JoinWayPointIDEquivalences', ] );
 ?>
 
 
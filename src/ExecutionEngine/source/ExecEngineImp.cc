@@ -524,11 +524,31 @@ MESSAGE_HANDLER_DEFINITION_BEGIN(ExecEngineImp, ConfigureExecEngine, ConfigureEx
                     globalDiskPool.DeleteContent(myTask.get_relation());
                 }
                 break;
+            case DeleteChunksTask::type:
+                {
+                    DeleteChunksTask myTask;
+                    myTask.swap(task);
+                    globalDiskPool.DeleteChunks(myTask.get_relation(),
+                            myTask.get_numCols(), myTask.get_chunks());
+                }
+                break;
+            case SetColumnCodecTask::type:
+                {
+                    SetColumnCodecTask myTask;
+                    myTask.swap(task);
+                    globalDiskPool.SetColumnCodec(myTask.get_relation(),
+                            myTask.get_numCols(), myTask.get_column(),
+                            myTask.get_codec(), myTask.get_level());
+                }
+                break;
             default:
                 FATAL("Unknown task type %llx", task.Type());
         }
     } END_FOREACH
 
+    // fill the space lost by the deletions, if there is enough of it
+    globalDiskPool.CompactFragmented();
+
     // we go thru the list of guys that are being configured...
     msg.configs.MoveToStart ();
     while (msg.configs.RightLength ()) {
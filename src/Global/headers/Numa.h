@@ -46,7 +46,10 @@ int numaCurrentNode(void);
 #include <numa.h>
 
 inline int numaNodeCount(void){ return numa_max_node() + 1; }
-inline int int numaCurrentNode(void){ return numa_preferred(); }
+inline int numaCurrentNode(void){
+	int node = numa_node_of_cpu(sched_getcpu());
+	return node < 0 ? 0 : node;
+}
 
 #else // no NUMA
 
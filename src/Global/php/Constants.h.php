@@ -40,7 +40,9 @@ require_once('grokit_config.php');
 /*
 ==================Central hash table parameters==================
 * - NUM_SLOTS_IN_SEGMENT_BITS: This should not be over 24 bits if the size of a chunk is 2M tuples.
-*     This size works well and Cleaner produces reasonably sized chunks.
+*     This size works well and Cleaner produces reasonably sized chunks. This is the largest a
+*     segment gets; segments start smaller when the joins estimate little data, and double in
+*     size when they are cleaned while the table is full (see HashTableMacros.h).
 * - NUM_SEGS: This should be manipulated to use most memory in the system (about 70%).
 *     Make sure it is set to a sum of few 2^k numbers so that % operator is implemented
 *     efficiently by the compiler.
@@ -55,9 +57,11 @@ require_once('grokit_config.php');
 ==================Column related constants==================
 * - COLUMN_ITERATOR_STEP: Constant to determine how much data is prepared in advance in column iterators
 * - COMPRESSION_UNIT: To allowed streamed decompression, small units have to be compressed in a streaming fashion.
+* - COLUMN_BATCH_SIZE: Largest number of values the generated code takes at once from ColumnIterator::GetBatch
 */
 #define COLUMN_ITERATOR_STEP (1<<14) /* 16KB */
 #define COMPRESSION_UNIT COLUMN_ITERATOR_STEP
+#define COLUMN_BATCH_SIZE 1024
 
 
 
@@ -115,10 +119,26 @@ require_once('grokit_config.php');
 
 
 /* Fraction of threads that need to be available to use compressed data
+ * (less I/O, the CPU pays for the decompression). Only used if the chunks are
+ * decompressed ahead, see NUM_DECOMPRESSION_THREADS.
 */
 #define USE_UNCOMPRESSED_THRESHOLD .1
 
 
+/* Number of threads that decompress the compressed columns of the chunks read
+ * from disk, before the chunks are handed to the waypoints. With 0, compressed
+ * data is never read.
+*/
+#define NUM_DECOMPRESSION_THREADS 4
+
+
+/* Compressed columns are read only if they take at most this fraction of the
+ * uncompressed size. Integer columns are encoded at write time only if they
+ * shrink below it.
+*/
+#define COMPRESSED_READ_RATIO .75
+
+
 /* Maximum number of threads running in the ChunkReaderWriter (serving messages).
 */
 #define CHUNK_RW_THREADS 12
@@ -130,6 +150,84 @@ require_once('grokit_config.php');
 #define DISK_OPERATION_STATISTICS_INTERVAL 100
 
 
+/* The requests of a disk job that are close on the same stripe are done by a
+ * single preadv/pwritev. Reads also go over gaps of up to this many pages
+ * between the requests (the gaps are read and thrown away); writes only
+ * coalesce contiguous requests.
+*/
+#define IO_COALESCE_MAX_GAP_PAGES 4
+
+
+/* Largest coalesced disk request, in pages.
+*/
+#define IO_COALESCE_MAX_PAGES 128
+
+
+/* Most disk requests (coalesced runs) in flight per stripe, when the stripes
+ * are read and written asynchronously (see AsyncDiskIO.h).
+*/
+#define HD_QUEUE_DEPTH 32
+
+
+/* Jobs the DiskArray sends to a stripe before the stripe is done with them.
+ * The other jobs wait in the DiskArray, where they are reordered: reads go
+ * before writes and by priority, then in elevator order of their pages.
+*/
+#define DISK_SCHED_JOBS_PER_STRIPE 2
+
+
+/* A job that has waited this long for its stripe (in milliseconds) goes next,
+ * whatever its kind or priority, so that writes and low priority reads are
+ * delayed but not starved.
+*/
+#define DISK_SCHED_DEADLINE_MS 500
+
+
+/* Priority of the disk tokens and of the chunk reads of the table scanners,
+ * as in ExecEngine (1 is the highest). The disk array serves the reads with
+ * higher priorities first.
+*/
+#define DISK_SCAN_PRIORITY 2
+
+/* Priority of the disk tokens and of the chunk reads of the tile joins; the
+ * join waits for the tiles, so they go before the reads of the scans.
+*/
+#define DISK_TILE_JOIN_PRIORITY 1
+
+/* Priority of the chunk writes, as in ExecEngine (1 is the highest). Only
+ * used to order the writes among themselves; reads always go first.
+*/
+#define DISK_WRITE_PRIORITY 2
+
+/* Priority of the reads and writes that move chunks to free space lower in
+ * the disk array (see CompactChunks); below the regular reads and writes.
+*/
+#define DISK_COMPACTION_PRIORITY 3
+
+/* Percent of the allocated space of the disk array that can be lost between
+ * the allocations (deleted chunks and relations) before the relations are
+ * compacted (see CompactChunks).
+*/
+#define DISK_COMPACTION_THRESHOLD 10
+
+/* Size, in MB, of the cache of the columns read from the disk shared by all
+ * the relations (see ChunkCache.h). 0 turns the cache off.
+*/
+#define CHUNK_CACHE_SIZE 2048
+
+/* Percent of the chunk cache in use past which the compressed version of the
+ * columns is read and cached, when there is one, instead of the uncompressed one.
+*/
+#define CHUNK_CACHE_PRESSURE 75
+
+
+/* A disk that takes this many times longer per page than the average of the
+ * other disks is considered slow. Since every chunk is striped over all the
+ * disks, the table scanners read ahead fewer chunks while one is slow.
+*/
+#define DISK_SLOW_FACTOR 2.0
+
+
 /* This is the number of CPU work token requests that the hash table cleaner can have out at one time.
 */
 #define MAX_CLEANER_CPU_WORKERS <?=$__grokit_config_cpu_cleaners?>
@@ -0,0 +1,105 @@
+//
+//  Copyright 2012 Alin Dobra and Christopher Jermaine
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+
+#ifndef BLOOM_FILTER_H
+#define BLOOM_FILTER_H
+
+#include "HashTableMacros.h"
+#include "Errors.h"
+
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+
+// this is a blocked Bloom filter over join key hashes.  Every key lives in a single
+// 64-byte block (one cache line) and sets one bit in each of the block's eight words,
+// so a probe costs one cache miss no matter how many bits are checked.  The filter is
+// fed the same HT_INDEX_TYPE hash that is used to place the tuple in the hash table,
+// so neither side has to hash the key twice
+class BloomFilter {
+
+	// number of 64-bit words in a block
+	static constexpr int WORDS_PER_BLOCK = 8;
+
+	static constexpr uint64_t NUM_BLOCKS = 1ULL << JOIN_FILTER_BLOCKS_BITS;
+
+	struct alignas(64) Block {
+		uint64_t words[WORDS_PER_BLOCK];
+	};
+
+	Block *blocks;
+
+	// the low bits of the hash already pick the segment and slot in the hash table,
+	// so the filter works on a remixed copy to stay independent of them
+	static uint64_t Remix (HT_INDEX_TYPE hash) {
+		uint64_t h = hash * 0x9E3779B97F4A7C15ULL;
+		return h ^ (h >> 29);
+	}
+
+	// the block takes the top bits; the 6-bit bit positions come from the rest
+	static uint64_t WhichBlock (uint64_t mixed) {
+		return mixed >> (64 - JOIN_FILTER_BLOCKS_BITS);
+	}
+
+	static uint64_t BitInWord (uint64_t mixed, int word) {
+		return 1ULL << ((mixed >> (6 * word)) & 63);
+	}
+
+public:
+
+	BloomFilter () {
+		if (posix_memalign ((void **) &blocks, sizeof (Block), NUM_BLOCKS * sizeof (Block)))
+			FATAL ("Could not allocate the join Bloom filter\n");
+		Clear ();
+	}
+
+	~BloomFilter () {
+		free (blocks);
+	}
+
+	// the filter owns its memory
+	BloomFilter (const BloomFilter &) = delete;
+	BloomFilter &operator = (const BloomFilter &) = delete;
+
+	// adds a key hash; safe to call from several threads at once
+	void Insert (HT_INDEX_TYPE hash) {
+		uint64_t mixed = Remix (hash);
+		Block &block = blocks[WhichBlock (mixed)];
+		for (int i = 0; i < WORDS_PER_BLOCK; i++) {
+			__atomic_fetch_or (&block.words[i], BitInWord (mixed, i), __ATOMIC_RELAXED);
+		}
+	}
+
+	// false means that no key with this hash was ever inserted
+	bool MayContain (HT_INDEX_TYPE hash) const {
+		uint64_t mixed = Remix (hash);
+		const Block &block = blocks[WhichBlock (mixed)];
+		for (int i = 0; i < WORDS_PER_BLOCK; i++) {
+			uint64_t bit = BitInWord (mixed, i);
+			if ((block.words[i] & bit) == 0)
+				return false;
+		}
+		return true;
+	}
+
+	// empties the filter
+	void Clear () {
+		memset (blocks, 0, NUM_BLOCKS * sizeof (Block));
+	}
+};
+
+#endif
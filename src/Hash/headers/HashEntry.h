@@ -27,7 +27,11 @@
 class HashEntry {
 
     // this is the smallest offet value that must be written externally outside of the hash
+#ifdef COMPACT_HASH_ENTRY
+    static constexpr unsigned int MAX = 127;
+#else
     static constexpr unsigned int MAX = 1023;
+#endif
 
     friend class HashTableSegment;
     unsigned int info;
@@ -68,6 +72,15 @@ class HashEntry {
     // (by definition, start records always hold the bitmap)
     inline void SetAttributeID (unsigned int whichID);
 
+    // put the fingerprint of the tuple's hash (see HASH_FINGERPRINT) into a "start" entry; this
+    // is a no-op unless the entries are compact
+    inline void SetFingerprint (int fingerprint);
+
+    // puts a second narrow attribute into the high half of a continuation entry whose own
+    // attribute takes up only the low half; reads sizeof (VAL_TYPE) / 2 bytes.  Only for
+    // compact entries
+    inline void PackSecond (unsigned int whichID, void *fromHere);
+
     // these functions just extract all of the above info out
     inline bool IsUsed ();
     inline bool IsStartOfTuple ();
@@ -75,6 +88,15 @@ class HashEntry {
     inline bool IsRHS ();
     inline bool IsLHS ();
     inline unsigned int GetAttributeID ();
+    inline int GetFingerprint ();
+
+    // a start entry matches a fingerprint if either of them is unknown, or they are the same
+    inline bool MatchesFingerprint (int fingerprint);
+
+    // true if this continuation entry holds two attributes; GetAttributeID is the one in the
+    // low half and GetSecondAttributeID the one in the high half
+    inline bool IsPacked ();
+    inline unsigned int GetSecondAttributeID ();
 
     // since these two may need to go to the Overflow object to retreive distances greater than
     // 10 bits, they also accept the overflow object as input
@@ -85,6 +107,11 @@ class HashEntry {
     // the location that is pointed to
     inline void Extract (void *writeHere);
 
+    // the same for the halves of a packed entry; the half is written zero-extended to
+    // sizeof (VAL_TYPE) bytes
+    inline void ExtractFirst (void *writeHere);
+    inline void ExtractSecond (void *writeHere);
+
     // this puts actual data into the hash entry, reading sizeof (VAL_TYPE) bytes from the
     // pointed to location
     inline void PutIn (void *fromHere);
@@ -92,6 +119,13 @@ class HashEntry {
     // zero it out... makes it unused, with nothing in there
     inline void EmptyOut ();
 
+    // the following are used by concurrent writers that share a segment.  TryClaim
+    // atomically takes an unused entry by marking it as a reserved continuation; it fails
+    // if some other writer got there first.  Publish atomically replaces the info part
+    // of an entry the caller owns, so other writers never see a half-updated entry
+    inline bool TryClaim ();
+    inline void Publish (HashEntry &fromMe);
+
 } __attribute__((__packed__));
 
 
@@ -105,6 +139,11 @@ class HashEntry {
 // in a start record, the next 10 bits are the distance from the correct position
 // in a continuation record, the next 10 bits are the attribute number
 // in a start record, the most significant 10 bits is the waypoint the record belongs to
+//
+// With COMPACT_HASH_ENTRY defined, the two distances take 7 bits each (bits 2-8 and 9-15), and
+// a start record keeps the hash fingerprint in bits 16-21.  A continuation record keeps its
+// attribute number in bits 12-21 as before; bit 9 marks it as packed, and then bits 22-31 are
+// the attribute number of the second attribute, held in the high half of the value
 inline void HashEntry :: EmptyOut () {info = 0;}
 inline void HashEntry :: SetEmpty () {info &= (~0 ^ 3);}
 inline void HashEntry :: SetRHS () {info |= 3;}
@@ -120,10 +159,80 @@ inline unsigned int HashEntry :: GetAttributeID () {return (info & 4190208) >> 1
 inline unsigned int HashEntry :: GetWayPointID () {return info >> 22;}
 inline void HashEntry :: Extract (void *writeHere) {*((VAL_TYPE *) writeHere) = value;}
 inline void HashEntry :: PutIn (void *fromHere) {value = *((VAL_TYPE *) fromHere);}
+inline void HashEntry :: ExtractFirst (void *writeHere) {*((VAL_TYPE *) writeHere) = value & 4294967295ULL;}
+inline void HashEntry :: ExtractSecond (void *writeHere) {*((VAL_TYPE *) writeHere) = value >> 32;}
+
+#ifdef COMPACT_HASH_ENTRY
+inline void HashEntry :: SetDistToNextEntryToZero () {info = (info & 4294966787) | ((0 & 127) << 2);}
+inline void HashEntry :: SetFingerprint (int fingerprint) {info = (info & 4290838527) | ((fingerprint & 63) << 16);}
+inline int HashEntry :: GetFingerprint () {return (info & 4128768) >> 16;}
+inline bool HashEntry :: IsPacked () {return (info & 3) == 1 && (info & 512);}
+inline unsigned int HashEntry :: GetSecondAttributeID () {return info >> 22;}
+inline void HashEntry :: PackSecond (unsigned int whichID, void *fromHere) {
+    value = (value & 4294967295ULL) | ((VAL_TYPE) *((uint32_t *) fromHere) << 32);
+    info = (info & 4194303) | 512 | ((whichID & 1023) << 22);
+}
+#else
 inline void HashEntry :: SetDistToNextEntryToZero () {info = (info & 4294963203) | ((0 & 1023) << 2);}
+inline void HashEntry :: SetFingerprint (int) {}
+inline int HashEntry :: GetFingerprint () {return 0;}
+inline bool HashEntry :: IsPacked () {return false;}
+inline unsigned int HashEntry :: GetSecondAttributeID () {return 0;}
+inline void HashEntry :: PackSecond (unsigned int, void *) {
+    FATAL ("Packed hash entries need COMPACT_HASH_ENTRY");
+}
+#endif
+
+inline bool HashEntry :: MatchesFingerprint (int fingerprint) {
+    return fingerprint <= 0 || GetFingerprint () == 0 || GetFingerprint () == fingerprint;
+}
+
+inline bool HashEntry :: TryClaim () {
+    unsigned int expected = 0;
+    return __atomic_compare_exchange_n (&info, &expected, 1 | (RESERVED_SLOT << 12), false,
+        __ATOMIC_ACQ_REL, __ATOMIC_RELAXED);
+}
+
+inline void HashEntry :: Publish (HashEntry &fromMe) {
+    value = fromMe.value;
+    __atomic_store_n (&info, fromMe.info, __ATOMIC_RELEASE);
+}
 
 // these last four operations all may need to go to the overflow object, if the 10 bits allocated to recording
-// distances to and from different positions in the array are not enough
+// distances to and from different positions in the array are not enough (7 bits for compact entries)
+#ifdef COMPACT_HASH_ENTRY
+inline void HashEntry :: SetDistToNextEntry (unsigned int distance, HT_INDEX_TYPE slot, Overflow &putExtraHere) {
+    if (distance >= MAX) {
+        putExtraHere.RecordDistanceToNext (slot, distance);
+        distance = MAX;
+    }
+    info = (info & 4294966787) | ((distance & 127) << 2);
+}
+
+inline void HashEntry :: SetDistFromCorrectPos (unsigned int distance, HT_INDEX_TYPE slot, Overflow &putExtraHere) {
+    if (distance >= MAX) {
+        putExtraHere.RecordDistanceFromCorrect (slot, distance);
+        distance = MAX;
+    }
+    info = (info & 4294902271) | ((distance & 127) << 9);
+}
+
+inline unsigned int HashEntry :: GetDisttoNextEntry (HT_INDEX_TYPE slot, Overflow &putExtraHere) {
+    unsigned int distance = (info & 508) >> 2;
+    if (distance == MAX)
+        return putExtraHere.GetDistanceToNext (slot);
+    else
+        return distance;
+}
+
+inline unsigned int HashEntry :: GetDistFromCorrectPos (HT_INDEX_TYPE slot, Overflow &putExtraHere) {
+    unsigned int distance = (info & 65024) >> 9;
+    if (distance == MAX)
+        return putExtraHere.GetDistanceFromCorrectPos (slot);
+    else
+        return distance;
+}
+#else
 inline void HashEntry :: SetDistToNextEntry (unsigned int distance, HT_INDEX_TYPE slot, Overflow &putExtraHere) {
     if (distance >= MAX) {
         putExtraHere.RecordDistanceToNext (slot, distance);
@@ -155,6 +264,6 @@ inline unsigned int HashEntry :: GetDistFromCorrectPos (HT_INDEX_TYPE slot, Over
     else
         return distance;
 }
-
+#endif // COMPACT_HASH_ENTRY
 
 #endif
@@ -30,6 +30,21 @@ private:
 	// each entry is one iff the particular HashTableSegment is write locked
 	int *writeLocked;
 
+	// number of concurrent writers that currently share each HashTableSegment
+	int *sharedWriters;
+
+	// number of exclusive writers blocked on each HashTableSegment; while this is non-zero
+	// no new shared writers are let in, so that the cleaner cannot be starved
+	int *exclusiveWaiting;
+
+	// state of the cleaning in ranges of each HashTableSegment: 0 if there is none, 1 while
+	// the first cleaner worker is setting it up, 2 once shared writers can come back in
+	int *cleaning;
+
+	// the number of slot bits that segments get when they are rebuilt, at the least; set from
+	// the cardinality estimates of the joins (see SizeFor)
+	int *targetBits;
+
 	// this is the current version of the hash table
 	HashTableView *currentTable;	
 	
@@ -78,6 +93,23 @@ public:
 	// simply releases a write lock on the segment
 	void CheckIn (int whichEntry);
 
+	// this is the shared counterpart of CheckOutOne, for writers that insert with
+	// HashTableSegment::InsertConcurrent.  Any number of shared writers can hold the same
+	// segment at once; they only exclude (and are excluded by) writers that used CheckOutOne,
+	// such as the cleaner.  The call blocks only if every acceptable segment is exclusively held
+	int CheckOutShared (int *theseAreOK, HashTableSegment &checkMeOut);
+
+	// releases a segment obtained with CheckOutShared
+	void CheckInShared (int whichEntry);
+
+	// this is called by each cleaner worker that cleans a range of segment whichSegment.  The
+	// first one to get here waits for the writers of the segment to drain out, and sets up the
+	// cleaning with HashTableSegment::StartCleaning; the others wait until that is done.  From
+	// then on, shared writers are let back in while exclusive writers wait until the cleaned
+	// segment is put in with Replace, which ends the cleaning.  Readers do not wait; only their
+	// probes into a range that a worker is moving wait for it (see HashTableSegment::StartProbe)
+	void CheckOutForCleaning (int whichSegment, int numRanges, HashTableSegment &checkMeOut);
+
 	// makes a shallow copy of the hash table
 	void Clone (HashTable &fromMe);
 	void copy(HashTable &fromMe){ Clone(fromMe); }
@@ -85,11 +117,26 @@ public:
 	// creates an empty hash table
 	HashTable ();
 
-	// allocates the hash table having NUM_SEGS segments of specified size; uses the specified
+	// allocates the hash table having NUM_SEGS segments of 2^slotBits slots each; uses the specified
 	// number of threads to zero out and prepare the hash table... this number needs to be at
 	// least 1 (a 1 means that no additional threads other than this one are spawned to do 
 	// the zeroing).
-	void Allocate (int numThreads);
+	void Allocate (int numThreads, int slotBits = NUM_SLOTS_IN_SEGMENT_BITS);
+
+	// the number of slot bits per segment that keeps numEntries hash table entries under
+	// ESTIMATE_FILL_RATE, within MIN_SLOTS_IN_SEGMENT_BITS and NUM_SLOTS_IN_SEGMENT_BITS
+	static int BitsFor (int64_t numEntries);
+
+	// notes that a join is about to put about numEntries entries into the hash table; segments
+	// that are smaller than BitsFor (numEntries) grow to that size the next time they are cleaned
+	void SizeFor (int64_t numEntries);
+
+	// the number of slot bits the cleaner should give the new version of segment checkMeOut
+	int RebuildBits (HashTableSegment &checkMeOut);
+
+	// returns 1 if no segment has reached NUM_SLOTS_IN_SEGMENT slots yet, so cleaning can still
+	// make room by growing segments instead of throwing data out
+	int CanGrow ();
 
 	// tells us if the hash table has been allocated
 	int IsAllocated ();
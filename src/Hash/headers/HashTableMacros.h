@@ -20,6 +20,7 @@
 // MACROS USED FOR HASHING!!
 
 #include "Constants.h"
+#include "Numa.h"
 
 #include <cstdint>
 
@@ -37,12 +38,17 @@
 #define HT_INDEX_TYPE uint64_t
 
 
-// this is the number of bits needed to index all of the entried in a hash table segment
+// this is the number of bits needed to index all of the entried in the largest hash table segment
 // moved to Constnts.h #define NUM_SLOTS_IN_SEGMENT_BITS 20
 
-// this is the number of entries in a hash table segment
+// this is the number of entries in the largest hash table segment.  Segments are sized at run time
+// (see HashTableSegment::Allocate) and may have fewer; hash values are always mapped to a slot of
+// the largest size first (WHICH_SLOT), and a smaller segment uses the top bits of that slot
 #define NUM_SLOTS_IN_SEGMENT (1ULL << (NUM_SLOTS_IN_SEGMENT_BITS))
 
+// the smallest segment we ever allocate; it has to be split into 2^NUM_FRAGMENT_BITS fragments
+#define MIN_SLOTS_IN_SEGMENT_BITS (NUM_SLOTS_IN_SEGMENT_BITS < 14 ? NUM_SLOTS_IN_SEGMENT_BITS : 14)
+
 // this is a bitmask that, when applied to an int, obtains a number from 0 to NUM_SLOTS_IN_SEGMENT
 #define HASH_SLOTS_MASK (NUM_SLOTS_IN_SEGMENT - 1ULL)
 
@@ -53,9 +59,31 @@
 // this take a hash value and figures out which segment it is in
 #define WHICH_SEGMENT(hash) ((hash >> NUM_SLOTS_IN_SEGMENT_BITS) % NUM_SEGS)
 
-// this is the absolute limit on the number of entries in a hash table segment... includes
+// a short tag made of the top hash bits, which pick neither the segment nor the slot.  With
+// compact hash entries it is kept in the start entry of a tuple, so that a probe can pass over
+// the tuples of its chain that cannot match without extracting them.  The tag is never 0; 0
+// stands for a tuple whose fingerprint is not known (e.g. one that came back from disk)
+#define HASH_FINGERPRINT_BITS 6
+#define HASH_FINGERPRINT(hash) (1 + (int) (((hash) >> (64 - HASH_FINGERPRINT_BITS)) % ((1 << HASH_FINGERPRINT_BITS) - 1)))
+
+// passed to HashTableSegment::Extract to match a tuple with any fingerprint
+#define NO_FINGERPRINT -1
+
+// this is the NUMA node that holds a segment, and that the work on the segment is sent to; the
+// segments are dealt out to the nodes round robin.  With INTERLEAVE_HASH_SEGMENTS defined, the
+// pages of every segment are interleaved over all the nodes instead
+#ifdef INTERLEAVE_HASH_SEGMENTS
+#define SEGMENT_NODE(seg) NUMA_ALL_NODES
+#else
+#define SEGMENT_NODE(seg) ((seg) % numaNodeCount())
+#endif
+
+// this is the limit on the number of entries in a hash table segment with numSlots slots... includes
 // some scratch space at the end
-#define ABSOLUTE_HARD_CAP ((HT_INDEX_TYPE)(NUM_SLOTS_IN_SEGMENT * 1.08))
+#define HARD_CAP_FOR(numSlots) ((HT_INDEX_TYPE)((numSlots) * 1.08))
+
+// the same, for the largest segment
+#define ABSOLUTE_HARD_CAP HARD_CAP_FOR(NUM_SLOTS_IN_SEGMENT)
 
 // this is the maximum fill rate we allow in a segment when we add data to it
 #define MAX_FILL_RATE .7
@@ -66,6 +94,22 @@
 // this is the goal in terms of how full a segment should be after cleaning
 #define FRAC_TO_TAKE_IT_DOWN (0.9 * CLEAN_FILL_RATE / MAX_FILL_RATE)
 
+// if a segment is cleaned while it is over-full, or while the hash table as a whole is at least
+// this full, the live data does not fit, and the segment is rebuilt with twice as many slots (up
+// to NUM_SLOTS_IN_SEGMENT)
+#define GROW_FILL_RATE .5
+
+// the fill rate that a segment sized from a cardinality estimate starts out below
+#define ESTIMATE_FILL_RATE (MAX_FILL_RATE / 2)
+
+// when nothing has to be extracted to disk, the cleaner splits a segment into this many ranges of
+// home slots per cleaner worker and cleans them in parallel while writers keep inserting
+#define CLEANER_RANGES_PER_WORKER 4
+
+// number of ranges a segment is split into when it is cleaned in ranges; if this is 1, every
+// segment is rebuilt in one go with the writers locked out
+#define CLEANER_NUM_RANGES (MAX_CLEANER_CPU_WORKERS * CLEANER_RANGES_PER_WORKER)
+
 // this is the number of test hash table probes to make when we determine of the segment is over-full
 #define NUM_TEST_PROBES 200
 
@@ -73,5 +117,34 @@
 // to identifying which attribute is being stored.  1111111111 is reserved to indicate the bitmap
 #define BITMAP 1023
 
+// attribute number given to a slot that a concurrent writer has claimed but not filled in yet
+#define RESERVED_SLOT 1022
+
+// attribute number of the entry that ends every tuple in a segment smaller than the largest size;
+// it holds the slot WHICH_SLOT gave for the tuple, which the segment itself only keeps the top
+// bits of, so that the cleaner can put the tuple in the right place when the segment grows
+#define SLOT_HASH 1021
+
+// the overflow table of a segment starts with one entry per 2^OVERFLOW_SLOTS_FRACTION_BITS slots
+// of the segment, and doubles whenever it gets half full
+#define OVERFLOW_SLOTS_FRACTION_BITS 8
+
+// the radix join mode groups tuples by the region of the hash table they go to before touching
+// it; a region is 2^RADIX_PARTITION_SLOT_BITS slots of a segment, about 200KB, so it fits in L2
+#define RADIX_PARTITION_SLOT_BITS 14
+
+// number of regions in a segment
+#define RADIX_NUM_PARTITIONS (NUM_SLOTS_IN_SEGMENT_BITS > RADIX_PARTITION_SLOT_BITS ? \
+	(1 << (NUM_SLOTS_IN_SEGMENT_BITS - RADIX_PARTITION_SLOT_BITS)) : 1)
+
+// the region of the whole table a hash goes to; also works on a bare slot, as for those
+// the segment part is zero
+#define WHICH_RADIX_PARTITION(hash) \
+	(WHICH_SEGMENT (hash) * RADIX_NUM_PARTITIONS + (WHICH_SLOT (hash) >> RADIX_PARTITION_SLOT_BITS))
+
+// log2 of the number of 64-byte blocks in the Bloom filter built over the RHS join keys;
+// 16 gives a 4MB filter, about 8 bits per key for 4M distinct keys
+#define JOIN_FILTER_BLOCKS_BITS 16
+
 #endif
 
@@ -27,6 +27,8 @@
 #include <memory>
 #include <functional>
 
+struct SegmentCleaning;
+
 // this class encapsulates one of the segments of the main hash table.  It is broken
 // into segments so that it is easy for writers to lock individual segments, and to
 // swap new versions in wholesale
@@ -54,6 +56,14 @@ private:
 		// this is the number of bytes in the hash segment
 		HT_INDEX_TYPE numBytes;
 
+		// the segment has 2^slotBits home slots, and room for hardCap entries in all
+		int slotBits;
+		HT_INDEX_TYPE numSlots;
+		HT_INDEX_TYPE hardCap;
+
+		// the NUMA node the entries were placed on (see SEGMENT_NODE)
+		int node;
+
 		// this tells us which slots to probe in the hash table when testing for fullness
 		std::unique_ptr<HT_INDEX_TYPE[]> randomProbeSlots;
 
@@ -68,14 +78,27 @@ private:
 		// 10 bits, and hence cannot be stored within the actual hash table itself
 		Overflow bigOffsets;
 
+		// set while the segment is being cleaned in ranges (see SegmentCleaning.h)
+		std::shared_ptr<SegmentCleaning> cleaning;
+
+		// the same, for the readers, which do not synchronize with the cleaner; set once the
+		// new version is ready
+		std::atomic<SegmentCleaning *> probeCleaning;
+
 		SharedData():
 			myData(nullptr),
 			randomProbeSlots(nullptr),
 			numBytes(0),
+			slotBits(0),
+			numSlots(0),
+			hardCap(0),
+			node(NUMA_ALL_NODES),
 			fillRate(0.0),
 			privateLHS(0),
 			privateRHS(0),
-			bigOffsets()
+			bigOffsets(),
+			cleaning(nullptr),
+			probeCleaning(nullptr)
 		{ }
 
 		~SharedData() { }
@@ -83,6 +106,32 @@ private:
 
 	std::shared_ptr<SharedData> data;
 
+	// probes the NUM_TEST_PROBES random slots, remembering the tuples found there in
+	// mySample; returns the number of probes that hit a used slot
+	int SampleCollisions (HashSegmentSample &mySample);
+
+	// records the collisions found by SampleCollisions and reports if we are over-full
+	int UpdateFillRate (int numCollisions);
+
+	// puts the tuple that starts at posInArray into the segment the way InsertConcurrent does;
+	// returns the position of the next tuple
+	int ClaimAndInsert (SerializedSegmentArray &data, HT_INDEX_TYPE fullSlot, int posInArray);
+
+	// puts one entry of a tuple into the first empty slot at or after whichSlot, for the sequential
+	// inserts; whichSlot is left on the entry
+	void PutEntry (HashEntry &entry, HT_INDEX_TYPE &whichSlot);
+
+	// the same for the concurrent inserts; prevSlot is the previous entry of the tuple, whose
+	// forward pointer is published once the entry is in place
+	void ClaimEntry (HashEntry &entry, HT_INDEX_TYPE &whichSlot, HT_INDEX_TYPE &prevSlot);
+
+	// the SLOT_HASH entry that ends a tuple with the given full slot
+	static HashEntry SlotEntry (HT_INDEX_TYPE fullSlot);
+
+	// StartProbe and EndProbe while the segment is being cleaned in ranges
+	HashTableSegment &StartProbeCleaning (SegmentCleaning *cleaning, HT_INDEX_TYPE fullSlot, int &pinnedRange);
+	void EndProbeCleaning (int pinnedRange);
+
 public:
 
 	// mark this segment as being overfull; used when someone tries to add data and finds there is too much there
@@ -99,11 +148,52 @@ public:
 	// from a tuple that hashed to position "goal".  The att we are interested in is whichAtt, and the value must be
 	// from the join waypoint hainvg join waypoint ID wayPointID.  The result is written to serializeHere; the number
 	// bytes serialized are returned (a 0 indicates that we could not find the desired data in the table).  If wayPointID
-	// is -1, then ANY waypoint is accepted; the waypoint found is put into wayPointID.  Whether or not this is a LHS tuple
-	// is returned inside of LHS.  Done is set to 1 if the last attribute in the tuple has been found; it is zero otherwise.
-	int Extract (void *serializeHere, HT_INDEX_TYPE &curSlot, HT_INDEX_TYPE goal, int &wayPointID, int whichAtt, int &LHS, int &done);
-
-	// insert the list of serialized tuples into the hash table... in the first, we assume that all inserts are sequential
+	// is -1, then ANY waypoint is accepted; the waypoint found is put into wayPointID.  Likewise, only tuples whose
+	// fingerprint matches (see HASH_FINGERPRINT) are looked at; if fingerprint is NO_FINGERPRINT, any is accepted and
+	// the fingerprint found is put into fingerprint.  Whether or not this is a LHS tuple is returned inside of LHS.
+	// Done is set to 1 if the last attribute in the tuple has been found; it is zero otherwise.  An attribute kept in
+	// half of a packed entry comes out zero-extended to a VAL_TYPE, but only half of that is counted as serialized.
+	int Extract (void *serializeHere, HT_INDEX_TYPE &curSlot, HT_INDEX_TYPE goal, int &wayPointID, int &fingerprint,
+		int whichAtt, int &LHS, int &done);
+
+	// called by a reader before it probes the tuples with the given full slot (as given by
+	// WHICH_SLOT); returns the version of the segment that has all of them, to Extract from.  That
+	// is this one, unless the segment is being cleaned in ranges: then it is this one while no
+	// cleaner worker has taken the range of the slot (the range is pinned until EndProbe so that
+	// it stays so), or the new version once the range is clean.  Only a probe into a range that
+	// is being moved waits.  pinnedRange has to be given back to EndProbe
+	HashTableSegment &StartProbe (HT_INDEX_TYPE fullSlot, int &pinnedRange);
+	void EndProbe (int pinnedRange);
+
+	// hint the CPU that the home slot of fullSlot (as given by WHICH_SLOT) is about to be probed; used
+	// by the batched LHS probe to overlap the cache misses of several lookups instead of taking them
+	// one by one
+	void Prefetch (HT_INDEX_TYPE fullSlot);
+
+	// maps a slot given by WHICH_SLOT to the home slot of the tuple in this segment, and back; a
+	// segment with fewer than NUM_SLOTS_IN_SEGMENT slots uses the top bits of the slot
+	HT_INDEX_TYPE HomeSlot (HT_INDEX_TYPE fullSlot);
+	HT_INDEX_TYPE FullSlot (HT_INDEX_TYPE homeSlot);
+
+	// called by the cleaner right after it extracted the bitmap of the tuple homed at homeSlot, with
+	// the curSlot and done that Extract left; returns the full slot of the tuple, which is kept in
+	// its last entry if the segment is smaller than the largest size
+	HT_INDEX_TYPE FullSlotOfTuple (HT_INDEX_TYPE curSlot, int done, HT_INDEX_TYPE homeSlot);
+
+	// number of home slots, and log2 of it
+	HT_INDEX_TYPE NumSlots ();
+	int GetSlotBits ();
+
+	// the NUMA node this segment lives on
+	int GetNode ();
+
+	// the number of slot bits the cleaner should give the new version of this segment: one more
+	// than now if the segment is over-full, or if it is cleaned while the hash table as a whole is
+	// over GROW_FILL_RATE, up to NUM_SLOTS_IN_SEGMENT_BITS
+	int SlotBitsAfterCleaning ();
+
+	// insert the list of serialized tuples into the hash table (the hashes in data are the slots
+	// given by WHICH_SLOT)... in the first, we assume that all inserts are sequential
 	// in terms of hash ID, and we zero out as we go
 	void Insert (SerializedSegmentArray &data);
 
@@ -111,6 +201,23 @@ public:
 	// result in a collision, then a 1 is returned... in any case, a list of the collisions found is returned in mySample
 	int Insert (SerializedSegmentArray &data, HashSegmentSample &mySample);
 
+	// same as above, but safe to run while other writers insert into the same segment (the
+	// segment is checked out with HashTable::CheckOutShared).  Empty slots are claimed with
+	// an atomic compare-and-swap on the entry info, so writers never wait for each other
+	int InsertConcurrent (SerializedSegmentArray &data, HashSegmentSample &mySample);
+
+	// same again, without the sampling; used by the cleaner to fill the new version of a segment
+	void InsertConcurrent (SerializedSegmentArray &data);
+
+	// sets up the cleaning of this segment in numRanges ranges: the new version of the segment
+	// is allocated with 2^slotBits slots, and from now on InsertConcurrent sends each tuple either
+	// to the old or to the new version.  No writer may hold the segment during the call (see
+	// HashTable::CheckOutForCleaning)
+	void StartCleaning (int numRanges, int slotBits);
+
+	// the state of the cleaning in ranges; nullptr if the segment is not being cleaned that way
+	SegmentCleaning *GetCleaning ();
+
 	// swap two segments
 	void swap (HashTableSegment &withMe);
 
@@ -126,8 +233,12 @@ public:
 	// create an empty HashTableSegment
 	HashTableSegment ();
 
-	// allocates this guy
-	void Allocate ();
+	// allocates this guy with 2^slotBits home slots on the given NUMA node; slotBits is clamped to
+	// the range from MIN_SLOTS_IN_SEGMENT_BITS to NUM_SLOTS_IN_SEGMENT_BITS
+	void Allocate (int slotBits = NUM_SLOTS_IN_SEGMENT_BITS, int node = NUMA_ALL_NODES);
+
+	// tells us if this guy has been allocated
+	int IsAllocated () { return data != nullptr; }
 
 	// clears him out
 	void ZeroOut ();
@@ -138,9 +249,25 @@ public:
 };
 
 
+inline HashTableSegment &HashTableSegment :: StartProbe (HT_INDEX_TYPE fullSlot, int &pinnedRange) {
+
+	pinnedRange = -1;
+	SegmentCleaning *cleaning = data->probeCleaning.load (std::memory_order_acquire);
+	if (cleaning == nullptr)
+		return *this;
+
+	return StartProbeCleaning (cleaning, fullSlot, pinnedRange);
+}
+
+inline void HashTableSegment :: EndProbe (int pinnedRange) {
+
+	if (pinnedRange != -1)
+		EndProbeCleaning (pinnedRange);
+}
+
 // returns number of bytes extracted on success, 0 otherwise
 inline int HashTableSegment :: Extract (void *serializeHere, HT_INDEX_TYPE &curSlot,
-	HT_INDEX_TYPE goal, int &wayPointID, int whichAtt, int &isLHS, int &done) {
+	HT_INDEX_TYPE goal, int &wayPointID, int &fingerprint, int whichAtt, int &isLHS, int &done) {
 
 	// if numBytes = 0 it means that we have not found anything from our tuple yet
 	int numBytes = 0;
@@ -153,6 +280,31 @@ inline int HashTableSegment :: Extract (void *serializeHere, HT_INDEX_TYPE &curS
 			return numBytes;
 		}
 
+		// a packed entry holds two single-word attributes; we stay on it after taking the first
+		// one, since the second one is always asked for next
+		if (numBytes == 0 && whichAtt != BITMAP && data->myData[curSlot].IsPacked ()) {
+
+			done = 0;
+			if (whichAtt == data->myData[curSlot].GetAttributeID ()) {
+				data->myData[curSlot].ExtractFirst (serializeHere);
+				return sizeof (VAL_TYPE) / 2;
+			}
+
+			if (whichAtt != data->myData[curSlot].GetSecondAttributeID ()) {
+				return 0;
+			}
+
+			data->myData[curSlot].ExtractSecond (serializeHere);
+			int dist = data->myData[curSlot].GetDisttoNextEntry (curSlot, data->bigOffsets);
+			if (dist == 0) {
+				curSlot += 1;
+				done = 1;
+			} else {
+				curSlot += dist;
+			}
+			return sizeof (VAL_TYPE) / 2;
+		}
+
 		// if we are currently serializing and the current attribute does not match, we are done
 		if ((numBytes > 0 || whichAtt != BITMAP) && whichAtt != data->myData[curSlot].GetAttributeID ()) {
 			done = 0;
@@ -166,10 +318,13 @@ inline int HashTableSegment :: Extract (void *serializeHere, HT_INDEX_TYPE &curS
 		}
 
 		// if this is the start of a tuple and it has the correct hash and we are looking for a bitmap, add it in
-		if (data->myData[curSlot].IsStartOfTuple () && curSlot - data->myData[curSlot].GetDistFromCorrectPos (curSlot, data->bigOffsets) == goal
-			&& whichAtt == BITMAP && (data->myData[curSlot].GetWayPointID () == wayPointID || wayPointID == -1)) {
+		if (data->myData[curSlot].IsStartOfTuple () && whichAtt == BITMAP && data->myData[curSlot].MatchesFingerprint (fingerprint)
+			&& curSlot - data->myData[curSlot].GetDistFromCorrectPos (curSlot, data->bigOffsets) == goal
+			&& (data->myData[curSlot].GetWayPointID () == wayPointID || wayPointID == -1)) {
 
 			wayPointID = data->myData[curSlot].GetWayPointID ();
+			if (fingerprint == NO_FINGERPRINT)
+				fingerprint = data->myData[curSlot].GetFingerprint ();
 			isLHS = data->myData[curSlot].IsLHS ();
 			data->myData[curSlot].Extract ((char*)serializeHere + numBytes);
 			numBytes += sizeof (VAL_TYPE);
@@ -192,13 +347,102 @@ inline int HashTableSegment :: Extract (void *serializeHere, HT_INDEX_TYPE &curS
 	}
 }
 
+inline void HashTableSegment :: Prefetch (HT_INDEX_TYPE fullSlot) {
+
+	// a tuple usually spans a couple of entries, so bring in the line after the home slot too
+	const char *where = (const char *) &(data->myData[HomeSlot (fullSlot)]);
+	__builtin_prefetch (where, 0, 1);
+	__builtin_prefetch (where + 64, 0, 1);
+}
+
+inline HT_INDEX_TYPE HashTableSegment :: HomeSlot (HT_INDEX_TYPE fullSlot) {
+	return fullSlot >> (NUM_SLOTS_IN_SEGMENT_BITS - data->slotBits);
+}
+
+inline HT_INDEX_TYPE HashTableSegment :: FullSlot (HT_INDEX_TYPE homeSlot) {
+	return homeSlot << (NUM_SLOTS_IN_SEGMENT_BITS - data->slotBits);
+}
+
+inline HT_INDEX_TYPE HashTableSegment :: NumSlots () {
+	return data->numSlots;
+}
+
+inline int HashTableSegment :: GetSlotBits () {
+	return data->slotBits;
+}
+
+inline int HashTableSegment :: GetNode () {
+	return data->node;
+}
+
+inline HT_INDEX_TYPE HashTableSegment :: FullSlotOfTuple (HT_INDEX_TYPE curSlot, int done, HT_INDEX_TYPE homeSlot) {
+
+	// tuples in a segment of the largest size do not need the extra entry
+	if (done || data->slotBits == NUM_SLOTS_IN_SEGMENT_BITS)
+		return FullSlot (homeSlot);
+
+	// the SLOT_HASH entry is the last one of the tuple
+	while (1) {
+		int dist = data->myData[curSlot].GetDisttoNextEntry (curSlot, data->bigOffsets);
+		if (dist == 0)
+			break;
+		curSlot += dist;
+	}
+
+	if (data->myData[curSlot].GetAttributeID () != SLOT_HASH)
+		return FullSlot (homeSlot);
+
+	HT_INDEX_TYPE fullSlot;
+	data->myData[curSlot].Extract (&fullSlot);
+	return fullSlot;
+}
+
+inline HashEntry HashTableSegment :: SlotEntry (HT_INDEX_TYPE fullSlot) {
+	HashEntry entry;
+	entry.EmptyOut ();
+	entry.PutIn (&fullSlot);
+	entry.SetContinuation ();
+	entry.SetAttributeID (SLOT_HASH);
+	return entry;
+}
+
+inline void HashTableSegment :: PutEntry (HashEntry &entry, HT_INDEX_TYPE &whichSlot) {
+
+	// try to find some space to add this thing... this involved hopping along the hash chains
+	unsigned int counter = 0;
+	while (whichSlot < data->hardCap && data->myData[whichSlot].IsUsed ()) {
+		int dist = data->myData[whichSlot].GetDisttoNextEntry (whichSlot, data->bigOffsets);
+		if (dist == 0)
+			dist = 1;
+		whichSlot += dist;
+		counter += dist;
+	}
+
+	// see if we went too far; we devote 10 bits to pointers, so we can go 1028 slots to find space in the hash table
+	if (whichSlot >= data->hardCap) {
+		FATAL ("I ran off the end of the hash table segment when I tried to add data.\nYou are probably trying to insert too much data with the same hash key");
+	}
+
+	// got an empty space, so add the new data
+	data->myData[whichSlot] = entry;
+
+	// if this is the first entry, then set up the back pointer
+	if (data->myData[whichSlot].IsStartOfTuple ())
+		data->myData[whichSlot].SetDistFromCorrectPos (counter, whichSlot, data->bigOffsets);
+
+	// if it is not, then set up the earlier one's forward pointer
+	else {
+		data->myData[whichSlot - counter].SetDistToNextEntry (counter, whichSlot - counter, data->bigOffsets);
+	}
+}
+
 // this version of insert does not do the sampleing, and it returns the last slot in the segment that it wrote to
 inline void HashTableSegment :: Insert (SerializedSegmentArray &segments) {
 
 	for (int posInHashes = 0, posInArray = 0; posInHashes < segments.lastUsedHash; posInHashes++) {
 
 		// first thing is to compute the slot we need to go to
-		HT_INDEX_TYPE whichSlot = segments.allHashes[posInHashes];
+		HT_INDEX_TYPE whichSlot = HomeSlot (segments.allHashes[posInHashes]);
 
 		// tell the loop that are at the start of a tuple
 		int startOfTuple = 1;
@@ -209,32 +453,13 @@ inline void HashTableSegment :: Insert (SerializedSegmentArray &segments) {
 			// mark that we are no longer at the start of the current tuple
 			startOfTuple = 0;
 
-			// try to find some space to add this thing... this involved hopping along the hash chains
-			unsigned int counter = 0;
-			while (whichSlot < ABSOLUTE_HARD_CAP && data->myData[whichSlot].IsUsed ()) {
-				int dist = data->myData[whichSlot].GetDisttoNextEntry (whichSlot, data->bigOffsets);
-				if (dist == 0)
-					dist = 1;
-				whichSlot += dist;
-				counter += dist;
-			}
-
-			// see if we went too far
-			if (whichSlot >= ABSOLUTE_HARD_CAP) {
-				FATAL ("I ran off the end of the hash table segment when I tried to add data.\n");
-			}
-
-			// got an empty space, so add the new data
-			data->myData[whichSlot] = segments.myData[posInArray];
-
-			// if this is the first entry, then set up the back pointer
-			if (data->myData[whichSlot].IsStartOfTuple ())
-				data->myData[whichSlot].SetDistFromCorrectPos (counter, whichSlot, data->bigOffsets);
+			PutEntry (segments.myData[posInArray], whichSlot);
+		}
 
-			// if it is not, then set up the earlier one's forward pointer
-			else {
-				data->myData[whichSlot - counter].SetDistToNextEntry (counter, whichSlot - counter, data->bigOffsets);
-			}
+		// a segment smaller than the largest size keeps the full slot at the end of the tuple
+		if (data->slotBits < NUM_SLOTS_IN_SEGMENT_BITS) {
+			HashEntry slotEntry = SlotEntry (segments.allHashes[posInHashes]);
+			PutEntry (slotEntry, whichSlot);
 		}
 	}
 }
@@ -0,0 +1,81 @@
+//
+//  Copyright 2012 Alin Dobra and Christopher Jermaine
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+
+#ifndef JOIN_FILTER_REGISTRY_H
+#define JOIN_FILTER_REGISTRY_H
+
+#include "BloomFilter.h"
+#include "QueryID.h"
+
+#include <pthread.h>
+#include <map>
+#include <string>
+
+// this is where the RHS of a join publishes the Bloom filter over its keys so that the
+// selections feeding the LHS can drop tuples that cannot possibly match before they are
+// ever shipped to the join.  Filters are found by the name of the join waypoint.
+//
+// A filter is filled while the RHS is hashed, but it may only be used for a query once
+// the whole RHS of that query is in it; the join waypoint marks queries ready as their
+// RHS finishes.  There is one filter per join (not per query class): every query class
+// hashes the same keys, so the union of their keys only lets a few more tuples through
+class JoinFilterRegistry {
+
+	struct FilterInfo {
+		BloomFilter filter;
+
+		// queries whose RHS has been completely inserted in the filter
+		QueryIDSet ready;
+
+		// set once the join can no longer promise a complete RHS (e.g. it is dying)
+		bool disabled;
+
+		FilterInfo () : disabled (false) {}
+	};
+
+	std::map<std::string, FilterInfo *> filters;
+
+	// protects the map and the ready sets
+	pthread_mutex_t myMutex;
+
+	JoinFilterRegistry ();
+
+public:
+
+	// returns the single instance of the registry
+	static JoinFilterRegistry &GetRegistry ();
+
+	~JoinFilterRegistry ();
+
+	// filter that the RHS of join joinName inserts into; created on first use
+	BloomFilter &GetFilter (const std::string &joinName);
+
+	// the RHS of these queries is now fully in the filter of joinName
+	void MarkReady (const std::string &joinName, QueryIDSet queries);
+
+	// no query may use the filter of joinName from now on
+	void Disable (const std::string &joinName);
+
+	// empties the filter of joinName; only to be called when no query runs through the join
+	void Reset (const std::string &joinName);
+
+	// returns the filter of joinName if some of the given queries can use it, and NULL
+	// otherwise.  On return, queries holds only the queries that can use it
+	const BloomFilter *GetReady (const std::string &joinName, QueryIDSet &queries);
+};
+
+#endif
@@ -0,0 +1,70 @@
+//
+//  Copyright 2012 Alin Dobra and Christopher Jermaine
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+
+#ifndef KEY_MATCH_H
+#define KEY_MATCH_H
+
+#include "HashTableMacros.h"
+
+#include <cstddef>
+
+#if defined(__AVX2__) || defined(__SSE4_1__)
+#include <immintrin.h>
+#endif
+
+// these are used by the join probe to compare fixed-width keys without deserializing them.
+// A key of such a type is stored in the hash table as a single VAL_TYPE word whose low
+// sizeof (type) bytes hold the value; the remaining bytes are whatever was in the
+// serialization buffer, so both sides are compared under a mask.
+
+// number of words that the caller pads its key arrays to; arrays must also be aligned to
+// KEY_WORDS_BLOCK * sizeof (VAL_TYPE) bytes
+#define KEY_WORDS_BLOCK 4
+
+// the mask selecting the bytes of a word that hold a key of numBytes bytes
+constexpr VAL_TYPE KeyWordMask (size_t numBytes) {
+	return numBytes >= sizeof (VAL_TYPE) ? ~(VAL_TYPE) 0 : (((VAL_TYPE) 1 << (8 * numBytes)) - 1);
+}
+
+// true iff a and b agree on every bit selected by mask; numWords is a multiple of KEY_WORDS_BLOCK
+inline bool KeyWordsEqual (const VAL_TYPE *a, const VAL_TYPE *b, const VAL_TYPE *mask, int numWords) {
+#if defined(__AVX2__)
+	for (int i = 0; i < numWords; i += 4) {
+		__m256i diff = _mm256_xor_si256 (_mm256_load_si256 ((const __m256i *) (a + i)),
+			_mm256_load_si256 ((const __m256i *) (b + i)));
+		if (!_mm256_testz_si256 (diff, _mm256_load_si256 ((const __m256i *) (mask + i))))
+			return false;
+	}
+	return true;
+#elif defined(__SSE4_1__)
+	for (int i = 0; i < numWords; i += 2) {
+		__m128i diff = _mm_xor_si128 (_mm_load_si128 ((const __m128i *) (a + i)),
+			_mm_load_si128 ((const __m128i *) (b + i)));
+		if (!_mm_testz_si128 (diff, _mm_load_si128 ((const __m128i *) (mask + i))))
+			return false;
+	}
+	return true;
+#else
+	VAL_TYPE diff = 0;
+	for (int i = 0; i < numWords; i++) {
+		diff |= (a[i] ^ b[i]) & mask[i];
+	}
+	return diff == 0;
+#endif
+}
+
+#endif
@@ -18,18 +18,84 @@
 #define OVERFLOW_H
 
 #include "HashTableMacros.h"
-#include "EfficientIntToIntMap.h"
+#include "Errors.h"
+
+#include <atomic>
+#include <mutex>
+#include <vector>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
 
 // this class is a container for hash table offsets that take up too many bits to
 // be stored within the hash table itself.  In this case, they are stored externally
-// in an object of type Overflow
+// in an object of type Overflow.  There is one per hash table segment.
+//
+// The offsets live in an open-addressed table made of 64-byte lines holding eight
+// (key, distance) pairs each, so a lookup is almost always a single cache miss.  The
+// table is sized along with its segment (see Allocate) and doubles when it gets half
+// full.  Lookups never block; recording is serialized so that several writers can share
+// one segment.  A lookup may race with a table being doubled, so the old tables are
+// only freed when the segment goes away
 class Overflow {
 
-	EfficientIntToIntMap distancesToNext;
-	EfficientIntToIntMap distancesFromCorrect;
+	// a slot and the kind of distance make up the key; 0 marks an unused entry
+	struct Entry {
+		uint32_t key;
+		uint32_t val;
+	};
+
+	static constexpr int ENTRIES_PER_LINE = 8;
+
+	struct alignas(64) Line {
+		Entry entries[ENTRIES_PER_LINE];
+	};
+
+	struct Table {
+		Line *lines;
+		int lineBits; // there are 2^lineBits lines
+		HT_INDEX_TYPE numUsed;
+	};
+
+	std::atomic<Table *> table;
+
+	// tables that were outgrown; a reader may still be looking at one of them
+	std::vector<Table *> retired;
+
+	std::mutex writeLock;
+
+	enum { TO_NEXT = 0, FROM_CORRECT = 1 };
+
+	static uint32_t MakeKey (HT_INDEX_TYPE slot, int kind) {
+		return (uint32_t) ((slot << 1) | kind) + 1;
+	}
+
+	static HT_INDEX_TYPE FirstLine (const Table *t, uint32_t key) {
+		return (key * 0x9E3779B97F4A7C15ULL) >> (64 - t->lineBits);
+	}
+
+	static Table *NewTable (int lineBits);
+	static void FreeTable (Table *t);
+
+	// adds (or overwrites) a key in t; the caller holds writeLock
+	static void Put (Table *t, uint32_t key, uint32_t val);
+
+	inline void Record (HT_INDEX_TYPE slot, int kind, unsigned int distance);
+	inline unsigned int Find (HT_INDEX_TYPE slot, int kind);
+
+	// counts kept for the current thread, so a work function can report its own
+	static uint64_t &RecordCounter () { static thread_local uint64_t n = 0; return n; }
+	static uint64_t &LookupCounter () { static thread_local uint64_t n = 0; return n; }
 
 public:
 
+	Overflow () : table (nullptr) {}
+
+	~Overflow ();
+
+	// sizes the table for a segment with numSlots slots; must be called before first use
+	void Allocate (HT_INDEX_TYPE numSlots);
+
 	// this is used to record an offset distance from one hash entry to the next
 	// that is larger than 10 bits
 	inline void RecordDistanceToNext (HT_INDEX_TYPE slot, unsigned int distance);
@@ -44,23 +110,130 @@ public:
 
 	// access a stored backward offset
 	inline unsigned int GetDistanceFromCorrectPos (HT_INDEX_TYPE slot);
-	
+
+	// number of offsets the calling thread has recorded in / looked up from any Overflow
+	// so far; take the difference around a piece of work to see how often it took the slow path
+	static uint64_t NumRecorded () { return RecordCounter (); }
+	static uint64_t NumLookups () { return LookupCounter (); }
 };
 
+inline Overflow :: ~Overflow () {
+	FreeTable (table.load ());
+	for (Table *t : retired) {
+		FreeTable (t);
+	}
+}
+
+inline Overflow :: Table *Overflow :: NewTable (int lineBits) {
+	Table *t = new Table;
+	t->lineBits = lineBits;
+	t->numUsed = 0;
+
+	size_t numBytes = sizeof (Line) << lineBits;
+	if (posix_memalign ((void **) &(t->lines), sizeof (Line), numBytes))
+		FATAL ("Could not allocate %lu bytes for the hash overflow table\n", numBytes);
+	memset (t->lines, 0, numBytes);
+	return t;
+}
+
+inline void Overflow :: FreeTable (Table *t) {
+	if (t != nullptr) {
+		free (t->lines);
+		delete t;
+	}
+}
+
+inline void Overflow :: Allocate (HT_INDEX_TYPE numSlots) {
+	FATALIF (((numSlots << 1) + 1) >> 32, "Hash segment too large for the overflow table keys\n");
+
+	// start with one entry per 2^OVERFLOW_SLOTS_FRACTION_BITS slots, but at least two lines
+	HT_INDEX_TYPE numLines = (numSlots >> OVERFLOW_SLOTS_FRACTION_BITS) / ENTRIES_PER_LINE;
+	int lineBits = 1;
+	while ((1ULL << lineBits) < numLines)
+		lineBits++;
+
+	FreeTable (table.exchange (NewTable (lineBits)));
+}
+
+inline void Overflow :: Put (Table *t, uint32_t key, uint32_t val) {
+	HT_INDEX_TYPE mask = (1ULL << t->lineBits) - 1;
+	for (HT_INDEX_TYPE line = FirstLine (t, key); ; line = (line + 1) & mask) {
+		Entry *entries = t->lines[line].entries;
+		for (int i = 0; i < ENTRIES_PER_LINE; i++) {
+			uint32_t cur = __atomic_load_n (&entries[i].key, __ATOMIC_RELAXED);
+			if (cur == key) {
+				__atomic_store_n (&entries[i].val, val, __ATOMIC_RELAXED);
+				return;
+			}
+			if (cur == 0) {
+				// the value has to be there before a reader can find the key
+				__atomic_store_n (&entries[i].val, val, __ATOMIC_RELAXED);
+				__atomic_store_n (&entries[i].key, key, __ATOMIC_RELEASE);
+				t->numUsed++;
+				return;
+			}
+		}
+	}
+}
+
+inline void Overflow :: Record (HT_INDEX_TYPE slot, int kind, unsigned int distance) {
+	std::lock_guard<std::mutex> guard (writeLock);
+	RecordCounter ()++;
+
+	Table *t = table.load (std::memory_order_relaxed);
+	FATALIF (t == nullptr, "Overflow table used before it was allocated\n");
+
+	// keep the table at most half full so chains stay within a line or two
+	HT_INDEX_TYPE capacity = (HT_INDEX_TYPE) ENTRIES_PER_LINE << t->lineBits;
+	if (2 * (t->numUsed + 1) > capacity) {
+		Table *bigger = NewTable (t->lineBits + 1);
+		for (HT_INDEX_TYPE line = 0; line < (1ULL << t->lineBits); line++) {
+			for (int i = 0; i < ENTRIES_PER_LINE; i++) {
+				Entry &e = t->lines[line].entries[i];
+				if (e.key != 0)
+					Put (bigger, e.key, e.val);
+			}
+		}
+		table.store (bigger, std::memory_order_release);
+		retired.push_back (t);
+		t = bigger;
+	}
+
+	Put (t, MakeKey (slot, kind), distance);
+}
+
+inline unsigned int Overflow :: Find (HT_INDEX_TYPE slot, int kind) {
+	LookupCounter ()++;
+
+	Table *t = table.load (std::memory_order_acquire);
+	uint32_t key = MakeKey (slot, kind);
+	HT_INDEX_TYPE mask = (1ULL << t->lineBits) - 1;
+	for (HT_INDEX_TYPE line = FirstLine (t, key); ; line = (line + 1) & mask) {
+		Entry *entries = t->lines[line].entries;
+		for (int i = 0; i < ENTRIES_PER_LINE; i++) {
+			uint32_t cur = __atomic_load_n (&entries[i].key, __ATOMIC_ACQUIRE);
+			if (cur == key)
+				return __atomic_load_n (&entries[i].val, __ATOMIC_RELAXED);
+			if (cur == 0)
+				FATAL ("You asked me to search for a key that was not there!\n");
+		}
+	}
+}
+
 inline void Overflow :: RecordDistanceToNext (HT_INDEX_TYPE slot, unsigned int distance) {
-        distancesToNext.Insert (slot, distance);
-}       
+	Record (slot, TO_NEXT, distance);
+}
 
 inline void Overflow :: RecordDistanceFromCorrect (HT_INDEX_TYPE slot, unsigned int distance) {
-        distancesFromCorrect.Insert (slot, distance);
-}       
+	Record (slot, FROM_CORRECT, distance);
+}
 
 inline unsigned int Overflow :: GetDistanceToNext (HT_INDEX_TYPE slot) {
-        return distancesToNext.Find (slot); 
-}       
+	return Find (slot, TO_NEXT);
+}
 
 inline unsigned int Overflow :: GetDistanceFromCorrectPos (HT_INDEX_TYPE slot) {
-        return distancesFromCorrect.Find (slot); 
-}       
+	return Find (slot, FROM_CORRECT);
+}
 
 #endif
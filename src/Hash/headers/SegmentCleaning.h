@@ -0,0 +1,122 @@
+//
+//  Copyright 2012 Alin Dobra and Christopher Jermaine
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+#ifndef SEGMENT_CLEANING_H
+#define SEGMENT_CLEANING_H
+
+#include "HashTableMacros.h"
+#include "HashTableSegment.h"
+#include "Timer.h"
+
+#include <atomic>
+#include <memory>
+#include <sched.h>
+
+// this is the state shared by the cleaner workers and the writers while a hash table segment
+// is cleaned in ranges.  The home slots of the segment are split into numRanges ranges, and
+// each range is cleaned by one worker, independently of the others.
+//
+// A writer that has a tuple whose home slot is in a range that no worker has taken yet pins
+// the range and puts the tuple into the old segment; the worker that takes the range later
+// carries it over.  Every other tuple goes straight into newSegment, which both the writers
+// and the workers fill with HashTableSegment::InsertConcurrent
+struct SegmentCleaning {
+
+	enum { RANGE_PENDING = 0, RANGE_CLEANING = 1, RANGE_CLEAN = 2 };
+
+	// the version of the segment being built
+	HashTableSegment newSegment;
+
+	// log2 of the number of home slots of the segment being cleaned; the ranges split those
+	int slotBits;
+
+	// number of ranges, and the state and number of pinning writers of each one
+	int numRanges;
+	std::unique_ptr<std::atomic<int>[]> state;
+	std::unique_ptr<std::atomic<int>[]> pins;
+
+	// ranges that are not clean yet
+	std::atomic<int> rangesLeft;
+
+	// started when the segment was taken away from the exclusive writers
+	Timer clock;
+
+	SegmentCleaning (int numRangesIn, int slotBitsIn):
+		slotBits(slotBitsIn),
+		numRanges(numRangesIn),
+		state(new std::atomic<int>[numRangesIn]),
+		pins(new std::atomic<int>[numRangesIn]),
+		rangesLeft(numRangesIn)
+	{
+		for (int i = 0; i < numRanges; i++) {
+			state[i] = RANGE_PENDING;
+			pins[i] = 0;
+		}
+	}
+
+	// first home slot of the range; RangeStart (numRanges) is the end of the segment
+	HT_INDEX_TYPE RangeStart (int whichRange) {
+		return ((1ULL << slotBits) * whichRange + numRanges - 1) / numRanges;
+	}
+
+	// range that a home slot of the segment being cleaned belongs to
+	int WhichRange (HT_INDEX_TYPE slot) {
+		return (int) ((slot * numRanges) >> slotBits);
+	}
+
+	// called by a writer before it puts a tuple homed in whichRange into the old segment; if
+	// this returns false, a worker has taken the range and the tuple goes to newSegment instead
+	bool Pin (int whichRange) {
+		pins[whichRange]++;
+		if (state[whichRange] == RANGE_PENDING)
+			return true;
+
+		pins[whichRange]--;
+		return false;
+	}
+
+	void Unpin (int whichRange) {
+		pins[whichRange]--;
+	}
+
+	// called by a reader before it probes the tuples homed in whichRange; returns true, with the
+	// range pinned, if they are all in the old segment, or false once they are all in newSegment
+	// (if a worker is moving them, this waits until it is done)
+	bool PinForProbe (int whichRange) {
+		if (Pin (whichRange))
+			return true;
+
+		while (state[whichRange] != RANGE_CLEAN)
+			sched_yield ();
+		return false;
+	}
+
+	// called by the worker that cleans whichRange before it reads the old segment; waits for the
+	// writers that are still putting tuples of the range into the old segment
+	void StartRange (int whichRange) {
+		state[whichRange] = RANGE_CLEANING;
+		while (pins[whichRange] != 0)
+			sched_yield ();
+	}
+
+	// returns true for the worker that finishes the last range
+	bool FinishRange (int whichRange) {
+		state[whichRange] = RANGE_CLEAN;
+		return --rangesLeft == 0;
+	}
+};
+
+#endif
@@ -36,6 +36,10 @@ class SerializedSegmentArray {
     int arrayLenHashes;
     int lastUsedHash;
 
+    // with compact hash entries, this is set when the last entry holds a single narrow
+    // attribute in its low half, so the next narrow attribute can go in its high half
+    bool lastHalfFree;
+
     void DoubleHashArray ();
     void DoubleEntryArray ();
 
@@ -47,24 +51,43 @@ class SerializedSegmentArray {
     SerializedSegmentArray ();
     ~SerializedSegmentArray ();
 
-    // this function is called when you want to start inserting a new tuple into the list
+    // this function is called when you want to start inserting a new tuple into the list;
+    // fingerprint is HASH_FINGERPRINT of the tuple's hash, or 0 if it is not known
     inline void StartNew (HT_INDEX_TYPE hashValue, unsigned int wayPointID, int RHS,
-            void *bitmapBytesToWrite, int howManyBytes);
+            void *bitmapBytesToWrite, int howManyBytes, int fingerprint);
 
-    // this function is called when you want to add more data to a record you've started
+    // this function is called when you want to add more data to a record you've started.  With
+    // compact hash entries, two consecutive attributes of at most half a VAL_TYPE share an entry
     inline void Append (unsigned int columnID, void *bytesToWrite, int howManyBytes);
 
     // forgets the data in the array
     inline void EmptyOut ();
 
+    // reorders the tuples so that the ones going to the same cache-sized region of the
+    // segment (see WHICH_RADIX_PARTITION) are next to each other; inserting them afterwards
+    // sweeps the segment once instead of jumping all over it
+    void RadixPartition ();
+
 };
 
 inline void SerializedSegmentArray :: EmptyOut () {
     lastUsedSeg = lastUsedHash = 0;
+    lastHalfFree = false;
 }
 
 inline void SerializedSegmentArray :: Append (unsigned int columnID, void *bytesToWrite, int howManyBytes) {
 
+#ifdef COMPACT_HASH_ENTRY
+    // a narrow attribute goes into the free half of the last entry if there is one
+    int isNarrow = howManyBytes > 0 && howManyBytes <= (int) sizeof (VAL_TYPE) / 2;
+    if (isNarrow && lastHalfFree) {
+        myData[lastUsedSeg - 1].PackSecond (columnID, bytesToWrite);
+        lastHalfFree = false;
+        return;
+    }
+    lastHalfFree = isNarrow;
+#endif
+
     // loop through and add all of the bytes in
     for (int bytesWritten = 0; bytesWritten < howManyBytes; bytesWritten += sizeof (VAL_TYPE), lastUsedSeg++) {
 
@@ -73,6 +96,7 @@ inline void SerializedSegmentArray :: Append (unsigned int columnID, void *bytes
             DoubleEntryArray ();
 
         // add the actual data
+        myData[lastUsedSeg].EmptyOut ();
         myData[lastUsedSeg].PutIn ((char*)bytesToWrite + bytesWritten);
 
         // put in the meta-data
@@ -83,13 +107,14 @@ inline void SerializedSegmentArray :: Append (unsigned int columnID, void *bytes
 }
 
 inline void SerializedSegmentArray :: StartNew (HT_INDEX_TYPE hashValue, unsigned int wayPointID, int RHS,
-        void *bitmapBytesToWrite, int howManyBytes) {
+        void *bitmapBytesToWrite, int howManyBytes, int fingerprint) {
 
     // remember the hash value
     if (lastUsedHash == arrayLenHashes)
         DoubleHashArray ();
     allHashes[lastUsedHash] = hashValue;
     lastUsedHash++;
+    lastHalfFree = false;
 
     // loop through and add all of the bytes in
     for (int bytesWritten = 0; bytesWritten < howManyBytes; bytesWritten += sizeof (VAL_TYPE), lastUsedSeg++) {
@@ -99,6 +124,7 @@ inline void SerializedSegmentArray :: StartNew (HT_INDEX_TYPE hashValue, unsigne
             DoubleEntryArray ();
 
         // add the actual data
+        myData[lastUsedSeg].EmptyOut ();
         myData[lastUsedSeg].PutIn ((char*)bitmapBytesToWrite + bytesWritten);
 
         // put in the meta-data
@@ -109,6 +135,7 @@ inline void SerializedSegmentArray :: StartNew (HT_INDEX_TYPE hashValue, unsigne
             else
                 myData[lastUsedSeg].SetLHS ();
             myData[lastUsedSeg].SetWayPointID (wayPointID);
+            myData[lastUsedSeg].SetFingerprint (fingerprint);
         } else {
             myData[lastUsedSeg].SetContinuation ();
             myData[lastUsedSeg].SetAttributeID (BITMAP);
@@ -18,12 +18,15 @@
 #include "Errors.h"
 
 #include <iostream>
+#include <algorithm>
 
 void HashTable :: EnterReader (HashTableView &myView) {
 
 	FATALIF (!IsAllocated (), "Can't do an op on an un-initialized hash table!");
 
-	// clone the current hash table
+	// clone the current hash table; a segment that is being cleaned in ranges keeps the new
+	// version with it, and the probes go to the version that has their tuples (see
+	// HashTableSegment::StartProbe)
 	pthread_mutex_lock (myMutex);
 	HashTableView temp (*currentTable);
 	pthread_mutex_unlock (myMutex);
@@ -48,6 +51,21 @@ int HashTable :: CheckOverFull (int *segList, double max_fill_rate) {
 	return count;
 }
 
+// moves the segments that live on the NUMA node we are running on to the front of the list, so
+// that writers fill the segments of their own node first; returns how many of them there are
+static int LocalSegmentsFirst (int *goodOnes, int numWanted) {
+
+	int myNode = numaCurrentNode ();
+	int numLocal = 0;
+	for (int i = 0; i < numWanted; i++) {
+		if (SEGMENT_NODE (goodOnes[i]) == myNode) {
+			std::swap (goodOnes[i], goodOnes[numLocal]);
+			numLocal++;
+		}
+	}
+	return numLocal;
+}
+
 int HashTable :: CheckOutOne (int *theseAreOK, HashTableSegment &checkMeOut) {
 
 	FATALIF (!IsAllocated (), "Can't do an op on an un-initialized hash table!");
@@ -62,15 +80,18 @@ int HashTable :: CheckOutOne (int *theseAreOK, HashTableSegment &checkMeOut) {
 		}
 	}
 
+	int numLocal = LocalSegmentsFirst (goodOnes, numWanted);
+
 	// now, try them one-at-a-time, in random order
 	pthread_mutex_lock (myMutex);
+	int waiting = 0;
 	while (1) {
 
-		// try each of the desired hash table segments, in random order
+		// try each of the desired hash table segments, in random order, the local ones first
 		for (int i = 0; i < numWanted; i++) {
 		
 			// randomly pick one of the guys in the list
-			int rangeSize = numWanted - i;
+			int rangeSize = (i < numLocal ? numLocal : numWanted) - i;
 			int whichIndex = i + (lrand48() % rangeSize);
 
 			// move him into the current slot
@@ -79,17 +100,33 @@ int HashTable :: CheckOutOne (int *theseAreOK, HashTableSegment &checkMeOut) {
 			goodOnes[i] = whichToChoose;
 
 			// try him
-			if (!writeLocked[whichToChoose]) {
+			if (!writeLocked[whichToChoose] && !sharedWriters[whichToChoose] && !cleaning[whichToChoose]) {
 
 				// he is open, so write lock him
 				writeLocked[whichToChoose] = 1;
 
+				// we are no longer in line for the others
+				if (waiting) {
+					for (int j = 0; j < numWanted; j++) {
+						exclusiveWaiting[goodOnes[j]]--;
+					}
+					pthread_cond_broadcast (signalWriters);
+				}
+
 				// and return him
 				currentTable->CloneOne (whichToChoose, checkMeOut);
 				pthread_mutex_unlock (myMutex);
 				return whichToChoose;
 			}
 		}			
+
+		// get in line, so that shared writers drain out of the segments we want
+		if (!waiting) {
+			for (int j = 0; j < numWanted; j++) {
+				exclusiveWaiting[goodOnes[j]]++;
+			}
+			waiting = 1;
+		}
 			
 		// if we got here, then every one that we want is write locked.  So
 		// we will go to sleep until one of them is unlocked, at which point
@@ -98,6 +135,99 @@ int HashTable :: CheckOutOne (int *theseAreOK, HashTableSegment &checkMeOut) {
 	}
 }
 
+int HashTable :: CheckOutShared (int *theseAreOK, HashTableSegment &checkMeOut) {
+
+	FATALIF (!IsAllocated (), "Can't do an op on an un-initialized hash table!");
+
+	int numWanted = 0;
+	int goodOnes[NUM_SEGS];
+	for (int i = 0; i < NUM_SEGS; i++) {
+		if (theseAreOK[i] == 1) {
+			goodOnes[numWanted] = i;
+			numWanted++;
+		}
+	}
+
+	int numLocal = LocalSegmentsFirst (goodOnes, numWanted);
+
+	pthread_mutex_lock (myMutex);
+	while (1) {
+
+		// stay away from the segments that an exclusive writer is held up on, unless they are
+		// being cleaned in ranges; then the exclusive writer has to wait for the cleaning anyway
+		for (int i = 0; i < numWanted; i++) {
+
+			int rangeSize = (i < numLocal ? numLocal : numWanted) - i;
+			int whichIndex = i + (lrand48() % rangeSize);
+
+			int whichToChoose = goodOnes[whichIndex];
+			goodOnes[whichIndex] = goodOnes[i];
+			goodOnes[i] = whichToChoose;
+
+			if (!writeLocked[whichToChoose] && (cleaning[whichToChoose] == 2 || !exclusiveWaiting[whichToChoose])) {
+				sharedWriters[whichToChoose]++;
+				currentTable->CloneOne (whichToChoose, checkMeOut);
+				pthread_mutex_unlock (myMutex);
+				return whichToChoose;
+			}
+		}
+
+		// every segment we want is either held or about to be held exclusively
+		pthread_cond_wait (signalWriters, myMutex);
+	}
+}
+
+void HashTable :: CheckInShared (int whichEntry) {
+
+	FATALIF (!IsAllocated (), "Can't do an op on an un-initialized hash table!");
+
+	// the last shared writer out lets the exclusive writers in
+	pthread_mutex_lock (myMutex);
+	FATALIF (sharedWriters[whichEntry] <= 0, "Checking in a segment that was not checked out shared!");
+	sharedWriters[whichEntry]--;
+	if (sharedWriters[whichEntry] == 0)
+		pthread_cond_broadcast (signalWriters);
+	pthread_mutex_unlock (myMutex);
+}
+
+void HashTable :: CheckOutForCleaning (int whichSegment, int numRanges, HashTableSegment &checkMeOut) {
+
+	FATALIF (!IsAllocated (), "Can't do an op on an un-initialized hash table!");
+
+	pthread_mutex_lock (myMutex);
+
+	// someone else is setting the cleaning up, or has already done it
+	if (cleaning[whichSegment]) {
+		while (cleaning[whichSegment] == 1)
+			pthread_cond_wait (signalWriters, myMutex);
+
+		currentTable->CloneOne (whichSegment, checkMeOut);
+		pthread_mutex_unlock (myMutex);
+		return;
+	}
+
+	// get in line like CheckOutOne does, so that the writers drain out
+	exclusiveWaiting[whichSegment]++;
+	while (writeLocked[whichSegment] || sharedWriters[whichSegment])
+		pthread_cond_wait (signalWriters, myMutex);
+	exclusiveWaiting[whichSegment]--;
+
+	writeLocked[whichSegment] = 1;
+	cleaning[whichSegment] = 1;
+	currentTable->CloneOne (whichSegment, checkMeOut);
+	pthread_mutex_unlock (myMutex);
+
+	// allocating and zeroing the new version takes a while, so it is done outside of the lock
+	checkMeOut.StartCleaning (numRanges, RebuildBits (checkMeOut));
+
+	// and now the shared writers can come back in
+	pthread_mutex_lock (myMutex);
+	writeLocked[whichSegment] = 0;
+	cleaning[whichSegment] = 2;
+	pthread_cond_broadcast (signalWriters);
+	pthread_mutex_unlock (myMutex);
+}
+
 void HashTable :: CheckIn (int whichEntry) {
 
 	FATALIF (!IsAllocated (), "Can't do an op on an un-initialized hash table!");
@@ -117,11 +247,61 @@ void HashTable :: Replace (int whichEntry, HashTableSegment &replaceWithMe) {
 	// add the new one in, then signal all potential writers
 	pthread_mutex_lock (myMutex);
 	writeLocked[whichEntry] = 0;
+	cleaning[whichEntry] = 0;
 	currentTable->Replace (whichEntry, replaceWithMe);
 	pthread_cond_broadcast (signalWriters);
 	pthread_mutex_unlock (myMutex);
 }
 
+int HashTable :: BitsFor (int64_t numEntries) {
+
+	int slotBits = MIN_SLOTS_IN_SEGMENT_BITS;
+	while (slotBits < NUM_SLOTS_IN_SEGMENT_BITS &&
+			numEntries > (int64_t) (NUM_SEGS * (1ULL << slotBits) * ESTIMATE_FILL_RATE)) {
+		slotBits++;
+	}
+
+	return slotBits;
+}
+
+void HashTable :: SizeFor (int64_t numEntries) {
+
+	FATALIF (!IsAllocated (), "Can't do an op on an un-initialized hash table!");
+
+	int slotBits = BitsFor (numEntries);
+	pthread_mutex_lock (myMutex);
+	if (slotBits > *targetBits)
+		*targetBits = slotBits;
+	pthread_mutex_unlock (myMutex);
+}
+
+int HashTable :: RebuildBits (HashTableSegment &checkMeOut) {
+
+	FATALIF (!IsAllocated (), "Can't do an op on an un-initialized hash table!");
+
+	pthread_mutex_lock (myMutex);
+	int slotBits = *targetBits;
+	pthread_mutex_unlock (myMutex);
+
+	// segments never shrink
+	return std::max (slotBits, checkMeOut.SlotBitsAfterCleaning ());
+}
+
+int HashTable :: CanGrow () {
+
+	FATALIF (!IsAllocated (), "Can't do an op on an un-initialized hash table!");
+
+	pthread_mutex_lock (myMutex);
+	int canGrow = 1;
+	for (currentTable->allSegments.MoveToStart (); currentTable->allSegments.RightLength (); currentTable->allSegments.Advance ()) {
+		if (currentTable->allSegments.Current ().GetSlotBits () >= NUM_SLOTS_IN_SEGMENT_BITS)
+			canGrow = 0;
+	}
+
+	pthread_mutex_unlock (myMutex);
+	return canGrow;
+}
+
 HashTable :: HashTable () {
 
 	myMutex = 0;
@@ -148,6 +328,10 @@ HashTable :: ~HashTable () {
 	delete signalWriters;
 	delete currentTable;
 	delete [] writeLocked;	
+	delete [] sharedWriters;
+	delete [] exclusiveWaiting;
+	delete [] cleaning;
+	delete targetBits;
 }
 
 // this structure stores all of the zero'ed out segments
@@ -155,10 +339,14 @@ struct WorkToDo {
 
 	pthread_mutex_t *myMutex;
 	int numToDo;
-	TwoWayList <HashTableSegment> allSegments;
+	int slotBits;
 
-	WorkToDo () {
+	// segment i is allocated on SEGMENT_NODE (i), so they are kept in order
+	HashTableSegment allSegments[NUM_SEGS];
+
+	WorkToDo (int slotBitsIn) {
 		numToDo = NUM_SEGS;
+		slotBits = slotBitsIn;
 		myMutex = new pthread_mutex_t;
 		pthread_mutex_init(myMutex, NULL);
 	}
@@ -175,9 +363,11 @@ void *DoSegments (void *arg) {
 	while (1) {
 
 		// first, see if there is any work to do
+		int whichSegment;
 		pthread_mutex_lock (myWork->myMutex);
 		if (myWork->numToDo > 0) {
 			myWork->numToDo--;
+			whichSegment = myWork->numToDo;
 		} else {
 			pthread_mutex_unlock (myWork->myMutex);
 			return NULL;
@@ -186,15 +376,13 @@ void *DoSegments (void *arg) {
 		// if we got here, there is work to do...
 		pthread_mutex_unlock (myWork->myMutex);
 
-		// create a new segment
+		// create a new segment; zeroing it out is what puts its pages on its node
 		HashTableSegment temp;
-		temp.Allocate ();
+		temp.Allocate (myWork->slotBits, SEGMENT_NODE (whichSegment));
 		temp.ZeroOut ();
 
-		// and add him in
-		pthread_mutex_lock (myWork->myMutex);
-		myWork->allSegments.Insert (temp);
-		pthread_mutex_unlock (myWork->myMutex);
+		// and add him in; no one else touches this entry
+		myWork->allSegments[whichSegment].swap (temp);
 	}
 }
 
@@ -235,7 +423,7 @@ void HashTable :: Clone (HashTable &copyMe) {
 	
 }
 
-void HashTable :: Allocate (int numThreads) {
+void HashTable :: Allocate (int numThreads, int slotBits) {
 
 	FATALIF (IsAllocated (), "Can't allocate the hash table twice!\n");
 
@@ -248,12 +436,20 @@ void HashTable :: Allocate (int numThreads) {
 	pthread_mutex_init (myMutex, NULL);
 	pthread_cond_init (signalWriters, NULL);
 	writeLocked = new int[NUM_SEGS];
+	sharedWriters = new int[NUM_SEGS];
+	exclusiveWaiting = new int[NUM_SEGS];
+	cleaning = new int[NUM_SEGS];
+	targetBits = new int;
+	*targetBits = slotBits;
 	for (int i = 0; i < NUM_SEGS; i++) {
 		writeLocked[i] = 0;
+		sharedWriters[i] = 0;
+		exclusiveWaiting[i] = 0;
+		cleaning[i] = 0;
 	}
 
 	// this struct will mark the progress of the allocating/zeroing
-	WorkToDo temp;
+	WorkToDo temp (slotBits);
 
 	// create a number of threads to do the work
 	pthread_t threads[numThreads - 1];
@@ -270,5 +466,9 @@ void HashTable :: Allocate (int numThreads) {
 	}
 
 	// and set up the actual hash table!
-	currentTable->AddStorage (temp.allSegments);
+	TwoWayList <HashTableSegment> allSegments;
+	for (int i = 0; i < NUM_SEGS; i++) {
+		allSegments.Append (temp.allSegments[i]);
+	}
+	currentTable->AddStorage (allSegments);
 }
@@ -15,6 +15,7 @@
 //
 
 #include "HashTableSegment.h"
+#include "SegmentCleaning.h"
 #include <string.h>
 #include <pthread.h>
 #include "MmapAllocator.h"
@@ -62,8 +63,14 @@ int HashTableSegment :: CheckOverFull (double max_fill_rate) {
   return (data->fillRate >= max_fill_rate);
 }
 
-// this version of insert does not do the sampleing, and it returns the last slot in the segment that it wrote to
-int HashTableSegment :: Insert (SerializedSegmentArray &segments, HashSegmentSample &sampledCollisions) {
+int HashTableSegment :: SlotBitsAfterCleaning () {
+	if (data->slotBits < NUM_SLOTS_IN_SEGMENT_BITS &&
+			(data->fillRate >= MAX_FILL_RATE || globalFillRate >= GROW_FILL_RATE))
+		return data->slotBits + 1;
+	return data->slotBits;
+}
+
+int HashTableSegment :: SampleCollisions (HashSegmentSample &sampledCollisions) {
 
 	// in the future, we might want to and the case where the bitstring spans multiple hash entries
 	FATALIF (sizeof (Bitstring) > sizeof (VAL_TYPE), "Oops! Sampling to check for overfull assumes the bitstring fits in one hash entry!\n");
@@ -76,7 +83,7 @@ int HashTableSegment :: Insert (SerializedSegmentArray &segments, HashSegmentSam
 
 		// first thing is to get the slot we need to go to
 		HT_INDEX_TYPE whichSlot = data->randomProbeSlots[probeNum];
-		FATALIF(whichSlot >= ABSOLUTE_HARD_CAP,
+		FATALIF(whichSlot >= data->hardCap,
 			"Slot to probe for probe number %d is past end of data slots", probeNum);
 
 		if (data->myData[whichSlot].IsUsed ()) {
@@ -96,10 +103,28 @@ int HashTableSegment :: Insert (SerializedSegmentArray &segments, HashSegmentSam
 		}
 	}
 
+	return numCollisions;
+}
+
+int HashTableSegment :: UpdateFillRate (int numCollisions) {
+
+	data->fillRate = 1.0*numCollisions/NUM_TEST_PROBES;
+
+	updateGlobalFillRate(data->fillRate);
+
+	return CheckOverFull();
+}
+
+// this version of insert does the sampling, and it reports whether the segment is over-full
+int HashTableSegment :: Insert (SerializedSegmentArray &segments, HashSegmentSample &sampledCollisions) {
+
+	// first thing we do is probe to see if there are too many over-full entries
+	int numCollisions = SampleCollisions (sampledCollisions);
+
 	for (int posInHashes = 0, posInArray = 0; posInHashes < segments.lastUsedHash; posInHashes++) {
 
 		// first thing is to compute the slot we need to go to
-		HT_INDEX_TYPE whichSlot = segments.allHashes[posInHashes];
+		HT_INDEX_TYPE whichSlot = HomeSlot (segments.allHashes[posInHashes]);
 
 		// tell the loop that are at the start of a tuple
 		int startOfTuple = 1;
@@ -110,44 +135,145 @@ int HashTableSegment :: Insert (SerializedSegmentArray &segments, HashSegmentSam
 			// mark that we are no longer at the start of the current tuple
 			startOfTuple = 0;
 
-			// try to find some space to add this thing... this involved hopping along the hash chains
-			unsigned int counter = 0;
-			while (whichSlot < ABSOLUTE_HARD_CAP && data->myData[whichSlot].IsUsed ()) {
-				int dist = data->myData[whichSlot].GetDisttoNextEntry (whichSlot, data->bigOffsets);
-				if (dist == 0)
-					dist = 1;
-				whichSlot += dist;
-				counter += dist;
-			}
-
-			// see if we went too far; we devote 10 bits to pointers, so we can go 1028 slots to find space in the hash table
-			if (whichSlot >= ABSOLUTE_HARD_CAP) {
-                printf("whichSlot=%d\ncounter=%d\n", whichSlot,counter);
-                std::cerr << "(" << data->fillRate << ") (" << numCollisions << ", " << NUM_TEST_PROBES * MAX_FILL_RATE << ")\n";
-                FATAL ("I ran off the end of the hash table segment when I tried to add data.\nYou are probably trying to insert too much data with the same hash key");
-			}
-
-			// got an empty space, so add the new data
-			data->myData[whichSlot] = segments.myData[posInArray];
-
-			// if this is the first entry, then set up the back pointer
-			if (data->myData[whichSlot].IsStartOfTuple ())
-				data->myData[whichSlot].SetDistFromCorrectPos (counter, whichSlot, data->bigOffsets);
-
-			// if it is not, then set up the earlier one's forward pointer
-			else {
-				data->myData[whichSlot - counter].SetDistToNextEntry (counter, whichSlot - counter, data->bigOffsets);
-			}
+			PutEntry (segments.myData[posInArray], whichSlot);
 		}
 
+		// a segment smaller than the largest size keeps the full slot at the end of the tuple
+		if (data->slotBits < NUM_SLOTS_IN_SEGMENT_BITS) {
+			HashEntry slotEntry = SlotEntry (segments.allHashes[posInHashes]);
+			PutEntry (slotEntry, whichSlot);
+		}
 	}
 
 	// finally, let the caller know if we get too many collisions
-	data->fillRate = 1.0*numCollisions/NUM_TEST_PROBES;
+	return UpdateFillRate (numCollisions);
+}
 
-	updateGlobalFillRate(data->fillRate);
+void HashTableSegment :: ClaimEntry (HashEntry &toWrite, HT_INDEX_TYPE &whichSlot, HT_INDEX_TYPE &prevSlot) {
 
-	return CheckOverFull();
+	// hop along the hash chains until we manage to claim an empty slot
+	unsigned int counter = 0;
+	while (whichSlot < data->hardCap) {
+		if (!data->myData[whichSlot].IsUsed () && data->myData[whichSlot].TryClaim ())
+			break;
+
+		int dist = data->myData[whichSlot].GetDisttoNextEntry (whichSlot, data->bigOffsets);
+		if (dist == 0)
+			dist = 1;
+		whichSlot += dist;
+		counter += dist;
+	}
+
+	if (whichSlot >= data->hardCap) {
+		FATAL ("I ran off the end of the hash table segment when I tried to add data.\nYou are probably trying to insert too much data with the same hash key");
+	}
+
+	// the slot is ours; fill it in and only then make it visible
+	if (toWrite.IsStartOfTuple ()) {
+		toWrite.SetDistFromCorrectPos (counter, whichSlot, data->bigOffsets);
+	} else {
+		HashEntry prev = data->myData[prevSlot];
+		prev.SetDistToNextEntry (counter, prevSlot, data->bigOffsets);
+		data->myData[prevSlot].Publish (prev);
+	}
+	data->myData[whichSlot].Publish (toWrite);
+
+	prevSlot = whichSlot;
+}
+
+int HashTableSegment :: ClaimAndInsert (SerializedSegmentArray &segments, HT_INDEX_TYPE fullSlot, int posInArray) {
+
+	// where the previous entry of the current tuple went; its forward pointer is set once
+	// the next entry is in place, so readers never follow a pointer to a half-written slot
+	HT_INDEX_TYPE whichSlot = HomeSlot (fullSlot);
+	HT_INDEX_TYPE prevSlot = whichSlot;
+	int startOfTuple = 1;
+
+	for (; posInArray < segments.lastUsedSeg && (startOfTuple || !segments.myData[posInArray].IsStartOfTuple ()); posInArray++) {
+
+		startOfTuple = 0;
+
+		HashEntry toWrite = segments.myData[posInArray];
+		ClaimEntry (toWrite, whichSlot, prevSlot);
+	}
+
+	// a segment smaller than the largest size keeps the full slot at the end of the tuple
+	if (data->slotBits < NUM_SLOTS_IN_SEGMENT_BITS) {
+		HashEntry slotEntry = SlotEntry (fullSlot);
+		ClaimEntry (slotEntry, whichSlot, prevSlot);
+	}
+
+	return posInArray;
+}
+
+int HashTableSegment :: InsertConcurrent (SerializedSegmentArray &segments, HashSegmentSample &sampledCollisions) {
+
+	// while the segment is cleaned in ranges, the new version is the one whose fullness matters
+	SegmentCleaning *cleaning = data->cleaning.get ();
+	HashTableSegment &sampled = (cleaning == nullptr ? *this : cleaning->newSegment);
+
+	// the sample may include slots that are concurrently being written; it is only an estimate anyway
+	int numCollisions = sampled.SampleCollisions (sampledCollisions);
+
+	for (int posInHashes = 0, posInArray = 0; posInHashes < segments.lastUsedHash; posInHashes++) {
+
+		HT_INDEX_TYPE fullSlot = segments.allHashes[posInHashes];
+
+		if (cleaning == nullptr) {
+			posInArray = ClaimAndInsert (segments, fullSlot, posInArray);
+			continue;
+		}
+
+		// the old segment only takes tuples of the ranges the cleaner has not got to yet
+		int whichRange = cleaning->WhichRange (HomeSlot (fullSlot));
+		if (cleaning->Pin (whichRange)) {
+			posInArray = ClaimAndInsert (segments, fullSlot, posInArray);
+			cleaning->Unpin (whichRange);
+		} else {
+			posInArray = cleaning->newSegment.ClaimAndInsert (segments, fullSlot, posInArray);
+		}
+	}
+
+	return sampled.UpdateFillRate (numCollisions);
+}
+
+void HashTableSegment :: InsertConcurrent (SerializedSegmentArray &segments) {
+
+	for (int posInHashes = 0, posInArray = 0; posInHashes < segments.lastUsedHash; posInHashes++) {
+		posInArray = ClaimAndInsert (segments, segments.allHashes[posInHashes], posInArray);
+	}
+}
+
+void HashTableSegment :: StartCleaning (int numRanges, int slotBits) {
+
+	FATALIF (!data, "Attempting to clean an unallocated HashTableSegment");
+	FATALIF (data->cleaning, "This HashTableSegment is already being cleaned");
+
+	std::shared_ptr<SegmentCleaning> cleaning = std::make_shared<SegmentCleaning> (numRanges, data->slotBits);
+	cleaning->newSegment.Allocate (slotBits, data->node);
+	cleaning->newSegment.ZeroOut ();
+
+	data->cleaning = cleaning;
+	data->probeCleaning.store (cleaning.get (), std::memory_order_release);
+}
+
+HashTableSegment &HashTableSegment :: StartProbeCleaning (SegmentCleaning *cleaning, HT_INDEX_TYPE fullSlot,
+		int &pinnedRange) {
+
+	int whichRange = cleaning->WhichRange (HomeSlot (fullSlot));
+	if (!cleaning->PinForProbe (whichRange))
+		return cleaning->newSegment;
+
+	pinnedRange = whichRange;
+	return *this;
+}
+
+void HashTableSegment :: EndProbeCleaning (int pinnedRange) {
+	data->probeCleaning.load (std::memory_order_relaxed)->Unpin (pinnedRange);
+}
+
+SegmentCleaning *HashTableSegment :: GetCleaning () {
+	return data->cleaning.get ();
 }
 
 HashTableSegment :: HashTableSegment (const HashTableSegment &cloneMe)
@@ -160,7 +286,7 @@ HashTableSegment :: HashTableSegment ():
 { }
 
 void HashTableSegment :: ZeroOut (HT_INDEX_TYPE low, HT_INDEX_TYPE high) {
-	for (HT_INDEX_TYPE i = low; i < ABSOLUTE_HARD_CAP && i < high; i++) {
+	for (HT_INDEX_TYPE i = low; i < data->hardCap && i < high; i++) {
 		data->myData[i].EmptyOut ();
 	}
 }
@@ -168,7 +294,7 @@ void HashTableSegment :: ZeroOut (HT_INDEX_TYPE low, HT_INDEX_TYPE high) {
 void HashTableSegment :: ZeroOut () {
     FATALIF(!data, "Attempting to zero out unallocated HashTableSegment");
 #ifdef SLOW_HASH_INIT
-	for (HT_INDEX_TYPE i = 0; i < ABSOLUTE_HARD_CAP; i++) {
+	for (HT_INDEX_TYPE i = 0; i < data->hardCap; i++) {
 		data->myData[i].EmptyOut ();
 	}
 #else
@@ -176,27 +302,35 @@ void HashTableSegment :: ZeroOut () {
 #endif
 }
 
-void HashTableSegment :: Allocate () {
+void HashTableSegment :: Allocate (int slotBits, int node) {
 
 	SharedData *nData = new SharedData;
 
 	// now we see how much storage we need
-	nData->numBytes = ABSOLUTE_HARD_CAP * sizeof(HashEntry);
+	slotBits = std::max (MIN_SLOTS_IN_SEGMENT_BITS, std::min (slotBits, NUM_SLOTS_IN_SEGMENT_BITS));
+	nData->slotBits = slotBits;
+	nData->numSlots = 1ULL << slotBits;
+	nData->hardCap = HARD_CAP_FOR (nData->numSlots);
+	nData->node = node;
+	nData->numBytes = nData->hardCap * sizeof(HashEntry);
 
 	// now, actually allocate the data
 	// if this table is small, we will not use big pages
 	if (nData->numBytes < 2097152 /* 2MB */) {
-		nData->myData = data_ptr_t(new HashEntry[ABSOLUTE_HARD_CAP], std::default_delete<HashEntry[]>());
+		nData->myData = data_ptr_t(new HashEntry[nData->hardCap], std::default_delete<HashEntry[]>());
 	} else {
 		//myData = (HashEntry *) SYS_MMAP_ALLOC (numBytes);
-		nData->myData = data_ptr_t((HashEntry *) mmap_alloc(nData->numBytes, 1),
+		nData->myData = data_ptr_t((HashEntry *) mmap_alloc(nData->numBytes, node),
 			[](HashEntry* ptr) { mmap_free(ptr); });
 		//FATALIF( !SYS_MMAP_CHECK((void*)myData), "Could not allocate %ld MB for segments of the large hash", numBytes >> 20);
 	}
 
+	// the side table for offsets that do not fit in an entry grows with the segment
+	nData->bigOffsets.Allocate (nData->hardCap);
+
 	nData->randomProbeSlots.reset(new HT_INDEX_TYPE[NUM_TEST_PROBES]);
 	for (size_t i = 0; i < NUM_TEST_PROBES; i++) {
-		nData->randomProbeSlots[i] = RandInt(0, NUM_SLOTS_IN_SEGMENT - 1);
+		nData->randomProbeSlots[i] = RandInt(0, nData->numSlots - 1);
 	}
 
 	data.reset(nData);
@@ -0,0 +1,105 @@
+//
+//  Copyright 2012 Alin Dobra and Christopher Jermaine
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+
+#include "JoinFilterRegistry.h"
+
+using namespace std;
+
+JoinFilterRegistry &JoinFilterRegistry::GetRegistry () {
+
+	// built by the first caller; the workers can get here at the same time, the
+	// initialization of a local static is thread safe
+	static JoinFilterRegistry registry;
+	return registry;
+}
+
+JoinFilterRegistry::JoinFilterRegistry () {
+	pthread_mutex_init (&myMutex, NULL);
+}
+
+JoinFilterRegistry::~JoinFilterRegistry () {
+	for (auto it = filters.begin (); it != filters.end (); it++) {
+		delete it->second;
+	}
+	pthread_mutex_destroy (&myMutex);
+}
+
+BloomFilter &JoinFilterRegistry::GetFilter (const string &joinName) {
+	pthread_mutex_lock (&myMutex);
+
+	FilterInfo *&info = filters[joinName];
+	if (info == NULL)
+		info = new FilterInfo;
+
+	pthread_mutex_unlock (&myMutex);
+	return info->filter;
+}
+
+void JoinFilterRegistry::MarkReady (const string &joinName, QueryIDSet queries) {
+	pthread_mutex_lock (&myMutex);
+
+	// a join whose RHS was empty never created its filter; nothing can match then,
+	// and an empty filter says exactly that
+	FilterInfo *&info = filters[joinName];
+	if (info == NULL)
+		info = new FilterInfo;
+
+	info->ready.Union (queries);
+
+	pthread_mutex_unlock (&myMutex);
+}
+
+void JoinFilterRegistry::Disable (const string &joinName) {
+	pthread_mutex_lock (&myMutex);
+
+	FilterInfo *&info = filters[joinName];
+	if (info == NULL)
+		info = new FilterInfo;
+
+	info->disabled = true;
+
+	pthread_mutex_unlock (&myMutex);
+}
+
+void JoinFilterRegistry::Reset (const string &joinName) {
+	pthread_mutex_lock (&myMutex);
+
+	auto it = filters.find (joinName);
+	if (it != filters.end () && !it->second->disabled) {
+		it->second->filter.Clear ();
+		it->second->ready = QueryIDSet ();
+	}
+
+	pthread_mutex_unlock (&myMutex);
+}
+
+const BloomFilter *JoinFilterRegistry::GetReady (const string &joinName, QueryIDSet &queries) {
+	const BloomFilter *result = NULL;
+	pthread_mutex_lock (&myMutex);
+
+	auto it = filters.find (joinName);
+	if (it != filters.end () && !it->second->disabled) {
+		queries.Intersect (it->second->ready);
+		if (!queries.IsEmpty ())
+			result = &it->second->filter;
+	} else {
+		queries = QueryIDSet ();
+	}
+
+	pthread_mutex_unlock (&myMutex);
+	return result;
+}
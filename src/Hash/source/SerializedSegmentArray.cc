@@ -17,9 +17,12 @@
 #include "SerializedSegmentArray.h"
 #include "MmapAllocator.h"
 
+#include <vector>
+
 SerializedSegmentArray :: SerializedSegmentArray () {
   arrayLenHashes = arrayLenSegs = MMAP_PAGE_SIZE/sizeof(HashEntry);
 	lastUsedHash = lastUsedSeg = 0;	
+	lastHalfFree = false;
 	allHashes = (HT_INDEX_TYPE *) mmap_alloc (sizeof (HT_INDEX_TYPE) * arrayLenHashes, 1);
 	myData = (HashEntry *) mmap_alloc (sizeof (HashEntry) * arrayLenSegs, 1);
 }
@@ -45,3 +48,46 @@ void SerializedSegmentArray :: DoubleEntryArray () {
 	arrayLenSegs *= 2;
 }
 
+
+void SerializedSegmentArray :: RadixPartition () {
+
+	if (lastUsedHash < 2)
+		return;
+
+	// find where each tuple starts; a tuple is its start entry and all continuations after it
+	std::vector<int> tupleStart (lastUsedHash + 1);
+	for (int tuple = 0, entry = 0; tuple < lastUsedHash; tuple++) {
+		tupleStart[tuple] = entry;
+		for (entry++; entry < lastUsedSeg && !myData[entry].IsStartOfTuple (); entry++);
+	}
+	tupleStart[lastUsedHash] = lastUsedSeg;
+
+	// count the tuples and entries of each partition, and turn the counts into offsets
+	std::vector<int> tuplePos (RADIX_NUM_PARTITIONS + 1, 0);
+	std::vector<int> entryPos (RADIX_NUM_PARTITIONS + 1, 0);
+	for (int tuple = 0; tuple < lastUsedHash; tuple++) {
+		int part = WHICH_RADIX_PARTITION (allHashes[tuple]);
+		tuplePos[part + 1]++;
+		entryPos[part + 1] += tupleStart[tuple + 1] - tupleStart[tuple];
+	}
+	for (int part = 1; part <= RADIX_NUM_PARTITIONS; part++) {
+		tuplePos[part] += tuplePos[part - 1];
+		entryPos[part] += entryPos[part - 1];
+	}
+
+	// and scatter the tuples into new arrays, keeping their order within a partition
+	HT_INDEX_TYPE *newHashes = (HT_INDEX_TYPE *) mmap_alloc (sizeof (HT_INDEX_TYPE) * arrayLenHashes, 1);
+	HashEntry *newData = (HashEntry *) mmap_alloc (sizeof (HashEntry) * arrayLenSegs, 1);
+	for (int tuple = 0; tuple < lastUsedHash; tuple++) {
+		int part = WHICH_RADIX_PARTITION (allHashes[tuple]);
+		int len = tupleStart[tuple + 1] - tupleStart[tuple];
+		newHashes[tuplePos[part]++] = allHashes[tuple];
+		memmove (newData + entryPos[part], myData + tupleStart[tuple], sizeof (HashEntry) * len);
+		entryPos[part] += len;
+	}
+
+	mmap_free (allHashes);
+	mmap_free (myData);
+	allHashes = newHashes;
+	myData = newData;
+}
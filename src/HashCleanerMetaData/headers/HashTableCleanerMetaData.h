@@ -121,6 +121,10 @@ protected:
 	// right away
 	void ProcessEmptyResult (int whichSegment, QueryExitContainer &theseAreDone);
 	
+	// notes that the segment returned by GetOneToRebuild is being cleaned in ranges, so that
+	// it is not handed out again; ProcessEmptyResult ends this
+	void IsCleaningInRanges (int whichSegment);
+
 	// sends a drop in
 	void GotDrop (WayPointID &whichOne, int whichSegment);
 
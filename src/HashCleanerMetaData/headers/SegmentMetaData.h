@@ -40,7 +40,10 @@ struct SegmentMetaData {
 	// this is the hash table segment that should actually be put into the hash table 
 	HashTableSegment oneToPutBack;
 
-	SegmentMetaData () {}
+	// one iff the segment is being cleaned in ranges
+	int cleaningInRanges;
+
+	SegmentMetaData () : cleaningInRanges (0) {}
 
 	~SegmentMetaData () {}
 
@@ -128,12 +128,17 @@ void HashTableCleanerManager :: ProcessEmptyResult (int whichSegment, QueryExitC
 
 	// put the newly-processed segment into the hash table
 	centralHashTable.Replace (whichSegment, allSegs[whichSegment].oneToPutBack);
+	allSegs[whichSegment].cleaningInRanges = 0;
 
 	// and see if some query is totally finished
 	SeeIfTotallyFinished (theseAreDone);
 
 }
 
+void HashTableCleanerManager :: IsCleaningInRanges (int whichSegment) {
+	allSegs[whichSegment].cleaningInRanges = 1;
+}
+
 void HashTableCleanerManager :: SeeIfTotallyFinished (QueryExitContainer &allDone) {
 
 	// see if any queries have totally finished
@@ -458,7 +463,8 @@ int HashTableCleanerManager :: GetOneToRebuild (JoinWayPointIDList &removeTheseW
 
 			// if we have received a cleaning request, and we are not currently cleaning
 			if (whichSegs[i] && (allSegs[i].deadBeingCleaned.RightLength () ||
-			    allSegs[i].woundedBeingCleaned.RightLength ())) {
+			    allSegs[i].woundedBeingCleaned.RightLength () ||
+			    allSegs[i].cleaningInRanges)) {
 				whichSegs[i] = 0;
 				gotOne--;
 			}
@@ -495,7 +501,8 @@ int HashTableCleanerManager :: GetOneToRebuild (JoinWayPointIDList &removeTheseW
 
 			// make sure this one is not being processed
 			if (allSegs[whichSegment].deadBeingCleaned.RightLength () ||
-			    allSegs[whichSegment].woundedBeingCleaned.RightLength ()) {
+			    allSegs[whichSegment].woundedBeingCleaned.RightLength () ||
+			    allSegs[whichSegment].cleaningInRanges) {
 				continue;
 			}
 
@@ -77,6 +77,11 @@
 // Join
 #define J_LHS           "lhs"
 #define J_RHS           "rhs"
+#define J_JOIN_PARAMS   "join_params"
+#define J_PROBE_BATCH   "probe_batch"
+#define J_CONC_BUILD    "concurrent_build"
+#define J_RADIX         "radix"
+#define J_RHS_TUPLES    "rhs_tuples"
 
 #define J_COLS_IN       "columns_in"
 #define J_COLS_OUT      "columns_out"
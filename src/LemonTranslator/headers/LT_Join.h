@@ -50,12 +50,20 @@ private:
 
     Json::Value global_info;
 
+    // Tuning knobs given with the join (PARAMETERS INLINE {...}); these only
+    // change how the join is executed, never its result
+    Json::Value join_params;
+
     // Definitions required per query
     typedef std::map< QueryID, std::string > QueryIDToString;
     QueryIDToString query_defs;
 
     QueryToJson per_query_info;
 
+    // number of hash table entries the RHS is expected to take, from the rhs_tuples join
+    // parameter or from the catalog; 0 if unknown
+    int64_t EstimateRHSEntries(void);
+
 public:
 
     LT_Join(WayPointID id, const SlotSet& atts, const SlotVec& atts_keys, WayPointID _cleanerID, Json::Value& info):
@@ -72,6 +80,7 @@ public:
         cleanerID(_cleanerID),
         global_defs(info[J_C_DEFS].asString()),
         global_info(info),
+        join_params(info.get(J_JOIN_PARAMS, Json::Value(Json::objectValue))),
         query_defs(),
         per_query_info()
     { }
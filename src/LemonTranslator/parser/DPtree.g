@@ -35,6 +35,7 @@ options {
  #include "ContainerTypes.h"
  #include "JsonAST.h"
  #include "ParserHelpers.h"
+ #include "ColumnCodec.h"
 
 /* Debugging */
 #undef PREPORTERROR
@@ -367,10 +368,29 @@ runStmt
   ;
 
 relationCR
-@init { Schema newSch; int index = 0; }
-@after { catalog.AddSchema(newSch);/* register the relatin with catalog */ }
+@init { Schema newSch; int index = 0; std::vector< std::pair<int, ColumnCodec> > codecs; }
+@after {
+    catalog.AddSchema(newSch);/* register the relatin with catalog */
+
+    // the codecs are kept with the relation on disk
+    for (size_t i = 0; i < codecs.size(); i++) {
+        SetColumnCodecTask task(newSch.GetRelationName(), index, codecs[i].first,
+            codecs[i].second.id, codecs[i].second.level);
+        lT->AddTask(task);
+    }
+}
   : ^(CRRELATION x=ID {newSch.SetRelationName(TXT($x));/* set relation name */}
-      ( ^(TPATT n=ID t=dType)
+      ( ^(TPATT n=ID t=dType
+            ( ^(USING c=ID (l=INT)?)
+            {
+                int codec = ColumnCodecByName(TXT($c));
+                FATALIF(codec == -1, "Unknown codec \%s for attribute \%s", TXT($c), TXT($n));
+                FATALIF(!ColumnCodecSupported(codec), "Codec \%s of attribute \%s is not supported by this build",
+                    TXT($c), TXT($n));
+
+                int level = $l == NULL ? 0 : atoi(TXT($l));
+                codecs.push_back(std::make_pair(index, ColumnCodec(codec, level)));
+            } )? )
         {
             Attribute att;
             att.SetName(TXT($n));
@@ -386,10 +406,22 @@ relationCR
   ;
 
 relationDeleteContent
-  : ^( DELETE_CONTENT n=ID ) {
+@init {
+    ChunkNumberList chunks;
+}
+  : ^( DELETE_CONTENT n=ID (c=INT { chunks.push_back(atol(TXT($c))); })* ) {
     std::string relName = STR($n);
-    DeleteRelationTask task(relName);
-    lT->AddTask(task);
+    if (chunks.empty()) {
+        DeleteRelationTask task(relName);
+        lT->AddTask(task);
+    } else {
+        // the file may have to be started to delete the chunks
+        SlotContainer attribs;
+        am.GetAttributesSlots(relName, attribs);
+
+        DeleteChunksTask task(relName, attribs.Length(), chunks);
+        lT->AddTask(task);
+    }
   }
   ;
 
@@ -1040,19 +1072,27 @@ joinWP
         SlotContainer atts;
 
         Json::Value jAttrs(Json::arrayValue);
+        Json::Value jParams(Json::objectValue);
     }
-    : ^(JOIN attributeList[atts, jAttrs]
+    : ^(JOIN attributeList[atts, jAttrs] joinParameters[jParams]?
     {
         std::string defs;
 
         Json::Value jVal(Json::objectValue);
         jVal[J_ARGS] = jAttrs;
         jVal[J_C_DEFS] = defs;
+        jVal[J_JOIN_PARAMS] = jParams;
 
         lT->AddJoinWP(wp, atts, jVal);
     } connList)
     ;
 
+// Join waypoint tuning knobs; only inline parameters are supported since they
+// are consumed by the translator itself
+joinParameters[Json::Value& putHere]
+    : ^(PARAMETERS__ ^(JSON_INLINE jsonObject[putHere]))
+    ;
+
 attributeList[SlotContainer& atts, Json::Value& json]
 : ^(ATTS (a=attribute {$atts.Append($a.slot); json.append($a.json);})+ )
 ;
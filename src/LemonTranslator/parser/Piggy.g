@@ -175,16 +175,26 @@ createStatement
   ;
 
 deleteStatement
-    : CONTENT n=identName -> ^(DELETE_CONTENT $n)
+    : CONTENT n=identName chunkList? -> ^(DELETE_CONTENT $n chunkList?)
     | RELATION n=identName -> ^(DELETE_RELATION $n)
     ;
 
+// the chunks of the relation deleted, all of them if none is given
+chunkList
+  : INT ( COMMA! INT)*
+  ;
+
 tpAttList
   : tpAtt ( COMMA! tpAtt)*
   ;
 
 tpAtt
-  : var=identName COLON dtype=type -> ^(TPATT $var $dtype)
+  : var=identName COLON dtype=type codecSpec? -> ^(TPATT $var $dtype codecSpec?)
+  ;
+
+// the codec the column is compressed with, and its level
+codecSpec
+  : USING c=ID ( LPAREN l=INT RPAREN )? -> ^(USING $c $l?)
   ;
 
 inStmt
@@ -193,8 +203,8 @@ inStmt
     ;
 
 actionBody
-    : jo=JOIN r1=identName BY l1=attEListAlt COMMA r2=identName BY l2=attEListAlt
-        ->  ^(JOIN ^(ATTS $l1) $r1 TERMCONN $r2) ^(QUERRY__ ID[$jo,ParserHelpers::qry.c_str()] ^(JOIN ^(ATTS $l2)))
+    : jo=JOIN r1=identName BY l1=attEListAlt COMMA r2=identName BY l2=attEListAlt par=parameterClause?
+        ->  ^(JOIN ^(ATTS $l1) $par? $r1 TERMCONN $r2) ^(QUERRY__ ID[$jo,ParserHelpers::qry.c_str()] ^(JOIN ^(ATTS $l2)))
     | fi=FILTER a=identName BY exp=expressionList
         -> ^(SELECT__ $a) ^(QUERRY__ ID[$fi,ParserHelpers::qry.c_str()] ^(FILTER $exp))
     | fi=FILTER a=identName BY gf=gfDef ct=constArgs st=stateArgs (USING nexp=namedExpressionList)?
@@ -15,6 +15,7 @@
 //
 #include "LT_Join.h"
 #include "AttributeManager.h"
+#include "Catalog.h"
 #include <assert.h>
 #include "Errors.h"
 
@@ -94,7 +95,7 @@ bool LT_Join::GetConfig(WayPointConfigureData& where){
     // here is the waypoint configuration data
     JoinConfigureData joinConfigure (joinID, myJoinWorkFuncs,
             myJoinEndingQueryExits, myJoinFlowThroughQueryExits, joinwriterID, cleanerID,
-            myJoinEndingQueryExitsCopy, myJoinFlowThroughQueryExitsCopy);
+            EstimateRHSEntries (), myJoinEndingQueryExitsCopy, myJoinFlowThroughQueryExitsCopy);
 
     where.swap (joinConfigure);
 
@@ -102,6 +103,45 @@ bool LT_Join::GetConfig(WayPointConfigureData& where){
 
 }
 
+int64_t LT_Join::EstimateRHSEntries(void) {
+
+    // the join parameters can say how many RHS tuples to expect
+    int64_t numTuples = join_params.get(J_RHS_TUPLES, 0).asInt64();
+
+    // otherwise, look up the relations the RHS keys come from in the catalog
+    if (numTuples == 0) {
+        AttributeManager& am = AttributeManager::GetAttributeManager();
+        Catalog& catalog = Catalog::GetCatalog();
+        StringContainer relations = catalog.GetRelationNames();
+
+        set<string> found;
+        for (QueryToSlotVec::iterator it = RHS_keys.begin(); it != RHS_keys.end(); it++) {
+            for (SlotVec::iterator key = it->second.begin(); key != it->second.end(); key++) {
+                string attName = am.GetAttributeName(*key);
+
+                // attributes of base relations are named relation_attribute
+                string bestMatch;
+                for (size_t i = 0; i < relations.size(); i++) {
+                    string prefix = relations[i] + "_";
+                    if (attName.compare(0, prefix.size(), prefix) == 0 && relations[i].size() > bestMatch.size())
+                        bestMatch = relations[i];
+                }
+
+                if (!bestMatch.empty() && found.insert(bestMatch).second) {
+                    Schema schema;
+                    if (catalog.GetSchema(bestMatch, schema))
+                        numTuples += schema.GetNumTuples();
+                }
+            }
+        }
+    }
+
+    // each RHS tuple takes an entry for the bitstring and at least one per attribute
+    set<SlotID> lhs, rhs;
+    GetAccumulatedLHSRHSAtts(lhs, rhs);
+    return numTuples * (1 + rhs.size());
+}
+
 bool LT_Join::GetConfigs(WayPointConfigurationList& where){
 
     // Get the config for join waypoint
@@ -681,6 +721,16 @@ Json::Value LT_Join::GetJson() {
         }
         ret["queries_attribute_comparison"] = list;
     }
+    // number of LHS tuples hashed and prefetched ahead of the probe; 0 probes
+    // one tuple at a time
+    ret[J_PROBE_BATCH] = join_params.get(J_PROBE_BATCH, 0).asInt();
+
+    // RHS workers share hash table segments instead of checking them out one at a time
+    ret[J_CONC_BUILD] = join_params.get(J_CONC_BUILD, false).asBool();
+
+    // build and probe go through the hash table one cache-sized region at a time
+    ret[J_RADIX] = join_params.get(J_RADIX, false).asBool();
+
     ret["exists_target"] = (Json::Value::UInt64) ExistsTarget.GetInt64();
     ret["not_exists_target"] = (Json::Value::UInt64) NotExistsTarget.GetInt64();
 
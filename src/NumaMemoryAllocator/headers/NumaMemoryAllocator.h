@@ -19,11 +19,12 @@
 #include <map>
 #include <unordered_map>
 #include <unordered_set>
+#include <utility>
 #include <vector>
 #include <mutex>
 
 #include "MmapAllocator.h"
-// Below 3 headers need for constant used for defining fixed hash size HASH_SEG_SIZE
+// Below 3 headers need for constant used for defining hash segment sizes HASH_SEG_SIZE
 #include "HashTableMacros.h"
 #include "Constants.h"
 #include "HashEntry.h"
@@ -77,8 +78,9 @@
 // Up to this number, no merging of adjacent chunks
 #define NO_COALESCE_MAXPAGESIZE 16
 
-// This is special size for hash segments and handled differently
-#define HASH_SEG_SIZE (ABSOLUTE_HARD_CAP * sizeof(HashEntry))
+// These are special sizes for hash segments (one for each segment size from
+// MIN_SLOTS_IN_SEGMENT_BITS to NUM_SLOTS_IN_SEGMENT_BITS) and handled differently
+#define HASH_SEG_SIZE(slotBits) (HARD_CAP_FOR(1ULL << (slotBits)) * sizeof(HashEntry))
 
 // Touch the pages once retreived from mmap.
 #define MMAP_TOUCH_PAGES 1
@@ -108,12 +110,12 @@ class NumaMemoryAllocator {
     int allocated_pages_;
     // number of free pages
     int free_pages_;
-    // page size of hash segment
+    // page size of the largest hash segment
     const int kHashSegPageSize;
-    // page aligned hash segment size
-    const size_t kHashSegAlignedSize;
-    // reserve fixed size chunk for hash entry
-    std::vector<void*> reserved_hash_segs;
+    // page sizes of all the hash segment sizes
+    std::unordered_set<int> hash_seg_page_sizes;
+    // freed hash segments kept for reuse, by page size and numa node
+    std::map<std::pair<int, int>, std::vector<void*>> reserved_hash_segs;
 
     struct NumaNode{
         // binary search tree of free list
@@ -122,7 +124,7 @@ class NumaMemoryAllocator {
     // store the relation between numa number and numa nodes
     std::vector<NumaNode*> numa_num_to_node;
     // store chunk info in external data structure to avoid breaking DMA
-    std::unordered_set<void*> occupied_hash_segs;
+    std::unordered_map<void*, std::pair<int, int>> occupied_hash_segs;  // hash segment to page size and node
     std::unordered_map<void*, MemoryChunkInfo*> ptr_to_bstchunk;
 
     size_t PageSizeToBytes(int page_size);
@@ -139,7 +141,14 @@ class NumaMemoryAllocator {
 
     void HeapInit();
 
-    void* HashSegAlloc();
+    // hash segments are placed on node; NUMA_ALL_NODES interleaves their pages over all the nodes
+    void* HashSegAlloc(int num_pages, int node);
+
+    // sets the memory policy of a fresh hash segment, before any of its pages are touched
+    void BindHashSeg(void* ptr, int num_pages, int node);
+
+    // unmaps the reserved hash segments smaller than num_pages
+    void ReleaseHashSegs(int num_pages);
 
     void* BSTreeAlloc(int num_pages, int node);
 
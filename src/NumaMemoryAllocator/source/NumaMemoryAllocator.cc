@@ -65,16 +65,18 @@ NumaMemoryAllocator::NumaMemoryAllocator(void)
     : is_initialized_(false),  // google code stype constructor initializer lists
       allocated_pages_(0),
       free_pages_(0),
-      kHashSegPageSize(BytesToPageSize(HASH_SEG_SIZE)),  // hash segment size in pages
-      kHashSegAlignedSize(PageSizeToBytes(kHashSegPageSize)) // hash segment size in bytes
-    {}
+      kHashSegPageSize(BytesToPageSize(HASH_SEG_SIZE(NUM_SLOTS_IN_SEGMENT_BITS)))  // hash segment size in pages
+{
+    for (int bits = MIN_SLOTS_IN_SEGMENT_BITS; bits <= NUM_SLOTS_IN_SEGMENT_BITS; bits++)
+        hash_seg_page_sizes.insert(BytesToPageSize(HASH_SEG_SIZE(bits)));
+}
 
 NumaMemoryAllocator::~NumaMemoryAllocator(void) {
     // for (auto p : ptr_to_bstchunk) {
     //     SYS_MMAP_FREE(p.first, PageSizeToBytes(p.second->size));
     // }
     // for (auto s: reserved_hash_segs) {
-    //     SYS_MMAP_FREE(s, kHashSegAlignedSize);
+    //     SYS_MMAP_FREE(s, PageSizeToBytes(kHashSegPageSize));
     // }
     // NumaMemoryAllocator::MemoryChunkInfo::FreeChunks();
 }
@@ -143,9 +145,12 @@ void* NumaMemoryAllocator::MmapAlloc(size_t num_bytes, int node, const char* f,
         HeapInit();
 
     int num_pages = BytesToPageSize(num_bytes);
-    if (kHashSegPageSize == num_pages) {
-        return HashSegAlloc();
+    if (hash_seg_page_sizes.count(num_pages)) {
+        return HashSegAlloc(num_pages, node);
     }
+    // the heap is kept per node; a request without a node preference uses the first one
+    if (node < 0 || node >= numa_num_to_node.size())
+        node = 0;
     void* res_ptr = BSTreeAlloc(num_pages, node);
 #if defined(USE_NUMA) || defined(TEST_NUMA_LOGIC)
     if (!res_ptr) {
@@ -173,8 +178,9 @@ void NumaMemoryAllocator::MmapChangeProt(void* ptr, int prot) {
     }
 
     lock_guard<mutex> lck(mtx_);
-    if (occupied_hash_segs.find(ptr) != occupied_hash_segs.end()) {
-        SYS_MMAP_PROT(ptr, kHashSegAlignedSize, prot);
+    auto seg = occupied_hash_segs.find(ptr);
+    if (seg != occupied_hash_segs.end()) {
+        SYS_MMAP_PROT(ptr, PageSizeToBytes(seg->second.first), prot);
     } else {
         // find the size and insert the freed memory in the
         auto it = ptr_to_bstchunk.find(ptr);
@@ -191,9 +197,10 @@ void NumaMemoryAllocator::MmapFree(void* ptr) {
         return;
 
     lock_guard<mutex> lck(mtx_);
-    if (occupied_hash_segs.find(ptr) != occupied_hash_segs.end()) {
-        reserved_hash_segs.push_back(ptr);
-        occupied_hash_segs.erase(ptr);
+    auto seg = occupied_hash_segs.find(ptr);
+    if (seg != occupied_hash_segs.end()) {
+        reserved_hash_segs[seg->second].push_back(ptr);
+        occupied_hash_segs.erase(seg);
         // UpdateStatus(-kHashSegPageSize);
     } else {
         FATALIF(ptr_to_bstchunk.find(ptr) == ptr_to_bstchunk.end(), "Freeing unallocated pointer %p.", ptr);
@@ -201,25 +208,68 @@ void NumaMemoryAllocator::MmapFree(void* ptr) {
     }
 }
 
-void* NumaMemoryAllocator::HashSegAlloc() {
+void* NumaMemoryAllocator::HashSegAlloc(int num_pages, int node) {
     void* res_ptr = nullptr;
-    if (reserved_hash_segs.empty()) {
+    auto it = reserved_hash_segs.find(make_pair(num_pages, node));
+    if (it == reserved_hash_segs.end()) {
+        // hash segments only grow, so the smaller ones freed so far will not be asked for again
+        ReleaseHashSegs(num_pages);
+
         // may use page aligned size
-        res_ptr = SYS_MMAP_ALLOC(kHashSegAlignedSize);
+        res_ptr = SYS_MMAP_ALLOC(PageSizeToBytes(num_pages));
         if (!SYS_MMAP_CHECK(res_ptr)){
             perror("NumaMemoryAllocator");
             FATAL("The memory allocator could not allocate memory");
         }
+        BindHashSeg(res_ptr, num_pages, node);
     } else {
-        res_ptr = reserved_hash_segs.back();
-        reserved_hash_segs.pop_back();
+        res_ptr = it->second.back();
+        it->second.pop_back();
+        if (it->second.empty())
+            reserved_hash_segs.erase(it);
     }
-    occupied_hash_segs.emplace(res_ptr);
-    SYS_MMAP_PROT(res_ptr, kHashSegAlignedSize, PROT_READ | PROT_WRITE);
+    occupied_hash_segs.emplace(res_ptr, make_pair(num_pages, node));
+    SYS_MMAP_PROT(res_ptr, PageSizeToBytes(num_pages), PROT_READ | PROT_WRITE);
     // UpdateStatus(kHashSegPageSize);
     return res_ptr;
 }
 
+void NumaMemoryAllocator::ReleaseHashSegs(int num_pages) {
+    while (!reserved_hash_segs.empty() && reserved_hash_segs.begin()->first.first < num_pages) {
+        auto it = reserved_hash_segs.begin();
+        for (void* seg : it->second) {
+            SYS_MMAP_FREE(seg, PageSizeToBytes(it->first.first));
+        }
+        reserved_hash_segs.erase(it);
+    }
+}
+
+void NumaMemoryAllocator::BindHashSeg(void* ptr, int num_pages, int node) {
+#ifdef USE_NUMA
+    int num_numa_nodes = numaNodeCount();
+    if (num_numa_nodes < 2)
+        return;
+
+    // the pages are not touched yet, so they are placed by the policy when the segment is zeroed
+    unsigned long node_mask = 0;
+    int mode = MPOL_BIND;
+    if (node == NUMA_ALL_NODES) {
+        for (int i = 0; i < num_numa_nodes; i++)
+            node_mask |= (1UL << i);
+        mode = MPOL_INTERLEAVE;
+    } else {
+        node_mask |= (1UL << (node % num_numa_nodes));
+    }
+    int retVal = mbind(ptr,                         // address
+                       PageSizeToBytes(num_pages),  // length
+                       mode,                        // policy mode
+                       &node_mask,                  // node mask
+                       num_numa_nodes + 1,          // max number of nodes
+                       0);                          // policy mode flag
+    WARNINGIF(retVal != 0, "Binding a hash segment to node %d failed with message %s", node, strerror(errno));
+#endif
+}
+
 void NumaMemoryAllocator::EraseTreePtr(int size, void* ptr, int node) {
     auto it = numa_num_to_node[node]->free_tree.find(size);
     if (it->second.size() == 1)
@@ -0,0 +1,37 @@
+#!/bin/bash
+
+# Compares the radix-partitioned join against the global hash table join on the
+# SIGMOD queries. Each query is run RUNS times in both modes, after one warm-up
+# run; the wall clock time of every run is written to radix-results.csv. The
+# times include code generation, which costs the same in both modes.
+#
+# Usage: bench-radix.sh [RUNS] [grokit options...]
+
+RUNS=${1:-5}
+shift 1
+GROKIT_OPTS="-b $@"
+
+DIR=$(dirname $(readlink -f $0))
+OUT=radix-results.csv
+
+echo "query,mode,run,seconds" > $OUT
+
+for query in Q5 Q7; do
+    for mode in global radix; do
+        file=$DIR/$query-$mode.pgy
+
+        # warm-up, so that cold disk reads do not count against the first mode
+        grokit $GROKIT_OPTS run $file > /dev/null
+
+        for run in $(seq 1 $RUNS); do
+            start=$(date +%s.%N)
+            grokit $GROKIT_OPTS run $file > /dev/null
+            end=$(date +%s.%N)
+            echo "$query,$mode,$run,$(echo "$end - $start" | bc)" >> $OUT
+        done
+    done
+done
+
+# average per query and mode
+awk -F, 'NR > 1 { sum[$1 "," $2] += $4; cnt[$1 "," $2]++ }
+    END { for (k in sum) printf "%s,%.3f\n", k, sum[k] / cnt[k] }' $OUT | sort
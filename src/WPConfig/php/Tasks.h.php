@@ -10,6 +10,8 @@ require_once('DataFunctions.php');
 
 #include <cinttypes>
 #include <string>
+#include <vector>
+#include <sys/types.h>
 
 #include "TwoWayList.h"
 
@@ -25,6 +27,18 @@ typedef TwoWayList<Task> TaskList;
 grokit\create_data_type("DeleteRelationTask", "Task", [ 'relation' => 'std::string' ], [], true);
 ?>
 
+// Delete some chunks of a relation, keeping their IDs
+typedef std::vector<off_t> ChunkNumberList;
+
+<?
+grokit\create_data_type("DeleteChunksTask", "Task", [ 'relation' => 'std::string', 'numCols' => 'uint64_t' ], [ 'chunks' => 'ChunkNumberList' ], true);
+?>
+
+// Set the codec and level a column of a relation is compressed with
+<?
+grokit\create_data_type("SetColumnCodecTask", "Task", [ 'relation' => 'std::string', 'numCols' => 'uint64_t', 'column' => 'int', 'codec' => 'int', 'level' => 'int' ], [], true);
+?>
+
 <?
 grokit\generate_deserializer( 'Task' );
 ?>
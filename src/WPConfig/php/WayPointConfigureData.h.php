@@ -214,12 +214,13 @@ grokit\create_data_type(
 // if this waypoint gets kicked out of the hash table.  It also contains a list of the new queries that have
 // never been seen before by this join waypoint, since these are treated differently than the existing queries
 // in that some state must be recorded for them.  Note that newEndingQueries must be a subset of endingQueryExits,
-// and newFlorThruQueries must be a subset of flowThroughQueryExits
+// and newFlorThruQueries must be a subset of flowThroughQueryExits.  rhsEntries is the number of hash table
+// entries the RHS of the join is expected to take, or 0 if there is no estimate
 <?php
 grokit\create_data_type(
     "JoinConfigureData"
     , "WayPointConfigureData"
-    , [ 'myDiskBasedTwinID' => 'WayPointID', 'hashTableCleaner' => 'WayPointID', ]
+    , [ 'myDiskBasedTwinID' => 'WayPointID', 'hashTableCleaner' => 'WayPointID', 'rhsEntries' => 'int64_t', ]
     , [ 'newEndingQueries' => 'QueryExitContainer', 'newFlowThruQueries' => 'QueryExitContainer']
     , true
 );
@@ -25,9 +25,93 @@ struct WayPointInformation {
 #define ZEROING_OUT_STEP_SIZE 2048
 
 #include <vector>
+#include <string>
 
 #include "ColumnIterator.h"
 #include "MMappedStorage.h"
+#include "SegmentCleaning.h"
+#include "Timer.h"
+
+// cleans one range of a segment that is being cleaned in ranges.  Nothing is extracted in this
+// case, so all there is to do is to move the live tuples homed in the range into the new version
+// of the segment; the writers keep inserting into the segment in the meantime
+static void CleanRange_<?=$wpName?> (HashCleanerWorkDescription &myWork, WayPointInformation *wayPointInfo,
+        void *serializeHere, ExecEngineData &result) {
+
+    int whichSegment = myWork.get_whichSegment ();
+    int whichRange = myWork.get_whichRange ();
+
+    HashTableSegment mySegment;
+    myWork.get_centralHashTable ().CheckOutForCleaning (whichSegment, myWork.get_numRanges (), mySegment);
+    SegmentCleaning &cleaning = *mySegment.GetCleaning ();
+    HashTableSegment newSegment (cleaning.newSegment);
+
+    // from here on, writers put the tuples of this range into the new version
+    cleaning.StartRange (whichRange);
+
+    SerializedSegmentArray storage;
+    int counter = 0;
+
+    HT_INDEX_TYPE high = cleaning.RangeStart (whichRange + 1);
+    for (HT_INDEX_TYPE i = cleaning.RangeStart (whichRange); i < high; i++) {
+
+        HT_INDEX_TYPE curSlot = i;
+        while (1) {
+
+            int whichWayPoint = -1, fingerprint = NO_FINGERPRINT, LHS, columnID, dummy, done;
+            Bitstring bitstringIFound;
+            int lastLen = mySegment.Extract (&bitstringIFound, curSlot, i, whichWayPoint, fingerprint, BITMAP, LHS, done);
+
+            if (lastLen == 0)
+                break;
+
+            int state = wayPointInfo[whichWayPoint].isDying;
+            FATALIF (state == DYING_AND_SEND, "Found a waypoint to send while cleaning a segment in ranges");
+            bitstringIFound.Difference (wayPointInfo[whichWayPoint].killThese);
+
+            // the tuple is kept if some query still needs it; the new version may have a different
+            // size, so it goes in by the slot WHICH_SLOT gave for it
+            int keep = !bitstringIFound.IsEmpty () && state == ALIVE;
+            if (keep)
+                storage.StartNew (mySegment.FullSlotOfTuple (curSlot, done, i), whichWayPoint, !LHS, &bitstringIFound, lastLen, fingerprint);
+
+            if (done)
+                goto end;
+
+<?  foreach( array_merge($lhs, $rhs) as $att ) { ?>
+            columnID = <?=$att->slot()?>;
+            lastLen = mySegment.Extract (serializeHere, curSlot, i, whichWayPoint, fingerprint, columnID, dummy, done);
+            if (lastLen > 0 && keep)
+                storage.Append (columnID, serializeHere, lastLen);
+
+            if (done)
+                goto end;
+<?  } // foreach attribute ?>
+end:
+            if (keep) {
+                newSegment.InsertConcurrent (storage);
+                storage.EmptyOut ();
+                counter++;
+            }
+        }
+    }
+
+    PROFILING(0.0, "Cleaner", "FindTuples", "%d", counter);
+
+    // the worker that finishes the last range hands the new version back
+    HashTableSegment putBack;
+    if (cleaning.FinishRange (whichRange)) {
+        putBack.swap (newSegment);
+
+        int64_t latency = int64_t (cleaning.clock.GetTime () * 1000);
+        PROFILING2_INSTANT("cln seg " + std::to_string (whichSegment), latency, "<?=$wpName?>");
+    }
+
+    ExtractionList extractionResult;
+    ExtractionContainer finalResult (whichSegment, myWork.get_diskTokenQueue (), extractionResult);
+    ExtractionResult reallyFinalResult (whichSegment, putBack, finalResult);
+    reallyFinalResult.swap (result);
+}
 
 extern "C"
 int CleanerWorkFunc_<?=$wpName?>( WorkDescription & workDescription, ExecEngineData & result ) {
@@ -89,6 +173,15 @@ int CleanerWorkFunc_<?=$wpName?>( WorkDescription & workDescription, ExecEngineD
         }
     }
 
+    // a range of a segment that is being cleaned in ranges
+    if (myWork.get_numRanges ()) {
+        CleanRange_<?=$wpName?> (myWork, wayPointInfo, serializeHere, result);
+
+        free (serializeHere);
+        delete [] wayPointInfo;
+        return 1;
+    }
+
     // check out the hash table segment we are processing
     HashTableSegment mySegment;
     int whichSegment = myWork.get_whichSegment ();
@@ -99,6 +192,9 @@ int CleanerWorkFunc_<?=$wpName?>( WorkDescription & workDescription, ExecEngineD
     theseAreOK[whichSegment] = 1;
     myWork.get_centralHashTable ().CheckOutOne (theseAreOK, mySegment);
 
+    // time it takes to rebuild the segment while the writers are locked out of it
+    Timer cleaningClock;
+
     // now set up the various attribute columns...
 
     // LHS IS FIRST
@@ -200,10 +296,18 @@ int CleanerWorkFunc_<?=$wpName?>( WorkDescription & workDescription, ExecEngineD
 
     // this is the new hash table segment we are building
     HashTableSegment newSegment;
-    newSegment.Allocate ();
+    newSegment.Allocate (myWork.get_centralHashTable ().RebuildBits (mySegment), mySegment.GetNode ());
 
-    // this is the last slot in the segment that we have zeroed out
+    // this is the last slot in the segment that we have zeroed out; the new version is zeroed as we
+    // go only if it has the same layout as the old one, otherwise it is zeroed up front
     HT_INDEX_TYPE upperBound = 0;
+    if (newSegment.GetSlotBits () != mySegment.GetSlotBits ()) {
+        newSegment.ZeroOut ();
+        upperBound = ABSOLUTE_HARD_CAP;
+    }
+
+    // the fragments of the extracted chunks are made of this many home slots
+    HT_INDEX_TYPE fragmentMask = (1ULL << (mySegment.GetSlotBits () - NUM_FRAGMENT_BITS)) - 1ULL;
 
     // Before we start main for loop, mark all start boundaries of fragment
     for (int IDX = 0; IDX < numDyingWaypoints; IDX++) {
@@ -220,7 +324,7 @@ int CleanerWorkFunc_<?=$wpName?>( WorkDescription & workDescription, ExecEngineD
     }
 
     // now, loop through the hash table!
-    for (HT_INDEX_TYPE i = 0; i < NUM_SLOTS_IN_SEGMENT; i++) {
+    for (HT_INDEX_TYPE i = 0; i < mySegment.NumSlots (); i++) {
 
         HT_INDEX_TYPE curSlot = i;
         while (1) {
@@ -229,22 +333,26 @@ int CleanerWorkFunc_<?=$wpName?>( WorkDescription & workDescription, ExecEngineD
             // of slots that we zero out in one fell swoop
             if (curSlot + ZEROING_OUT_STEP_SIZE > upperBound)  {
                 HT_INDEX_TYPE newUpperBound = curSlot + ZEROING_OUT_STEP_SIZE;
-                if (newUpperBound >= NUM_SLOTS_IN_SEGMENT)
+                if (newUpperBound >= mySegment.NumSlots ())
                     newUpperBound = ABSOLUTE_HARD_CAP;
                 newSegment.ZeroOut (upperBound, newUpperBound);
                 upperBound = newUpperBound;
             }
 
             // begin by trying to extract the bitmap
-            int whichWayPoint = -1, LHS, columnID, dummy, done;
+            int whichWayPoint = -1, fingerprint = NO_FINGERPRINT, LHS, columnID, dummy, done;
             Bitstring bitstringIFound;
-            int lastLen = mySegment.Extract (&bitstringIFound, curSlot, i, whichWayPoint, BITMAP, LHS, done);
+            int lastLen = mySegment.Extract (&bitstringIFound, curSlot, i, whichWayPoint, fingerprint, BITMAP, LHS, done);
 
 
             // see if we didn't find any data in this slot
             if (lastLen == 0)
                 break;
 
+            // the slot WHICH_SLOT gave for this tuple; the hash columns and the new version of the
+            // segment go by this, not by where the tuple was homed here
+            HT_INDEX_TYPE fullSlot = mySegment.FullSlotOfTuple (curSlot, done, i);
+
             // we did find data, so get this guy's bitmap
             Bitstring *bitstringPtr = &bitstringIFound;
 
@@ -263,7 +371,7 @@ int CleanerWorkFunc_<?=$wpName?>( WorkDescription & workDescription, ExecEngineD
                 counter++;
 
                 // now put the hash in
-                hashColumnIterLHS[index].Insert (i);
+                hashColumnIterLHS[index].Insert (fullSlot);
                 hashColumnIterLHS[index].Advance ();
 
                 // if this guy is dying and we got RHS data, put the bitmap (and hash) in a RHS chunk
@@ -275,13 +383,13 @@ int CleanerWorkFunc_<?=$wpName?>( WorkDescription & workDescription, ExecEngineD
                 bitmapColumnRHSIsUsed[index]++;
 
                 // now put the hash in
-                hashColumnIterRHS[index].Insert (i);
+                hashColumnIterRHS[index].Insert (fullSlot);
                 hashColumnIterRHS[index].Advance ();
 
                 // if this entry has interesting data, then put it in
             } else if (!bitstringPtr->IsEmpty () && state == ALIVE) {
 
-                storage.StartNew (i, whichWayPoint, !LHS, bitstringPtr, lastLen);
+                storage.StartNew (fullSlot, whichWayPoint, !LHS, bitstringPtr, lastLen, fingerprint);
             }
 
             // if we finished the tuple, stop serializing
@@ -291,7 +399,7 @@ int CleanerWorkFunc_<?=$wpName?>( WorkDescription & workDescription, ExecEngineD
             // NOW DO LHS COLUMNS
 <?  foreach( $lhs as $att ) { ?>
             columnID = <?=$att->slot()?>;
-            lastLen = mySegment.Extract( serializeHere, curSlot, i, whichWayPoint, columnID, dummy, done);
+            lastLen = mySegment.Extract( serializeHere, curSlot, i, whichWayPoint, fingerprint, columnID, dummy, done);
 
             // see if we got something... in the first two cases, we are extracting data for a disk-based join
             if (lastLen > 0 && state == DYING_AND_SEND && LHS) {
@@ -323,7 +431,7 @@ int CleanerWorkFunc_<?=$wpName?>( WorkDescription & workDescription, ExecEngineD
             // NOW DO RHS COLUMNS
 <?  foreach( $rhs as $att ) { ?>
             columnID = <?=$att->slot()?>;
-            lastLen = mySegment.Extract( serializeHere, curSlot, i, whichWayPoint, columnID, dummy, done);
+            lastLen = mySegment.Extract( serializeHere, curSlot, i, whichWayPoint, fingerprint, columnID, dummy, done);
 
             // see if we got something... in the first two cases, we are extracting data for a disk-based join
             if (lastLen > 0 && state == DYING_AND_SEND && LHS) {
@@ -361,7 +469,7 @@ end:        // AT THIS POINT, DONE WITH ALL OF THE COLUMNS!!
         }
 
         // Mark only if i is not at the end and condition matches for all LSBs as 11111111....
-        if ((i != NUM_SLOTS_IN_SEGMENT-1) && (i & ((1ULL << (NUM_SLOTS_IN_SEGMENT_BITS-NUM_FRAGMENT_BITS))- 1ULL)) == ((1ULL<<(NUM_SLOTS_IN_SEGMENT_BITS-NUM_FRAGMENT_BITS))-1ULL)) {
+        if ((i != mySegment.NumSlots ()-1) && (i & fragmentMask) == fragmentMask) {
             //printf("\n Markfragment Index value = %d  %lx", i, &i); fflush(stdout);
             //if (i == NUM_SLOTS_IN_SEGMENT-1) assert(0);
             for (int IDX = 0; IDX < numDyingWaypoints; IDX++) {
@@ -388,6 +496,9 @@ end:        // AT THIS POINT, DONE WITH ALL OF THE COLUMNS!!
     PROFILING(0.0, "Cleaner", "FindTuples", "%d", counter);
     newSegment.ZeroOut (upperBound, ABSOLUTE_HARD_CAP);
 
+    int64_t latency = int64_t (cleaningClock.GetTime () * 1000);
+    PROFILING2_INSTANT("cln seg " + std::to_string (whichSegment), latency, "<?=$wpName?>");
+
     // now we are at the final cleanup, where we build our output chunks... there could potentially be one
     // LHS chunk and one RHS chunk for each and every join waypoint
 
@@ -27,6 +27,50 @@ function attData($att){ return $att."_Column"; }
 function attStorage($att){ return "storage_".$att; }
 // test weathe the type of an attribute is simple or complex
 function isFixedAtt($att){ return lookupAttribute($att)->type()->isFixedSize(); }
+// test whether an attribute can be compared straight out of the hash table: its type
+// is fixed size and serializes to the raw bytes of at most one VAL_TYPE word
+function isWordKeyAtt($att){
+    $type = lookupAttribute($att)->type();
+    $wordTypes = [ 'base::INT', 'base::BIGINT', 'base::DATE', 'base::FACTOR' ];
+    return $type->isFixedSize() && in_array($type->name(), $wordTypes);
+}
+// test whether the column of an attribute can be read as runs of equal values
+// (EncodedRunIterator.h): the integer encodings are only used for fixed width
+// integers, and the values must convert back to the type with a cast
+function isRunAtt($att){
+    $type = lookupAttribute($att)->type();
+    $runTypes = [ 'base::INT', 'base::BIGINT', 'base::UINT' ];
+    return in_array($type->name(), $runTypes);
+}
+// form the name of the run iterator of an attribute
+function attRuns($att){ return $att."_Runs"; }
+// test whether the column of an attribute can be read as codes of its strings
+// (DictCodeIterator.h): only STRING columns are dictionary encoded
+function isDictAtt($att){
+    $type = lookupAttribute($att)->type();
+    return $type->name() == 'base::STRING';
+}
+// form the name of the dictionary code iterator of an attribute
+function attCodes($att){ return $att."_Codes"; }
+// form the name of the hashes by chunk code of an attribute (DictCodeHash)
+function attCodeHashes($att){ return $att."_CodeHashes"; }
+// C++ expression for the hash of $val, the current value of $att. The attributes
+// in $dict_atts are hashed once per string of the chunk and looked up by chunk
+// code after that; they need the hashes declared by cgDeclareCodeHashes()
+function attHash($att, $val, $dict_atts = []){
+    if (!in_array($att, $dict_atts)) return "Hash(".$val.")";
+    return "DictCodeHash(".attCodes($att).", ".attCodeHashes($att).", ".$val.")";
+}
+// test whether the column of an attribute can be read in batches of contiguous
+// values (ColumnIterator::GetBatch): the type must be a native type that is
+// stored as its raw bytes
+function isBatchAtt($att){
+    $type = lookupAttribute($att)->type();
+    $batchTypes = [ 'base::INT', 'base::BIGINT', 'base::UINT', 'base::SMALLINT', 'base::FLOAT', 'base::DOUBLE' ];
+    return in_array($type->name(), $batchTypes);
+}
+// form the name of the current batch of an attribute
+function attBatch($att){ return $att."_Batch"; }
 // serialization and deserialization functions
 function attSerializedSize($att, $obj){
     if (attType($att)->isFixedSize()) return "sizeof(".$att.")";
@@ -93,7 +137,9 @@ function cgConstructColumns($atts, $postfix = "") {
 
 // Function to define columns that are needed.
 // Needs attribute map. Assumens $attributes is set globaly
-function cgAccessColumns($att_map, $chunk, $wpName){ ?>
+// The attributes in $run_atts also get an EncodedRunIterator over their column,
+// the ones in $dict_atts a DictCodeIterator
+function cgAccessColumns($att_map, $chunk, $wpName, $run_atts = [], $dict_atts = []){ ?>
     // Declaring and extracting all the columns that are needed
 <? foreach( $att_map as $att => $qry){ ?>
     QueryIDSet <?=attQrys($att)?>(<?=$qry?>, true);
@@ -105,6 +151,14 @@ function cgAccessColumns($att_map, $chunk, $wpName){ ?>
                 FATAL("Error: Column <?=$att?> not found in <?=$wpName?>\n");
             }
         }
+<?  if( in_array($att, $run_atts) ) { ?>
+    // runs of the encoded column, valid only if the column is encoded
+    EncodedRunIterator <?=attRuns($att)?>(<?=attCol($att)?>, sizeof(<?=attType($att)?>));
+<?  } // if runs wanted ?>
+<?  if( in_array($att, $dict_atts) ) { ?>
+    // codes of the strings of the column, valid only if the column is dictionary encoded
+    DictCodeIterator <?=attCodes($att)?>(<?=attCol($att)?>);
+<?  } // if codes wanted ?>
     <?=attIteratorType($att)?> <?=attData($att)?> (<?=attCol($att)?>/*, 8192*/);
 
 <? }
@@ -134,13 +188,113 @@ function cgAccessAttributes($att_map) { ?>
 <?
 }
 
+// The code below works on runs of tuples that have the same bitstring and the same
+// values for all the attributes in the list, so that the work is done once per run.
+// The list must only have attributes for which isRunAtt() holds, and their run
+// iterators must have been declared by cgAccessColumns().
+
+// C++ condition that is true if the chunk can be processed as runs: the columns
+// of all the attributes that are read are encoded
+function cgRunsUsable($att_map) {
+    $conds = [ 'true' ];
+    foreach( $att_map as $att => $qry ) {
+        $conds[] = '(!' . attQrys($att) . '.Overlaps(queriesToRun) || ' . attRuns($att) . '.IsValid())';
+    }
+    return implode(' && ', $conds);
+}
+
+// Function to compute, into $var, the length of the current run
+function cgRunLength($att_map, $var, $indentLevel = 1) {
+    $indent = str_repeat('    ', $indentLevel);
+    echo $indent . 'uint64_t ' . $var . ' = queries.RunLength();' . PHP_EOL;
+    foreach( $att_map as $att => $qry ) {
+        echo $indent . 'if (' . attRuns($att) . '.RunLength() < ' . $var . ')' . PHP_EOL;
+        echo $indent . '    ' . $var . ' = ' . attRuns($att) . '.RunLength();' . PHP_EOL;
+    }
+    echo $indent . 'FATALIF(' . $var . ' == 0, "Encoded column shorter than the bitstring");' . PHP_EOL;
+}
+
+// Function to extract the values of the attributes for the current run
+function cgAccessRunAttributes($att_map, $indentLevel = 1) {
+    $indent = str_repeat('    ', $indentLevel);
+    echo $indent . '// extract values of attributes from the runs' . PHP_EOL;
+    foreach( $att_map as $att => $qry ) {
+        echo $indent . 'const ' . attType($att) . ' ' . $att . ' = (' . attType($att) . ') ' . attRuns($att) . '.GetValue();' . PHP_EOL;
+    }
+}
+
+// Function to skip the attributes and the bitstring over $var tuples
+function cgSkipRuns($att_map, $var, $indentLevel = 1) {
+    $indent = str_repeat('    ', $indentLevel);
+    echo $indent . 'queries.Skip(' . $var . ');' . PHP_EOL;
+    foreach( $att_map as $att => $qry ) {
+        echo $indent . attRuns($att) . '.Skip(' . $var . ');' . PHP_EOL;
+    }
+}
+
+// The code below works on batches of tuples that have the same bitstring and whose
+// values are contiguous in memory, so that the loops over a batch have no calls into
+// the iterators and can be vectorized. The list must only have attributes for which
+// isBatchAtt() holds.
+
+// Function to get, into $var, the length of the next batch, and the batch of each
+// attribute
+function cgBatchLength($att_map, $var, $indentLevel = 1) {
+    $indent = str_repeat('    ', $indentLevel);
+    echo $indent . 'uint64_t ' . $var . ' = queries.RunLength();' . PHP_EOL;
+    echo $indent . 'if (' . $var . ' > COLUMN_BATCH_SIZE)' . PHP_EOL;
+    echo $indent . '    ' . $var . ' = COLUMN_BATCH_SIZE;' . PHP_EOL;
+    foreach( $att_map as $att => $qry ) {
+        echo $indent . 'const ' . attType($att) . '* ' . attBatch($att) . ' = NULL;' . PHP_EOL;
+        echo $indent . 'if (' . attQrys($att) . '.Overlaps(queriesToRun))' . PHP_EOL;
+        echo $indent . '    ' . attBatch($att) . ' = ' . attData($att) . '.GetBatch(' . $var . ', ' . $var . ');' . PHP_EOL;
+    }
+    echo $indent . 'FATALIF(' . $var . ' == 0, "Column shorter than the bitstring");' . PHP_EOL;
+}
+
+// Function to extract the values of the attributes for tuple $index of the batch
+function cgAccessBatchAttributes($att_map, $index, $indentLevel = 1) {
+    $indent = str_repeat('    ', $indentLevel);
+    foreach( $att_map as $att => $qry ) {
+        echo $indent . 'const ' . attType($att) . '& ' . $att . ' = ' . attBatch($att) . '[' . $index . '];' . PHP_EOL;
+    }
+}
+
+// Function to advance the attributes and the bitstring over $var tuples
+function cgSkipBatches($att_map, $var, $indentLevel = 1) {
+    $indent = str_repeat('    ', $indentLevel);
+    echo $indent . 'queries.Skip(' . $var . ');' . PHP_EOL;
+    foreach( $att_map as $att => $qry ) {
+        echo $indent . attData($att) . '.AdvanceBy(' . $var . ');' . PHP_EOL;
+    }
+}
+
 // Function to advance columns corresponding to attributes
-function cgAdvanceAttributes($att_map, $indentLevel = 1) {
+function cgAdvanceAttributes($att_map, $indentLevel = 1, $dict_atts = []) {
     $indent = str_repeat('    ', $indentLevel);
     echo $indent . '// Advance attributes' . PHP_EOL;
     foreach( $att_map as $att => $qry ) {
         echo $indent . attData($att) . '.Advance();' . PHP_EOL;
     }
+    cgAdvanceCodes($dict_atts, $indentLevel);
+}
+
+// Function to advance the dictionary code iterators of the attributes in
+// $dict_atts, the ones that are valid
+function cgAdvanceCodes($dict_atts, $indentLevel = 1) {
+    $indent = str_repeat('    ', $indentLevel);
+    foreach( $dict_atts as $att ) {
+        echo $indent . 'if (' . attCodes($att) . '.IsValid()) ' . attCodes($att) . '.Advance();' . PHP_EOL;
+    }
+}
+
+// Function to declare the hashes by chunk code of the attributes in $dict_atts
+function cgDeclareCodeHashes($dict_atts, $indentLevel = 1) {
+    $indent = str_repeat('    ', $indentLevel);
+    foreach( $dict_atts as $att ) {
+        echo $indent . '// hashes of the strings of ' . $att . ' by chunk code' . PHP_EOL;
+        echo $indent . 'std::vector<uint64_t> ' . attCodeHashes($att) . ';' . PHP_EOL;
+    }
 }
 
 // Function to advance a set of columns corresponding to attributes.
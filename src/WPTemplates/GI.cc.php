@@ -51,6 +51,34 @@ int GIProduceChunkWorkFunc_<?=$wpName?> ( WorkDescription &workDescription, Exec
     Chunk chunk;
 
     PROFILING2_START;
+<?  if( $type->produce_chunk() ) { ?>
+    // The GI fills the columns itself
+<?      foreach($outputs as $att){ ?>
+    Column <?=$att->name()?>_Column_Ocol;
+<?      } ?>
+
+    size_t tuple_count = 0;
+    bool stream_done = !my_state->ProduceChunk( tuple_count, <?=join(array_map( function($el){ return $el->name() . '_Column_Ocol'; }, $outputs), ', ')?> );
+
+    // Once the stream is done the columns might not be there, use empty ones
+<?      foreach($outputs as $att){ ?>
+    if( ! <?=$att->name()?>_Column_Ocol.IsValid() ) {
+        MMappedStorage <?=$att->name()?>_Column_store;
+        Column <?=$att->name()?>_Column_Empty(<?=$att->name()?>_Column_store);
+        <?=$att->type()->iterator()?> <?=$att->name()?>_Column_Out(<?=$att->name()?>_Column_Empty);
+        <?=$att->name()?>_Column_Out.Done(<?=$att->name()?>_Column_Ocol);
+    }
+<?      } ?>
+
+    // Put the columns into the chunk.
+<?      foreach($outputs as $att){ ?>
+    {
+        int cSlot = <?=$att->slot()?>;
+
+        chunk.SwapColumn( <?=$att->name()?>_Column_Ocol, cSlot );
+    }
+<?      } ?>
+<?  } else { // tuple at a time ?>
     // Start new columns and allocate storage for them
 <?  cgConstructColumns($outputs); ?>
 
@@ -93,6 +121,7 @@ int GIProduceChunkWorkFunc_<?=$wpName?> ( WorkDescription &workDescription, Exec
         chunk.SwapColumn( <?=$att->name()?>_Column_Ocol, cSlot );
     }
 <?  } ?>
+<?  } // tuple at a time ?>
 
 
     PROFILING2_END;
@@ -571,6 +571,9 @@ function GLAGenerate_ProcessChunk( $wpName, $queries, $attMap ) {
 #include <map>
 #include <sstream>
 
+#include "EncodedRunIterator.h"
+#include "DictCodeIterator.h"
+
 //+{"kind":"WPF", "name":"Process Chunk", "action":"start"}
 extern "C"
 int GLAProcessChunkWorkFunc_<?=$wpName?>
@@ -601,7 +604,52 @@ int GLAProcessChunkWorkFunc_<?=$wpName?>
 
     FATALIF( queriesCovered.IsEmpty(), "Queries being run do not overlap queries known by this waypoint!" );
 
-<?  cgAccessColumns($attMap, 'input', $wpName); ?>
+<?
+    // Runs of tuples with equal values can be added to the GLAs at once if
+    // all the GLAs can add runs, their inputs only depend on the tuple, and
+    // the columns can be encoded with runs.
+    $useRuns = true;
+    foreach( $attMap as $att => $qry ) {
+        $useRuns = $useRuns && isRunAtt($att);
+    }
+    foreach( $queries as $query => $info ) {
+        $useRuns = $useRuns && $info['gla']->add_run();
+        foreach( $info['expressions'] as $exp ) {
+            $useRuns = $useRuns && $exp->is_deterministic();
+        }
+    }
+    $runAtts = $useRuns ? array_keys($attMap) : [];
+
+    // The tuples can be added a batch at a time, each GLA in its own loop over
+    // the contiguous values of the batch, if the columns are of native types and
+    // the order in which the GLAs see the inputs does not matter.
+    $useBatches = \count($attMap) > 0;
+    foreach( $attMap as $att => $qry ) {
+        $useBatches = $useBatches && isBatchAtt($att);
+    }
+    foreach( $queries as $query => $info ) {
+        foreach( $info['expressions'] as $exp ) {
+            $useBatches = $useBatches && $exp->is_deterministic();
+        }
+    }
+
+    // The GLAs that take a STRING input by code (GroupBy) get the chunk code of
+    // its column when the input is an attribute whose column is dictionary encoded.
+    $codeAtts = [];
+    foreach( $queries as $query => $info ) {
+        $pos = $info['gla']->code_input();
+        if( $pos === null ) continue;
+
+        $exps = array_values($info['expressions']);
+        $att = $exps[$pos]->value();
+        if( array_key_exists($att, $attMap) && isDictAtt($att) ) {
+            $codeAtts[$query] = $att;
+        }
+    }
+    $dictAtts = array_values(array_unique($codeAtts));
+
+    cgAccessColumns($attMap, 'input', $wpName, $runAtts, $dictAtts);
+?>
 
     // prepare bitstring iterator
     BStringIterator queries;
@@ -722,6 +770,82 @@ int GLAProcessChunkWorkFunc_<?=$wpName?>
     } // foreach query
 ?>
     int64_t numTuples = 0;
+<?  if( $useRuns ) { ?>
+    if( <?=cgRunsUsable($attMap)?> ) {
+        // The columns are encoded, add each run of equal tuples at once
+        while( !queries.AtEndOfColumn() ) {
+<?      cgRunLength($attMap, 'runLength', 3); ?>
+            numTuples += runLength;
+            QueryIDSet qry;
+            qry = queries.GetCurrent();
+            qry.Intersect(queriesToRun);
+
+<?
+        cgAccessRunAttributes($attMap, 3);
+        foreach( $queries as $query => $info ) {
+            $input = $info['expressions'];
+            $glaVar = $glaVars[$query];
+
+            $runArgs = array_map( 'strval', $input );
+            $runArgs[] = 'runLength';
+?>
+            // Do query <?=queryName($query)?>:
+            if( qry.Overlaps(<?=queryName($query)?>) ) {
+<?
+            cgDeclarePreprocessing($input, 4);
+?>
+                <?=$glaVar?>->AddRun( <?=implode(', ', $runArgs)?> );
+
+#ifdef PER_QUERY_PROFILE
+                numTuples_<?=queryName($query)?> += runLength;
+#endif // PER_QUERY_PROFILE
+            } // if query overlaps <?=queryName($query)?>.
+<?
+        } // foreach query
+
+        cgSkipRuns($attMap, 'runLength', 3);
+?>
+        } // while not at end of input
+    }
+
+<?  } // if runs can be used ?>
+<?  if( $useBatches ) { ?>
+    // Add the batches of contiguous tuples with the same queries, one GLA at a time
+    while( !queries.AtEndOfColumn() ) {
+<?      cgBatchLength($attMap, 'batchLength', 2); ?>
+        numTuples += batchLength;
+        QueryIDSet qry;
+        qry = queries.GetCurrent();
+        qry.Intersect(queriesToRun);
+
+<?
+        foreach( $queries as $query => $info ) {
+            $input = $info['expressions'];
+            $glaVar = $glaVars[$query];
+?>
+        // Do query <?=queryName($query)?>:
+        if( qry.Overlaps(<?=queryName($query)?>) ) {
+            for( uint64_t i = 0; i < batchLength; i++ ) {
+<?
+            cgAccessBatchAttributes($attMap, 'i', 4);
+            cgDeclarePreprocessing($input, 4);
+?>
+                <?=$glaVar?>->AddItem( <?=implode(', ', $input);?>);
+            }
+
+#ifdef PER_QUERY_PROFILE
+            numTuples_<?=queryName($query)?> += batchLength;
+#endif // PER_QUERY_PROFILE
+        } // if query overlaps <?=queryName($query)?>.
+<?
+        } // foreach query
+
+        cgSkipBatches($attMap, 'batchLength', 2);
+?>
+    } // while not at end of input
+
+<?  } // if batches can be used ?>
+    // Tuple by tuple, if the input was not processed as runs or batches above
     while( !queries.AtEndOfColumn() ) {
         ++numTuples;
         QueryIDSet qry;
@@ -743,8 +867,22 @@ int GLAProcessChunkWorkFunc_<?=$wpName?>
 <?
         // Declare preprocessing variables
         cgDeclarePreprocessing($input, 3);
+
+        if( array_key_exists($query, $codeAtts) ) {
+            $codes = attCodes($codeAtts[$query]);
+?>
+            if( <?=$codes?>.IsValid() ) {
+                <?=$glaVar?>->AddItemCode( <?=$codes?>.GetChunkCode(), <?=implode(', ', $input);?>);
+            } else {
+                <?=$glaVar?>->AddItem( <?=implode(', ', $input);?>);
+            }
+<?
+        } else {
 ?>
             <?=$glaVar?>->AddItem( <?=implode(', ', $input);?>);
+<?
+        } // if the GLA takes an input by code
+?>
 
 #ifdef PER_QUERY_PROFILE
             numTuples_<?=queryName($query)?>++;
@@ -753,7 +891,7 @@ int GLAProcessChunkWorkFunc_<?=$wpName?>
 <?
     } // foreach query
 
-    cgAdvanceAttributes($attMap, 2);
+    cgAdvanceAttributes($attMap, 2, $dictAtts);
 ?>
     } // while not at end of input
 
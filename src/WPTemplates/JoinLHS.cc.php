@@ -14,8 +14,71 @@ function JoinLHS($wpName, $jDesc){
     ksort($rhsAttOrder);
 
     $jDesc->hash_RHS_attr = $rhsAttOrder;
+
+    // radix mode: all LHS tuples of the chunk are hashed first and then probed grouped by
+    // the cache-sized region of the hash table they hit, instead of in input order
+    $radix = $jDesc->radix;
+
+    // number of LHS tuples hashed and prefetched ahead of the match loop; the radix mode
+    // already walks the table region by region, so it does not prefetch on top of that
+    $batch = $radix ? 0 : $jDesc->probe_batch;
+    $batchKeys = array_unique($jDesc->LHS_keys);
+
+    // the string keys are hashed by chunk code if their columns are dictionary encoded;
+    // the codes are read where the hashes are computed, the first pass of the radix
+    // mode, the refill of the batch or the match loop
+    $dictAtts = [];
+    foreach($jDesc->attribute_queries_LHS as $att => $qrys) {
+        if (isDictAtt($att) && in_array($att, $jDesc->LHS_keys)) {
+            $dictAtts[] = $att;
+        }
+    }
+
+    // where the LHS values of the tuple being matched come from: the input columns, or the
+    // values buffered by the first pass of the radix mode
+    $lhsVal = function($att) use ($radix) {
+        return $radix ? $att . '_Vals[tuplePos]' : attData($att) . '.GetCurrent()';
+    };
+
+    // query classes whose keys are all fixed-width words are matched by comparing the
+    // serialized words straight out of the hash table, without deserializing them
+    $wordClasses = [];
+    $wordAtts = [];
+    foreach($jDesc->queries_attribute_comparison as $i => $qClass) {
+        $isWord = \count($qClass->att_pairs) > 0;
+        foreach($qClass->att_pairs as $pair) {
+            $isWord = $isWord && isWordKeyAtt($pair->lhs) && isWordKeyAtt($pair->rhs)
+                && strval(attType($pair->lhs)) == strval(attType($pair->rhs));
+        }
+        if ($isWord) {
+            $wordClasses[$i] = (int) ceil(\count($qClass->att_pairs) / 4) * 4; // KEY_WORDS_BLOCK
+            foreach($qClass->att_pairs as $pair) {
+                $wordAtts[$pair->rhs] = true;
+            }
+        }
+    }
+
+    // RHS atts that still have to be deserialized: the ones copied to the output and
+    // the ones compared the generic way
+    $objAtts = [];
+    foreach($jDesc->attribute_queries_RHS_copy as $att => $queries) {
+        $objAtts[$att] = true;
+    }
+    foreach($jDesc->queries_attribute_comparison as $i => $qClass) {
+        if (!array_key_exists($i, $wordClasses)) {
+            foreach($qClass->att_pairs as $pair) {
+                $objAtts[$pair->rhs] = true;
+            }
+        }
+    }
 ?>
 
+// module specific headers to allow separate compilation
+#include "KeyMatch.h"
+#include "DictCodeIterator.h"
+#include <string>
+#include <vector>
+
 //+{"kind":"WPF", "name":"LHS Lookup", "action":"start"}
 extern "C"
 int JoinLHSWorkFunc_<?=$wpName?>(WorkDescription &workDescription, ExecEngineData &result) {
@@ -42,14 +105,21 @@ int JoinLHSWorkFunc_<?=$wpName?>(WorkDescription &workDescription, ExecEngineDat
 
     QueryIDSet queriesToRun = QueryExitsToQueries(myWork.get_whichQueryExits ());
 
-<?  cgAccessColumns($jDesc->attribute_queries_LHS, 'input', $wpName); ?>
+<?  cgAccessColumns($jDesc->attribute_queries_LHS, 'input', $wpName, [], $dictAtts); ?>
+<?  cgDeclareCodeHashes($dictAtts); ?>
 
     BStringIterator myInBStringIter;
     input.SwapBitmap (myInBStringIter);
 
     // start the iterators for the output columns for LHS; used only if stillShallow = 0
 <?  foreach($jDesc->attribute_queries_LHS_copy as $att => $queries){ ?>
+<?      if ($radix) { ?>
+    MMappedStorage <?=$att?>_Column_Out_store;
+    Column <?=$att?>_Column_Out_col (<?=$att?>_Column_Out_store);
+    <?=attIteratorType($att)?> <?=$att?>_Column_Out (<?=$att?>_Column_Out_col);
+<?      } else { ?>
     <?=attIteratorType($att)?> <?=$att?>_Column_Out;
+<?      } /*if radix*/ ?>
 <?  } /*foreach*/ ?>
 
     // these manage the output columns that come from the RHS (now stored in the hash table)
@@ -66,8 +136,12 @@ int JoinLHSWorkFunc_<?=$wpName?>(WorkDescription &workDescription, ExecEngineDat
     HashTableSegment myEntries[NUM_SEGS];
     myView.ExtractAllSegments (myEntries);
 
-    // this tells us that we are "still shallow"---not making a deep copy of the LHS atts to the output
-    int stillShallow = 1;
+    // number of probes into the segments of each NUMA node, so we can tell how many were remote
+    std::vector<int64_t> nodeProbes (numaNodeCount (), 0);
+
+    // this tells us that we are "still shallow"---not making a deep copy of the LHS atts to the output;
+    // the radix mode writes its output in partition order, so it always copies
+    int stillShallow = <?=$radix ? 0 : 1?>;
 
     // the bitstring that will be exracted from the hash table
     QueryIDSet *bitstringRHS = 0;
@@ -85,9 +159,124 @@ int JoinLHSWorkFunc_<?=$wpName?>(WorkDescription &workDescription, ExecEngineDat
     <?=attType($att)?> <?=$att?>RHSobj;
 <?  } /*foreach*/ ?>
 
+    // the keys compared as raw words point into the extracted tuple instead
+    VAL_TYPE keyWordShadow = 0;
+<?  foreach($wordAtts as $att => $dummy) { ?>
+    const VAL_TYPE *<?=$att?>RHSWord = &keyWordShadow;
+<?  } /*foreach*/ ?>
+<?  foreach($wordClasses as $i => $numWords) {
+        $qClass = $jDesc->queries_attribute_comparison[$i];
+?>
+
+    // masks of the key words of query class <?=$qClass->qClass?>
+
+    alignas(32) const VAL_TYPE keyMask<?=$i?>[<?=$numWords?>] = {
+<?      foreach($qClass->att_pairs as $pair) { ?>
+        KeyWordMask (sizeof (<?=attType($pair->lhs)?>)),
+<?      } /*foreach pair*/ ?>
+    };
+<?  } /*foreach word class*/ ?>
+
     // now actually try to match up all of the tuples!
     int totalNum = 0;
+
+    // so we can tell how often the probes below took the overflow slow path
+    uint64_t ovfLookups = Overflow::NumLookups ();
+<?  if ($batch > 0) { ?>
+
+    // batched probing: the hashes of the next <?=$batch?> LHS tuples are computed up
+    // front and their home slots are prefetched, so that the matching below finds
+    // them in cache instead of taking one miss per tuple
+    HT_INDEX_TYPE batchHashes[<?=$batch?>];
+    int batchPos = 0;
+    int batchLen = 0;
+<?  } /*if batch*/ ?>
+<?  if ($radix) { ?>
+
+    // radix mode, first pass: hash every active tuple and buffer its LHS values
+    std::vector<QueryIDSet> tupleBits;
+    std::vector<HT_INDEX_TYPE> tupleHashes;
+<?      foreach($jDesc->attribute_queries_LHS as $att => $qrys) { ?>
+    std::vector<<?=attType($att)?>> <?=$att?>_Vals;
+<?      } /*foreach*/ ?>
+    while (!myInBStringIter.AtEndOfColumn ()) {
+        QueryIDSet bits = myInBStringIter.GetCurrent ();
+        bits.Intersect (queriesToRun);
+
+        if (!bits.IsEmpty ()) {
+            HT_INDEX_TYPE hashValue = HASH_INIT;
+<?      foreach($jDesc->LHS_keys as $att) { ?>
+            hashValue = CongruentHash(<?=attHash($att, attData($att) . '.GetCurrent()', $dictAtts)?>, hashValue);
+<?      } /*foreach*/ ?>
+            tupleBits.push_back (bits);
+            tupleHashes.push_back (hashValue);
+<?      foreach($jDesc->attribute_queries_LHS as $att => $qrys) { ?>
+            <?=$att?>_Vals.push_back (<?=attData($att)?>.GetCurrent());
+<?      } /*foreach*/ ?>
+        }
+
+<?      foreach($jDesc->attribute_queries_LHS as $att => $qrys) { ?>
+        <?=attData($att)?>.Advance();
+<?      } /*foreach*/ ?>
+<?      cgAdvanceCodes($dictAtts, 2); ?>
+        myInBStringIter.Advance ();
+    }
+
+    // then partition the tuples by region of the hash table (a counting sort on the hash bits)
+    std::vector<int> partStart (NUM_SEGS * RADIX_NUM_PARTITIONS + 1, 0);
+    for (size_t i = 0; i < tupleHashes.size (); i++) {
+        partStart[WHICH_RADIX_PARTITION (tupleHashes[i]) + 1]++;
+    }
+    for (size_t i = 1; i < partStart.size (); i++) {
+        partStart[i] += partStart[i - 1];
+    }
+    std::vector<int> radixOrder (tupleHashes.size ());
+    for (size_t i = 0; i < tupleHashes.size (); i++) {
+        radixOrder[partStart[WHICH_RADIX_PARTITION (tupleHashes[i])]++] = i;
+    }
+
+    // second pass: match the tuples one partition after the other
+    for (size_t radixPos = 0; radixPos < radixOrder.size (); radixPos++) {
+        int tuplePos = radixOrder[radixPos];
+<?  } else { ?>
     while (!myInBStringIter.AtEndOfColumn ()) { // TBD, probably this is not working TBD
+<?  } /*if radix*/ ?>
+<?  if ($batch > 0) { ?>
+
+        // refill the batch; the iterators are rewound so the match loop sees the same tuples
+        if (batchPos == batchLen) {
+            myInBStringIter.CheckpointSave ();
+<?      foreach($batchKeys as $att) { ?>
+            <?=$att?>_Column.CheckpointSave ();
+<?      } /*foreach*/ ?>
+
+            for (batchLen = 0; batchLen < <?=$batch?> && !myInBStringIter.AtEndOfColumn (); batchLen++) {
+                QueryIDSet batchBits = myInBStringIter.GetCurrent ();
+                batchBits.Intersect (queriesToRun);
+
+                HT_INDEX_TYPE batchHash = HASH_INIT;
+                if (!batchBits.IsEmpty ()) {
+<?      foreach($jDesc->LHS_keys as $att) { ?>
+                    batchHash = CongruentHash(<?=attHash($att, attData($att) . '.GetCurrent()', $dictAtts)?>, batchHash);
+<?      } /*foreach*/ ?>
+                    myEntries[WHICH_SEGMENT (batchHash)].Prefetch (WHICH_SLOT (batchHash));
+                }
+                batchHashes[batchLen] = batchHash;
+
+<?      foreach($batchKeys as $att) { ?>
+                <?=$att?>_Column.Advance ();
+<?      } /*foreach*/ ?>
+<?      cgAdvanceCodes($dictAtts, 4); // only read here, they are not rewound ?>
+                myInBStringIter.Advance ();
+            }
+
+            myInBStringIter.CheckpointRestore ();
+<?      foreach($batchKeys as $att) { ?>
+            <?=$att?>_Column.CheckpointRestore ();
+<?      } /*foreach*/ ?>
+            batchPos = 0;
+        }
+<?  } /*if batch*/ ?>
 
         // counts how many matches for this query
         int numHits = 0;
@@ -96,8 +285,12 @@ int JoinLHSWorkFunc_<?=$wpName?>(WorkDescription &workDescription, ExecEngineDat
         // now go through the LHS input atts one at a time and extract if it is needed by an active query
 
         // see which queries match up
+<?  if ($radix) { ?>
+        QueryIDSet curBits = tupleBits[tuplePos];
+<?  } else { ?>
         QueryIDSet curBits = myInBStringIter.GetCurrent ();
         curBits.Intersect (queriesToRun);
+<?  } /*if radix*/ ?>
 
         QueryIDSet exists; // keeps track of the queries for which a match is found
         QueryIDSet oldBitstringLHS; // last value of bistringLHS
@@ -108,18 +301,44 @@ int JoinLHSWorkFunc_<?=$wpName?>(WorkDescription &workDescription, ExecEngineDat
 
             totalNum++;
 
+<?  if ($radix) { ?>
+            // the hash for LHS was computed by the first pass
+            HT_INDEX_TYPE hashValue = tupleHashes[tuplePos];
+<?  } else if ($batch > 0) { ?>
+            // the hash for LHS was computed when the batch was filled
+            HT_INDEX_TYPE hashValue = batchHashes[batchPos];
+<?  } else { ?>
             // compute the hash for LHS
             HT_INDEX_TYPE hashValue = HASH_INIT;
-<?  foreach($jDesc->LHS_keys as $att) { ?>
-            hashValue = CongruentHash(Hash(<?=$att?>_Column.GetCurrent()), hashValue);
-<?  } /*foreach*/ ?>
+<?      foreach($jDesc->LHS_keys as $att) { ?>
+            hashValue = CongruentHash(<?=attHash($att, attData($att) . '.GetCurrent()', $dictAtts)?>, hashValue);
+<?      } /*foreach*/ ?>
+<?  } /*if batch*/ ?>
 
-            // figure out which of the hash buckets it goes into
+<?  foreach($wordClasses as $i => $numWords) {
+        $qClass = $jDesc->queries_attribute_comparison[$i];
+?>
+            // LHS keys of query class <?=$qClass->qClass?> laid out as hash table words
+            alignas(32) VAL_TYPE lhsWords<?=$i?>[<?=$numWords?>] = { 0 };
+<?      foreach($qClass->att_pairs as $j => $pair) { ?>
+            memcpy (&lhsWords<?=$i?>[<?=$j?>], &<?=$lhsVal($pair->lhs)?>, sizeof (<?=attType($pair->lhs)?>));
+<?      } /*foreach pair*/ ?>
+<?  } /*foreach word class*/ ?>
+
+            // figure out which of the hash buckets it goes into; only the tuples with the same
+            // fingerprint can match (if the entries are compact, the others are passed over)
             unsigned int index = WHICH_SEGMENT (hashValue);
+            int fingerprint = HASH_FINGERPRINT (hashValue);
 
-            // now, go to that index and extract matching tuples!
-            HT_INDEX_TYPE curSlot = WHICH_SLOT (hashValue);
+            // now, go to that index and extract matching tuples! (from the new version of the
+            // segment if the cleaner already moved them there)
+            int pinnedRange;
+            HashTableSegment &probeMe = myEntries[index].StartProbe (WHICH_SLOT (hashValue), pinnedRange);
+            HT_INDEX_TYPE curSlot = probeMe.HomeSlot (WHICH_SLOT (hashValue));
             hashValue = curSlot;
+            if (myEntries[index].GetNode () >= 0) {
+                nodeProbes[myEntries[index].GetNode ()]++;
+            }
 
             // this loops through all of the possible RHS hits
             while (1) {
@@ -136,6 +355,9 @@ int JoinLHSWorkFunc_<?=$wpName?>(WorkDescription &workDescription, ExecEngineDat
 <?  foreach($jDesc->hash_RHS_attr as $att) { ?>
                 <?=$att?>RHS = &<?=$att?>RHSShadow;
 <?  } /*foreach*/ ?>
+<?  foreach($wordAtts as $att => $dummy) { ?>
+                <?=$att?>RHSWord = &keyWordShadow;
+<?  } /*foreach*/ ?>
 
                 // here we go through and extract the atts one at a time from the hash
                 // table.  Note that the atts must be extracted IN ORDER.  That is, the
@@ -144,7 +366,7 @@ int JoinLHSWorkFunc_<?=$wpName?>(WorkDescription &workDescription, ExecEngineDat
 
                 // The Extract function pulls an attribute out of the hash table...
                 int lenSoFar = 0, dummy, done;
-                int lastLen = myEntries[index].Extract (serializeHere, curSlot, hashValue, wayPointID, BITMAP, dummy, done);
+                int lastLen = probeMe.Extract (serializeHere, curSlot, hashValue, wayPointID, fingerprint, BITMAP, dummy, done);
 
                 // if we cannot find a bitstring, there was no tuple here, and we are done
                 if (lastLen == 0) {
@@ -157,13 +379,18 @@ int JoinLHSWorkFunc_<?=$wpName?>(WorkDescription &workDescription, ExecEngineDat
 
                 // next look for other hashed attributes
 <?  foreach($jDesc->hash_RHS_attr as $att) { ?>
-                lastLen = myEntries[index].Extract (serializeHere + lenSoFar, curSlot, hashValue, wayPointID, <?=attSlot($att)?>, dummy, done);
+                lastLen = probeMe.Extract (serializeHere + lenSoFar, curSlot, hashValue, wayPointID, fingerprint, <?=attSlot($att)?>, dummy, done);
 
                 // see if we got attribute
                 if (lastLen > 0) {
+<?      if (array_key_exists($att, $objAtts) || !array_key_exists($att, $wordAtts)) { ?>
                     Deserialize(serializeHere + lenSoFar, <?=$att?>RHSobj);
                     //<?=attOptimizedDeserialize($att, $att."RHSobj", "serializeHere", "lenSoFar")?>;
                     <?=$att?>RHS = &<?=$att?>RHSobj;
+<?      } /*if deserialized*/ ?>
+<?      if (array_key_exists($att, $wordAtts)) { ?>
+                    <?=$att?>RHSWord = (const VAL_TYPE *) (serializeHere + lenSoFar);
+<?      } /*if word key*/ ?>
                     lenSoFar += lastLen;
                 } else {
                     FATALIF(<?=attQrys($att)?>_RHS.Overlaps(*bitstringRHS),
@@ -176,20 +403,31 @@ int JoinLHSWorkFunc_<?=$wpName?>(WorkDescription &workDescription, ExecEngineDat
                 QueryIDSet qBits;
                 //printf("TPLLLLL: cust_acctbal = %f    orders_custkey = %d   cust_custkey = %d\n", *customer_c_acctbalRHS, orders_o_custkey_Column.GetCurrent(), *customer_c_custkeyRHS);
 
-<? foreach($jDesc->queries_attribute_comparison as $qClass) { ?>
+<? foreach($jDesc->queries_attribute_comparison as $i => $qClass) { ?>
                 // See if any query in query class is eligible for this comparision
                 qBits = QueryIDSet(<?=$qClass->qClass?>, true);
                 qBits.Intersect(*bitstringRHS);
+<?  if (array_key_exists($i, $wordClasses)) { ?>
+                if (!qBits.IsEmpty ()) {
+                    alignas(32) VAL_TYPE rhsWords[<?=$wordClasses[$i]?>] = { 0 };
+<?      foreach($qClass->att_pairs as $j => $pair) { ?>
+                    rhsWords[<?=$j?>] = *<?=$pair->rhs?>RHSWord;
+<?      } /*foreach pair*/ ?>
+                    if (KeyWordsEqual (rhsWords, lhsWords<?=$i?>, keyMask<?=$i?>, <?=$wordClasses[$i]?>))
+                        bitstringLHS.Union (qBits);
+                }
+<?  } else { ?>
                 if (
                     !qBits.IsEmpty () &&
 
     <? foreach($qClass->att_pairs as $pair) { ?>
-                     *<?=$pair->rhs?>RHS == <?=$pair->lhs?>_Column.GetCurrent() &&
+                     *<?=$pair->rhs?>RHS == <?=$lhsVal($pair->lhs)?> &&
     <? } /*foreach pair*/?>
                      1 )
                 {
                     bitstringLHS.Union (qBits);
                 }
+<?  } /*if word class*/ ?>
 <? } /*foreach query class*/ ?>
 
                 // if any of them hit...
@@ -215,7 +453,7 @@ int JoinLHSWorkFunc_<?=$wpName?>(WorkDescription &workDescription, ExecEngineDat
                     // that get copied into output atts
                     if (!stillShallow) {
 <? foreach($jDesc->attribute_queries_LHS_copy as $att => $qrys) { ?>
-                        <?=attData($att)?>_Out.Insert (<?=attData($att)?>.GetCurrent());
+                        <?=attData($att)?>_Out.Insert (<?=$lhsVal($att)?>);
                         <?=attData($att)?>_Out.Advance();
 
 <? } /*foreach*/ ?>
@@ -236,6 +474,8 @@ int JoinLHSWorkFunc_<?=$wpName?>(WorkDescription &workDescription, ExecEngineDat
                     oldBitstringLHS=bitstringLHS;
                 }  // empty bistring
             }
+
+            myEntries[index].EndProbe (pinnedRange);
         }
 
     // compute the true exist queries
@@ -275,14 +515,35 @@ int JoinLHSWorkFunc_<?=$wpName?>(WorkDescription &workDescription, ExecEngineDat
                myOutBStringIter.Advance ();
         }
         }
+<?  if ($radix) { ?>
+
+        // a not exists result without any match still needs its row of values, since
+        // the radix mode is never shallow
+        if (numHits == 0 && !oldBitstringLHS.IsEmpty()) {
+<? foreach($jDesc->attribute_queries_LHS_copy as $att => $qrys) { ?>
+            <?=attData($att)?>_Out.Insert (<?=$lhsVal($att)?>);
+            <?=attData($att)?>_Out.Advance();
+<? } /*foreach*/ ?>
+<? foreach($jDesc->attribute_queries_RHS_copy as $att => $qrys) { ?>
+            <?=attType($att)?> tmp_<?=attData($att)?>;
+            <?=attData($att)?>_Out.Insert (tmp_<?=attData($att)?>);
+            <?=attData($att)?>_Out.Advance();
+<? } /*foreach*/ ?>
+        }
+<?  } else { ?>
 
         // lastly, we need to advance in the INPUT tuples
 <? foreach($jDesc->attribute_queries_LHS as $att => $qrys) { ?>
         <?=attData($att)?>.Advance();
 <? } /*foreach*/ ?>
+<?      if ($batch == 0) cgAdvanceCodes($dictAtts, 2); ?>
 
         // advance the input bitstring
         myInBStringIter.Advance ();
+<?  } /*if radix*/ ?>
+<?  if ($batch > 0) { ?>
+        batchPos++;
+<?  } /*if batch*/ ?>
     }
 
     // DONE!  So construct the output tuple
@@ -328,6 +589,18 @@ int JoinLHSWorkFunc_<?=$wpName?>(WorkDescription &workDescription, ExecEngineDat
     PCounterList counterList;
     PCounter totalCnt("tpi lhs", totalNum, "<?=$wpName?>");
     counterList.Append(totalCnt);
+    PCounter ovfLkpCnt("ovf lkp", Overflow::NumLookups () - ovfLookups, "<?=$wpName?>");
+    counterList.Append(ovfLkpCnt);
+    int myNode = numaCurrentNode ();
+    int64_t remoteProbes = 0;
+    for (int node = 0; node < nodeProbes.size (); node++) {
+        PCounter nodeCnt("prb node" + std::to_string (node), nodeProbes[node], "<?=$wpName?>");
+        counterList.Append(nodeCnt);
+        if (node != myNode)
+            remoteProbes += nodeProbes[node];
+    }
+    PCounter remoteCnt("prb remote", remoteProbes, "<?=$wpName?>");
+    counterList.Append(remoteCnt);
 
     PROFILING2_SET(counterList, "<?=$wpName?>");
 
@@ -77,7 +77,7 @@ int JoinLHSHashWorkFunc_<?=$wpName?> (WorkDescription &workDescription, ExecEngi
         void *location = (void*)&qry;
 
         // remember the serialized value
-        serializedSegments[index].StartNew (WHICH_SLOT (hashValue), wayPointID, 0, location, bytesUsed);
+        serializedSegments[index].StartNew (WHICH_SLOT (hashValue), wayPointID, 0, location, bytesUsed, HASH_FINGERPRINT (hashValue));
 
         // now, go thru all of the attributes that are used
 <? foreach($jDesc->LHS_hash as $att) { ?>
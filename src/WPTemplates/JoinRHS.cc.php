@@ -6,8 +6,27 @@
 
 function JoinRHS($wpName, $jDesc){
 
+    // insert into shared segments rather than checking them out one at a time
+    $concurrent = $jDesc->concurrent_build;
+
+    // group the tuples by region of the segment before inserting them
+    $radix = $jDesc->radix;
+
+    // the string keys are hashed by chunk code if their columns are dictionary encoded
+    $dictAtts = [];
+    foreach($jDesc->attribute_queries_RHS as $att => $qrys) {
+        foreach($jDesc->query_classes_hash as $qClass) {
+            if (isDictAtt($att) && in_array($att, $qClass->rhs_keys) && !in_array($att, $dictAtts)) {
+                $dictAtts[] = $att;
+            }
+        }
+    }
 ?>
 
+// module specific headers to allow separate compilation
+#include "JoinFilterRegistry.h"
+#include "DictCodeIterator.h"
+
 //+{"kind":"WPF", "name":"RHS Hash", "action":"start"}
 extern "C"
 int JoinRHSWorkFunc_<?=$wpName?> (WorkDescription &workDescription, ExecEngineData &result) {
@@ -33,7 +52,8 @@ int JoinRHSWorkFunc_<?=$wpName?> (WorkDescription &workDescription, ExecEngineDa
 
     QueryIDSet queriesToRun = QueryExitsToQueries(myWork.get_whichQueryExits ());
 
-<?  cgAccessColumns($jDesc->attribute_queries_RHS, 'input', $wpName); ?>
+<?  cgAccessColumns($jDesc->attribute_queries_RHS, 'input', $wpName, [], $dictAtts); ?>
+<?  cgDeclareCodeHashes($dictAtts); ?>
 
     // prepare bitstring iterator
     Column inBitCol;
@@ -42,6 +62,9 @@ int JoinRHSWorkFunc_<?=$wpName?> (WorkDescription &workDescription, ExecEngineDa
 
     int totalNum = 0; // counter for the tuples processed
 
+    // every key hashed here also goes in the Bloom filter that the LHS selections probe
+    BloomFilter &joinFilter = JoinFilterRegistry::GetRegistry ().GetFilter ("<?=$wpName?>");
+
     // now actually hash all of the tuples!
     while (!queries.AtEndOfColumn ()){
         QueryIDSet qry;
@@ -53,7 +76,7 @@ int JoinRHSWorkFunc_<?=$wpName?> (WorkDescription &workDescription, ExecEngineDa
 <? cgAccessAttributes($jDesc->attribute_queries_RHS); ?>
 
          if (qry.IsEmpty()){
-<?     cgAdvanceAttributes($jDesc->attribute_queries_RHS); ?>
+<?     cgAdvanceAttributes($jDesc->attribute_queries_RHS, 1, $dictAtts); ?>
              continue;
          }
 
@@ -74,8 +97,9 @@ int JoinRHSWorkFunc_<?=$wpName?> (WorkDescription &workDescription, ExecEngineDa
 
             HT_INDEX_TYPE hashValue = HASH_INIT;
     <? foreach($qClass->rhs_keys as $att) { ?>
-            hashValue = CongruentHash(Hash(<?=$att?>), hashValue);
+            hashValue = CongruentHash(<?=attHash($att, $att, $dictAtts)?>, hashValue);
     <? } /*foreach attribute*/ ?>
+            joinFilter.Insert (hashValue);
 
             // figure out which of the hash buckets it goes into
             unsigned int index = WHICH_SEGMENT (hashValue);
@@ -98,7 +122,7 @@ int JoinRHSWorkFunc_<?=$wpName?> (WorkDescription &workDescription, ExecEngineDa
             void *location = (void*)&myInBString;
 
             // remember the serialized value
-            serializedSegments[index].StartNew (WHICH_SLOT (hashValue), wayPointID, 1, location, bytesUsed);
+            serializedSegments[index].StartNew (WHICH_SLOT (hashValue), wayPointID, 1, location, bytesUsed, HASH_FINGERPRINT (hashValue));
 
             // now, go thru all of the attributes that are used
 <?      foreach($attOrder as $att => $slot) {
@@ -124,12 +148,19 @@ int JoinRHSWorkFunc_<?=$wpName?> (WorkDescription &workDescription, ExecEngineDa
 
 <? } /*foreach query class*/ ?>
 <? /* Is this correct. Should it be inside the loop for the class? */ ?>
-<?     cgAdvanceAttributes($jDesc->attribute_queries_RHS); ?>
+<?     cgAdvanceAttributes($jDesc->attribute_queries_RHS, 1, $dictAtts); ?>
     }
 
     // now we are done serializing the chunk
     free (serializeHere);
 
+<?  if ($radix) { ?>
+    // partition every segment's tuples by region, so each insert below sweeps its segment once
+    for (int i = 0; i < NUM_SEGS; i++) {
+        serializedSegments[i].RadixPartition ();
+    }
+
+<?  } /*if radix*/ ?>
     // so actually do the hashing... first set up the list of the guys we want to hash
     int theseAreOK [NUM_SEGS];
     for (int i = 0; i < NUM_SEGS; i++) {
@@ -139,16 +170,28 @@ int JoinRHSWorkFunc_<?=$wpName?> (WorkDescription &workDescription, ExecEngineDa
     // this is the set of sample collisions taken from the over-full segments
     HashSegmentSample mySamples;
 
+    // so we can tell how often the inserts below took the overflow slow path
+    uint64_t ovfRecorded = Overflow::NumRecorded ();
+    uint64_t ovfLookups = Overflow::NumLookups ();
+
     // now go through and, one-at-a-time, add the data to each table segment
     for (int i = 0; i < NUM_SEGS; i++) {
         // first get a segment to add data to
         HashTableSegment checkedOutCopy;
+<?  if ($concurrent) { ?>
+        int whichOne = myWork.get_centralHashTable ().CheckOutShared (theseAreOK, checkedOutCopy);
+<?  } else { ?>
         int whichOne = myWork.get_centralHashTable ().CheckOutOne (theseAreOK, checkedOutCopy);
+<?  } /*if concurrent*/ ?>
         theseAreOK[whichOne] = 0;
 
         // now add the data
         HashSegmentSample mySample;
+<?  if ($concurrent) { ?>
+        if (checkedOutCopy.InsertConcurrent (serializedSegments[whichOne], mySample)) {
+<?  } else { ?>
         if (checkedOutCopy.Insert (serializedSegments[whichOne], mySample)) {
+<?  } /*if concurrent*/ ?>
 
             // if we are in here, it means that the segment was over-full, so note that we will
             // need to empty it out... we record all of the samples
@@ -158,7 +201,11 @@ int JoinRHSWorkFunc_<?=$wpName?> (WorkDescription &workDescription, ExecEngineDa
         }
 
         // and then put the segment back in the hash table
+<?  if ($concurrent) { ?>
+        myWork.get_centralHashTable ().CheckInShared (whichOne);
+<?  } else { ?>
         myWork.get_centralHashTable ().CheckIn (whichOne);
+<?  } /*if concurrent*/ ?>
     }
 
 <?  cgPutbackColumns($jDesc->attribute_queries_RHS, 'input', $wpName); ?>
@@ -175,6 +222,10 @@ int JoinRHSWorkFunc_<?=$wpName?> (WorkDescription &workDescription, ExecEngineDa
     counterList.Append(totalCnt);
     PCounter globalCnt("jRHS", totalNum, "global");
     counterList.Append(globalCnt);
+    PCounter ovfRecCnt("ovf rec", Overflow::NumRecorded () - ovfRecorded, "<?=$wpName?>");
+    counterList.Append(ovfRecCnt);
+    PCounter ovfLkpCnt("ovf lkp", Overflow::NumLookups () - ovfLookups, "<?=$wpName?>");
+    counterList.Append(ovfLkpCnt);
 
     PROFILING2_SET(counterList, "<?=$wpName?>");
 
@@ -11,6 +11,7 @@ function PrintGenerate($wpName, $queries, $attMap){
 #include <iostream>
 #include <string.h>
 #include "Profiling.h"
+#include "ColumnarFile.h"
 
 //+{"kind":"WPF", "name":"Process Chunk", "action":"start"}
 extern "C"
@@ -48,7 +49,11 @@ int PrintWorkFunc_<?=$wpName?> (WorkDescription &workDescription, ExecEngineData
     Json::Value jsonRow;
     Json::FastWriter jsonWriter;
     std::string jsonString;
-<?      } // if type is json ?>
+<?      } // if type is json
+        else if( $type == 'columnar' ) {
+?>
+    ColumnarBatch batch_<?=queryName($query)?>(<?=count($val["expressions"])?>);
+<?      } // if type is columnar ?>
 
     PrintFileObj& pfo_<?=queryName($query)?> = streams.Find(<?=queryName($query)?>);
     DistributedCounter* counter_<?=queryName($query)?> = counters.Find(<?=queryName($query)?>);
@@ -77,7 +82,8 @@ int PrintWorkFunc_<?=$wpName?> (WorkDescription &workDescription, ExecEngineData
     foreach($queries as $query=>$val){ ?>
         // execute <?=queryName($query)?> code
         if (qry.Overlaps(<?=queryName($query)?>) && counter_<?=queryName($query)?>->Decrement(1)>=0){
-<?      cgPreprocess($val); ?>
+<?      cgPreprocess($val);
+        $type = $val["type"]; ?>
 #ifdef PER_QUERY_PROFILE
             ++n_tuples_<?=queryName($query)?>;
 #endif // PER_QUERY_PROFILE
@@ -110,7 +116,23 @@ int PrintWorkFunc_<?=$wpName?> (WorkDescription &workDescription, ExecEngineData
 
             // Now we print the buffer
             fprintf(file_<?=queryName($query)?>, "%s", buffer);
-<?      } // if output file is csv ?>
+<?      } // if output file is csv
+        else if( $type == 'columnar' ) {
+            foreach($val["expressions"] as $i => $exp) {
+                $kind = grokit\columnarKind($exp->type());
+                grokit_assert($kind !== null, 'Type ' . $exp->type() . ' cannot be printed to a columnar file');
+?>
+            {
+                const <?=$exp->type()?>& colVal = <?=$exp->value()?>;
+<?              if( $kind == 'string' ) { ?>
+                batch_<?=queryName($query)?>.AddString(<?=$i?>, colVal.ToString(), colVal.Length(), ColumnarIsNull(colVal));
+<?              } else { ?>
+                batch_<?=queryName($query)?>.AddFixed(<?=$i?>, colVal, ColumnarIsNull(colVal));
+<?              } ?>
+            }
+<?          } // for each expression ?>
+            batch_<?=queryName($query)?>.EndTuple();
+<?      } // if output file is columnar ?>
         }
 <?  } // for each query ?>
 <?
@@ -120,6 +142,12 @@ int PrintWorkFunc_<?=$wpName?> (WorkDescription &workDescription, ExecEngineData
 
 <?  cgPutbackColumns($attMap, 'input', $wpName); ?>
 
+<?  foreach($queries as $query=>$val){
+        if( $val["type"] == 'columnar' ) { ?>
+    batch_<?=queryName($query)?>.Write(file_<?=queryName($query)?>);
+<?      } // if output file is columnar
+    } // for each query ?>
+
     PROFILING2_END;
 
     PCounterList counterList;
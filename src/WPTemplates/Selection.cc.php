@@ -4,7 +4,7 @@
 
 /* function to instantiate a Selection waypoint */
 
-function SelectionGenerate($wpName, $queries, $attMap) {
+function SelectionGenerate($wpName, $queries, $attMap, $joinFilter = null) {
 
     //echo PHP_EOL . '/*' . PHP_EOL;
     //print_r($wpName);
@@ -16,6 +16,9 @@ function SelectionGenerate($wpName, $queries, $attMap) {
 // module specific headers to allow separate compilation
 #include "GLAData.h"
 #include "Errors.h"
+#include "JoinFilterRegistry.h"
+#include "EncodedRunIterator.h"
+#include "DictCodeIterator.h"
 
 //+{"kind":"WPF", "name":"Pre-Processing", "action":"start"}
 extern "C"
@@ -127,7 +130,49 @@ int SelectionProcessChunkWorkFunc_<?=$wpName?> (WorkDescription &workDescription
     QueryIDSet queriesToRun = QueryExitsToQueries(myWork.get_whichQueryExits ());
 <?
     cgDeclareQueryIDs($queries);
-    cgAccessColumns($attMap, 'input', $wpName);
+
+    // The predicates can be evaluated once for a run of tuples with equal values
+    // if they only depend on the tuple and nothing else is computed per tuple
+    $useRuns = $joinFilter === null;
+    foreach( $attMap as $att => $qry ) {
+        $useRuns = $useRuns && isRunAtt($att);
+    }
+    foreach( $queries as $query => $val ) {
+        $useRuns = $useRuns && $val['gf'] === null && \count($val['synths']) == 0;
+        foreach( $val['filters'] as $exp ) {
+            $useRuns = $useRuns && $exp->is_deterministic();
+        }
+    }
+    $runAtts = $useRuns ? array_keys($attMap) : [];
+
+    // Same for evaluating the predicates a batch at a time, each query in its own
+    // loop over the contiguous values of the batch, if the columns are of native types
+    $useBatches = $joinFilter === null && \count($attMap) > 0;
+    foreach( $attMap as $att => $qry ) {
+        $useBatches = $useBatches && isBatchAtt($att);
+    }
+    foreach( $queries as $query => $val ) {
+        $useBatches = $useBatches && $val['gf'] === null && \count($val['synths']) == 0;
+        foreach( $val['filters'] as $exp ) {
+            $useBatches = $useBatches && $exp->is_deterministic();
+        }
+    }
+
+    // A predicate on a single dictionary encoded string column can be evaluated
+    // once per distinct string of the chunk and looked up by code after that
+    $useCodes = $joinFilter === null && !$useRuns && \count($attMap) == 1;
+    foreach( $attMap as $att => $qry ) {
+        $useCodes = $useCodes && isDictAtt($att);
+    }
+    foreach( $queries as $query => $val ) {
+        $useCodes = $useCodes && $val['gf'] === null && \count($val['synths']) == 0;
+        foreach( $val['filters'] as $exp ) {
+            $useCodes = $useCodes && $exp->is_deterministic();
+        }
+    }
+    $dictAtts = $useCodes ? array_keys($attMap) : [];
+
+    cgAccessColumns($attMap, 'input', $wpName, $runAtts, $dictAtts);
 
     // Declare the constants needed by the filters and synth expressions.
     foreach( $queries as $query => $val ) {
@@ -142,6 +187,44 @@ int SelectionProcessChunkWorkFunc_<?=$wpName?> (WorkDescription &workDescription
     } // foreach query
 ?>
 
+<?
+    if( $joinFilter !== null ) {
+        $filterKeys = array_unique($joinFilter['keys']);
+?>
+    // the join <?=$joinFilter['join']?> downstream publishes a Bloom filter over its RHS keys;
+    // tuples whose key is not in it cannot match and are dropped right here
+    QueryIDSet joinFilterQrys = queriesToRun;
+    joinFilterQrys.Difference(QueryIDSet(<?=$joinFilter['not_exists']?>, true));
+    const BloomFilter *joinFilter =
+        JoinFilterRegistry::GetRegistry().GetReady("<?=$joinFilter['join']?>", joinFilterQrys);
+<?
+        foreach( $filterKeys as $att ) {
+            if( array_key_exists($att, $attMap) ) {
+?>
+    if (!<?=attQrys($att)?>.Overlaps(queriesToRun))
+        joinFilter = nullptr; // column of <?=$att?> was not extracted
+<?
+            } else {
+?>
+    // extracting <?=$att?> for the join filter:
+    Column <?=attCol($att)?>;
+    if (joinFilter != nullptr) {
+        input.SwapColumn(<?=attCol($att)?>, <?=attSlot($att)?>);
+        if (! <?=attCol($att)?>.IsValid()){
+            FATAL("Error: Column <?=$att?> not found in <?=$wpName?>\n");
+        }
+    }
+    <?=attIteratorType($att)?> <?=attData($att)?> (<?=attCol($att)?>);
+<?
+            } // if key not accessed already
+        } // foreach key
+?>
+    int64_t filterChecked = 0;
+    int64_t filterRejected = 0;
+
+<?
+    } // if join filter
+?>
     // prepare bitstring iterator
     Column inBitCol;
     BStringIterator queries;
@@ -232,6 +315,153 @@ int SelectionProcessChunkWorkFunc_<?=$wpName?> (WorkDescription &workDescription
 #endif // PER_QUERY_PROFILE
 
     int64_t numTuples = 0;
+<?  if( $useRuns ) { ?>
+    if( <?=cgRunsUsable($attMap)?> ) {
+        // The columns are encoded, evaluate the predicates once per run of equal tuples
+        while (!queries.AtEndOfColumn ()) {
+<?      cgRunLength($attMap, 'runLength', 3); ?>
+            numTuples += runLength;
+            QueryIDSet qry;
+            qry = queries.GetCurrent();
+            qry.Intersect(queriesToRun);
+
+<?
+        cgAccessRunAttributes($attMap, 3);
+        foreach($queries as $query => $val) {
+            $filters = $val['filters'];
+
+            $filterVals = array_map( function($expr) { return '('. $expr . ')'; }, $filters );
+            $selExpr = \count($filterVals) > 0 ? implode( ' && ', $filterVals ) : 'true';
+?>
+            // do <?=queryName($query)?>:
+            if( qry.Overlaps(<?=queryName($query)?>) ) {
+#ifdef PER_QUERY_PROFILE
+                numTuples_<?=queryName($query)?> += runLength;
+#endif // PER_QUERY_PROFILE
+<?          cgDeclarePreprocessing($filters, 4); ?>
+                if( !( <?=$selExpr?> ) ) {
+                    qry.Difference(<?=queryName($query)?>);
+                }
+            }
+<?
+        } // foreach query
+?>
+            for (uint64_t i = 0; i < runLength; i++) {
+                outQueries.Insert(qry);
+                outQueries.Advance();
+            }
+
+<?      cgSkipRuns($attMap, 'runLength', 3); ?>
+        } // while we still have runs remaining
+    }
+
+<?  } // if runs can be used ?>
+<?  if( $useCodes ) {
+        $att = $dictAtts[0];
+        $codes = attCodes($att);
+?>
+    if( <?=attQrys($att)?>.Overlaps(queriesToRun) && <?=$codes?>.IsValid() ) {
+        // The column is dictionary encoded, evaluate the predicates once per code
+        // of the chunk: -1 not evaluated yet, 0 false, 1 true
+<?      foreach($queries as $query => $val) { ?>
+        std::vector<int8_t> <?=queryName($query)?>_results;
+<?      } // foreach query ?>
+        while (!queries.AtEndOfColumn ()) {
+            ++numTuples;
+            QueryIDSet qry;
+            qry = queries.GetCurrent();
+            qry.Intersect(queriesToRun);
+            queries.Advance();
+
+            FATALIF(<?=$codes?>.AtEnd(), "Dictionary encoded column shorter than the bitstring");
+            uint32_t code = <?=$codes?>.GetChunkCode();
+<?      foreach($queries as $query => $val) { ?>
+            if (code == <?=queryName($query)?>_results.size())
+                <?=queryName($query)?>_results.push_back(-1);
+<?      } // foreach query ?>
+
+<?
+        foreach($queries as $query => $val) {
+            $filters = $val['filters'];
+
+            $filterVals = array_map( function($expr) { return '('. $expr . ')'; }, $filters );
+            $selExpr = \count($filterVals) > 0 ? implode( ' && ', $filterVals ) : 'true';
+?>
+            // do <?=queryName($query)?>:
+            if( qry.Overlaps(<?=queryName($query)?>) ) {
+#ifdef PER_QUERY_PROFILE
+                ++numTuples_<?=queryName($query)?>;
+#endif // PER_QUERY_PROFILE
+                int8_t& result = <?=queryName($query)?>_results[code];
+                if (result < 0) {
+                    <?=attType($att)?> <?=$att?>;
+                    <?=$att?>.Deserialize(<?=$codes?>.GetChunkEntry(code));
+<?          cgDeclarePreprocessing($filters, 5); ?>
+                    result = ( <?=$selExpr?> ) ? 1 : 0;
+                }
+                if( !result ) {
+                    qry.Difference(<?=queryName($query)?>);
+                }
+            }
+<?
+        } // foreach query
+?>
+            outQueries.Insert(qry);
+            outQueries.Advance();
+            <?=$codes?>.Advance();
+        } // while we still have tuples remaining
+    }
+
+<?  } // if codes can be used ?>
+<?  if( $useBatches ) { ?>
+    // Evaluate the predicates on batches of contiguous tuples with the same queries,
+    // one query at a time, then write the bitstrings of the batch
+    QueryIDSet batchQueries[COLUMN_BATCH_SIZE];
+    while (!queries.AtEndOfColumn ()) {
+<?      cgBatchLength($attMap, 'batchLength', 2); ?>
+        numTuples += batchLength;
+        QueryIDSet qry;
+        qry = queries.GetCurrent();
+        qry.Intersect(queriesToRun);
+
+        for (uint64_t i = 0; i < batchLength; i++)
+            batchQueries[i] = qry;
+
+<?
+        foreach($queries as $query => $val) {
+            $filters = $val['filters'];
+
+            $filterVals = array_map( function($expr) { return '('. $expr . ')'; }, $filters );
+            $selExpr = \count($filterVals) > 0 ? implode( ' && ', $filterVals ) : 'true';
+?>
+        // do <?=queryName($query)?>:
+        if( qry.Overlaps(<?=queryName($query)?>) ) {
+#ifdef PER_QUERY_PROFILE
+            numTuples_<?=queryName($query)?> += batchLength;
+#endif // PER_QUERY_PROFILE
+            for (uint64_t i = 0; i < batchLength; i++) {
+<?
+            cgAccessBatchAttributes($attMap, 'i', 4);
+            cgDeclarePreprocessing($filters, 4);
+?>
+                if( !( <?=$selExpr?> ) ) {
+                    batchQueries[i].Difference(<?=queryName($query)?>);
+                }
+            }
+        }
+<?
+        } // foreach query
+?>
+        for (uint64_t i = 0; i < batchLength; i++) {
+            outQueries.Insert(batchQueries[i]);
+            outQueries.Advance();
+        }
+
+<?      cgSkipBatches($attMap, 'batchLength', 2); ?>
+    } // while we still have batches remaining
+
+<?  } // if batches can be used ?>
+    // Tuple by tuple, if the input was not processed as runs or batches above
     while (!queries.AtEndOfColumn ()) {
         ++numTuples;
         QueryIDSet qry;
@@ -296,6 +526,38 @@ int SelectionProcessChunkWorkFunc_<?=$wpName?> (WorkDescription &workDescription
 <?
         } // foreach synthesized attribute
     } // foreach query
+
+    if( $joinFilter !== null ) {
+?>
+        // probe the join filter with the hash the join itself will compute
+        if (joinFilter != nullptr) {
+            if (qry.Overlaps(joinFilterQrys)) {
+                ++filterChecked;
+                HT_INDEX_TYPE hashValue = HASH_INIT;
+<?
+        foreach( $joinFilter['keys'] as $att ) {
+?>
+                hashValue = CongruentHash(Hash(<?=attData($att)?>.GetCurrent()), hashValue);
+<?
+        } // foreach key
+?>
+                if (!joinFilter->MayContain(hashValue)) {
+                    ++filterRejected;
+                    qry.Difference(joinFilterQrys);
+                }
+            }
+<?
+        foreach( $filterKeys as $att ) {
+            if( !array_key_exists($att, $attMap) ) {
+?>
+            <?=attData($att)?>.Advance();
+<?
+            } // if key not accessed already
+        } // foreach key
+?>
+        }
+<?
+    } // if join filter
 ?>
         outQueries.Insert(qry);
         outQueries.Advance();
@@ -308,6 +570,19 @@ int SelectionProcessChunkWorkFunc_<?=$wpName?> (WorkDescription &workDescription
     // finally, if there were any results, put the data back in the chunk
 <?
     cgPutbackColumns($attMap, 'input', $wpName);
+    if( $joinFilter !== null ) {
+        foreach( $filterKeys as $att ) {
+            if( !array_key_exists($att, $attMap) ) {
+?>
+    // putting back column of <?=$att?>:
+    if (joinFilter != nullptr) {
+        <?=attData($att)?>.Done(<?=attCol($att)?>);
+        input.SwapColumn(<?=attCol($att)?>, <?=attSlot($att)?>);
+    }
+<?
+            } // if key not accessed already
+        } // foreach key
+    } // if join filter
     foreach( $queries as $query => $val ) {
         $synths = $val['synths'];
 ?>
@@ -352,6 +627,20 @@ int SelectionProcessChunkWorkFunc_<?=$wpName?> (WorkDescription &workDescription
 ?>
 #endif // PER_QUERY_PROFILE
 
+<?  if( $joinFilter !== null ) { ?>
+    if (joinFilter != nullptr) {
+        PCounter filterChkCnt("jfc", filterChecked, "<?=$wpName?>");
+        counterList.Append(filterChkCnt);
+        PCounter filterRejCnt("jfr", filterRejected, "<?=$wpName?>");
+        counterList.Append(filterRejCnt);
+
+        // rejection rate of the filter, in tenths of a percent
+        if (filterChecked > 0) {
+            int64_t rejectRate = filterRejected * 1000 / filterChecked;
+            PROFILING2_INSTANT("jfrr", rejectRate, "<?=$wpName?>");
+        }
+    }
+<?  } // if join filter ?>
     PROFILING2_SET(counterList, "<?=$wpName?>");
 
     ChunkContainer tempResult (input);
@@ -46,8 +46,30 @@ class HashTableCleanerWayPointImp : public WayPointImp {
         void SendDone (QueryExitContainer &theseAreDone);
 
         bool centralHashBuilt = false;
-        // function to build the central hash
-        void BuildCentralHash();
+        // function to build the central hash, with segments sized for rhsEntries hash table
+        // entries (the estimate the first join sent along)
+        void BuildCentralHash(int64_t rhsEntries);
+
+        // a segment that is being cleaned in ranges (see SegmentCleaning.h).  The lists are the
+        // ones GetOneToRebuild gave back for the segment; each range gets a copy of them
+        struct RangeCleaning {
+
+            // the next range to give to a worker, and the number of ranges not done yet;
+            // the segment is not being cleaned in ranges if rangesLeft is zero
+            int nextRange;
+            int rangesLeft;
+
+            JoinWayPointIDList removeTheseWPsAndHold;
+            QueryExitContainer theseQueriesAreDone;
+            JoinWayPointIDEquivalences equivalences;
+
+            RangeCleaning () : nextRange (0), rangesLeft (0) {}
+        };
+
+        RangeCleaning rangeCleaning[NUM_SEGS];
+
+        // sends the next range of the segment out to be cleaned, using the given token
+        void SendOutRange (int whichSegment, CPUWorkToken &myToken);
 
     public:
 
@@ -29,6 +29,7 @@ class TableWayPointImp : public WayPointImp {
 
         typedef DiskPool::ClusterRange ClusterRange;
         typedef DiskPool::ClusterRangeList ClusterRangeList;
+        typedef DiskPool::ZoneMapList ZoneMapList;
 
         //id of the FileScanner object
         TableScanID fileId;
@@ -61,7 +62,8 @@ class TableWayPointImp : public WayPointImp {
         // monitor number of token requests out to make sure we are as aggressive as we can
         int numRequestsOut;
 
-        // last chunk we generated to ensure a circular list behavior
+        // last chunk we generated to ensure a circular list behavior; the
+        // scan goes on after it, -1 before the first
         int lastChunkId;
 
         // number of chunks; used mostly to know what chunkID to generate
@@ -72,12 +74,27 @@ class TableWayPointImp : public WayPointImp {
 
         QueryToScannerRangeList queryClusterRanges;
 
+        // physical column of the clustering attribute, -1 if the relation is not
+        // clustered, and its zone maps; the ranges pushed down are on it
+        int clusterColumn;
+        ZoneMapList clusterZoneMaps;
+
         /// AUXILIARY FUNCTIONS
         // look for queries that can tag chunk _chunkId
         Bitstring FindQueries(off_t _chunkId);
+        // true if a tuple with a value of the clustering attribute in chunkRange
+        // and zone can be in the pushed-down ranges of query
+        bool QueryMayMatch(QueryID query, const ClusterRange& chunkRange, const ZoneMap& zone);
+        // moves from queries to filteredOut the queries that no tuple of chunk
+        // _chunkId can match, according to its cluster range and zone maps
+        void FilterQueries(off_t _chunkId, Bitstring& queries, Bitstring& filteredOut);
+        // finds the fragments of chunk _chunkId that can have tuples for queries
+        // returns false if there are no fragment zone maps or all the fragments can
+        bool FindFragments(off_t _chunkId, Bitstring queries, int& fragStart, int& fragEnd);
         // funtion to keep a constant suply of write tokens so we can do agressive IO
         void GenerateTokenRequests();
-        // function to find a chunk that needs to be generated
+        // function to find the next chunk that needs to be generated in the
+        // circular scan shared by the queries
         // returns "false" if no such chunk exists
         bool ChunkRequestIsPossible(off_t &_chunkId);
 
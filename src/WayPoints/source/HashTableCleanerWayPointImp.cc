@@ -35,9 +35,9 @@ HashTableCleanerWayPointImp :: HashTableCleanerWayPointImp () {
 
 HashTableCleanerWayPointImp :: ~HashTableCleanerWayPointImp () {}
 
-void HashTableCleanerWayPointImp :: BuildCentralHash(){
+void HashTableCleanerWayPointImp :: BuildCentralHash(int64_t rhsEntries){
     LOG_ENTRY(1, "Building Central Hash");
-    centralHashTable.Allocate(NUM_EXEC_ENGINE_THREADS);
+    centralHashTable.Allocate(NUM_EXEC_ENGINE_THREADS, HashTable::BitsFor(rhsEntries));
     HashTable hCopy;
     hCopy.copy(centralHashTable);
     metaData.AddCentralHashTable (hCopy);
@@ -153,6 +153,15 @@ void HashTableCleanerWayPointImp :: RequestGranted (GenericWorkToken &returnVal)
     CPUWorkToken myToken;
     myToken.swap (returnVal);
 
+    // the segments that are being cleaned in ranges come first, so that they are kept away
+    // from the readers as briefly as possible
+    for (int i = 0; i < NUM_SEGS; i++) {
+        if (rangeCleaning[i].rangesLeft && rangeCleaning[i].nextRange < CLEANER_NUM_RANGES) {
+            SendOutRange (i, myToken);
+            return;
+        }
+    }
+
     // now get all of the info we need to go out and process a hash table segment
     JoinWayPointIDList removeTheseWPsAndSend;
     JoinWayPointIDList removeTheseWPsAndHold;
@@ -176,6 +185,24 @@ void HashTableCleanerWayPointImp :: RequestGranted (GenericWorkToken &returnVal)
 
     //	cout << "About to clean segemnt " << whichSegment << "\n";
 
+    // if nothing is extracted, no writer will ack or drop anything, and the cleaned segment can
+    // go in as soon as it is built; in that case the segment is cleaned in ranges, in parallel,
+    // and the writers keep inserting into it in the meantime
+    removeTheseWPsAndSend.MoveToStart ();
+    if (CLEANER_NUM_RANGES > 1 && !removeTheseWPsAndSend.RightLength ()) {
+
+        RangeCleaning &job = rangeCleaning[whichSegment];
+        job.nextRange = 0;
+        job.rangesLeft = CLEANER_NUM_RANGES;
+        job.removeTheseWPsAndHold.swap (removeTheseWPsAndHold);
+        job.theseQueriesAreDone.swap (theseQueriesAreDone);
+        job.equivalences.swap (equivalences);
+        metaData.IsCleaningInRanges (whichSegment);
+
+        SendOutRange (whichSegment, myToken);
+        return;
+    }
+
     // figure out where the result of the work needs to be sent
     QueryExitContainer myOutputExits;
     for (removeTheseWPsAndSend.MoveToStart (); removeTheseWPsAndSend.RightLength (); removeTheseWPsAndSend.Advance ()) {
@@ -207,15 +234,48 @@ void HashTableCleanerWayPointImp :: RequestGranted (GenericWorkToken &returnVal)
     tempTable.Clone (centralHashTable);
 
     // set up the work description
-    HashCleanerWorkDescription workDesc (whichSegment, tempTable, useTheseTokens, removeTheseWPsAndSend,
+    HashCleanerWorkDescription workDesc (whichSegment, 0, 0, tempTable, useTheseTokens, removeTheseWPsAndSend,
             removeTheseWPsAndHold, theseQueriesAreDone, equivalences);
 
-    // now, get the work sent out!
+    // now, get the work sent out, to a worker on the node that holds the segment
     WorkFunc myFunc = GetWorkFunction (CleanerWorkFunc::type);
     WayPointID tempID = GetID ();
-    myCPUWorkers.DoSomeWork (tempID, tempList, myOutputExits, myToken, workDesc, myFunc);
+    myCPUWorkers.DoSomeWork (tempID, tempList, myOutputExits, myToken, workDesc, myFunc, SEGMENT_NODE (whichSegment));
 }
 
+void HashTableCleanerWayPointImp :: SendOutRange (int whichSegment, CPUWorkToken &myToken) {
+
+    RangeCleaning &job = rangeCleaning[whichSegment];
+    int whichRange = job.nextRange++;
+
+    // the lists for this range
+    JoinWayPointIDList removeTheseWPsAndSend;
+    JoinWayPointIDList removeTheseWPsAndHold;
+    removeTheseWPsAndHold.copy (job.removeTheseWPsAndHold);
+    QueryExitContainer theseQueriesAreDone;
+    theseQueriesAreDone.copy (job.theseQueriesAreDone);
+    JoinWayPointIDEquivalences equivalences;
+    equivalences.copy (job.equivalences);
+
+    // nothing is extracted, so there is no one to send the result to
+    QueryExitContainer myOutputExits;
+    DiskWorkTokenQueue useTheseTokens;
+
+    WayPointID myID = GetID ();
+    HashCleanerHistory myHistory (myID, whichSegment);
+    HistoryList tempList;
+    tempList.Insert (myHistory);
+
+    HashTable tempTable;
+    tempTable.Clone (centralHashTable);
+
+    HashCleanerWorkDescription workDesc (whichSegment, whichRange, CLEANER_NUM_RANGES, tempTable, useTheseTokens,
+            removeTheseWPsAndSend, removeTheseWPsAndHold, theseQueriesAreDone, equivalences);
+
+    WorkFunc myFunc = GetWorkFunction (CleanerWorkFunc::type);
+    WayPointID tempID = GetID ();
+    myCPUWorkers.DoSomeWork (tempID, tempList, myOutputExits, myToken, workDesc, myFunc, SEGMENT_NODE (whichSegment));
+}
 
 // these comparison funcs are used in the next routine
 int CompareFirst (const void *a, const void *b) {
@@ -231,13 +291,20 @@ void HashTableCleanerWayPointImp :: ProcessDirectMsg (DirectMsg &message) {
     PDEBUG("HashTableCleanerWayPointImp :: ProcessDirectMsg");
 
     if (!strcmp (message.get_message ().TypeName (), "GetHashTable")) {
+        GetHashTable myMsg;
+        myMsg.swap (message.get_message ());
+
+        // the first join decides the size the segments start out with; later ones can
+        // only make them grow
         if (!centralHashBuilt)
-            BuildCentralHash();
+            BuildCentralHash(myMsg.get_rhsEntries ());
+        else
+            centralHashTable.SizeFor (myMsg.get_rhsEntries ());
 
         HashTable centralHashCopy;
         centralHashCopy.Clone(centralHashTable);
         CentralHashMessage hashMessage(GetID(), centralHashCopy);
-        DirectMsg centralHashMsg (message.get_message().get_sender(), hashMessage);
+        DirectMsg centralHashMsg (myMsg.get_sender(), hashMessage);
         SendDirectMsg (centralHashMsg);
 
     } else if (!strcmp (message.get_message ().TypeName (), "QueryDoneMsg")) {
@@ -328,6 +395,10 @@ void HashTableCleanerWayPointImp :: ProcessDirectMsg (DirectMsg &message) {
         qsort (counts, len, sizeof (unsigned int) * 2, CompareFirst);
         cout << "After sorting...";
 
+        // while the segments can still grow, the cleaner makes room by doubling them instead
+        if (centralHashTable.CanGrow ())
+            notReallyFull = len;
+
         // now, loop through the waypoints once again and kill the worst offenders
         for (int i = 0; len - notReallyFull > len * FRAC_TO_TAKE_IT_DOWN; i += 2) {
 
@@ -375,6 +446,39 @@ void HashTableCleanerWayPointImp :: DoneProducing (QueryExitContainer &whichOnes
     // create a temporary result
     ExtractionContainer finalOutput;
 
+    // this is one range of a segment that is being cleaned in ranges; the worker that finished
+    // the last range sends the cleaned segment back, and it goes in once all ranges are back
+    int whichSegment = myResult.get_whichSegment ();
+    if (rangeCleaning[whichSegment].rangesLeft) {
+
+        if (myResult.get_newSegment ().IsAllocated ())
+            metaData.AllDone (myResult, finalOutput);
+
+        if (--rangeCleaning[whichSegment].rangesLeft == 0) {
+            QueryExitContainer theseAreDone;
+            metaData.ProcessEmptyResult (whichSegment, theseAreDone);
+
+            theseAreDone.MoveToStart ();
+            if (theseAreDone.RightLength ()) {
+                SendDone (theseAreDone);
+            }
+
+            RangeCleaning empty;
+            empty.removeTheseWPsAndHold.swap (rangeCleaning[whichSegment].removeTheseWPsAndHold);
+            empty.theseQueriesAreDone.swap (rangeCleaning[whichSegment].theseQueriesAreDone);
+            empty.equivalences.swap (rangeCleaning[whichSegment].equivalences);
+        }
+
+        // nothing goes anywhere; reuse the token for the next range or segment
+        ExecEngineData generic;
+        generic.swap (dataProduced);
+
+        GenericWorkToken putResHere;
+        ReclaimToken (putResHere);
+        RequestGranted (putResHere);
+        return;
+    }
+
     // extract the actual result
     metaData.AllDone (myResult, finalOutput);
 
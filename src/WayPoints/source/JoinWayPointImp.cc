@@ -18,6 +18,7 @@
 #include "CPUWorkerPool.h"
 #include "HashTableCleanerWayPointImp.h"
 #include "Properties.h"
+#include "JoinFilterRegistry.h"
 
 using namespace std;
 
@@ -48,6 +49,10 @@ void JoinWayPointImp :: ProcessDirectMsg (DirectMsg &message) {
         if (state == FINE) {
             state = DYING;
 
+            // the LHS may now run before the RHS is complete, so the selections upstream
+            // must stop trusting our key filter
+            JoinFilterRegistry::GetRegistry ().Disable (GetName ());
+
             // if we are now dying, we just go ahead and start up all of the LHS queries
             cout << "starting the following: \n";
             for (waitingOnRHS.MoveToStart (); waitingOnRHS.RightLength (); ) {
@@ -123,6 +128,9 @@ void JoinWayPointImp :: TypeSpecificConfigure (WayPointConfigureData &configData
     stillGoing.MoveToFinish ();
     stillGoing.SwapRights (endingOnes);
 
+    // make sure our key filter exists before any RHS chunk is hashed
+    JoinFilterRegistry::GetRegistry ().GetFilter (GetName ());
+
     // remember the identifier for the hash tbale cleaner
     hashTableCleaner = tempConfig.get_hashTableCleaner ();
 
@@ -131,8 +139,12 @@ void JoinWayPointImp :: TypeSpecificConfigure (WayPointConfigureData &configData
     myJoinWayPointID = HashTableCleanerWayPointImp :: metaData.NewJoinWaypoint (
             myID, tempConfig.get_myDiskBasedTwinID ());
 
-    if( !hashTableReady ) {
-        GetHashTable ght(GetID());
+    // the cleaner sizes the hash table segments for what the new queries will put in
+    if( hashTableReady ) {
+        centralHashTable.SizeFor (tempConfig.get_rhsEntries ());
+    }
+    else {
+        GetHashTable ght(GetID(), tempConfig.get_rhsEntries ());
 
         WayPointID cleanerID = hashTableCleaner;
         DirectMsg msg(cleanerID, ght);
@@ -207,6 +219,9 @@ void JoinWayPointImp :: ProcessHoppingDownstreamMsg (HoppingDownstreamMsg &messa
                     QueryExit tempExit;
                     temp.get_whichOnes ().Remove (tempExit);
 
+                    // all of its RHS keys are in the filter now, so the LHS may be filtered
+                    JoinFilterRegistry::GetRegistry ().MarkReady (GetName (), tempExit.query);
+
                     // there are two cases: either we have intercepted the LHS message matching this one, or not
                     // so we loop through all of the intercepted messages to try to find it
                     int foundAMate = 0;
@@ -277,6 +292,12 @@ void JoinWayPointImp :: ProcessHoppingDownstreamMsg (HoppingDownstreamMsg &messa
 
             }
 
+            // once nothing runs through us, the keys of the old queries can go
+            stillGoing.MoveToStart ();
+            if (!stillGoing.RightLength ()) {
+                JoinFilterRegistry::GetRegistry ().Reset (GetName ());
+            }
+
             // lastly, send out a query done message to all of the people down the graph
             temp.swap (message.get_msg ());
             SendHoppingDownstreamMsg (message);
@@ -24,6 +24,7 @@
 #include "EEExternMessages.h"
 #include "EventProcessor.h"
 #include "SerializeJson.h"
+#include "ColumnarFile.h"
 #include "Errors.h"
 
 #include "WPFExitCodes.h"
@@ -97,6 +98,27 @@ namespace {
         fprintf(file, "\n");
     }
 
+    void BeginColumnar( FILE * file, PrintFileInfo & info ) {
+        PrintHeader & header = info.get_header();
+
+        // the first row of the header names the columns
+        vector<string> names;
+        FOREACH_TWL(col, header) {
+            string name;
+            FOREACH_TWL(value, col) {
+                if( name.empty() )
+                    name = value;
+            } END_FOREACH;
+            names.push_back(name);
+        } END_FOREACH;
+
+        ColumnarWriteFileHeader(file, names);
+    }
+
+    void EndColumnar( PrintFileObj & info ) {
+        ColumnarWriteEnd(info.get_file());
+    }
+
     FILE * BeginFile( PrintFileInfo & info ) {
         string& fName = info.get_file();
         string& fType = info.get_type();
@@ -114,6 +136,9 @@ namespace {
         else if( fType == "json" ) {
             BeginJSON( str, info );
         }
+        else if( fType == "columnar" ) {
+            BeginColumnar( str, info );
+        }
         else {
             FATAL("File %s has unknown type %s in Print", fName.c_str(), fType.c_str());
         }
@@ -128,6 +153,8 @@ namespace {
             EndCSV( info );
         } else if( fType == "json" ) {
             EndJSON( info );
+        } else if( fType == "columnar" ) {
+            EndColumnar( info );
         } else {
             FATAL("File has unknown type %s in Print", fType.c_str());
         }
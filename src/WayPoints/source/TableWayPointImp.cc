@@ -17,6 +17,7 @@
 #include "TableWayPointImp.h"
 #include "Constants.h"
 #include "DiskPool.h"
+#include "DiskArray.h"
 #include "QueryManager.h"
 #include "Logging.h"
 #include "Profiling.h"
@@ -41,6 +42,78 @@ Bitstring TableWayPointImp::FindQueries(off_t _chunkId){
     return queryChunkMap->GetBits(_chunkId);
 }
 
+bool TableWayPointImp::QueryMayMatch(QueryID query, const ClusterRange& chunkRange, const ZoneMap& zone){
+    int64_t cMin = chunkRange.first;
+    int64_t cMax = chunkRange.second;
+    ClusterRangeList& qRanges = queryClusterRanges[query];
+
+    bool keep = qRanges.empty();
+
+    for( auto iter = qRanges.begin(); !keep && iter != qRanges.end(); iter++) {
+        int64_t min = iter->first;
+        int64_t max = iter->second;
+
+        /* This is a concise way of determining whether the intervals
+         * [min, max] and [cMin, cMax] intersect.
+         *
+         * Notice that if either interval is inverted, the intersection
+         * will also be inverted. An inverted chunk range is not known.
+         */
+        bool clusterKeep = cMin > cMax || std::min(max, cMax) >= std::max(min, cMin);
+
+        keep = clusterKeep && zone.MayContain(min, max);
+    }
+
+    return keep;
+}
+
+void TableWayPointImp::FilterQueries(off_t _chunkId, Bitstring& queries, Bitstring& filteredOut){
+    // chunks written after we started have no zone maps
+    ZoneMap noZone;
+    const ZoneMap& zone = _chunkId < (off_t) clusterZoneMaps.size() ?
+        clusterZoneMaps[_chunkId].column : noZone;
+
+    // Filter based on clustering
+    const ClusterRange& chunkRange = clusterRanges[_chunkId];
+    Bitstring bitIter = queries;
+    while( !bitIter.IsEmpty() ) {
+        QueryID qid = bitIter.GetFirst();
+
+        if( !QueryMayMatch(qid, chunkRange, zone) ) {
+            filteredOut.Union(qid);
+            queries.Difference(qid);
+        }
+    }
+}
+
+bool TableWayPointImp::FindFragments(off_t _chunkId, Bitstring queries, int& fragStart, int& fragEnd){
+    if( _chunkId >= (off_t) clusterZoneMaps.size() )
+        return false;
+
+    std::vector<ZoneMap>& fragZones = clusterZoneMaps[_chunkId].fragments;
+    const ClusterRange& chunkRange = clusterRanges[_chunkId];
+    int numFrags = fragZones.size();
+
+    fragStart = numFrags;
+    fragEnd = -1;
+    for( int frag = 0; frag < numFrags; frag++ ) {
+        Bitstring bitIter = queries;
+        bool keep = false;
+        while( !keep && !bitIter.IsEmpty() ) {
+            QueryID qid = bitIter.GetFirst();
+            keep = QueryMayMatch(qid, chunkRange, fragZones[frag]);
+        }
+
+        if( keep ) {
+            fragStart = std::min(fragStart, frag);
+            fragEnd = frag;
+        }
+    }
+
+    // the chunk zone map covers all fragments, so some fragment has to match
+    return fragEnd >= 0 && (fragStart > 0 || fragEnd < numFrags - 1);
+}
+
 TableWayPointImp :: TableWayPointImp () :
     WayPointImp(),
     fileId(),
@@ -52,10 +125,12 @@ TableWayPointImp :: TableWayPointImp () :
     qeCounters(),
     doneQueries(),
     numRequestsOut(0),
-    lastChunkId(0),
+    lastChunkId(-1),
     numChunks(0),
     clusterRanges(),
-    queryClusterRanges()
+    queryClusterRanges(),
+    clusterColumn(-1),
+    clusterZoneMaps()
 {
     PDEBUG ("TableWayPointImp :: TableWayPointImp ()");
 }
@@ -94,6 +169,18 @@ void TableWayPointImp :: TypeSpecificConfigure (WayPointConfigureData &configDat
         ackQueries = new QueryChunkMap(numChunks);
     }
 
+    // zone maps of the clustering attribute, the ranges pushed down are on it
+    SlotID& clusterAtt = tempConfig.get_clusterAttribute();
+    if (clusterColumn == -1 && clusterAtt.IsValid()) {
+        FOREACH_EM(physical, logical, tempConfig.get_columnsToSlotsMap()){
+            if (logical == clusterAtt)
+                clusterColumn = physical.GetInt();
+        }END_FOREACH;
+
+        if (clusterColumn != -1)
+            clusterZoneMaps = globalDiskPool.ZoneMaps(fileId, clusterColumn);
+    }
+
     // Update cluster ranges for each new query
     QueryToScannerRangeList& newRanges = tempConfig.get_filterRanges();
     for(auto elem : newRanges) {
@@ -152,8 +239,10 @@ void TableWayPointImp :: TypeSpecificConfigure (WayPointConfigureData &configDat
 
 void TableWayPointImp::GenerateTokenRequests(){
     PDEBUG ("TableWayPointImp :: GenerateTokenRequests()");
-    for (; numRequestsOut < FILE_SCANNER_MAX_NO_CHUNKS_REQUEST; numRequestsOut++) {
-        RequestTokenDelayOK (DiskWorkToken::type);
+    // ask for fewer chunks while a disk is slow, they would all wait for it
+    int maxRequests = DiskArray::ReadAheadChunks(FILE_SCANNER_MAX_NO_CHUNKS_REQUEST);
+    for (; numRequestsOut < maxRequests; numRequestsOut++) {
+        RequestTokenDelayOK (DiskWorkToken::type, DISK_SCAN_PRIORITY);
     }
 }
 
@@ -177,7 +266,6 @@ void TableWayPointImp :: RequestGranted (GenericWorkToken &returnVal) {
 
         // the mask of the queries for which we generate the chunk
         Bitstring queries = FindQueries(_chunkId);
-        Bitstring bitIter;
         Bitstring filteredOut;
 
         Bitstring ackedQ = ackQueries->GetBits(_chunkId);
@@ -191,35 +279,8 @@ void TableWayPointImp :: RequestGranted (GenericWorkToken &returnVal) {
         WARNINGIF(queries.Overlaps(doneQueries),"Why am I still seeing queries that are done?");
         queries.Difference(doneQueries);
 
-        // Filter based on clustering
-        const ClusterRange& chunkRange = clusterRanges[_chunkId];
-        int64_t cMin = chunkRange.first;
-        int64_t cMax = chunkRange.second;
-        bitIter = queries;
-        while( !bitIter.IsEmpty() ) {
-            QueryID qid = bitIter.GetFirst();
-            ClusterRangeList& qRanges = queryClusterRanges[qid];
-
-            bool keep = qRanges.empty() || cMin > cMax;
-
-            for( auto iter = qRanges.begin(); !keep && iter != qRanges.end(); iter++) {
-                int64_t min = iter->first;
-                int64_t max = iter->second;
-
-                /* This is a concise way of determining whether the intervals
-                 * [min, max] and [cMin, cMax] intersect.
-                 *
-                 * Notice that if either interval is inverted, the intersection
-                 * will also be inverted.
-                 */
-                keep = std::min(max, cMax) >= std::max(min, cMin);
-            }
-
-            if( !keep ) {
-                filteredOut.Union(qid);
-                queries.Difference(qid);
-            }
-        }
+        // Filter based on clustering and zone maps
+        FilterQueries(_chunkId, queries, filteredOut);
 
         //reset the bitmap for the requested chunk
         queryChunkMap->Clear(_chunkId);
@@ -252,14 +313,25 @@ void TableWayPointImp :: RequestGranted (GenericWorkToken &returnVal) {
 
         int numAvailableCPUs = myCPUWorkers.NumAvailable();
         // use uncompressed if less than USE_UNCOMPRESSED_THRESHOLD
-        // fraction of threads available
-        // bool useUncompressed = (numAvailableCPUs < USE_UNCOMPRESSED_THRESHOLD*NUM_EXEC_ENGINE_THREADS);
-        bool useUncompressed = true;
+        // fraction of threads available, or if nobody decompresses the
+        // chunks ahead of the CPU workers
+        bool useUncompressed = NUM_DECOMPRESSION_THREADS == 0 ||
+            (numAvailableCPUs < USE_UNCOMPRESSED_THRESHOLD*NUM_EXEC_ENGINE_THREADS);
+
+        // if only some fragments can match, the others are tagged with no query
+        int fragStart = -1;
+        int fragEnd = -1;
+        if( !FindFragments(_chunkId, queries, fragStart, fragEnd) ) {
+            fragStart = -1;
+            fragEnd = -1;
+        }
 
         // send the request
         WayPointID tempID = GetID ();
-        ChunkID chunkID(_chunkId, fileId);
-        globalDiskPool.ReadRequest(chunkID, tempID, useUncompressed, lineage, myOutputExitsCopy, myToken, colsToRead);
+        ChunkID chunkID(_chunkId, fileId, fragStart, fragEnd);
+        // the read goes at the priority of the token it was granted with
+        globalDiskPool.ReadRequest(chunkID, tempID, useUncompressed, lineage, myOutputExitsCopy, myToken, colsToRead,
+                DISK_SCAN_PRIORITY);
         sentRequest = true;
 
         LOG_ENTRY_P(2, "CHUNK %d of %s REQUESTED for queries %s",
@@ -311,8 +383,8 @@ void TableWayPointImp :: ProcessHoppingUpstreamMsg (HoppingUpstreamMsg &message)
             IDInfo info;
             qe.exit.getInfo(info);
 
-            LOG_ENTRY_P(2, "SCANNER(%s) starting (%s,%s)", infoTS.getName().c_str(),
-                    qName.c_str(), info.getName().c_str());
+            LOG_ENTRY_P(2, "SCANNER(%s) starting (%s,%s) at chunk %d", infoTS.getName().c_str(),
+                    qName.c_str(), info.getName().c_str(), lastChunkId + 1);
         }
 
         // make sure that the queries we are supposed to start are a subset of
@@ -325,6 +397,9 @@ void TableWayPointImp :: ProcessHoppingUpstreamMsg (HoppingUpstreamMsg &message)
         // WARNING: for now we assume that we do not have bulkloads so
         // the query gets all the chunks in the system. When bulkloads are added
         // we need an object to tell us what chunks we should serve to the query
+        // The scan goes on from where it is, so the query shares the chunks
+        // the others still need and gets the rest after the wrap around (see
+        // ChunkRequestIsPossible)
         queryChunkMap->ORAll(newQ);
 
         // Clear any acks we have nave gotten for this query, as we may have
@@ -431,17 +506,27 @@ void TableWayPointImp :: ProcessDropMsg (QueryExitContainer &whichExits,
 }
 
 /**
-  The implementation of the method is very simplistic at this moment.
-  If the size of the request pool is less than the maximum number of allowed chunks, a new request is possible.
-  In the future this should be like a control system that regulates the amount of chunks that are produced.
-  Profiling information is required for this more complicated behavior.
+  The chunks are produced in a circular scan shared by all the queries: the
+  search for the next chunk starts after the last one produced and wraps
+  around at the end of the relation.
+
+  A query that starts while others are being scanned gets all its chunks
+  marked (see StartProducingMsg), so it joins the scan where it is and gets
+  the chunks the others still need together with them. The chunks it missed,
+  before the position it joined at, come after the scan wraps around; the
+  query is done when the scan is back where it joined (all its chunks are
+  acknowledged). The chunks dropped for a query are produced again when the
+  scan gets to them on its next lap.
+
+  The position is kept when there is nothing to produce, so the next query
+  joins where the last one left off.
   */
 bool TableWayPointImp::ChunkRequestIsPossible(off_t &_chunkId) {
-    lastChunkId = queryChunkMap->FindFirstSet(lastChunkId);
-    if (lastChunkId == -1){
-        lastChunkId = 0; // start from the beginning next time
+    int found = queryChunkMap->FindFirstSet(lastChunkId + 1);
+    if (found == -1){
         return false; // we did not find any chunk
     } else {
+        lastChunkId = found;
         _chunkId = lastChunkId;
         return true;
     }
@@ -117,7 +117,7 @@ void TileJoinWayPointImp::GenerateTokenRequests(){
 	// This limit should be CPU limit, but let it be same for now
 	//for (; numDiskRequestsOut < FILE_SCANNER_MAX_NO_CHUNKS_REQUEST; numDiskRequestsOut++) {
 	for (; numDiskRequestsOut < 8; numDiskRequestsOut++) {
-		RequestTokenDelayOK (DiskWorkToken::type);
+		RequestTokenDelayOK (DiskWorkToken::type, DISK_TILE_JOIN_PRIORITY);
 	}
 }
 
@@ -219,7 +219,8 @@ void TileJoinWayPointImp :: ScheduleIO(GenericWorkToken &returnVal) {
 		if (!isLHS)
 			chunkIDcopy = rhsID;
 		WayPointID temp2 = GetID();
-		globalDiskPool.ReadRequest(chunkIDcopy, temp2, true/*use uncompressed*/, lineage, myOutputExitsCopy2, myToken, tmp);
+		globalDiskPool.ReadRequest(chunkIDcopy, temp2, true/*use uncompressed*/, lineage, myOutputExitsCopy2, myToken, tmp,
+				DISK_TILE_JOIN_PRIORITY);
 
 	} else {
 		GiveBackToken(myToken);